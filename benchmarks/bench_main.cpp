@@ -0,0 +1,330 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+/// Benchmark driver for the analysis stages of d-SEAMS
+///
+/// Builds synthetic ice (cubic ice, with a proton-ordered arrangement of the
+/// hydrogen atoms which obeys the ice rules) and water (the same box, with
+/// every molecule randomly displaced) boxes of increasing size, writes them
+/// out as LAMMPS trajectories, and times each stage of a typical bulk ice
+/// analysis on them:
+///
+/// - parse: reading the oxygen atoms of a frame
+/// - neighbours: the cutoff-based neighbour list
+/// - hbonds: the hydrogen-bonded network (including reading the H atoms)
+/// - bop: CHILL+ correlation and classification
+/// - rings: primitive ring enumeration
+/// - tum: topological unit matching (shape matching of cages)
+/// - output: writing a dump file, until it has reached the disk
+///
+/// Usage: yodaStruct_bench [--cells 2,3,4] [--repeats 3]
+///                         [--workdir bench_out/] [--out bench.json]
+///
+/// Run it from the top-level directory, since the shape-matching stage reads
+/// the reference cages from templates/.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <bond.hpp>
+#include <bop.hpp>
+#include <bulkTUM.hpp>
+#include <franzblau.hpp>
+#include <mol_sys.hpp>
+#include <neighbours.hpp>
+#include <output_sink.hpp>
+#include <profiling.hpp>
+#include <seams_input.hpp>
+#include <seams_output.hpp>
+
+#include <fmt/format.h>
+
+namespace {
+
+//! Lattice constant of cubic ice (in Angstrom)
+const double latticeIc = 6.358;
+//! O-H bond length (in Angstrom)
+const double bondOH = 0.9572;
+//! LAMMPS atom types used in the synthetic boxes (as in the example inputs)
+const int typeH = 1, typeO = 2;
+
+/** @struct BenchResult
+ * @brief Timings of one stage on one box.
+ */
+struct BenchResult {
+  std::string stage;  //! Name of the stage
+  std::string system; //! ice or water
+  int cells;          //! Unit cells along each dimension
+  int nAtoms;         //! Number of oxygen atoms
+  int repeats;        //! Number of timed runs
+  double minSeconds;  //! Fastest run
+  double meanSeconds; //! Mean over all runs
+  long items;         //! Items produced by the stage (bonds, rings ...)
+};
+
+/**
+ * @details Writes cubic ice with nCells unit cells along each dimension to a
+ * LAMMPS trajectory with a single frame. The oxygen atoms sit on a diamond
+ * lattice; atoms of the first sublattice donate hydrogen bonds along the first
+ * two bond directions, and atoms of the second sublattice along the other two,
+ * so that every O-O bond carries exactly one hydrogen. If displacement is
+ * non-zero, each molecule is shifted by a random vector with that standard
+ * deviation (per component), which gives a disordered, water-like box.
+ */
+int writeSyntheticBox(std::string fileName, int nCells, double displacement,
+                      unsigned int seed) {
+  // Fractional coordinates of the FCC sublattice
+  const std::array<std::array<double, 3>, 4> fcc = {
+      {{0.0, 0.0, 0.0}, {0.0, 0.5, 0.5}, {0.5, 0.0, 0.5}, {0.5, 0.5, 0.0}}};
+  // The four bond directions from the first sublattice
+  const std::array<std::array<double, 3>, 4> bondDir = {
+      {{1, 1, 1}, {1, -1, -1}, {-1, 1, -1}, {-1, -1, 1}}};
+  double boxLength = nCells * latticeIc;
+  double hScale = bondOH / std::sqrt(3.0);
+  std::mt19937 gen(seed);
+  std::normal_distribution<double> shift(0.0, displacement);
+  int nMolecules = 8 * nCells * nCells * nCells;
+  std::ofstream outputFile(fileName);
+  if (!outputFile.is_open()) {
+    std::cerr << "Could not open " << fileName << " for writing.\n";
+    return 1;
+  }
+  outputFile << "ITEM: TIMESTEP\n0\nITEM: NUMBER OF ATOMS\n"
+             << 3 * nMolecules << "\nITEM: BOX BOUNDS pp pp pp\n";
+  for (int k = 0; k < 3; k++) {
+    outputFile << fmt::format("0 {:.6f}\n", boxLength);
+  }
+  outputFile << "ITEM: ATOMS id mol type x y z\n";
+  int atomID = 1, molID = 1;
+  // Wraps a coordinate back into the box
+  auto wrap = [boxLength](double r) {
+    return r - boxLength * std::floor(r / boxLength);
+  };
+  for (int ix = 0; ix < nCells; ix++) {
+    for (int iy = 0; iy < nCells; iy++) {
+      for (int iz = 0; iz < nCells; iz++) {
+        for (int sub = 0; sub < 2; sub++) {
+          for (auto &site : fcc) {
+            std::array<double, 3> dr = {0, 0, 0};
+            if (displacement > 0) {
+              dr = {shift(gen), shift(gen), shift(gen)};
+            }
+            std::array<double, 3> o;
+            o[0] = (ix + site[0] + 0.25 * sub) * latticeIc + dr[0];
+            o[1] = (iy + site[1] + 0.25 * sub) * latticeIc + dr[1];
+            o[2] = (iz + site[2] + 0.25 * sub) * latticeIc + dr[2];
+            outputFile << fmt::format("{} {} {} {:.5f} {:.5f} {:.5f}\n",
+                                      atomID++, molID, typeO, wrap(o[0]),
+                                      wrap(o[1]), wrap(o[2]));
+            // Hydrogens: first sublattice along +d0, +d1; second along -d2,
+            // -d3
+            for (int h = 0; h < 2; h++) {
+              const std::array<double, 3> &d = bondDir[sub == 0 ? h : h + 2];
+              double sign = sub == 0 ? 1.0 : -1.0;
+              outputFile << fmt::format(
+                  "{} {} {} {:.5f} {:.5f} {:.5f}\n", atomID++, molID, typeH,
+                  wrap(o[0] + sign * hScale * d[0]),
+                  wrap(o[1] + sign * hScale * d[1]),
+                  wrap(o[2] + sign * hScale * d[2]));
+            } // end of loop through hydrogens
+            molID++;
+          } // end of loop through FCC sites
+        }   // end of loop through sublattices
+      }
+    }
+  } // end of loop through unit cells
+  return 0;
+}
+
+/**
+ * @details Runs a stage (repeats) times and returns the fastest and mean wall
+ * clock time. The stage returns the number of items it produced.
+ */
+BenchResult timeStage(std::string stage, int repeats,
+                      const std::function<long()> &run) {
+  BenchResult result;
+  result.stage = stage;
+  result.repeats = repeats;
+  result.minSeconds = 0.0;
+  result.meanSeconds = 0.0;
+  result.items = 0;
+  for (int r = 0; r < repeats; r++) {
+    auto start = std::chrono::steady_clock::now();
+    result.items = run();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    double seconds = elapsed.count();
+    result.minSeconds =
+        r == 0 ? seconds : std::min(result.minSeconds, seconds);
+    result.meanSeconds += seconds / repeats;
+  } // end of loop through repeats
+  return result;
+}
+
+/**
+ * @details Times every stage on one synthetic box. Each stage works on the
+ * output of the previous one, exactly as in a Lua script.
+ */
+std::vector<BenchResult> benchmarkBox(std::string workDir, std::string system,
+                                      int nCells, int repeats) {
+  std::vector<BenchResult> results;
+  std::string trajFile =
+      workDir + fmt::format("{}-{}.lammpstrj", system, nCells);
+  std::string outDir = workDir + fmt::format("{}-{}/", system, nCells);
+  sout::makePath(outDir);
+  writeSyntheticBox(trajFile, nCells, system == "water" ? 0.3 : 0.0,
+                    12345 + nCells);
+  molSys::PointCloud<molSys::Point<double>, double> yCloud;
+  std::vector<std::vector<int>> nList, hbnList, rings;
+  // -----------------
+  results.push_back(timeStage("parse", repeats, [&]() -> long {
+    yCloud = molSys::PointCloud<molSys::Point<double>, double>();
+    sinp::readLammpsTrjO(trajFile, 1, &yCloud, typeO);
+    return yCloud.nop;
+  }));
+  results.push_back(timeStage("neighbours", repeats, [&]() -> long {
+    nList = nneigh::neighListO(3.5, &yCloud, typeO);
+    long nPairs = 0;
+    for (auto &row : nList) {
+      nPairs += row.size() - 1;
+    }
+    return nPairs / 2;
+  }));
+  results.push_back(timeStage("hbonds", repeats, [&]() -> long {
+    hbnList = bond::populateHbonds(trajFile, &yCloud, nList, 1, typeH);
+    hbnList = nneigh::neighbourListByIndex(&yCloud, hbnList);
+    long nBonds = 0;
+    for (auto &row : hbnList) {
+      nBonds += row.size() - 1;
+    }
+    return nBonds / 2;
+  }));
+  results.push_back(timeStage("bop", repeats, [&]() -> long {
+    chill::getCorrelPlus(&yCloud, nList, false);
+    chill::getIceTypeNoPrint(&yCloud, nList, false);
+    return yCloud.nop;
+  }));
+  results.push_back(timeStage("rings", repeats, [&]() -> long {
+    rings = primitive::ringNetwork(hbnList, 6);
+    return rings.size();
+  }));
+  results.push_back(timeStage("tum", repeats, [&]() -> long {
+    tum3::topoUnitMatchingBulk(outDir, rings, hbnList, &yCloud, 1, false,
+                               false);
+    sout::flushAllSinks();
+    return rings.size();
+  }));
+  results.push_back(timeStage("output", repeats, [&]() -> long {
+    sout::writeDump(&yCloud, outDir, "dump.lammpstrj");
+    sout::flushAllSinks();
+    return yCloud.nop;
+  }));
+  // -----------------
+  for (auto &result : results) {
+    result.system = system;
+    result.cells = nCells;
+    result.nAtoms = yCloud.nop;
+  }
+  return results;
+}
+
+/**
+ * @details Writes all the results as a JSON object.
+ */
+int writeResults(std::string fileName,
+                 const std::vector<BenchResult> &results) {
+  std::ofstream outputFile(fileName);
+  if (!outputFile.is_open()) {
+    std::cerr << "Could not open " << fileName << " for writing.\n";
+    return 1;
+  }
+  outputFile << "{\n  \"benchmarks\": [";
+  for (int i = 0; i < results.size(); i++) {
+    const BenchResult &r = results[i];
+    outputFile << fmt::format(
+        "{}\n    {{\"stage\": \"{}\", \"system\": \"{}\", \"cells\": {}, "
+        "\"atoms\": {}, \"repeats\": {}, \"min_seconds\": {:.6f}, "
+        "\"mean_seconds\": {:.6f}, \"items\": {}}}",
+        i == 0 ? "" : ",", r.stage, r.system, r.cells, r.nAtoms, r.repeats,
+        r.minSeconds, r.meanSeconds, r.items);
+  } // end of loop through results
+  outputFile << "\n  ]\n}\n";
+  return 0;
+}
+
+//! Splits a comma-separated list of integers
+std::vector<int> parseList(std::string list) {
+  std::vector<int> values;
+  std::stringstream ss(list);
+  std::string token;
+  while (std::getline(ss, token, ',')) {
+    values.push_back(std::stoi(token));
+  }
+  return values;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::vector<int> cellList = {2, 3, 4};
+  int repeats = 3;
+  std::string workDir = "bench_out/";
+  std::string outFile = "bench.json";
+  // Parse the options
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string option = argv[i];
+    std::string value = argv[i + 1];
+    if (option == "--cells") {
+      cellList = parseList(value);
+    } else if (option == "--repeats") {
+      repeats = std::max(1, std::stoi(value));
+    } else if (option == "--workdir") {
+      workDir = value.back() == '/' ? value : value + "/";
+    } else if (option == "--out") {
+      outFile = value;
+    } else {
+      std::cerr << "Unknown option " << option << "\n";
+      return 1;
+    }
+  } // end of parsing the options
+  sout::makePath(workDir);
+  // -----------------
+  std::vector<BenchResult> results;
+  for (int nCells : cellList) {
+    for (std::string system : {"ice", "water"}) {
+      std::vector<BenchResult> boxResults =
+          benchmarkBox(workDir, system, nCells, repeats);
+      for (auto &r : boxResults) {
+        std::cout << fmt::format("{:<6} {:>3} cells {:>8} atoms  {:<12} "
+                                 "min {:>10.4f} s  mean {:>10.4f} s  "
+                                 "items {}\n",
+                                 r.system, r.cells, r.nAtoms, r.stage,
+                                 r.minSeconds, r.meanSeconds, r.items);
+      }
+      results.insert(results.end(), boxResults.begin(), boxResults.end());
+    } // end of loop through systems
+  }   // end of loop through box sizes
+  // -----------------
+  sout::closeAllSinks();
+  return writeResults(outFile, results);
+}
@@ -1,10 +1,18 @@
 print("\n Welcome to the manual lua function evaluation environment.\n");
 
-for frame=targetFrame,finalFrame,frameGap do
-   resCloud=readFrameOnlyOne(trajectory,frame,resCloud,oxygenAtomType,isSlice,sliceLowerLimits,sliceUpperLimits) --- Get the frame
-   nList=neighborList(cutoffRadius, resCloud, oxygenAtomType); --- Calculate the neighborlist by ID
-   hbnList=getHbondNetwork(trajectory,resCloud,nList,frame,hydrogenAtomType) --- Get the hydrogen-bonded network for the current frame
-   hbnList=bondNetworkByIndex(resCloud,hbnList) --- Hydrogen-bonded network using indices not IDs
-   rings=getPrimitiveRings(hbnList,maxDepth); --- Gets every ring (non-primitives included)
-   prismAnalysis(outDir, rings, hbnList, resCloud, maxDepth, lowestAtomID, targetFrame, frame, false); --- Does the prism analysis for quasi-one-dimensional ice
+verlet = newVerletList(neighbourSkin); --- Neighbour pairs reused across frames
+ringTracker = newRingTracker(); --- Rings of the previous frame, updated where the H-bonds changed
+hCloud = newPointCloud(); --- Hydrogen atoms of the current frame
+
+--- The frames are read on background threads, ahead of the analysis
+oFrames = prefetchFrameOnlyOne(trajectory,targetFrame,finalFrame,frameGap,oxygenAtomType,isSlice,sliceLowerLimits,sliceUpperLimits)
+hFrames = prefetchFrameOnlyOne(trajectory,targetFrame,finalFrame,frameGap,hydrogenAtomType,false,{0,0,0},{0,0,0})
+
+while nextFrame(oFrames,resCloud) and nextFrame(hFrames,hCloud) do --- Get the frame (swapped into resCloud in place)
+   frame = resCloud.currentFrame
+   neighborListVerletInto(nList, verlet, cutoffRadius, resCloud, oxygenAtomType); --- Calculate the neighborlist by ID
+   getHbondNetworkFromCloudsInto(hbnList, resCloud, hCloud, nList) --- Get the hydrogen-bonded network for the current frame
+   bondNetworkByIndexInto(hbnList, resCloud, hbnList) --- Hydrogen-bonded network using indices not IDs
+   getPrimitiveRingsIncrementalInto(ringsAllSizes, ringTracker, hbnList, maxDepth); --- Gets every ring (non-primitives included)
+   prismAnalysis(outDir, ringsAllSizes, hbnList, resCloud, maxDepth, lowestAtomID, targetFrame, frame, false); --- Does the prism analysis for quasi-one-dimensional ice
 end
@@ -1,5 +1,6 @@
 print("\n Welcome to the Ice Type Determination Module\n");
 cutoffRadius = 3.5; --- This is for H2O
+neighbourSkin = 0.5; --- Neighbour lists are only rebuilt once an atom moves by more than half of this
 oxygenAtomType = 2; --- This is assigned by LAMMPS
 hydrogenAtomType = 1; --- Hydrogen atom type assigned
 targetFrame=1; --- The first frame
@@ -25,6 +25,8 @@
 , blas
 , lib
 , boost
+, zlib
+, zstd
 , cmake }:
   clangStdenv.mkDerivation {
   name = "yodaStruct";
@@ -41,6 +43,8 @@
   eigen
   catch2
   boost
+  zlib
+  zstd
   liblapack
   blas
   lua
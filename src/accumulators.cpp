@@ -0,0 +1,417 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <mutex>
+
+#include <accumulators.hpp>
+#include <output_sink.hpp>
+#include <seams_output.hpp>
+
+namespace {
+
+struct ThreadDistributions;
+
+// Distributions of every thread, and those of threads which have exited
+struct Registry {
+  std::mutex mtx;
+  std::vector<ThreadDistributions *> threads;
+  std::map<std::string, sstat::Distribution> retired;
+  std::vector<double> quantiles;
+};
+
+Registry &registry() {
+  static Registry reg;
+  return reg;
+}
+
+// Adds the distributions of from into into, by name
+void mergeInto(std::map<std::string, sstat::Distribution> &into,
+               const std::map<std::string, sstat::Distribution> &from) {
+  for (auto &entry : from) {
+    into[entry.first].merge(entry.second);
+  }
+}
+
+// The distributions of one thread. They are merged into the retired ones
+// when the thread exits
+struct ThreadDistributions {
+  std::map<std::string, sstat::Distribution> byName;
+  ThreadDistributions() {
+    std::lock_guard<std::mutex> lock(registry().mtx);
+    registry().threads.push_back(this);
+  }
+  ~ThreadDistributions() {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    mergeInto(reg.retired, byName);
+    reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), this));
+  }
+};
+
+ThreadDistributions &threadDistributions() {
+  thread_local ThreadDistributions local;
+  return local;
+}
+
+} // namespace
+
+/**
+ * @details Sets up nBins equal bins between low and high.
+ * @param[in] low Lower end of the first bin
+ * @param[in] high Upper end of the last bin
+ * @param[in] nBins Number of bins
+ */
+sstat::Histogram::Histogram(double low, double high, int nBins)
+    : low(low), high(high), counts(std::max(nBins, 1), 0),
+      scale(std::max(nBins, 1) / (high - low)) {}
+
+/**
+ * @details Adds the counts of another histogram. The bins have to be the
+ * same; an empty (default-constructed) histogram takes over the bins of the
+ * other one.
+ * @param[in] other The histogram to be added
+ */
+void sstat::Histogram::merge(const sstat::Histogram &other) {
+  if (counts.empty()) {
+    *this = other;
+    return;
+  } // nothing to merge with
+  if (other.counts.empty()) {
+    return;
+  } // nothing to merge in
+  if (other.nBins() != nBins() || other.low != low || other.high != high) {
+    std::cerr << "Cannot merge histograms with different bins.\n";
+    return;
+  } // error
+  for (int ibin = 0; ibin < nBins(); ibin++) {
+    counts[ibin] += other.counts[ibin];
+  }
+  underflow += other.underflow;
+  overflow += other.overflow;
+}
+
+/**
+ * @details Finds the bin in which the cumulative count of the values in range
+ * reaches a fraction p of their total, and interpolates linearly inside it.
+ * Returns NaN if no values fell inside the range.
+ * @param[in] p The quantile (between 0 and 1)
+ */
+double sstat::Histogram::quantile(double p) const {
+  std::uint64_t total = 0;
+  for (auto count : counts) {
+    total += count;
+  }
+  if (total == 0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  } // no values
+  double target = std::min(std::max(p, 0.0), 1.0) * total;
+  double cumulative = 0.0;
+  for (int ibin = 0; ibin < nBins(); ibin++) {
+    if (counts[ibin] > 0 && cumulative + counts[ibin] >= target) {
+      double fraction = (target - cumulative) / counts[ibin];
+      return low + (ibin + fraction) / scale;
+    } // found the bin
+    cumulative += counts[ibin];
+  } // end of loop through the bins
+  return high;
+}
+
+/**
+ * @details Combines the moments of two sets of values, with the pairwise
+ * update of Chan, Golub and LeVeque, which is exact (up to rounding).
+ * @param[in] other The moments to be added
+ */
+void sstat::Moments::merge(const sstat::Moments &other) {
+  if (other.n == 0) {
+    return;
+  }
+  if (n == 0) {
+    *this = other;
+    return;
+  }
+  std::uint64_t total = n + other.n;
+  double delta = other.mean - mean;
+  mean += delta * other.n / total;
+  m2 += other.m2 + delta * delta * n * other.n / total;
+  min = std::min(min, other.min);
+  max = std::max(max, other.max);
+  n = total;
+}
+
+/**
+ * @details Sets up the markers for quantile p. The first five values are
+ * kept as they are; the markers start moving from the sixth value on.
+ * @param[in] p The quantile (between 0 and 1)
+ */
+sstat::P2Quantile::P2Quantile(double p) : p(p) {
+  desired = {1.0, 1.0 + 2.0 * p, 1.0 + 4.0 * p, 3.0 + 2.0 * p, 5.0};
+  increments = {0.0, p / 2.0, p, (1.0 + p) / 2.0, 1.0};
+  positions = {1.0, 2.0, 3.0, 4.0, 5.0};
+}
+
+/**
+ * @details Moves the markers for a new value: the marker positions above the
+ * cell containing the value are incremented, and the three middle markers are
+ * adjusted (with a piecewise-parabolic prediction, or a linear one if that
+ * would not keep the heights ordered) whenever they are off their desired
+ * positions by one or more.
+ * @param[in] value The new value
+ */
+void sstat::P2Quantile::add(double value) {
+  if (count < 5) {
+    heights[count++] = value;
+    if (count == 5) {
+      std::sort(heights.begin(), heights.end());
+    }
+    return;
+  } // first five values
+  count++;
+  // Cell of the value (and new extremes)
+  int k;
+  if (value < heights[0]) {
+    heights[0] = value;
+    k = 0;
+  } else if (value >= heights[4]) {
+    heights[4] = value;
+    k = 3;
+  } else {
+    k = 0;
+    while (k < 3 && value >= heights[k + 1]) {
+      k++;
+    }
+  } // found the cell
+  for (int i = k + 1; i < 5; i++) {
+    positions[i] += 1.0;
+  }
+  for (int i = 0; i < 5; i++) {
+    desired[i] += increments[i];
+  }
+  // Adjust the middle markers
+  for (int i = 1; i < 4; i++) {
+    double d = desired[i] - positions[i];
+    if ((d >= 1.0 && positions[i + 1] - positions[i] > 1.0) ||
+        (d <= -1.0 && positions[i - 1] - positions[i] < -1.0)) {
+      double sign = d > 0 ? 1.0 : -1.0;
+      // Piecewise-parabolic prediction
+      double parabolic =
+          heights[i] +
+          sign / (positions[i + 1] - positions[i - 1]) *
+              ((positions[i] - positions[i - 1] + sign) *
+                   (heights[i + 1] - heights[i]) /
+                   (positions[i + 1] - positions[i]) +
+               (positions[i + 1] - positions[i] - sign) *
+                   (heights[i] - heights[i - 1]) /
+                   (positions[i] - positions[i - 1]));
+      if (heights[i - 1] < parabolic && parabolic < heights[i + 1]) {
+        heights[i] = parabolic;
+      } else {
+        int j = i + static_cast<int>(sign);
+        heights[i] += sign * (heights[j] - heights[i]) /
+                      (positions[j] - positions[i]);
+      } // linear prediction
+      positions[i] += sign;
+    } // marker has to move
+  }   // end of loop through the middle markers
+}
+
+/**
+ * @details Returns the height of the middle marker. With fewer than five
+ * values, the quantile of the values seen so far is returned instead.
+ */
+double sstat::P2Quantile::value() const {
+  if (count == 0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  if (count < 5) {
+    std::array<double, 5> sorted = heights;
+    std::sort(sorted.begin(), sorted.begin() + count);
+    int index = static_cast<int>(std::lround(p * (count - 1)));
+    return sorted[index];
+  } // too few values for the markers
+  return heights[2];
+}
+
+/**
+ * @details Sets up the bins, and a P² estimator for each of the quantiles.
+ * @param[in] low Lower end of the first bin
+ * @param[in] high Upper end of the last bin
+ * @param[in] nBins Number of bins
+ * @param[in] quantiles Quantiles (between 0 and 1) to be estimated
+ */
+sstat::Distribution::Distribution(double low, double high, int nBins,
+                                  std::vector<double> quantiles)
+    : histogram(low, high, nBins), probabilities(quantiles) {
+  for (double p : probabilities) {
+    estimates.emplace_back(p);
+  }
+}
+
+/**
+ * @details Adds the histogram and moments of another distribution. If both
+ * distributions have values, the P² estimates no longer describe all the
+ * values, and quantiles are taken from the merged histogram from then on.
+ * @param[in] other The distribution to be added
+ */
+void sstat::Distribution::merge(const sstat::Distribution &other) {
+  if (histogram.counts.empty() || moments.n == 0) {
+    Histogram bins = histogram;
+    *this = other;
+    if (!bins.counts.empty() && histogram.counts.empty()) {
+      histogram = bins;
+    } // keep the bins of an empty distribution
+    return;
+  } // nothing to merge with
+  if (other.moments.n == 0) {
+    return;
+  } // nothing to merge in
+  histogram.merge(other.histogram);
+  moments.merge(other.moments);
+  merged = true;
+}
+
+/**
+ * @details Returns quantile p, from the P² estimator of p if there is one
+ * (and no other values have been merged in), and otherwise by interpolating
+ * the histogram.
+ * @param[in] p The quantile (between 0 and 1)
+ */
+double sstat::Distribution::quantile(double p) const {
+  if (!merged) {
+    for (auto &estimate : estimates) {
+      if (estimate.probability() == p) {
+        return estimate.value();
+      }
+    } // end of loop through the estimates
+  }
+  return histogram.quantile(p);
+}
+
+/**
+ * @details Writes the moments and quantiles as comment lines, followed by
+ * the centre, count and normalized density of every bin.
+ * @param[in] fileName The output file
+ */
+int sstat::Distribution::write(const std::string &fileName) const {
+  sout::OutputSink outputFile(fileName);
+  if (!outputFile.isOpen()) {
+    std::cerr << "Could not open the file " << fileName << ".\n";
+    return 1;
+  } // error
+  outputFile.print("# count {}\n", moments.n);
+  outputFile.print("# mean {:g}\n", moments.mean);
+  outputFile.print("# variance {:g}\n", moments.variance());
+  outputFile.print("# min {:g}\n", moments.min);
+  outputFile.print("# max {:g}\n", moments.max);
+  outputFile.print("# below {:g}: {}\n", histogram.low, histogram.underflow);
+  outputFile.print("# above {:g}: {}\n", histogram.high, histogram.overflow);
+  for (double p : probabilities) {
+    outputFile.print("# quantile {:g} {:g}\n", p, quantile(p));
+  }
+  outputFile.print("# binCentre count density\n");
+  double norm = moments.n > 0 ? 1.0 / (moments.n * histogram.binWidth()) : 0;
+  for (int ibin = 0; ibin < histogram.nBins(); ibin++) {
+    outputFile.print("{:g} {} {:g}\n", histogram.binCentre(ibin),
+                     histogram.counts[ibin], histogram.counts[ibin] * norm);
+  } // end of loop through the bins
+  return 0;
+}
+
+/**
+ * @details Sets the quantiles estimated with P² by the distributions created
+ * after this call. Distributions which already exist are not changed.
+ * @param[in] quantiles Quantiles (between 0 and 1)
+ */
+void sstat::setQuantiles(std::vector<double> quantiles) {
+  std::lock_guard<std::mutex> lock(registry().mtx);
+  registry().quantiles = quantiles;
+}
+
+/**
+ * @details Returns the distribution of a quantity belonging to the calling
+ * thread, so that values can be added to it without any locking. It is
+ * created, with the given bins, the first time the thread asks for it.
+ * @param[in] name Name of the quantity
+ * @param[in] low Lower end of the first bin
+ * @param[in] high Upper end of the last bin
+ * @param[in] nBins Number of bins
+ */
+sstat::Distribution &sstat::distribution(const std::string &name, double low,
+                                         double high, int nBins) {
+  auto &local = threadDistributions().byName;
+  auto it = local.find(name);
+  if (it != local.end()) {
+    return it->second;
+  } // exists
+  std::lock_guard<std::mutex> lock(registry().mtx);
+  return local
+      .emplace(name,
+               sstat::Distribution(low, high, nBins, registry().quantiles))
+      .first->second;
+}
+
+/**
+ * @details Merges the distributions of every thread (including those of
+ * threads which have exited). No other thread may be adding values while
+ * this runs, so call it between frames.
+ */
+std::map<std::string, sstat::Distribution> sstat::mergedDistributions() {
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  std::map<std::string, sstat::Distribution> merged = reg.retired;
+  for (auto *thread : reg.threads) {
+    mergeInto(merged, thread->byName);
+  }
+  return merged;
+}
+
+/**
+ * @details Writes out every distribution, merged over all threads, to a file
+ * named after the quantity (cij-histogram.txt, for instance). The files are
+ * overwritten, so this can be called at checkpoints as well as at the end of
+ * the run.
+ * @param[in] path Directory (ending with a slash) for the files
+ */
+int sstat::writeAll(const std::string &path) {
+  auto merged = sstat::mergedDistributions();
+  if (merged.empty()) {
+    return 0;
+  } // nothing recorded
+  if (!path.empty() && sout::ensurePath(path) != 0) {
+    std::cerr << "Could not create the directory " << path << ".\n";
+    return 1;
+  } // error
+  int status = 0;
+  for (auto &entry : merged) {
+    status |= entry.second.write(path + entry.first + "-histogram.txt");
+  }
+  return status;
+}
+
+/**
+ * @details Clears the distributions of every thread. As for
+ * sstat::mergedDistributions, no other thread may be adding values.
+ */
+void sstat::reset() {
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  reg.retired.clear();
+  for (auto *thread : reg.threads) {
+    thread->byName.clear();
+  }
+}
@@ -14,23 +14,104 @@
 
 // Internal Libraries
 #include <bond.hpp>
+#include <profiling.hpp>
+#include <seams_input.hpp>
 #include <generic.hpp>
 
+namespace {
+
+//! Below this many bonds, a comparison sort is faster than the radix sort
+constexpr std::size_t radixSortThreshold = 256;
+
+// The neighbours (by index) in a row of the neighbour list, sorted by their
+// positions in the order in which the atoms were read in. The bonds of an atom
+// then come out in the same order whichever way the atoms and the neighbour
+// list are ordered
+void neighboursInFileOrder(const std::vector<int> &row,
+                           const std::vector<int> &position,
+                           std::vector<int> *neighbours) {
+  neighbours->assign(row.begin() + 1, row.end());
+  std::sort(neighbours->begin(), neighbours->end(),
+            [&position](int iatom, int jatom) {
+              return position[iatom] < position[jatom];
+            });
+}
+
+} // namespace
+
+/**
+ * @details Packs bonds given as a vector of vectors (each row holding the two
+ * bonded atoms) into a bond::BondList, keeping their order.
+ * @param[in] bonds Row-ordered vector of vectors of the bonds
+ */
+bond::BondList bond::packBonds(const std::vector<std::vector<int>> &bonds) {
+  bond::BondList packed;
+  packed.keys.reserve(bonds.size());
+  for (auto &currentBond : bonds) {
+    packed.add(currentBond[0], currentBond[1]);
+  } // end of loop through bonds
+  return packed;
+}
+
 /**
- * @details Create a vector of vectors containing bond information (outputs
+ * @details Sorts the packed bonds and removes duplicates, giving the same
+ * order as std::sort and std::unique on the equivalent vector of vectors.
+ * Large lists are sorted with a least-significant-digit radix sort on the
+ * 64-bit keys, 16 bits at a time. Digits which are the same for every key
+ * (for instance the upper bits of the atom IDs of a small system) are skipped.
+ * @param[in, out] bonds The bonds, which are sorted and deduplicated in place
+ */
+void bond::sortUniqueBonds(bond::BondList &bonds) {
+  std::vector<std::uint64_t> &keys = bonds.keys;
+  if (keys.size() < radixSortThreshold) {
+    std::sort(keys.begin(), keys.end());
+  } // small lists
+  else {
+    // Bits which differ between at least two keys
+    std::uint64_t anyBits = 0, allBits = ~std::uint64_t{0};
+    for (auto key : keys) {
+      anyBits |= key;
+      allBits &= key;
+    } // end of loop through keys
+    std::uint64_t varyingBits = anyBits ^ allBits;
+    std::vector<std::uint64_t> buffer(keys.size());
+    std::vector<std::size_t> offsets(1 << 16);
+    for (int shift = 0; shift < 64; shift += 16) {
+      if (((varyingBits >> shift) & 0xffff) == 0) {
+        continue;
+      } // every key has the same digit
+      std::fill(offsets.begin(), offsets.end(), 0);
+      for (auto key : keys) {
+        offsets[(key >> shift) & 0xffff]++;
+      } // end of counting the digits
+      std::size_t start = 0;
+      for (auto &offset : offsets) {
+        std::size_t count = offset;
+        offset = start;
+        start += count;
+      } // end of prefix sum
+      for (auto key : keys) {
+        buffer[offsets[(key >> shift) & 0xffff]++] = key;
+      } // end of scatter
+      keys.swap(buffer);
+    } // end of loop through digits
+  }   // radix sort
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+/**
+ * @details Create a packed list containing bond information (outputs
  * bonded atom IDs, not indices!) from the neighbour list vector of vectors
- * (which contains atom INDICES). Moreover, the first element corresponds to the
- * atom whose neighbours have been found.
+ * (which contains atom INDICES). Moreover, the first atom of a bond
+ * corresponds to the atom whose neighbours have been found. The bonds are
+ * listed in the order in which the atoms were read in.
  */
-std::vector<std::vector<int>>
-bond::populateBonds(std::vector<std::vector<int>> nList,
+bond::BondList
+bond::populateBonds(const std::vector<std::vector<int>> &nList,
                     molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
   //
-  std::vector<std::vector<int>> bonds; // Output vector of vectors
-  std::vector<int> currentBond;        // Vector for the current bond
-  int first, second;                   // Indices for the bonds
-  int iatom, jatom;                    // Elements of the bond
-  int iatomID, jatomID; // Atom IDs of the elements which are bonded
+  bond::BondList bonds; // Output bonds
+  int iatom, jatom;     // Elements of the bond
 
   // Error handling
   if (nList.size() == 0) {
@@ -39,7 +120,7 @@ bond::populateBonds(std::vector<std::vector<int>> nList,
     return bonds;
   }
 
-  // Form of the bonds vector of vectors:
+  // Form of the bonds:
   // 214    272
   // 1       2
   // Meaning that 272 and 214 are bonded; similarly 1 and 2 are bonded
@@ -48,31 +129,27 @@ bond::populateBonds(std::vector<std::vector<int>> nList,
 
   // Traverse the neighbour list
 
-  // Loop through every atom in the neighbour list by index
-  for (int i = 0; i < nList.size(); i++) {
+  // Loop through every atom in the neighbour list by index, in the order in
+  // which the atoms were read in
+  std::vector<int> position = molSys::filePositions(yCloud);
+  std::vector<int> neighbours; // Neighbours of the current atom
+  for (int k = 0; k < nList.size(); k++) {
+    int i = molSys::fileIndex(yCloud, k);
     iatom = nList[i][0]; // Index of the i^th atom
     // Get the neighbours of iatom
-    for (int j = 1; j < nList[i].size(); j++) {
+    neighboursInFileOrder(nList[iatom], position, &neighbours);
+    for (int j = 0; j < neighbours.size(); j++) {
       //
-      jatom = nList[iatom][j]; // Index of the neighbour
+      jatom = neighbours[j]; // Index of the neighbour
       // To avoid duplicates, skip all bonds such
-      // that iatom>jatom
-      if (iatom > jatom) {
+      // that iatom was read after jatom
+      if (position[iatom] > position[jatom]) {
         continue;
       } // Skip to avoid duplicates
 
-      // Clear the current bond vector
-      currentBond.clear();
-      // Fill the current bond vector with ATOM IDs
-      iatomID = yCloud->pts[iatom].atomID;
-      jatomID = yCloud->pts[jatom].atomID;
-      currentBond.push_back(iatomID);
-      currentBond.push_back(jatomID);
-      // Add to the bonds vector of vectors
-      bonds.push_back(currentBond);
+      // Add the bond, by ATOM IDs
+      bonds.add(yCloud->pts[iatom].atomID, yCloud->pts[jatom].atomID);
     } // end of loop the neighbour list
-    // The last pair is with the last element and the first element
-    // Fill currentBond and update bonds
 
   } // end of loop through rings
 
@@ -80,25 +157,23 @@ bond::populateBonds(std::vector<std::vector<int>> nList,
 }
 
 /**
- *  @details Create a vector of vectors containing bond information (outputs
+ *  @details Create a packed list containing bond information (outputs
  * bonded atom IDs, not indices!) from the neighbour list vector of vectors
  * (which contains atom INDICES). Bonds between dummy atoms, and between dummy
- * and ice atoms are not added. Moreover, the first element corresponds to the
- * atom whose neighbours have been found.
+ * and ice atoms are not added. Moreover, the first atom of a bond corresponds
+ * to the atom whose neighbours have been found. The bonds are listed in the
+ * order in which the atoms were read in.
  *  @param[in] nList Row-ordered neighbour list by ID
  *  @param[in] yCloud The input molSys::PointCloud
  *  @param[in] atomTypes Contains an atom type for each particle in yCloud
  */
-std::vector<std::vector<int>>
-bond::populateBonds(std::vector<std::vector<int>> nList,
+bond::BondList
+bond::populateBonds(const std::vector<std::vector<int>> &nList,
                     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                    std::vector<cage::iceType> atomTypes) {
+                    const std::vector<cage::iceType> &atomTypes) {
   //
-  std::vector<std::vector<int>> bonds; // Output vector of vectors
-  std::vector<int> currentBond;        // Vector for the current bond
-  int first, second;                   // Indices for the bonds
-  int iatom, jatom;                    // Elements of the bond
-  int iatomID, jatomID; // Atom IDs of the elements which are bonded
+  bond::BondList bonds; // Output bonds
+  int iatom, jatom;     // Elements of the bond
 
   // Error handling
   if (nList.size() == 0) {
@@ -107,7 +182,7 @@ bond::populateBonds(std::vector<std::vector<int>> nList,
     return bonds;
   }
 
-  // Form of the bonds vector of vectors:
+  // Form of the bonds:
   // 214    272
   // 1       2
   // Meaning that 272 and 214 are bonded; similarly 1 and 2 are bonded
@@ -116,39 +191,35 @@ bond::populateBonds(std::vector<std::vector<int>> nList,
 
   // Traverse the neighbour list
 
-  // Loop through every atom in the neighbour list by index
-  for (int i = 0; i < nList.size(); i++) {
+  // Loop through every atom in the neighbour list by index, in the order in
+  // which the atoms were read in
+  std::vector<int> position = molSys::filePositions(yCloud);
+  std::vector<int> neighbours; // Neighbours of the current atom
+  for (int k = 0; k < nList.size(); k++) {
+    int i = molSys::fileIndex(yCloud, k);
     iatom = nList[i][0]; // Index of the i^th atom
     // Skip for dummy atoms
     if (atomTypes[iatom] == cage::dummy) {
       continue;
     } // Skip for dummy atoms
     // Get the neighbours of iatom
-    for (int j = 1; j < nList[i].size(); j++) {
+    neighboursInFileOrder(nList[iatom], position, &neighbours);
+    for (int j = 0; j < neighbours.size(); j++) {
       //
-      jatom = nList[iatom][j]; // Index of the neighbour
+      jatom = neighbours[j]; // Index of the neighbour
       // Skip for dummy atoms
       if (atomTypes[jatom] == cage::dummy) {
         continue;
       } // Skip for dummy atoms
       // To avoid duplicates, skip all bonds such
-      // that iatom>jatom
-      if (iatom > jatom) {
+      // that iatom was read after jatom
+      if (position[iatom] > position[jatom]) {
         continue;
       } // Skip to avoid duplicates
 
-      // Clear the current bond vector
-      currentBond.clear();
-      // Fill the current bond vector with ATOM IDs
-      iatomID = yCloud->pts[iatom].atomID;
-      jatomID = yCloud->pts[jatom].atomID;
-      currentBond.push_back(iatomID);
-      currentBond.push_back(jatomID);
-      // Add to the bonds vector of vectors
-      bonds.push_back(currentBond);
+      // Add the bond, by ATOM IDs
+      bonds.add(yCloud->pts[iatom].atomID, yCloud->pts[jatom].atomID);
     } // end of loop the neighbour list
-    // The last pair is with the last element and the first element
-    // Fill currentBond and update bonds
 
   } // end of loop through rings
 
@@ -173,8 +244,9 @@ bond::populateBonds(std::vector<std::vector<int>> nList,
 std::vector<std::vector<int>>
 bond::populateHbonds(std::string filename,
                      molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                     std::vector<std::vector<int>> nList, int targetFrame,
+                     const std::vector<std::vector<int>> &nList, int targetFrame,
                      int Htype) {
+  sprof::StageTimer timer("hbonds");
   //
   std::vector<std::vector<int>>
       hBondNet; // Output vector of vectors containing the HBN
@@ -202,7 +274,7 @@ bond::populateHbonds(std::string filename,
 
   // --------------------
   // Get all the hydrogen atoms in the frame (no slice)
-  hCloud = sinp::readLammpsTrjreduced(filename, targetFrame, &hCloud, Htype);
+  sinp::readLammpsTrjreduced(filename, targetFrame, &hCloud, Htype);
 
   // Get the unordered map of the oxygen atom IDs (keys) and the molecular IDs
   // (values)
@@ -323,6 +395,7 @@ bond::populateHbonds(std::string filename,
   // Erase all temporary stuff
   hCloud = molSys::clearPointCloud(&hCloud);
 
+  sprof::count("hbonds", hBondNet.size());
   return hBondNet;
 }
 
@@ -342,7 +415,8 @@ bond::populateHbonds(std::string filename,
 std::vector<std::vector<int>>
 bond::populateHbondsWithInputClouds(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                      molSys::PointCloud<molSys::Point<double>, double> *hCloud,
-                     std::vector<std::vector<int>> nList) {
+                     const std::vector<std::vector<int>> &nList) {
+  sprof::StageTimer timer("hbonds");
   //
   std::vector<std::vector<int>>
       hBondNet; // Output vector of vectors containing the HBN
@@ -483,6 +557,7 @@ bond::populateHbondsWithInputClouds(molSys::PointCloud<molSys::Point<double>, do
 
   // --------------------
 
+  sprof::count("hbonds", hBondNet.size());
   return hBondNet;
 }
 
@@ -515,8 +590,10 @@ double bond::getHbondDistanceOH(
 }
 
 /**
- *  Create a vector of vectors containing bond information (bonded atom IDs, not
- vector or array indices!) from the ring vector of vectors and cageList
+ *  Create a packed list containing bond information (bonded atom IDs, not
+ vector or array indices!) from the ring vector of vectors and cageList. The
+ two atoms of every bond are in ascending order, and the bonds are sorted, with
+ duplicates removed.
  *  @param[in] rings Row-ordered vector of vectors atom indices of ring
  information. Each row is a ring, containing the indices of the particles in
  that ring
@@ -525,13 +602,11 @@ double bond::getHbondDistanceOH(
  *  @param[in, out] nRings The total number of rings for all the cages, for the
  particular cage type
 */
-std::vector<std::vector<int>>
-bond::createBondsFromCages(std::vector<std::vector<int>> rings,
+bond::BondList
+bond::createBondsFromCages(const std::vector<std::vector<int>> &rings,
                            std::vector<cage::Cage> *cageList,
                            cage::cageType type, int *nRings) {
-  std::vector<std::vector<int>> bonds; // Output vector of vectors
-  std::vector<int> currentBond;        // Vector for the current bond
-  int ringSize = rings[0].size();
+  bond::BondList bonds; // Output bonds
   int currentRing; // (vector) index of the current ring in a particular cage
 
   // Error handling
@@ -540,8 +615,9 @@ bond::createBondsFromCages(std::vector<std::vector<int>> rings,
     std::cerr << "There are no rings in the system!\n";
     return bonds;
   }
+  int ringSize = rings[0].size();
 
-  // Form of the bonds vector of vectors:
+  // Form of the bonds:
   // 272    214
   // 1       2
   // Meaning that 272 and 214 are bonded; similarly 1 and 2 are bonded
@@ -561,84 +637,30 @@ bond::createBondsFromCages(std::vector<std::vector<int>> rings,
     // Now loop through a particular ring inside the i^th cage
     for (int iring = 0; iring < (*cageList)[icage].rings.size(); iring++) {
       currentRing = (*cageList)[icage].rings[iring]; // Current ring index
+      const std::vector<int> &ring = rings[currentRing];
       // Get the first atom of each pair inside currentRing
-      for (int k = 0; k < rings[currentRing].size() - 1; k++) {
-        // Clear the current bond vector
-        currentBond.clear();
-        // Fill the current bond vector
-        currentBond.push_back(rings[currentRing][k]);
-        currentBond.push_back(rings[currentRing][k + 1]);
-        std::sort(currentBond.begin(), currentBond.end());
-        // Add to the bonds vector of vectors
-        bonds.push_back(currentBond);
+      for (int k = 0; k < ring.size() - 1; k++) {
+        bonds.add(std::min(ring[k], ring[k + 1]),
+                  std::max(ring[k], ring[k + 1]));
       } // end of loop through ring elements, except the last one
       // The last pair is with the last element and the first element
-      // Fill currentBond and update bonds
-      currentBond.clear();
-      currentBond.push_back(rings[currentRing][ringSize - 1]);
-      currentBond.push_back(rings[currentRing][0]);
-      std::sort(currentBond.begin(), currentBond.end());
-      bonds.push_back(currentBond);
+      bonds.add(std::min(ring[ringSize - 1], ring[0]),
+                std::max(ring[ringSize - 1], ring[0]));
     } // end of loop through a particular ring
   }   // end of loop through cages
 
   // This may have duplicates, so the duplicates should be removed
-  std::sort(bonds.begin(), bonds.end());
-  bonds.erase(std::unique(bonds.begin(), bonds.end()), bonds.end());
+  bond::sortUniqueBonds(bonds);
 
   return bonds;
 }
 
 /**
- *  The bond 1 2 and 2 1 are the same. To prevent multiple bonds between the
- same atoms, remove all bonds which are duplicates of the reversed vectors
- (denoting individual bonds) within the bonds vector of vectors
- *  @param[in, out] bonds Row-ordered vector of vectors of the bond matrix
- Each row is a ring, containing the indices of the particles in that ring
+ *  Remove duplicate bonds, sorting the bonds. Bonds are not reordered
+ internally, so that the bond 1 2 and 2 1 are both kept if they are present.
+ *  @param[in] bonds The bonds, possibly with duplicates
 */
-std::vector<std::vector<int>>
-bond::trimBonds(std::vector<std::vector<int>> bonds) {
-  std::vector<int>
-      reversedBond; // Vector for the current bond in reversed order
-  std::vector<bool> isBondFlag;
-  int temp = 0;
-
-  std::sort(bonds.begin(), bonds.end());
-  bonds.erase(std::unique(bonds.begin(), bonds.end()), bonds.end());
-
-  // // Temp uncommented
-  // // Resize the flag vector and init to true
-  // isBondFlag.resize(bonds.size(), true);
-  // // Form of the bonds vector of vectors:
-  // // 272    214
-  // // 1       2
-  // // Meaning that 272 and 214 are bonded; similarly 1 and 2 are bonded
-
-  // // Traverse the bonds vector of vectors
-
-  // // Loop through all the bonds
-  // for(int ibond=0; ibond<bonds.size(); ibond++){
-
-  //   // Skip if the bond has been flagged as false
-  //   if(isBondFlag[ibond] == false){continue;}
-
-  //   reversedBond.clear();
-  //   reversedBond.push_back( bonds[ibond][1] );
-  //   reversedBond.push_back( bonds[ibond][0] );
-
-  //   // Compare with other bonds by looping through
-  //   // the rest
-  //   for(int jbond=0; jbond<bonds.size(); jbond++){
-  //     // Skip if jbond has been flagged
-  //     if(isBondFlag[jbond] == false){continue;}
-  //     // Compare reversed bond and jbond if jbond has not been flagged yet
-  //     if(reversedBond==bonds[jbond]){
-  //       isBondFlag[jbond] = false;
-  //       temp++;
-  //     } // end of check of comparison
-  //   } // end of looping through all possible bonds
-  // } // end of loop through all possible bonds
-  // // temp
-
+bond::BondList bond::trimBonds(bond::BondList bonds) {
+  bond::sortUniqueBonds(bonds);
   return bonds;
 }
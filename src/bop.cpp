@@ -13,6 +13,7 @@
 //-----------------------------------------------------------------------------------
 
 #include <bop.hpp>
+#include <profiling.hpp>
 #include <iostream>
 
 namespace bg = boost::geometry;
@@ -295,9 +296,10 @@ std::complex<double> sph::lookupTableQ6(int m, std::array<double, 2> angles) {
 
 //! Uses Boost for spherical harmonics, and gets c_ij according to the CHILL
 //! algorithm
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 chill::getCorrel(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                 std::vector<std::vector<int>> nList, bool isSlice) {
+                 const std::vector<std::vector<int>> &nList, bool isSlice) {
+  sprof::StageTimer timer("bop.cij");
   //
   int l = 3;      // TODO: Don't hard-code this; change later
   int iatomID;    // Atom ID (key) of iatom
@@ -434,9 +436,9 @@ chill::getCorrel(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
 }
 
 //! Classifies each atom according to the CHILL algorithm without printing
-molSys::PointCloud<molSys::Point<double>, double> chill::getIceTypeNoPrint(
+molSys::PointCloud<molSys::Point<double>, double> &chill::getIceTypeNoPrint(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<std::vector<int>> nList, bool isSlice) {
+    const std::vector<std::vector<int>> &nList, bool isSlice) {
   int ih, ic, water, interIce, unknown, total; // No. of particles of each type
   ih = ic = water = unknown = interIce = total = 0;
   int num_staggrd, num_eclipsd, na;
@@ -501,10 +503,11 @@ molSys::PointCloud<molSys::Point<double>, double> chill::getIceTypeNoPrint(
 }
 
 //! Classifies each atom according to the CHILL algorithm
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 chill::getIceType(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                  std::vector<std::vector<int>> nList, std::string path,
+                  const std::vector<std::vector<int>> &nList, std::string path,
                   int firstFrame, bool isSlice, std::string outputFileName) {
+  sprof::StageTimer timer("bop.iceType");
   int ih, ic, water, interIce, unknown, total; // No. of particles of each type
   ih = ic = water = unknown = interIce = total = 0;
   int num_staggrd, num_eclipsd, na;
@@ -598,9 +601,10 @@ chill::getIceType(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
  *  @param[in] nList Row-ordered neighbour list by atom ID
  *  @param[in] isSlice This decides whether there is a slice or not
  */
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 chill::getCorrelPlus(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                     std::vector<std::vector<int>> nList, bool isSlice) {
+                     const std::vector<std::vector<int>> &nList, bool isSlice) {
+  sprof::StageTimer timer("bop.cij");
   //
   int l = 3;      // TODO: Don't hard-code this; change later
   int iatomID;    // Atom ID (key) of iatom
@@ -751,11 +755,12 @@ chill::getCorrelPlus(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
  *   will be written out.
  *   The default file name is "chillPlus.txt"
  */
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 chill::getIceTypePlus(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                      std::vector<std::vector<int>> nList, std::string path,
+                      const std::vector<std::vector<int>> &nList, std::string path,
                       int firstFrame, bool isSlice,
                       std::string outputFileName) {
+  sprof::StageTimer timer("bop.iceType");
   int ih, ic, interIce, water, unknown, clath, interClath,
       total; // No. of particles of each type
   ih = ic = water = unknown = interIce = total = 0;
@@ -866,7 +871,8 @@ chill::getIceTypePlus(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
  */
 std::vector<double>
 chill::getq6(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-             std::vector<std::vector<int>> nList, bool isSlice) {
+             const std::vector<std::vector<int>> &nList, bool isSlice) {
+  sprof::StageTimer timer("bop.q6");
   //
   int l = 6;      // We're using q6 here
   int jatomID;    // Atom ID of the nearest neighbour
@@ -1008,9 +1014,10 @@ chill::getq6(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
  *  @param[in] q6 Vector containing the previously calculated averaged @f$q_6@f$
  *   values (using chill::getq6)
  */
-molSys::PointCloud<molSys::Point<double>, double> chill::reclassifyWater(
+molSys::PointCloud<molSys::Point<double>, double> &chill::reclassifyWater(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<double> *q6) {
+  sprof::StageTimer timer("bop.reclassify");
   // If averaged q6 > 0.5, then consider it to be ice
   // If averaged q3 < -0.75 then it is ih or ic. If q3 < -0.85 then it is cubic,
   // otherwise it is hexagonal
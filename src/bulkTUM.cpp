@@ -13,6 +13,7 @@
 //-----------------------------------------------------------------------------------
 
 #include <bulkTUM.hpp>
+#include <profiling.hpp>
 
 // -----------------------------------------------------------------------------------------------------
 // TOPOLOGICAL UNIT MATCHING ALGORITHMS
@@ -24,8 +25,8 @@
  * primitive rings which should also be by index. This is registered as a Lua
  * function and is accessible to the user. Internally, this function calls the
  * following functions:
- *   - ring::getSingleRingSize (Saves rings of a single ring size into a new
- * vector of vectors, which is subsequently used for finding DDCs, HCs etc).
+ *   - ring::RingsBySize::ofSize (The rings of a single ring size, which are
+ * subsequently used for finding DDCs, HCs etc).
  *   - ring::findDDC (Finds the DDCs).
  *   - ring::findHC (Finds the HCs).
  *   - ring::findMixedRings (Finds the mixed rings, which are shared by DDCs and
@@ -38,9 +39,14 @@
  * for printing out the ice types found).
  *   - sout::writeLAMMPSdataTopoBulk (Writes out the atoms, with the classified
  *    types, into a LAMMPS data file, which can be visualized in OVITO).
+ *
+ * The cages (and the prism blocks of prism3::findBulkPrisms) are shape-matched
+ * on match::threads() threads. The RMSD of every cage is added to the RMSD
+ * per atom in the order of the cages, so the output does not depend on the
+ * number of threads.
  *  @param[in] path The file path of the output directory to which output files
  *   will be written.
- *  @param[in] rings Vector of vectors containing the primitive rings. This
+ *  @param[in] rings The primitive rings, bucketed by size. This
  *   contains rings of all sizes.
  *  @param[in] nList Row-ordered neighbour list, by index.
  *  @param[in] yCloud The input PointCloud, with respect to which the indices in
@@ -50,10 +56,11 @@
  *   finding PNCs (false)
  */
 int tum3::topoUnitMatchingBulk(
-    std::string path, std::vector<std::vector<int>> rings,
-    std::vector<std::vector<int>> nList,
+    std::string path, const ring::RingsBySize &rings,
+    const std::vector<std::vector<int>> &nList,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int firstFrame,
     bool printClusters, bool onlyTetrahedral) {
+  sprof::StageTimer timer("tum");
   // The input rings vector has rings of all sizes
 
   // ringType has a value for rings of a particular size
@@ -62,8 +69,6 @@ int tum3::topoUnitMatchingBulk(
                 // ringList, of type enum strucType in gen.hpp
   // Make a list of all the DDCs and HCs
   std::vector<cage::Cage> cageList;
-  std::vector<std::vector<int>>
-      ringsOneType;    // Vector of vectors of rings of a single size
   int initRingSize;    // Todo or not: calculate the PNCs or not
   int maxRingSize = 6; // DDCs and HCs are for 6-membered rings
   std::vector<cage::iceType>
@@ -71,8 +76,6 @@ int tum3::topoUnitMatchingBulk(
   // Number of types
   int numHC, numDDC, mixedRings, prismaticRings, basalRings;
   // Shape-matching variables ----
-  double rmsd;              // RMSD value for a particular cage type
-  std::vector<double> quat; // Quaternion obtained from shape-matching
   std::vector<std::vector<double>> quatList; // List of quaternions
   // Reference points
   Eigen::MatrixXd refPntsDDC(14,
@@ -102,10 +105,8 @@ int tum3::topoUnitMatchingBulk(
   // Init
   // Get rings of size 5 or 6.
   for (int ringSize = initRingSize; ringSize <= maxRingSize; ringSize++) {
-    // Clear ringsOneType
-    ring::clearRingList(ringsOneType);
-    // Get rings of the current ring size
-    ringsOneType = ring::getSingleRingSize(rings, ringSize);
+    // Rings of the current ring size
+    const std::vector<std::vector<int>> &ringsOneType = rings.ofSize(ringSize);
     // Skip for zero rings
     if (ringsOneType.size() == 0) {
       continue;
@@ -140,6 +141,9 @@ int tum3::topoUnitMatchingBulk(
   // --------------------------------------------------
   // SHAPE-MATCHING
   //
+  // The cages are made up of 6-membered rings
+  const std::vector<std::vector<int>> &ringsOneType =
+      rings.ofSize(maxRingSize);
   // Get the reference point sets
   //
   std::string filePathHC = "templates/hc.xyz";
@@ -158,31 +162,32 @@ int tum3::topoUnitMatchingBulk(
   //
   // Loop through the entire cageList vector of cages to match the HCs and DDCs
   //
-  // HCs are first, followed by DDCs.
-  //
-  // Go through all the HCs
-  for (int icage = 0; icage < numHC; icage++) {
-    // Match against a perfect HC
-    tum3::shapeMatchHC(yCloud, refPntsHC, cageList[icage], ringsOneType, nList,
-                       &quat, &rmsd);
-    // Update the vector of quaternions
-    quatList.push_back(quat);
-    // Update the RMSD per ring
-    tum3::updateRMSDatom(ringsOneType, cageList[icage], rmsd, &rmsdPerAtom,
-                         &noOfCommonElements, atomTypes);
-  } // end of looping through all HCs
-  // --------------------------------------------------
-  // Go through all the DDCs
-  for (int icage = numHC; icage < cageList.size(); icage++) {
-    // Match against a perfect DDC
-    tum3::shapeMatchDDC(yCloud, refPntsDDC, cageList, icage, ringsOneType,
-                        &quat, &rmsd);
-    // Update the vector of quaternions
-    quatList.push_back(quat);
-    // Update the RMSD per ring
-    tum3::updateRMSDatom(ringsOneType, cageList[icage], rmsd, &rmsdPerAtom,
-                         &noOfCommonElements, atomTypes);
-  } // end of looping through all HCs
+  // HCs are first, followed by DDCs. The cages are shape-matched on
+  // match::threads() threads, into a quaternion and RMSD per cage
+  //
+  // Bonds between atoms, for ordering the basal rings of every HC
+  nneigh::Adjacency bonded(nList);
+  std::vector<std::vector<double>> cageQuat(cageList.size());
+  std::vector<double> cageRMSD(cageList.size());
+  match::parallelFor(cageList.size(), [&](int icage) {
+    if (icage < numHC) {
+      // Match against a perfect HC
+      tum3::shapeMatchHC(yCloud, refPntsHC, cageList[icage], ringsOneType,
+                         bonded, &cageQuat[icage], &cageRMSD[icage]);
+    } // HC
+    else {
+      // Match against a perfect DDC
+      tum3::shapeMatchDDC(yCloud, refPntsDDC, cageList, icage, ringsOneType,
+                          &cageQuat[icage], &cageRMSD[icage]);
+    } // DDC
+  });
+  // Update the vector of quaternions and the RMSD per atom, in the order of
+  // the cages, so that the sums do not depend on the number of threads
+  for (int icage = 0; icage < cageList.size(); icage++) {
+    quatList.push_back(cageQuat[icage]);
+    tum3::updateRMSDatom(ringsOneType, cageList[icage], cageRMSD[icage],
+                         &rmsdPerAtom, &noOfCommonElements, atomTypes);
+  } // end of looping through all cages
 
   // --------------------------------------------------
   // Getting the RMSD per atom
@@ -190,6 +195,10 @@ int tum3::topoUnitMatchingBulk(
   tum3::averageRMSDatom(&rmsdPerAtom, &noOfCommonElements);
   // --------------------------------------------------
 
+  // Save the rings to the binary trajectory, if there is one
+  if (sbin::isEnabled()) {
+    sbin::recordRings(yCloud, rings.toVector());
+  }
   // Print out the lammps data file with the bonds and types
   sout::writeLAMMPSdataTopoBulk(yCloud, nList, atomTypes, path);
   // To output the bonds between dummy atoms, uncomment the following line
@@ -235,6 +244,21 @@ int tum3::topoUnitMatchingBulk(
   return 0;
 }
 
+/**
+ * @details Sorts the rings (of all sizes) into a ring::RingsBySize, and runs
+ * topological unit matching on it. This is the version registered in Lua, for
+ * scripts which pass the rings as a vector of vectors.
+ */
+int tum3::topoUnitMatchingBulk(
+    std::string path, const std::vector<std::vector<int>> &rings,
+    const std::vector<std::vector<int>> &nList,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int firstFrame,
+    bool printClusters, bool onlyTetrahedral) {
+  return tum3::topoUnitMatchingBulk(path, ring::RingsBySize(rings), nList,
+                                    yCloud, firstFrame, printClusters,
+                                    onlyTetrahedral);
+}
+
 // Shape-matching for an HC
 /**
  * @details Match the input cage with a perfect HC.
@@ -250,8 +274,8 @@ int tum3::topoUnitMatchingBulk(
  */
 int tum3::shapeMatchHC(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    const Eigen::MatrixXd &refPoints, cage::Cage cageUnit,
-    std::vector<std::vector<int>> rings, std::vector<std::vector<int>> nList,
+    const Eigen::MatrixXd &refPoints, const cage::Cage &cageUnit,
+    const std::vector<std::vector<int>> &rings, const nneigh::Adjacency &bonded,
     std::vector<double> *quat, double *rmsd) {
   //
   int iring,
@@ -277,7 +301,7 @@ int tum3::shapeMatchHC(
   //
   // ----------------
   // Re-order the basal rings so that they are matched
-  pntToPnt::relOrderHC(yCloud, rings[iring], rings[jring], nList, &basal1,
+  pntToPnt::relOrderHC(yCloud, rings[iring], rings[jring], bonded, &basal1,
                        &basal2);
   // ----------------
   // Loop through all possible permutations
@@ -322,8 +346,8 @@ int tum3::shapeMatchHC(
  */
 int tum3::shapeMatchDDC(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    const Eigen::MatrixXd &refPoints, std::vector<cage::Cage> cageList,
-    int cageIndex, std::vector<std::vector<int>> rings,
+    const Eigen::MatrixXd &refPoints, const std::vector<cage::Cage> &cageList,
+    int cageIndex, const std::vector<std::vector<int>> &rings,
     std::vector<double> *quat, double *rmsd) {
   //
   std::vector<int> ddcOrder;             // Connectivity of the DDC
@@ -419,8 +443,9 @@ Eigen::MatrixXd tum3::buildRefHC(std::string fileName) {
   // Get the re-ordered matched basal rings, ordered with respect to each
   // other
 
-  pntToPnt::relOrderHC(&setCloud, rings[iring], rings[jring], nList,
-                       &matchedBasal1, &matchedBasal2);
+  pntToPnt::relOrderHC(&setCloud, rings[iring], rings[jring],
+                       nneigh::Adjacency(nList), &matchedBasal1,
+                       &matchedBasal2);
   // Get the reference point set
   refPnts =
       pntToPnt::changeHexCageOrder(&setCloud, matchedBasal1, matchedBasal2, 0);
@@ -483,11 +508,11 @@ Eigen::MatrixXd tum3::buildRefDDC(std::string fileName) {
  * used for averaging the RMSD per atom depending on the number of cages that
  * share that particular ring.
  */
-int tum3::updateRMSDatom(std::vector<std::vector<int>> rings,
-                         cage::Cage cageUnit, double rmsd,
+int tum3::updateRMSDatom(const std::vector<std::vector<int>> &rings,
+                         const cage::Cage &cageUnit, double rmsd,
                          std::vector<double> *rmsdPerAtom,
                          std::vector<int> *noOfCommonAtoms,
-                         std::vector<cage::iceType> atomTypes) {
+                         const std::vector<cage::iceType> &atomTypes) {
   //
   int nRings = cageUnit.rings.size(); // Number of rings in the current cage
   int iring; // Index according to the rings vector of vector, for the current
@@ -638,99 +663,134 @@ std::vector<cage::Cage> tum3::topoBulkCriteria(
 //
 // -----------------------------------------------------------------
 /**
- * @details  Groups cages into clusters and prints out each cluster into an XYZ
- * file
+ * @details Finds the cluster of every cage. Two cages are in the same cluster
+ * if they are of the same type and share a ring (directly, or through other
+ * cages of the cluster).
+ *
+ * An inverted index from each ring to the cages containing it gives the
+ * adjacent cages directly, and the clusters are the connected components,
+ * found with a union-find (disjoint-set) structure. Clusters are numbered
+ * from 0 in the order of their lowest cage index. Cages which do not share a
+ * ring with any other cage of the same type get a cluster ID of -1.
+ * @param[in] cageList The cages
+ * @param[in] nCages The number of cages (numHC + numDDC)
+ * @param[in] nRings The number of rings the cages are made of
  */
-int tum3::clusterCages(
-    molSys::PointCloud<molSys::Point<double>, double> *yCloud, std::string path,
-    std::vector<std::vector<int>> rings, std::vector<cage::Cage> cageList,
-    int numHC, int numDDC) {
+std::vector<int> tum3::cageClusterIDs(const std::vector<cage::Cage> &cageList,
+                                      int nCages, int nRings) {
   //
-  std::vector<int> linkedList; // Linked list for the clustered cages
-  int nCages = numHC + numDDC; // Number of cages in total
-  int j, temp;                 // Variables used inside the loops
-  bool isNeighbour; // true if cages are adjacent to each other, false otherwise
-  std::vector<bool>
-      visited; // To make sure you don't go through the same cages again.
-  int singleDDCs, singleHCs; // Number of single DDCs and HCs
-  // Units are in Angstrom^3
-  double volDDC = 72.7;          // The calculated alpha volume of a single DDC
-  double volHC = 40.63;          // The calculated alpha volume of a single HC
-  int nextElement;               // value in list
-  int index;                     // starting index value
-  int currentIndex;              // Current cage index
-  int iClusterNumber;            // Number in the current cluster
-  std::vector<int> nClusters;    // Number of cages in each cluster
-  std::vector<int> clusterCages; // Indices of each cage in the cluster
-  std::vector<int> atoms; // Vector containing the atom indices of all the
-                          // atoms in the cages
-  cage::cageType type;    // Type of the cages in the cluster
+  std::vector<int> parent(nCages); // Union-find parent of each cage
+  std::vector<int> cageClusterID(nCages, -1); // Cluster of each cage
+  int nClusters = 0;                          // Number of clusters
   // -----------------------------------------------------------
   // INITIALIZATION
-  linkedList.resize(nCages); // init to dummy value
-  // Initial values of the list.
   for (int icage = 0; icage < nCages; icage++) {
-    // Assign the index as the ID
-    linkedList[icage] = icage; // Index
-  }                            // init of cluster IDs
+    parent[icage] = icage;
+  } // init of the union-find forest
+  // Root of the tree containing a cage (with path halving)
+  auto findRoot = [&parent](int icage) {
+    while (parent[icage] != icage) {
+      parent[icage] = parent[parent[icage]];
+      icage = parent[icage];
+    }
+    return icage;
+  };
+  // -----------------------------------------------------------
+  // RING -> CAGE INDEX
+  // Compressed lists of the cages containing each ring
+  std::vector<int> ringOffsets(nRings + 1, 0);
+  for (int icage = 0; icage < nCages; icage++) {
+    for (int iring : cageList[icage].rings) {
+      ringOffsets[iring + 1]++;
+    }
+  }
+  for (int iring = 0; iring < nRings; iring++) {
+    ringOffsets[iring + 1] += ringOffsets[iring];
+  }
+  std::vector<int> ringCages(ringOffsets[nRings]);
+  std::vector<int> fill(ringOffsets.begin(), ringOffsets.end() - 1);
+  for (int icage = 0; icage < nCages; icage++) {
+    for (int iring : cageList[icage].rings) {
+      ringCages[fill[iring]++] = icage;
+    }
+  } // end of filling the ring -> cage index
+  // -----------------------------------------------------------
+  // CONNECTED COMPONENTS
+  // Join every cage sharing a ring with the first cage of the same type which
+  // contains that ring
+  for (int iring = 0; iring < nRings; iring++) {
+    int firstHC = -1, firstDDC = -1;
+    for (int p = ringOffsets[iring]; p < ringOffsets[iring + 1]; p++) {
+      int icage = ringCages[p];
+      int &first =
+          cageList[icage].type == cage::DoubleDiaC ? firstDDC : firstHC;
+      if (first < 0) {
+        first = icage;
+        continue;
+      }
+      int rootA = findRoot(first);
+      int rootB = findRoot(icage);
+      if (rootA != rootB) {
+        // The lower index becomes the root
+        parent[std::max(rootA, rootB)] = std::min(rootA, rootB);
+      }
+    } // end of loop through cages containing iring
+  }   // end of loop through rings
   // -----------------------------------------------------------
-  // GETTING THE LINKED LIST
+  // NUMBER THE CLUSTERS
   //
-  // HCs first
-  for (int i = 0; i < nCages - 1; i++) {
-    // If iatom is already in a cluster, skip it
-    if (linkedList[i] != i) {
+  // Size of each component, by root
+  std::vector<int> componentSize(nCages, 0);
+  for (int icage = 0; icage < nCages; icage++) {
+    componentSize[findRoot(icage)]++;
+  }
+  for (int icage = 0; icage < nCages; icage++) {
+    int root = findRoot(icage);
+    // If only one cage is in the cluster
+    if (componentSize[root] == 1) {
       continue;
-    } // Already part of a cluster
-    //
-    j = i; // Init of j
-    // Execute the next part of the loop while j is not equal to i
-    do {
-      //
-      // Go through the rest of the atoms (KLOOP)
-      for (int k = i + 1; k < nCages; k++) {
-        // Skip if already part of a cluster
-        if (linkedList[k] != k) {
-          continue;
-        } // Already part of a cluster
-        //
-        // k and j must be of the same type
-        if (cageList[k].type != cageList[j].type) {
-          continue;
-        } // skip if k and j are not of the same type
-        // Check to see if k is a nearest neighbour of j
-        isNeighbour =
-            ring::hasCommonElements(cageList[k].rings, cageList[j].rings);
-        if (isNeighbour) {
-          // Swap!
-          temp = linkedList[j];
-          linkedList[j] = linkedList[k];
-          linkedList[k] = temp;
-        } // j and k are neighbouring cages
-      }   // end of loop through k (KLOOP)
-      //
-      j = linkedList[j];
-    } while (j != i); // end of control for j!=i
-  } // end of getting the linked list (looping through every i)
-  // -----------------------------------------------------------
-  // WRITE-OUTS
+    } // cluster has only one cage
+    // The root is the lowest cage index of the cluster, so clusters are
+    // numbered in order of their first cage
+    if (root == icage) {
+      cageClusterID[icage] = nClusters++;
+    } else {
+      cageClusterID[icage] = cageClusterID[root];
+    }
+  } // end of numbering the clusters
+
+  return cageClusterID;
+}
+
+/**
+ * @details  Groups cages into clusters (with tum3::cageClusterIDs) and prints
+ * out each cluster into an XYZ file. Single cages are only counted. The atoms
+ * of every cluster are collected in a single pass over the cages, and all the
+ * clusters are written out together.
+ */
+int tum3::clusterCages(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, std::string path,
+    const std::vector<std::vector<int>> &rings,
+    const std::vector<cage::Cage> &cageList, int numHC, int numDDC) {
   //
-  // init
-  visited.resize(nCages);
+  int nCages = numHC + numDDC; // Number of cages in total
+  int singleDDCs, singleHCs;   // Number of single DDCs and HCs
+  // Units are in Angstrom^3
+  double volDDC = 72.7; // The calculated alpha volume of a single DDC
+  double volHC = 40.63; // The calculated alpha volume of a single HC
+  std::vector<int> cageClusterID; // Cluster of each cage
+  std::vector<std::vector<int>> clusterAtoms; // Atom indices of each cluster
+  std::vector<cage::cageType> clusterTypes;   // Type of each cluster
+  // -----------------------------------------------------------
+  // CLUSTERS
+  cageClusterID = tum3::cageClusterIDs(cageList, nCages, rings.size());
   singleDDCs = 0;
   singleHCs = 0;
-
-  for (int i = 0; i < nCages; i++) {
-    //
-    if (visited[i]) {
-      continue;
-    } // Already counted
-    // Now that the cage has been visited, set it to true
-    visited[i] = true; // Visited
-    // If only one cage is in the cluster
-    if (linkedList[i] == i) {
+  for (int icage = 0; icage < nCages; icage++) {
+    int clusterID = cageClusterID[icage];
+    if (clusterID < 0) {
       // Add to the number of single DDCs
-      if (cageList[i].type == cage::DoubleDiaC) {
+      if (cageList[icage].type == cage::DoubleDiaC) {
         singleDDCs++;
       } // add to the single DDCs
       else {
@@ -738,57 +798,53 @@ int tum3::clusterCages(
       } // single HCs
       continue;
     } // cluster has only one cage
-    //
-    // init
-    clusterCages.resize(0);
-    //
-    type = cageList[i].type;
-    currentIndex = i;
-    nextElement = linkedList[currentIndex];
-    index = i;
-    iClusterNumber = 1;        // at least one value
-    clusterCages.push_back(i); // Add the first cage
-    // Get the other cages in the cluster
-    while (nextElement != index) {
-      iClusterNumber++;
-      currentIndex = nextElement;
-      visited[currentIndex] = true;
-      clusterCages.push_back(currentIndex); // Add the first cage
-      nextElement = linkedList[currentIndex];
-    } // get number
-    // Update the number of molecules in the cluster
-    nClusters.push_back(iClusterNumber);
-    // --------------
-    // PRINT OUT
-    atoms = tum3::atomsFromCages(rings, cageList, clusterCages);
-    int clusterID = nClusters.size();
-    // Write out the cluster
-    sout::writeXYZcluster(path, yCloud, atoms, clusterID, type);
-    // Print out the cages into an XYZ file
-    // --------------
-  } // end of loop through
+    if (clusterID == clusterAtoms.size()) {
+      clusterAtoms.emplace_back();
+      clusterTypes.push_back(cageList[icage].type);
+    } // first cage of a new cluster
+  } // end of counting the clusters
+  // -----------------------------------------------------------
+  // ATOMS IN EACH CLUSTER
+  for (int icage = 0; icage < nCages; icage++) {
+    int clusterID = cageClusterID[icage];
+    if (clusterID < 0) {
+      continue;
+    } // single cage
+    for (int iring : cageList[icage].rings) {
+      clusterAtoms[clusterID].insert(clusterAtoms[clusterID].end(),
+                                     rings[iring].begin(), rings[iring].end());
+    } // loop through every ring in the current cage
+  }   // end of loop through all cages
+  // Duplicate atoms (shared by rings or cages) must be removed. The atoms are
+  // listed in the order of the trajectory, even if they have been reordered
+  std::vector<int> position = molSys::filePositions(yCloud);
+  for (auto &atoms : clusterAtoms) {
+    std::sort(atoms.begin(), atoms.end(), [&position](int iatom, int jatom) {
+      return position[iatom] < position[jatom];
+    });
+    atoms.erase(std::unique(atoms.begin(), atoms.end()), atoms.end());
+  } // end of removing duplicates
+  // -----------------------------------------------------------
+  // WRITE-OUTS
+  // Cluster IDs in the files start from 1
+  sout::writeXYZclusters(path, yCloud, clusterAtoms, clusterTypes);
   // -----------------------------------------------------------
   // Write out the stuff for single cages
   // ----------------
-  std::ofstream outputFile;
   // Make the output directory if it doesn't exist
-  sout::makePath(path);
-  std::string outputDirName = path + "bulkTopo";
-  sout::makePath(outputDirName);
-  outputDirName = path + "bulkTopo/clusterXYZ/";
-  sout::makePath(outputDirName);
-  outputDirName = path + "bulkTopo/clusterXYZ/frame-" +
-                  std::to_string(yCloud->currentFrame);
-  sout::makePath(outputDirName);
+  std::string outputDirName = path + "bulkTopo/clusterXYZ/frame-" +
+                              std::to_string(yCloud->currentFrame);
+  sout::ensurePath(path);
+  sout::ensurePath(path + "bulkTopo");
+  sout::ensurePath(path + "bulkTopo/clusterXYZ/");
+  sout::ensurePath(outputDirName);
   // ----------------
   // Write output to file inside the output directory
-  outputFile.open(path + "bulkTopo/clusterXYZ/frame-" +
-                  std::to_string(yCloud->currentFrame) + "/info.dat");
-  outputFile << "# volDDC volHC in Angstrom^3\n";
-  outputFile << singleDDCs * volDDC << " " << singleHCs * volHC << "\n";
-  outputFile << "There are " << singleDDCs << " single DDCs\n";
-  outputFile << "There are " << singleHCs << " single HCs\n";
-  outputFile.close(); // Close the file
+  sout::OutputSink outputFile(outputDirName + "/info.dat");
+  outputFile.print("# volDDC volHC in Angstrom^3\n");
+  outputFile.print("{:g} {:g}\n", singleDDCs * volDDC, singleHCs * volHC);
+  outputFile.print("There are {} single DDCs\n", singleDDCs);
+  outputFile.print("There are {} single HCs\n", singleHCs);
   // -----------------------------------------------------------
   return 0;
 } // end of the function
@@ -798,9 +854,10 @@ int tum3::clusterCages(
  of all the atoms in a cluster of cages, according to the input cageList vector
  of Cages
  ***********************************************/
-std::vector<int> tum3::atomsFromCages(std::vector<std::vector<int>> rings,
-                                      std::vector<cage::Cage> cageList,
-                                      std::vector<int> clusterCages) {
+std::vector<int>
+tum3::atomsFromCages(const std::vector<std::vector<int>> &rings,
+                     const std::vector<cage::Cage> &cageList,
+                     const std::vector<int> &clusterCages) {
   //
   std::vector<int> atoms; // Contains the atom indices (not IDs) of atoms
   int ringSize = rings[0].size(); // Number of nodes in each ring
@@ -13,6 +13,7 @@
 //-----------------------------------------------------------------------------------
 
 #include <cluster.hpp>
+#include <profiling.hpp>
 #include <iostream>
 
 namespace bg = boost::geometry;
@@ -153,6 +154,20 @@ int clump::largestIceCluster(
     (*nClusters).push_back(iClusterNumber);
   } // end of loop through
   // -----------------------------------------------------------
+  // Save the cluster each atom belongs to in the binary trajectory, if there is
+  // one. Clusters are numbered in the order of startingIndex
+  if (sbin::isEnabled()) {
+    std::vector<int> atomCluster(yCloud->nop, -1);
+    for (int iCluster = 0; iCluster < startingIndex.size(); iCluster++) {
+      currentIndex = startingIndex[iCluster];
+      do {
+        atomCluster[currentIndex] = iCluster;
+        currentIndex = linkedList[currentIndex];
+      } while (currentIndex != startingIndex[iCluster]);
+    } // end of loop through clusters
+    sbin::recordClusterIDs(yCloud, atomCluster);
+  }
+  // -----------------------------------------------------------
   // Get the largest cluster and save the atoms to the iceCloud pointCloud
   nLargestCluster = *std::max_element((*nClusters).begin(), (*nClusters).end());
   int lClusIndex = distance(
@@ -313,9 +328,10 @@ int clump::clusterAnalysis(
     std::string path,
     molSys::PointCloud<molSys::Point<double>, double> *iceCloud,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<std::vector<int>> nList,
+    const std::vector<std::vector<int>> &nList,
     std::vector<std::vector<int>> &iceNeighbourList, double cutoff,
     int firstFrame, std::string bopAnalysis) {
+  sprof::StageTimer timer("cluster");
   //
   std::vector<bool> isIce;    // For every particle in yCloud, has a value
   int nTotalIce;              // Total number of ice-like molecules
@@ -357,9 +373,9 @@ int clump::clusterAnalysis(
   // Q6
   if (bopAnalysis == "chill") {
     //
-    *yCloud = chill::getCorrel(yCloud, nList, false);
+    chill::getCorrel(yCloud, nList, false);
     // Get the ice types
-    *yCloud = chill::getIceTypeNoPrint(yCloud, nList, false);
+    chill::getIceTypeNoPrint(yCloud, nList, false);
     // Assign values to isIce according to the CHILL algorithm
     for (int iatom = 0; iatom < yCloud->nop; iatom++) {
       // If it is an ice-like molecule, add it, otherwise skip
@@ -397,7 +413,7 @@ int clump::clusterAnalysis(
  */
 int clump::recenterClusterCloud(
     molSys::PointCloud<molSys::Point<double>, double> *iceCloud,
-    std::vector<std::vector<int>> nList) {
+    const std::vector<std::vector<int>> &nList) {
   //
   int dim = 3; // Dimensions
   std::vector<double> box = iceCloud->box;
@@ -0,0 +1,709 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <zlib.h>
+#ifdef DSEAMS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include <compressed_input.hpp>
+
+namespace {
+
+// Size of the blocks handed over by the decompression thread
+const std::size_t chunkSize = 1 << 18;
+// Number of blocks the decompression thread may get ahead of the reader
+const std::size_t maxChunksAhead = 2;
+// Amount of decompressed text between two access points
+const std::int64_t accessSpan = std::int64_t(4) << 20;
+// Size of the deflate history needed to restart inside a gzip member
+const std::size_t windowSize = 32768;
+// Size of the reads from the compressed file
+const std::size_t inputSize = 1 << 18;
+
+// -----------------
+// Index
+
+// A point from which decompression can be restarted
+struct AccessPoint {
+  std::int64_t in = 0;  // Offset in the compressed file
+  std::int64_t out = 0; // Offset in the decompressed text
+  int bits = 0; // gzip: bits of the byte before in which are still to be read
+  std::vector<unsigned char> window; // gzip: the last 32 KB of output
+};
+
+// Access points and frame offsets of a compressed file. Found once per file,
+// and kept while the file is unchanged
+struct CompressedIndex {
+  sinp::Compression method = sinp::Compression::none;
+  std::uintmax_t fileSize = 0;            // Size when the index was built
+  std::time_t modified = 0;               // Modification time, likewise
+  std::vector<AccessPoint> points;        // In order of increasing offset
+  std::vector<std::int64_t> frameOffsets; // Start of every ITEM: TIMESTEP line
+};
+
+struct IndexRegistry {
+  std::unordered_map<std::string, std::shared_ptr<const CompressedIndex>>
+      indices;
+  std::mutex mtx;
+};
+
+IndexRegistry &registry() {
+  static IndexRegistry reg;
+  return reg;
+}
+
+bool isBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Finds the lines whose first two words are "ITEM:" and "TIMESTEP", which is
+// how the LAMMPS readers find the start of a frame, in text handed over one
+// block at a time
+class TimestepScanner {
+public:
+  void scan(const char *text, std::size_t n, std::int64_t offset,
+            std::vector<std::int64_t> &found) {
+    static const char item[] = "ITEM:";
+    static const char timestep[] = "TIMESTEP";
+    std::size_t i = 0;
+    while (i < n) {
+      char c = text[i];
+      if (state == skip) {
+        const void *eol = std::memchr(text + i, '\n', n - i);
+        if (eol == nullptr) {
+          return;
+        }
+        i = static_cast<const char *>(eol) - text;
+        c = '\n';
+      }
+      if (c == '\n') {
+        if (state == end) {
+          found.push_back(lineStart);
+        }
+        state = lead;
+        lineStart = offset + i + 1;
+        i++;
+        continue;
+      }
+      // Matching the start of the line, one character at a time
+      switch (state) {
+      case lead:
+        if (!isBlank(c)) {
+          state = c == item[0] ? inItem : skip;
+          matched = 1;
+        }
+        break;
+      case inItem:
+        if (c != item[matched]) {
+          state = skip;
+        } else if (++matched == 5) {
+          state = afterItem;
+        }
+        break;
+      case afterItem:
+        state = isBlank(c) ? gap : skip;
+        break;
+      case gap:
+        if (!isBlank(c)) {
+          state = c == timestep[0] ? inTimestep : skip;
+          matched = 1;
+        }
+        break;
+      case inTimestep:
+        if (c != timestep[matched]) {
+          state = skip;
+        } else if (++matched == 8) {
+          state = end;
+        }
+        break;
+      case end:
+        if (isBlank(c)) {
+          found.push_back(lineStart);
+        }
+        state = skip;
+        break;
+      case skip:
+        break;
+      }
+      i++;
+    } // end of loop through the text
+  }
+
+private:
+  enum State { lead, inItem, afterItem, gap, inTimestep, end, skip };
+  State state = lead;
+  int matched = 0;
+  std::int64_t lineStart = 0;
+};
+
+// -----------------
+// Decoders
+
+class Decoder {
+public:
+  virtual ~Decoder() = default;
+  // Decompresses up to n bytes into out. Fewer bytes are returned only at the
+  // end of the file (or after an error)
+  virtual std::size_t read(char *out, std::size_t n) = 0;
+};
+
+// Decompresses gzip files, including files made up of several members.
+// Decompression starts either at the start of the file, or at an access
+// point. If index is given, access points are added to it on the way
+class GzipDecoder : public Decoder {
+public:
+  GzipDecoder(const std::string &filename, const AccessPoint *start,
+              CompressedIndex *index)
+      : filename(filename), input(inputSize), index(index) {
+    file.open(filename, std::ios::binary);
+    if (!file) {
+      std::cerr << "Could not open " << filename << ".\n";
+      done = true;
+    }
+    if (start == nullptr) {
+      // Automatic detection of the gzip (or zlib) header
+      inflateInit2(&strm, 15 + 32);
+    } else {
+      // Raw deflate data, primed with the bits and history before the point
+      inflateInit2(&strm, -15);
+      raw = true;
+      betweenMembers = false;
+      bufferOffset = start->in - (start->bits ? 1 : 0);
+      file.seekg(bufferOffset);
+      if (start->bits) {
+        int c = file.get();
+        bufferOffset++;
+        inflatePrime(&strm, start->bits, c >> (8 - start->bits));
+      }
+      inflateSetDictionary(&strm, start->window.data(), start->window.size());
+      outTotal = start->out;
+    }
+    if (index != nullptr) {
+      window.resize(windowSize);
+    }
+  }
+
+  ~GzipDecoder() override { inflateEnd(&strm); }
+
+  std::size_t read(char *out, std::size_t n) override {
+    strm.next_out = reinterpret_cast<unsigned char *>(out);
+    strm.avail_out = n;
+    while (strm.avail_out > 0 && !done) {
+      if (strm.avail_in == 0 && !refill()) {
+        if (!betweenMembers) {
+          std::cerr << filename << " ends in the middle of its gzip data.\n";
+        }
+        done = true;
+        break;
+      }
+      // Skip the rest of a member trailer after raw deflate data
+      if (trailerLeft > 0) {
+        std::size_t k = std::min<std::size_t>(trailerLeft, strm.avail_in);
+        strm.next_in += k;
+        strm.avail_in -= k;
+        trailerLeft -= k;
+        continue;
+      }
+      unsigned char *before = strm.next_out;
+      int ret = inflate(&strm, Z_BLOCK);
+      std::size_t produced = strm.next_out - before;
+      if (produced > 0) {
+        betweenMembers = false;
+        outTotal += produced;
+        if (index != nullptr) {
+          remember(before, produced);
+        }
+      }
+      if (ret == Z_STREAM_END) {
+        // The next member (if any) starts with a gzip header of its own
+        if (raw) {
+          trailerLeft = 8;
+          inflateReset2(&strm, 15 + 32);
+          raw = false;
+        } else {
+          inflateReset(&strm);
+        }
+        betweenMembers = true;
+        continue;
+      }
+      if ((ret != Z_OK && ret != Z_BUF_ERROR) ||
+          (ret == Z_BUF_ERROR && strm.avail_in > 0)) {
+        // Anything after the last member which is not a gzip header (such
+        // as zero padding) just ends the file
+        if (!betweenMembers || outTotal == 0) {
+          std::cerr << "Could not decompress " << filename << ": "
+                    << (strm.msg != nullptr ? strm.msg : "corrupt data")
+                    << "\n";
+        }
+        done = true;
+        break;
+      }
+      // At the end of a deflate block (but not the last one of a member)
+      if (index != nullptr && (strm.data_type & 128) &&
+          !(strm.data_type & 64) && outTotal - lastPoint > accessSpan) {
+        addPoint();
+      }
+    } // end of loop filling the output
+    return n - strm.avail_out;
+  }
+
+private:
+  bool refill() {
+    bufferOffset += bufferFill;
+    file.read(reinterpret_cast<char *>(input.data()), input.size());
+    bufferFill = file.gcount();
+    strm.next_in = input.data();
+    strm.avail_in = bufferFill;
+    return bufferFill > 0;
+  }
+
+  // Keeps the last 32 KB of output, for the access points
+  void remember(const unsigned char *data, std::size_t n) {
+    if (n > windowSize) {
+      data += n - windowSize;
+      n = windowSize;
+    }
+    while (n > 0) {
+      std::size_t k = std::min(n, windowSize - windowPos);
+      std::memcpy(window.data() + windowPos, data, k);
+      windowPos = (windowPos + k) % windowSize;
+      data += k;
+      n -= k;
+    }
+  }
+
+  void addPoint() {
+    AccessPoint point;
+    point.in = bufferOffset + (strm.next_in - input.data());
+    point.out = outTotal;
+    point.bits = strm.data_type & 7;
+    point.window.reserve(windowSize);
+    point.window.insert(point.window.end(), window.begin() + windowPos,
+                        window.end());
+    point.window.insert(point.window.end(), window.begin(),
+                        window.begin() + windowPos);
+    index->points.push_back(std::move(point));
+    lastPoint = outTotal;
+  }
+
+  std::string filename;
+  std::ifstream file;
+  z_stream strm{};
+  std::vector<unsigned char> input;
+  std::int64_t bufferOffset = 0; // Offset of input[0] in the file
+  std::size_t bufferFill = 0;    // Bytes read into input
+  std::int64_t outTotal = 0;     // Offset of the next output byte
+  int trailerLeft = 0;           // Bytes of a member trailer still to skip
+  bool raw = false;              // Inside raw deflate data
+  bool betweenMembers = true;    // No output since the last member ended
+  bool done = false;
+  // Index being built
+  CompressedIndex *index;
+  std::vector<unsigned char> window;
+  std::size_t windowPos = 0;
+  std::int64_t lastPoint = 0;
+};
+
+#ifdef DSEAMS_WITH_ZSTD
+// Decompresses zstd files. Every zstd frame can be decompressed on its own, so
+// access points are placed at frame boundaries
+class ZstdDecoder : public Decoder {
+public:
+  ZstdDecoder(const std::string &filename, const AccessPoint *start,
+              CompressedIndex *index)
+      : filename(filename), input(ZSTD_DStreamInSize()), index(index) {
+    stream = ZSTD_createDStream();
+    ZSTD_initDStream(stream);
+    file.open(filename, std::ios::binary);
+    if (!file) {
+      std::cerr << "Could not open " << filename << ".\n";
+      done = true;
+    }
+    if (start != nullptr) {
+      bufferOffset = start->in;
+      file.seekg(bufferOffset);
+      outTotal = start->out;
+    }
+    inBuffer = {input.data(), 0, 0};
+  }
+
+  ~ZstdDecoder() override { ZSTD_freeDStream(stream); }
+
+  std::size_t read(char *out, std::size_t n) override {
+    ZSTD_outBuffer outBuffer = {out, n, 0};
+    while (outBuffer.pos < outBuffer.size && !done) {
+      if (inBuffer.pos == inBuffer.size && !refill()) {
+        if (!frameDone) {
+          std::cerr << filename << " ends in the middle of its zstd data.\n";
+        }
+        done = true;
+        break;
+      }
+      std::size_t before = outBuffer.pos;
+      std::size_t ret = ZSTD_decompressStream(stream, &outBuffer, &inBuffer);
+      if (ZSTD_isError(ret)) {
+        std::cerr << "Could not decompress " << filename << ": "
+                  << ZSTD_getErrorName(ret) << "\n";
+        done = true;
+        break;
+      }
+      outTotal += outBuffer.pos - before;
+      frameDone = ret == 0;
+      // At the end of a zstd frame
+      if (frameDone && index != nullptr && outTotal - lastPoint > accessSpan) {
+        AccessPoint point;
+        point.in = bufferOffset + inBuffer.pos;
+        point.out = outTotal;
+        index->points.push_back(std::move(point));
+        lastPoint = outTotal;
+      }
+    } // end of loop filling the output
+    return outBuffer.pos;
+  }
+
+private:
+  bool refill() {
+    bufferOffset += inBuffer.size;
+    file.read(static_cast<char *>(input.data()), input.size());
+    inBuffer = {input.data(), static_cast<std::size_t>(file.gcount()), 0};
+    return inBuffer.size > 0;
+  }
+
+  std::string filename;
+  std::ifstream file;
+  ZSTD_DStream *stream;
+  std::vector<char> input;
+  ZSTD_inBuffer inBuffer;
+  std::int64_t bufferOffset = 0; // Offset of input[0] in the file
+  std::int64_t outTotal = 0;     // Offset of the next output byte
+  bool frameDone = true;         // No output since the last frame ended
+  bool done = false;
+  CompressedIndex *index;
+  std::int64_t lastPoint = 0;
+};
+#endif
+
+std::unique_ptr<Decoder> makeDecoder(const std::string &filename,
+                                     sinp::Compression method,
+                                     const AccessPoint *start,
+                                     CompressedIndex *index) {
+  switch (method) {
+  case sinp::Compression::gzip:
+    return std::make_unique<GzipDecoder>(filename, start, index);
+  case sinp::Compression::zstd:
+#ifdef DSEAMS_WITH_ZSTD
+    return std::make_unique<ZstdDecoder>(filename, start, index);
+#else
+    break;
+#endif
+  case sinp::Compression::none:
+    break;
+  }
+  return nullptr;
+}
+
+// -----------------
+// Streams
+
+// A stream buffer filled by a background thread, which decompresses the file
+// a few blocks ahead of the reader. The first skip bytes are discarded, and
+// the stream ends after limit bytes (unless limit is -1)
+class PipedStreamBuf : public std::streambuf {
+public:
+  PipedStreamBuf(std::unique_ptr<Decoder> decoder, std::int64_t skip,
+                 std::int64_t limit)
+      : decoder(std::move(decoder)), skip(skip), limit(limit) {
+    worker = std::thread(&PipedStreamBuf::run, this);
+  }
+
+  ~PipedStreamBuf() override {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      stop = true;
+    }
+    spaceFree.notify_all();
+    worker.join();
+  }
+
+protected:
+  int_type underflow() override {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    }
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      chunkReady.wait(lock, [this] { return finished || !ready.empty(); });
+      if (ready.empty()) {
+        return traits_type::eof();
+      }
+      if (!current.empty()) {
+        spare.push_back(std::move(current));
+      }
+      current = std::move(ready.front());
+      ready.pop_front();
+    }
+    spaceFree.notify_one();
+    setg(current.data(), current.data(), current.data() + current.size());
+    return traits_type::to_int_type(*gptr());
+  }
+
+private:
+  // Loop run by the decompression thread
+  void run() {
+    while (true) {
+      std::vector<char> chunk;
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (stop) {
+          return;
+        }
+        if (!spare.empty()) {
+          chunk = std::move(spare.back());
+          spare.pop_back();
+        }
+      }
+      chunk.resize(chunkSize);
+      std::size_t n = decoder->read(chunk.data(), chunk.size());
+      if (n == 0) {
+        break;
+      }
+      chunk.resize(n);
+      if (skip > 0) {
+        std::size_t k = std::min<std::int64_t>(skip, n);
+        chunk.erase(chunk.begin(), chunk.begin() + k);
+        skip -= k;
+        if (chunk.empty()) {
+          continue;
+        }
+      }
+      if (limit >= 0) {
+        chunk.resize(std::min<std::int64_t>(limit, chunk.size()));
+        limit -= chunk.size();
+        if (chunk.empty()) {
+          break;
+        }
+      }
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        spaceFree.wait(lock, [this] {
+          return stop || ready.size() < maxChunksAhead;
+        });
+        if (stop) {
+          return;
+        }
+        ready.push_back(std::move(chunk));
+      }
+      chunkReady.notify_one();
+    } // end of loop through the file
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      finished = true;
+    }
+    chunkReady.notify_one();
+  }
+
+  std::unique_ptr<Decoder> decoder;
+  std::int64_t skip;
+  std::int64_t limit;
+  std::deque<std::vector<char>> ready;  // Decompressed, not yet read
+  std::vector<char> current;            // Being read
+  std::vector<std::vector<char>> spare; // Already read, to be refilled
+  std::mutex mtx;
+  std::condition_variable chunkReady, spaceFree;
+  bool finished = false; // The decompression thread reached the end
+  bool stop = false;     // The reader is done with the stream
+  std::thread worker;
+};
+
+class PipedInputStream : public std::istream {
+public:
+  PipedInputStream(std::unique_ptr<Decoder> decoder, std::int64_t skip = 0,
+                   std::int64_t limit = -1)
+      : std::istream(nullptr), buffer(std::move(decoder), skip, limit) {
+    rdbuf(&buffer);
+  }
+
+private:
+  PipedStreamBuf buffer;
+};
+
+// -----------------
+
+// Returns the index of a compressed file, building it (if build is true) when
+// the file is new or has changed
+std::shared_ptr<const CompressedIndex>
+compressedIndex(const std::string &filename, sinp::Compression method,
+                bool build) {
+  namespace fs = boost::filesystem;
+  boost::system::error_code ec;
+  std::uintmax_t fileSize = fs::file_size(filename, ec);
+  if (ec) {
+    return nullptr;
+  }
+  std::time_t modified = fs::last_write_time(filename, ec);
+  IndexRegistry &reg = registry();
+  {
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    auto it = reg.indices.find(filename);
+    if (it != reg.indices.end() && it->second->fileSize == fileSize &&
+        it->second->modified == modified) {
+      return it->second;
+    }
+  }
+  if (!build) {
+    return nullptr;
+  }
+  auto index = std::make_shared<CompressedIndex>();
+  index->method = method;
+  index->fileSize = fileSize;
+  index->modified = modified;
+  // One pass through the whole file, on the decompression thread
+  {
+    PipedInputStream stream(
+        makeDecoder(filename, method, nullptr, index.get()));
+    std::vector<char> text(chunkSize);
+    TimestepScanner scanner;
+    std::int64_t offset = 0;
+    while (stream) {
+      stream.read(text.data(), text.size());
+      std::size_t n = stream.gcount();
+      scanner.scan(text.data(), n, offset, index->frameOffsets);
+      offset += n;
+    }
+  }
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  reg.indices[filename] = index;
+  return index;
+}
+
+} // namespace
+
+/**
+ * @details Decides the compression of a file from its magic number: 1f 8b for
+ * gzip and 28 b5 2f fd for zstd. Files which cannot be opened, or which start
+ * with anything else, are taken to be uncompressed.
+ * @param[in] filename The file
+ * @return The compression method
+ */
+sinp::Compression sinp::compression(const std::string &filename) {
+  std::ifstream file(filename, std::ios::binary);
+  unsigned char magic[4] = {0, 0, 0, 0};
+  file.read(reinterpret_cast<char *>(magic), 4);
+  std::size_t n = file.gcount();
+  if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+    return sinp::Compression::gzip;
+  }
+  if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f &&
+      magic[3] == 0xfd) {
+    return sinp::Compression::zstd;
+  }
+  return sinp::Compression::none;
+}
+
+/**
+ * @details gzip is always supported; zstd only if d-SEAMS was built with it.
+ * @param[in] method The compression method
+ * @return True if files compressed with this method can be read
+ */
+bool sinp::compressionSupported(sinp::Compression method) {
+  if (method == sinp::Compression::zstd) {
+#ifdef DSEAMS_WITH_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  }
+  return true;
+}
+
+/**
+ * @details Opens a file for the text readers. Uncompressed files are opened
+ * as they always were, with an std::ifstream. Compressed files are
+ * decompressed on a background thread while the stream is being read.
+ *
+ * The LAMMPS readers count the frames from the start of the stream. For a
+ * compressed file and targetFrame > 1, the stream instead starts at the
+ * beginning of targetFrame (with decompression restarted at the nearest
+ * access point before it), and framesBefore is set to targetFrame-1. The
+ * index needed for this is built the first time. Once the index exists, the
+ * stream also ends where the next frame starts, so that nothing after
+ * targetFrame is decompressed.
+ * @param[in] filename The file to be read
+ * @param[in] targetFrame The frame about to be read, for LAMMPS trajectories
+ * @param[out] framesBefore Number of frames before the start of the stream
+ *  (may be nullptr)
+ * @return The stream; if the file could not be opened, its failbit is set
+ */
+std::unique_ptr<std::istream> sinp::openInput(std::string filename,
+                                              int targetFrame,
+                                              int *framesBefore) {
+  if (framesBefore != nullptr) {
+    *framesBefore = 0;
+  }
+  sinp::Compression method = sinp::compression(filename);
+  if (method == sinp::Compression::none) {
+    return std::make_unique<std::ifstream>(filename);
+  }
+  if (!sinp::compressionSupported(method)) {
+    std::cerr << filename
+              << " is compressed with zstd, but d-SEAMS was built without "
+                 "zstd support.\n";
+    auto stream = std::make_unique<std::ifstream>();
+    stream->setstate(std::ios::failbit);
+    return stream;
+  }
+  std::shared_ptr<const CompressedIndex> index;
+  if (framesBefore != nullptr && targetFrame >= 1) {
+    index = compressedIndex(filename, method, targetFrame > 1);
+  }
+  if (!index || targetFrame > index->frameOffsets.size()) {
+    return std::make_unique<PipedInputStream>(
+        makeDecoder(filename, method, nullptr, nullptr));
+  }
+  // -----------------
+  // Start from the access point before the frame, if there is one
+  std::int64_t frameOffset = index->frameOffsets[targetFrame - 1];
+  std::int64_t limit = -1;
+  if (targetFrame < index->frameOffsets.size()) {
+    limit = index->frameOffsets[targetFrame] - frameOffset;
+  }
+  auto it = std::upper_bound(index->points.begin(), index->points.end(),
+                             frameOffset,
+                             [](std::int64_t offset, const AccessPoint &point) {
+                               return offset < point.out;
+                             });
+  const AccessPoint *start = nullptr;
+  std::int64_t skip = frameOffset;
+  if (it != index->points.begin()) {
+    start = &(*std::prev(it));
+    skip = frameOffset - start->out;
+  }
+  *framesBefore = targetFrame - 1;
+  // The decoder copies what it needs from the access point, so the index may
+  // be replaced while the stream is read
+  return std::make_unique<PipedInputStream>(
+      makeDecoder(filename, method, start, nullptr), skip, limit);
+}
@@ -0,0 +1,332 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
+
+#include <bond.hpp>
+#include <bop.hpp>
+#include <domain.hpp>
+#include <franzblau.hpp>
+#include <neighbours.hpp>
+#include <profiling.hpp>
+#include <shapeMatch.hpp>
+
+namespace {
+
+using Cloud = molSys::PointCloud<molSys::Point<double>, double>;
+
+// Position along a periodic dimension of length boxLength, wrapped into
+// [0, boxLength)
+double wrapInto(double position, double boxLength) {
+  double wrapped = std::fmod(position, boxLength);
+  return wrapped < 0 ? wrapped + boxLength : wrapped;
+}
+
+// Copies the atoms (by index, in the given order) of yCloud into outCloud
+void copyAtoms(const Cloud *yCloud, const std::vector<int> &atoms,
+               Cloud *outCloud) {
+  *outCloud = molSys::clearPointCloud(outCloud);
+  outCloud->pts.reserve(atoms.size());
+  for (int iatom : atoms) {
+    outCloud->pts.push_back(yCloud->pts[iatom]);
+    outCloud->idIndexMap[yCloud->pts[iatom].atomID] =
+        outCloud->pts.size() - 1;
+  } // end of loop through the atoms
+  outCloud->nop = outCloud->pts.size();
+  outCloud->box = yCloud->box;
+  outCloud->boxLow = yCloud->boxLow;
+  outCloud->currentFrame = yCloud->currentFrame;
+}
+
+} // namespace
+
+/**
+ * @details Returns the width of the halo a subdomain needs so that the given
+ * products of its own atoms come out the same as for the whole frame. This is
+ * the largest reach of any of the products (see the sdom namespace).
+ * @param[in] settings The cutoff radius and maxDepth
+ * @param[in] products The products computed for every frame
+ */
+double sdom::haloWidth(const spipe::Settings &settings,
+                       const std::vector<spipe::Product> &products) {
+  double halo = 0.0;
+  for (auto product : products) {
+    switch (product) {
+    case spipe::Product::neighbours:
+    case spipe::Product::hbonds:
+      halo = std::max(halo, settings.cutoffRadius);
+      break;
+    case spipe::Product::bop:
+      halo = std::max(halo, 2.0 * settings.cutoffRadius);
+      break;
+    case spipe::Product::rings:
+      halo = std::max(halo, settings.cutoffRadius * settings.maxDepth);
+      break;
+    default:
+      break;
+    } // end of switch
+  }   // end of loop through the products
+  return halo;
+}
+
+/**
+ * @details Splits the periodic box into a grid of nDomains[0] x nDomains[1] x
+ * nDomains[2] subdomains of equal size, numbered with z running fastest. Each
+ * atom is owned by the subdomain it lies in (after wrapping it into the box),
+ * and is a halo atom of every other subdomain it is within halo of, along
+ * every dimension. A dimension for which the width of a subdomain plus both
+ * halos is larger than the box is not split.
+ * @param[in] yCloud The frame
+ * @param[in] nDomains Number of subdomains along x, y and z
+ * @param[in] halo Width of the halo around every subdomain
+ * @return The atoms of every subdomain, in ascending order of their index.
+ */
+std::vector<sdom::Domain>
+sdom::decompose(const molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                std::array<int, 3> nDomains, double halo) {
+  std::array<int, 3> n;         // Subdomains along each dimension
+  std::array<double, 3> width;  // Width of the subdomains
+  for (int k = 0; k < 3; k++) {
+    double boxLength = yCloud->box[k];
+    n[k] = std::max(1, nDomains[k]);
+    if (n[k] > 1 && boxLength / n[k] + 2.0 * halo > boxLength) {
+      n[k] = 1;
+    } // the halos would overlap
+    width[k] = boxLength / n[k];
+  } // end of loop through dimensions
+  std::vector<sdom::Domain> domains(n[0] * n[1] * n[2]);
+  //
+  std::array<int, 3> owner;                // Subdomain the atom lies in
+  std::array<std::vector<int>, 3> inside;  // Subdomains which see the atom
+  for (int iatom = 0; iatom < yCloud->pts.size(); iatom++) {
+    std::array<double, 3> position = {yCloud->pts[iatom].x,
+                                      yCloud->pts[iatom].y,
+                                      yCloud->pts[iatom].z};
+    for (int k = 0; k < 3; k++) {
+      inside[k].clear();
+      if (n[k] == 1) {
+        owner[k] = 0;
+        inside[k].push_back(0);
+        continue;
+      } // dimension not split
+      double boxLength = yCloud->box[k];
+      double u = wrapInto(position[k] - yCloud->boxLow[k], boxLength);
+      owner[k] = std::min(static_cast<int>(u / width[k]), n[k] - 1);
+      for (int i = 0; i < n[k]; i++) {
+        // Distance from the lower edge of the halo of subdomain i
+        double t = wrapInto(u - i * width[k] + halo, boxLength);
+        if (t < width[k] + 2.0 * halo) {
+          inside[k].push_back(i);
+        }
+      } // end of loop through subdomains along k
+    }   // end of loop through dimensions
+    for (int ix : inside[0]) {
+      for (int iy : inside[1]) {
+        for (int iz : inside[2]) {
+          sdom::Domain &domain = domains[(ix * n[1] + iy) * n[2] + iz];
+          domain.atoms.push_back(iatom);
+          domain.owned.push_back(ix == owner[0] && iy == owner[1] &&
+                                 iz == owner[2]);
+        }
+      }
+    } // end of loop through the subdomains which see iatom
+  }   // end of loop through atoms
+  return domains;
+}
+
+/**
+ * @details Fills outCloud with the owned and halo atoms of a subdomain, in the
+ * order of Domain::atoms, so that the local index of an atom is its position
+ * in Domain::atoms. The box is that of the whole frame, so distances are
+ * still computed with the periodic boundary conditions.
+ * @param[in] yCloud The frame
+ * @param[in] domain The subdomain
+ * @param[out] outCloud The atoms of the subdomain
+ */
+int sdom::localCloud(
+    const molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    const sdom::Domain &domain,
+    molSys::PointCloud<molSys::Point<double>, double> *outCloud) {
+  copyAtoms(yCloud, domain.atoms, outCloud);
+  return 0;
+}
+
+/**
+ * @details Returns true if more than one subdomain has been requested along
+ * any dimension.
+ * @param[in] settings The settings of the pipeline
+ */
+bool sdom::isDecomposed(const spipe::Settings &settings) {
+  return std::any_of(settings.domains.begin(), settings.domains.end(),
+                     [](int n) { return n > 1; });
+}
+
+/**
+ * @details Computes the neighbour list, hydrogen-bond network, rings and
+ * CHILL+ bond correlations of a frame, whichever of them are in the schedule,
+ * on every subdomain separately (spread over settings.domainThreads
+ * threads, or every hardware thread if it is 0). The products of the atoms (and the rings of the roots) owned by a
+ * subdomain are then copied into data, with the local indices translated back
+ * to indices of the frame. The results are the same as those of the
+ * pipeline without subdomains. The halo atoms get the same neighbour list,
+ * hydrogen bonds and bond correlations as the owned atoms, since the ring
+ * search and the bond correlations of the owned atoms read them, but only the
+ * rows of the owned atoms are kept. The on-disk cache is not used for the
+ * subdomains.
+ * @param[in] settings The cutoff, maxDepth, atom types and subdomains
+ * @param[in] order The products computed for every frame
+ * @param[in] ringSizes The ring sizes to search for (every size up to
+ *  maxDepth if empty)
+ * @param[in, out] data The frame (and its hydrogen atoms), and its products
+ */
+int sdom::computeProducts(const spipe::Settings &settings,
+                          const std::vector<spipe::Product> &order,
+                          const std::vector<int> &ringSizes,
+                          spipe::FrameData &data) {
+  sprof::StageTimer timer("domains");
+  auto scheduled = [&order](spipe::Product product) {
+    return std::find(order.begin(), order.end(), product) != order.end();
+  };
+  // Every product needs the neighbour list
+  if (!scheduled(spipe::Product::neighbours)) {
+    return 0;
+  }
+  bool needHbonds = scheduled(spipe::Product::hbonds);
+  bool needRings = scheduled(spipe::Product::rings);
+  bool needBop = scheduled(spipe::Product::bop);
+  if (data.cloud.box.size() < 3 || data.cloud.boxLow.size() < 3) {
+    std::cerr << "The box of frame " << data.cloud.currentFrame
+              << " is needed to split it into subdomains.\n";
+    return 1;
+  } // error handling
+  int nThreads = settings.domainThreads;
+  if (nThreads <= 0) {
+    nThreads =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  } // every hardware thread
+  std::vector<sdom::Domain> domains = sdom::decompose(
+      &data.cloud, settings.domains, sdom::haloWidth(settings, order));
+  // --------
+  // The hydrogen atoms of every molecule, by index
+  std::unordered_map<int, std::vector<int>> hAtoms;
+  if (needHbonds) {
+    for (int hatom = 0; hatom < data.hCloud.pts.size(); hatom++) {
+      hAtoms[data.hCloud.pts[hatom].molID].push_back(hatom);
+    }
+  } // hydrogen atoms
+  // --------
+  // Products of the whole frame. Every row (and every set of bond
+  // correlations) is written by the subdomain owning the atom
+  int nop = data.cloud.pts.size();
+  data.nList.assign(nop, std::vector<int>());
+  if (needHbonds) {
+    data.hbnList.assign(nop, std::vector<int>());
+  }
+  std::vector<std::vector<molSys::Result>> cij(needBop ? nop : 0);
+  std::vector<std::vector<std::vector<int>>> domainRings(domains.size());
+  //
+  match::parallelFor(
+      domains.size(),
+      [&](int idom) {
+        const sdom::Domain &domain = domains[idom];
+        Cloud cloud; // Atoms of the subdomain
+        sdom::localCloud(&data.cloud, domain, &cloud);
+        std::vector<std::vector<int>> nList = nneigh::neighListO(
+            settings.cutoffRadius, &cloud, settings.oxygenType);
+        std::vector<std::vector<int>> hbnList; // By local index
+        if (needHbonds) {
+          // The hydrogen atoms of the molecules in the subdomain
+          std::vector<int> hIndices;
+          for (auto &point : cloud.pts) {
+            auto it = hAtoms.find(point.molID);
+            if (it != hAtoms.end()) {
+              hIndices.insert(hIndices.end(), it->second.begin(),
+                              it->second.end());
+            }
+          } // end of loop through the molecules
+          std::sort(hIndices.begin(), hIndices.end());
+          hIndices.erase(std::unique(hIndices.begin(), hIndices.end()),
+                         hIndices.end());
+          Cloud hCloud;
+          copyAtoms(&data.hCloud, hIndices, &hCloud);
+          hbnList =
+              bond::populateHbondsWithInputClouds(&cloud, &hCloud, nList);
+          hbnList = nneigh::neighbourListByIndex(&cloud, hbnList);
+        } // hydrogen bonds
+        if (needRings) {
+          sprof::StageTimer ringTimer("rings");
+          // Only the rings whose root is owned by the subdomain
+          domainRings[idom] = primitive::ringNetworkFromRoots(
+              hbnList, settings.maxDepth, domain.owned, ringSizes);
+          for (auto &ring : domainRings[idom]) {
+            for (int &iatom : ring) {
+              iatom = domain.atoms[iatom];
+            }
+          } // end of loop through rings
+        }   // rings
+        if (needBop) {
+          chill::getCorrelPlus(&cloud, nList, settings.isSlice);
+        } // bond correlations
+        // --------
+        // Products of the owned atoms, by index in the frame
+        for (int iatom = 0; iatom < domain.atoms.size(); iatom++) {
+          if (!domain.owned[iatom]) {
+            continue;
+          }
+          int jatom = domain.atoms[iatom];
+          data.nList[jatom] = std::move(nList[iatom]);
+          if (needHbonds) {
+            for (int &katom : hbnList[iatom]) {
+              katom = domain.atoms[katom];
+            }
+            data.hbnList[jatom] = std::move(hbnList[iatom]);
+          } // hydrogen bonds
+          if (needBop) {
+            cij[jatom] = std::move(cloud.pts[iatom].c_ij);
+          } // bond correlations
+        }   // end of loop through the atoms of the subdomain
+      },
+      1, nThreads);
+  // --------
+  // The bond correlations are only copied into the frame now, since the
+  // subdomains read its atoms
+  if (needBop) {
+    for (int iatom = 0; iatom < nop; iatom++) {
+      data.cloud.pts[iatom].c_ij = std::move(cij[iatom]);
+    }
+  } // bond correlations
+  // Rings of all the subdomains, sorted by their root like those of
+  // primitive::ringNetwork
+  if (needRings) {
+    std::vector<std::vector<int>> rings;
+    for (auto &ringsOfDomain : domainRings) {
+      std::move(ringsOfDomain.begin(), ringsOfDomain.end(),
+                std::back_inserter(rings));
+    }
+    std::stable_sort(rings.begin(), rings.end(),
+                     [](const std::vector<int> &a, const std::vector<int> &b) {
+                       return a[0] < b[0];
+                     });
+    sprof::count("rings", rings.size());
+    data.rings = ring::RingsBySize(rings);
+  } // rings
+  sprof::count("domains", domains.size());
+  return 0;
+}
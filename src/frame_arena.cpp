@@ -0,0 +1,145 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#include <algorithm>
+
+#include <frame_arena.hpp>
+#include <profiling.hpp>
+
+namespace {
+
+// The arena of the calling thread
+smem::FrameArena &threadArena() {
+  thread_local smem::FrameArena arena;
+  return arena;
+}
+
+} // namespace
+
+/**
+ * @details Allocates the retained block, and the monotonic resource which
+ * hands it out.
+ * @param[in] initialBytes The size of the block, in bytes
+ */
+smem::FrameArena::FrameArena(std::size_t initialBytes) {
+  heap.allocations = &counters.upstreamAllocations;
+  block.resize(initialBytes);
+  resetBuffer();
+}
+
+/**
+ * @details Hands out the next bytes of the current block, counting the
+ * allocation. The monotonic resource asks the heap for a new block once the
+ * retained one is used up.
+ */
+void *smem::FrameArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  counters.allocations++;
+  counters.bytes += bytes;
+  used += bytes;
+  return arena->allocate(bytes, alignment);
+}
+
+/**
+ * @details Frees everything handed out since the last release. If more
+ * memory than the retained block was needed, the block is enlarged to the
+ * most memory used (plus a quarter), so that the next scope of the same size
+ * fits into it.
+ */
+void smem::FrameArena::release() {
+  counters.releases++;
+  counters.peakBytes = std::max(counters.peakBytes, used);
+  if (used > block.size()) {
+    arena.reset();
+    block.clear();
+    block.shrink_to_fit();
+    block.resize(used + used / 4);
+    resetBuffer();
+  } else {
+    arena->release();
+  }
+  used = 0;
+}
+
+/**
+ * @details Creates the monotonic resource over the retained block.
+ */
+void smem::FrameArena::resetBuffer() {
+  if (block.empty()) {
+    arena = std::make_unique<std::pmr::monotonic_buffer_resource>(&heap);
+  } else {
+    arena = std::make_unique<std::pmr::monotonic_buffer_resource>(
+        block.data(), block.size(), &heap);
+  }
+  counters.capacity = block.size();
+}
+
+/**
+ * @details Allocates a block from the heap, counting it.
+ */
+void *smem::FrameArena::HeapCounter::do_allocate(std::size_t bytes,
+                                                 std::size_t alignment) {
+  (*allocations)++;
+  return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+/**
+ * @details Returns a block to the heap.
+ */
+void smem::FrameArena::HeapCounter::do_deallocate(void *p, std::size_t bytes,
+                                                  std::size_t alignment) {
+  std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+/**
+ * @details Opens a scope on the arena of the calling thread.
+ */
+smem::ScratchScope::ScratchScope() { threadArena().depth++; }
+
+/**
+ * @details Closes the scope. When the outermost scope ends, the arena is
+ * released, and the number of allocations and bytes served since it was
+ * opened are added to the scratch stage of the profiler.
+ */
+smem::ScratchScope::~ScratchScope() {
+  smem::FrameArena &arena = threadArena();
+  if (--arena.depth > 0) {
+    return;
+  }
+  static thread_local smem::ArenaStats before; // Counters at the last release
+  const smem::ArenaStats &now = arena.stats();
+  sprof::count("scratch.allocations", now.allocations - before.allocations);
+  sprof::count("scratch.bytes", now.bytes - before.bytes);
+  sprof::count("scratch.heapBlocks",
+               now.upstreamAllocations - before.upstreamAllocations);
+  arena.release();
+  before = arena.stats();
+}
+
+/**
+ * @details Returns the arena of the calling thread if a smem::ScratchScope is
+ * open on it, and the heap (std::pmr::new_delete_resource) otherwise.
+ */
+std::pmr::memory_resource *smem::scratch() {
+  smem::FrameArena &arena = threadArena();
+  if (arena.depth > 0) {
+    return &arena;
+  }
+  return std::pmr::new_delete_resource();
+}
+
+/**
+ * @details Returns a copy of the counters of the arena of the calling thread.
+ */
+smem::ArenaStats smem::stats() { return threadArena().stats(); }
@@ -0,0 +1,369 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sys/stat.h>
+
+#include <fmt/core.h>
+
+#include <bond.hpp>
+#include <frame_cache.hpp>
+#include <franzblau.hpp>
+#include <neighbours.hpp>
+#include <profiling.hpp>
+#include <seams_output.hpp>
+
+namespace {
+
+// 64-bit FNV-1a hash, fed with the raw bytes of the keyed values
+struct Hasher {
+  std::uint64_t value = 14695981039346656037ull;
+  void addBytes(const void *data, std::size_t nBytes) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < nBytes; i++) {
+      value ^= bytes[i];
+      value *= 1099511628211ull;
+    }
+  }
+  template <typename T> void add(const T &x) { addBytes(&x, sizeof(T)); }
+};
+
+// Directory of the cache (empty if there is no cache)
+struct CacheState {
+  std::mutex mtx;
+  std::string directory;
+};
+
+CacheState &state() {
+  static CacheState cache;
+  return cache;
+}
+
+std::string entryPath(const std::string &directory, const std::string &kind,
+                      std::uint64_t key) {
+  return fmt::format("{}/{}-{:016x}.bin", directory, kind, key);
+}
+
+// Reads the entry for key, or computes (and stores) it
+template <typename Compute>
+std::vector<std::vector<int>> lookup(const std::string &kind,
+                                     std::uint64_t key, Compute &&compute) {
+  std::vector<std::vector<int>> list;
+  if (scache::load(kind, key, &list)) {
+    sprof::count("cache.hits", 1);
+    return list;
+  } // found
+  sprof::count("cache.misses", 1);
+  list = compute();
+  scache::store(kind, key, list);
+  return list;
+}
+
+} // namespace
+
+/**
+ * @details Uses a directory for the cache entries, creating it if it does
+ * not exist. Entries already in the directory (from earlier runs) are reused.
+ * @param[in] directory The cache directory
+ */
+int scache::enable(std::string directory) {
+  while (directory.size() > 1 && directory.back() == '/') {
+    directory.pop_back();
+  } // entries are written to directory/name
+  if (sout::makePath(directory) != 0) {
+    std::cerr << "Could not create the cache directory " << directory
+              << ".\n";
+    return 1;
+  } // error
+  std::lock_guard<std::mutex> lock(state().mtx);
+  state().directory = directory;
+  return 0;
+}
+
+/**
+ * @details Stops using the cache. The entries are left on disk.
+ */
+void scache::disable() {
+  std::lock_guard<std::mutex> lock(state().mtx);
+  state().directory.clear();
+}
+
+/**
+ * @details True if scache::enable has been called (and the cache has not
+ * been disabled since).
+ */
+bool scache::isEnabled() {
+  std::lock_guard<std::mutex> lock(state().mtx);
+  return !state().directory.empty();
+}
+
+/**
+ * @details Hashes the box, and the IDs, types, coordinates and slice flags
+ * of every point, which is everything the neighbour lists and hydrogen bonds
+ * of the PointCloud depend on.
+ * @param[in] yCloud The input PointCloud
+ */
+std::uint64_t scache::hashCloud(
+    const molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  Hasher hasher;
+  hasher.add(yCloud->nop);
+  for (double length : yCloud->box) {
+    hasher.add(length);
+  }
+  for (double low : yCloud->boxLow) {
+    hasher.add(low);
+  }
+  for (auto &pnt : yCloud->pts) {
+    hasher.add(pnt.atomID);
+    hasher.add(pnt.molID);
+    hasher.add(pnt.type);
+    hasher.add(pnt.x);
+    hasher.add(pnt.y);
+    hasher.add(pnt.z);
+    hasher.add(static_cast<unsigned char>(pnt.inSlice));
+  } // end of loop through the points
+  return hasher.value;
+}
+
+/**
+ * @details Hashes the length and values of every row, so that lists with the
+ * same values split differently into rows get different hashes.
+ * @param[in] list The row-ordered list
+ */
+std::uint64_t scache::hashList(const std::vector<std::vector<int>> &list) {
+  Hasher hasher;
+  hasher.add(list.size());
+  for (auto &row : list) {
+    hasher.add(row.size());
+    if (!row.empty()) {
+      hasher.addBytes(row.data(), row.size() * sizeof(int));
+    }
+  } // end of loop through the rows
+  return hasher.value;
+}
+
+/**
+ * @details Identifies a trajectory file by its size, its modification time
+ * and its first 64 KiB, without reading the whole (possibly very large)
+ * file. Returns 0 if the file cannot be read.
+ * @param[in] filename The trajectory file
+ */
+std::uint64_t scache::hashTrajectory(const std::string &filename) {
+  struct stat info;
+  if (stat(filename.c_str(), &info) != 0) {
+    return 0;
+  } // no such file
+  Hasher hasher;
+  hasher.add(static_cast<std::uint64_t>(info.st_size));
+  hasher.add(static_cast<std::int64_t>(info.st_mtime));
+  std::ifstream inpFile(filename, std::ios::binary);
+  std::vector<char> block(1 << 16);
+  inpFile.read(block.data(), block.size());
+  hasher.addBytes(block.data(), inpFile.gcount());
+  return hasher.value;
+}
+
+/**
+ * @details Reads a cache entry. Missing, truncated or corrupted entries (and
+ * entries written for another key or format version) are treated as misses.
+ * @param[in] kind The kind of list (neighbours, hbonds or rings)
+ * @param[in] key The key of the entry
+ * @param[out] list The list read from the entry
+ * @return True if the entry was found and read
+ */
+bool scache::load(const std::string &kind, std::uint64_t key,
+                  std::vector<std::vector<int>> *list) {
+  std::string directory;
+  {
+    std::lock_guard<std::mutex> lock(state().mtx);
+    directory = state().directory;
+  }
+  if (directory.empty()) {
+    return false;
+  } // no cache
+  sprof::StageTimer timer("cache.read");
+  std::ifstream inpFile(entryPath(directory, kind, key), std::ios::binary);
+  if (!inpFile) {
+    return false;
+  } // no entry
+  scache::EntryHeader header;
+  inpFile.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!inpFile || std::memcmp(header.magic, "DSEAMSCA", 8) != 0 ||
+      header.version != scache::formatVersion || header.key != key) {
+    return false;
+  } // not an entry for this key
+  inpFile.seekg(0, std::ios::end);
+  std::uint64_t fileBytes = inpFile.tellg();
+  inpFile.seekg(sizeof(header));
+  if (fileBytes != sizeof(header) +
+                       (header.nRows + 1) * sizeof(std::uint64_t) +
+                       header.nValues * sizeof(std::int32_t)) {
+    return false;
+  } // truncated
+  std::vector<std::uint64_t> offsets(header.nRows + 1);
+  std::vector<std::int32_t> values(header.nValues);
+  inpFile.read(reinterpret_cast<char *>(offsets.data()),
+               offsets.size() * sizeof(std::uint64_t));
+  if (header.nValues > 0) {
+    inpFile.read(reinterpret_cast<char *>(values.data()),
+                 values.size() * sizeof(std::int32_t));
+  }
+  if (!inpFile || offsets.front() != 0 || offsets.back() != header.nValues ||
+      !std::is_sorted(offsets.begin(), offsets.end())) {
+    return false;
+  } // corrupted
+  list->assign(header.nRows, std::vector<int>());
+  for (std::uint64_t irow = 0; irow < header.nRows; irow++) {
+    (*list)[irow].assign(values.begin() + offsets[irow],
+                         values.begin() + offsets[irow + 1]);
+  } // end of loop through the rows
+  return true;
+}
+
+/**
+ * @details Writes a cache entry. The entry is written to a temporary file
+ * first, and then renamed, so that a run which is interrupted (or a second
+ * run using the same cache) never sees a partly written entry.
+ * @param[in] kind The kind of list (neighbours, hbonds or rings)
+ * @param[in] key The key of the entry
+ * @param[in] list The list to be stored
+ */
+int scache::store(const std::string &kind, std::uint64_t key,
+                  const std::vector<std::vector<int>> &list) {
+  std::string directory;
+  {
+    std::lock_guard<std::mutex> lock(state().mtx);
+    directory = state().directory;
+  }
+  if (directory.empty()) {
+    return 1;
+  } // no cache
+  sprof::StageTimer timer("cache.write");
+  // Compressed-row form of the list
+  std::vector<std::uint64_t> offsets(1, 0);
+  std::vector<std::int32_t> values;
+  offsets.reserve(list.size() + 1);
+  for (auto &row : list) {
+    values.insert(values.end(), row.begin(), row.end());
+    offsets.push_back(values.size());
+  } // end of loop through the rows
+  scache::EntryHeader header;
+  std::memcpy(header.magic, "DSEAMSCA", 8);
+  header.version = scache::formatVersion;
+  header.reserved = 0;
+  header.key = key;
+  header.nRows = list.size();
+  header.nValues = values.size();
+  // Write, and then move into place
+  std::string fileName = entryPath(directory, kind, key);
+  std::string tmpName = fileName + ".tmp";
+  {
+    std::ofstream outFile(tmpName, std::ios::binary | std::ios::trunc);
+    outFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    outFile.write(reinterpret_cast<const char *>(offsets.data()),
+                  offsets.size() * sizeof(std::uint64_t));
+    outFile.write(reinterpret_cast<const char *>(values.data()),
+                  values.size() * sizeof(std::int32_t));
+    if (!outFile) {
+      std::cerr << "Could not write the cache entry " << tmpName << ".\n";
+      std::remove(tmpName.c_str());
+      return 1;
+    } // error
+  }
+  if (std::rename(tmpName.c_str(), fileName.c_str()) != 0) {
+    std::cerr << "Could not write the cache entry " << fileName << ".\n";
+    std::remove(tmpName.c_str());
+    return 1;
+  } // error
+  return 0;
+}
+
+/**
+ * @details Returns the same neighbour list as nneigh::neighListO, from the
+ * cache if it has been computed before for the same atoms, cutoff, type and
+ * precision.
+ * @param[in] rcutoff Distance cutoff
+ * @param[in] yCloud The input PointCloud
+ * @param[in] typeI Type ID of the atoms
+ */
+std::vector<std::vector<int>>
+scache::neighListO(double rcutoff,
+                   molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                   int typeI) {
+  if (!scache::isEnabled()) {
+    return nneigh::neighListO(rcutoff, yCloud, typeI);
+  } // no cache
+  Hasher hasher;
+  hasher.add(scache::hashCloud(yCloud));
+  hasher.add(rcutoff);
+  hasher.add(typeI);
+  hasher.add(static_cast<int>(molSys::precision()));
+  return lookup("neighbours", hasher.value, [&]() {
+    return nneigh::neighListO(rcutoff, yCloud, typeI);
+  });
+}
+
+/**
+ * @details Returns the same hydrogen-bond network as bond::populateHbonds,
+ * from the cache if it has been computed before for the same oxygen atoms,
+ * neighbour list, trajectory, frame and hydrogen type.
+ * @param[in] filename Trajectory file, from which the hydrogen atoms are read
+ * @param[in] yCloud The input PointCloud (oxygen atoms)
+ * @param[in] nList Row-ordered neighbour list by atom ID
+ * @param[in] targetFrame The frame of the hydrogen atoms
+ * @param[in] Htype Type ID of the hydrogen atoms
+ */
+std::vector<std::vector<int>>
+scache::populateHbonds(std::string filename,
+                       molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                       const std::vector<std::vector<int>> &nList,
+                       int targetFrame, int Htype) {
+  if (!scache::isEnabled()) {
+    return bond::populateHbonds(filename, yCloud, nList, targetFrame, Htype);
+  } // no cache
+  Hasher hasher;
+  hasher.add(scache::hashTrajectory(filename));
+  hasher.add(scache::hashCloud(yCloud));
+  hasher.add(scache::hashList(nList));
+  hasher.add(targetFrame);
+  hasher.add(Htype);
+  return lookup("hbonds", hasher.value, [&]() {
+    return bond::populateHbonds(filename, yCloud, nList, targetFrame, Htype);
+  });
+}
+
+/**
+ * @details Returns the same rings as primitive::ringNetwork, from the cache
+ * if they have been found before for the same neighbour list and maximum
+ * depth.
+ * @param[in] nList Row-ordered neighbour list by index
+ * @param[in] maxDepth The maximum depth upto which rings will be searched
+ */
+std::vector<std::vector<int>>
+scache::ringNetwork(const std::vector<std::vector<int>> &nList, int maxDepth) {
+  if (!scache::isEnabled()) {
+    return primitive::ringNetwork(nList, maxDepth);
+  } // no cache
+  Hasher hasher;
+  hasher.add(scache::hashList(nList));
+  hasher.add(maxDepth);
+  return lookup("rings", hasher.value,
+                [&]() { return primitive::ringNetwork(nList, maxDepth); });
+}
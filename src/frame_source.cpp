@@ -0,0 +1,207 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <utility>
+
+#include <frame_source.hpp>
+#include <profiling.hpp>
+#include <seams_input.hpp>
+
+namespace {
+
+using Cloud = molSys::PointCloud<molSys::Point<double>, double>;
+
+// Copies the atoms of one type (inside the slice, if isSlice is set) out of
+// a frame with every atom, in the order of the trajectory, and then puts them
+// in the order set with molSys::setAtomOrder, as sinp::readLammpsTrjreduced
+// would
+void copyType(const Cloud &atoms, int type, bool isSlice,
+              const std::array<double, 3> &coordLow,
+              const std::array<double, 3> &coordHigh, Cloud *yCloud) {
+  *yCloud = molSys::clearPointCloud(yCloud);
+  for (int k = 0; k < atoms.pts.size(); k++) {
+    const auto &pnt = atoms.pts[molSys::fileIndex(&atoms, k)];
+    if (pnt.type != type) {
+      continue;
+    }
+    if (isSlice &&
+        !sinp::atomInSlice(pnt.x, pnt.y, pnt.z, coordLow, coordHigh)) {
+      continue;
+    } // outside the slice
+    yCloud->pts.push_back(pnt);
+    yCloud->idIndexMap[pnt.atomID] = yCloud->pts.size() - 1;
+  } // end of loop through the atoms
+  yCloud->nop = yCloud->pts.size();
+  yCloud->box = atoms.box;
+  yCloud->boxLow = atoms.boxLow;
+  yCloud->currentFrame = atoms.currentFrame;
+  molSys::reorderAtoms(yCloud, molSys::atomOrder());
+}
+
+} // namespace
+
+/**
+ * @details Starts the background threads, which begin reading the first depth
+ * frames of the loop straight away.
+ * @param[in] filename The trajectory file
+ * @param[in] firstFrame The first frame of the loop (starting from 1)
+ * @param[in] finalFrame The last frame of the loop (inclusive)
+ * @param[in] frameGap The step between frames
+ * @param[in] reader The sinp reader used for every frame
+ * @param[in] typeI The type ID of the atoms to be read (unless reader is
+ *  FrameReader::allAtoms)
+ * @param[in] isSlice This decides whether a slice will be created or not
+ * @param[in] coordLow Contains the lower limits of the slice, if a slice is to
+ *  be created
+ * @param[in] coordHigh Contains the upper limits of the slice, if a slice is
+ *  to be created
+ * @param[in] depth Number of frames which may be read ahead
+ * @param[in] nThreads Number of background threads reading frames
+ * @param[in] typeJ The type ID of the second kind of atoms, for
+ *  FrameReader::twoTypes
+ */
+sinp::FrameSource::FrameSource(std::string filename, int firstFrame,
+                               int finalFrame, int frameGap,
+                               sinp::FrameReader reader, int typeI,
+                               bool isSlice, std::array<double, 3> coordLow,
+                               std::array<double, 3> coordHigh, int depth,
+                               int nThreads, int typeJ)
+    : filename(filename), firstFrame(firstFrame), frameGap(frameGap),
+      nFrames(0), reader(reader), typeI(typeI), typeJ(typeJ), isSlice(isSlice),
+      coordLow(coordLow), coordHigh(coordHigh) {
+  // Same frames as for frame=firstFrame,finalFrame,frameGap in Lua
+  if (frameGap > 0 && finalFrame >= firstFrame) {
+    nFrames = (finalFrame - firstFrame) / frameGap + 1;
+  } else if (frameGap < 0 && finalFrame <= firstFrame) {
+    nFrames = (firstFrame - finalFrame) / (-frameGap) + 1;
+  }
+  slots.resize(std::max(depth, 1));
+  nThreads = std::max(1, std::min(nThreads, static_cast<int>(slots.size())));
+  for (int i = 0; i < nThreads; i++) {
+    workers.emplace_back(&sinp::FrameSource::run, this);
+  }
+}
+
+/**
+ * @details Stops the background threads. Frames still being read are
+ * finished first, and discarded.
+ */
+sinp::FrameSource::~FrameSource() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop = true;
+  }
+  slotFree.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+/**
+ * @details Swaps the next frame of the loop into yCloud, so that the
+ * PointCloud passed in keeps its address (Lua may hold a reference to it),
+ * and its previous contents are reused for a later frame. Waits for the frame
+ * if it has not been read yet; the time spent waiting is recorded as the
+ * stage "prefetch.wait".
+ * @param[out] yCloud The outputted PointCloud
+ * @param[out] jCloud The atoms of typeJ, for FrameReader::twoTypes (may be
+ *  null otherwise)
+ * @return true if a frame was handed out, false at the end of the loop
+ */
+bool sinp::FrameSource::nextFrame(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    molSys::PointCloud<molSys::Point<double>, double> *jCloud) {
+  sprof::StageTimer timer("prefetch.wait");
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (nConsumed >= nFrames) {
+      return false;
+    }
+    Slot &slot = slots[nConsumed % slots.size()];
+    frameReady.wait(lock,
+                    [&] { return slot.ready && slot.index == nConsumed; });
+    std::swap(*yCloud, slot.cloud);
+    if (jCloud) {
+      std::swap(*jCloud, slot.jCloud);
+    }
+    slot.ready = false;
+    nConsumed++;
+  }
+  slotFree.notify_all();
+  return true;
+}
+
+/**
+ * @details Returns the number of frames handed out by nextFrame so far.
+ */
+int sinp::FrameSource::framesRead() {
+  std::lock_guard<std::mutex> lock(mtx);
+  return nConsumed;
+}
+
+/**
+ * @details Loop run by each background thread. A thread claims the next
+ * frame of the loop once its slot has been handed out, and reads it into the
+ * slot outside the lock. Frame i always goes into slot i % depth, so the
+ * frames are handed out in order even if several threads read them.
+ */
+void sinp::FrameSource::run() {
+  std::unique_lock<std::mutex> lock(mtx);
+  while (true) {
+    slotFree.wait(lock, [this] {
+      return stop || nClaimed >= nFrames ||
+             nClaimed < nConsumed + static_cast<int>(slots.size());
+    });
+    if (stop || nClaimed >= nFrames) {
+      break;
+    }
+    int index = nClaimed++;
+    Slot &slot = slots[index % slots.size()];
+    lock.unlock();
+    // Nobody else touches the slot until it is marked as ready
+    this->readFrame(firstFrame + index * frameGap, &slot);
+    lock.lock();
+    slot.index = index;
+    slot.ready = true;
+    frameReady.notify_all();
+  } // end of loop through the frames
+}
+
+/**
+ * @details Reads one frame with the reader chosen for the loop. With
+ * FrameReader::twoTypes the frame is read only once, with every atom, and the
+ * two kinds of atoms are copied out of it.
+ */
+void sinp::FrameSource::readFrame(int frame, Slot *slot) {
+  molSys::PointCloud<molSys::Point<double>, double> *yCloud = &slot->cloud;
+  switch (reader) {
+  case sinp::FrameReader::allAtoms:
+    sinp::readLammpsTrj(filename, frame, yCloud, isSlice, coordLow, coordHigh);
+    break;
+  case sinp::FrameReader::oneType:
+    sinp::readLammpsTrjO(filename, frame, yCloud, typeI, isSlice, coordLow,
+                         coordHigh);
+    break;
+  case sinp::FrameReader::reduced:
+    sinp::readLammpsTrjreduced(filename, frame, yCloud, typeI, isSlice,
+                               coordLow, coordHigh);
+    break;
+  case sinp::FrameReader::twoTypes:
+    sinp::readLammpsTrj(filename, frame, &slot->atoms);
+    copyType(slot->atoms, typeI, isSlice, coordLow, coordHigh, yCloud);
+    copyType(slot->atoms, typeJ, false, coordLow, coordHigh, &slot->jCloud);
+    break;
+  }
+}
@@ -13,6 +13,7 @@
 //-----------------------------------------------------------------------------------
 
 #include <franzblau.hpp>
+#include <profiling.hpp>
 
 /**
  * @details The vector of vector of rings, by index, is returned, given a
@@ -29,7 +30,11 @@
  * of the ring members.
  */
 std::vector<std::vector<int>>
-primitive::ringNetwork(std::vector<std::vector<int>> nList, int maxDepth) {
+primitive::ringNetwork(const std::vector<std::vector<int>> &nList, int maxDepth) {
+  sprof::StageTimer timer("rings");
+  // The graph and the candidate rings only live until the end of this
+  // function, so they are kept in the scratch arena
+  smem::ScratchScope scope;
   //
   primitive::Graph fullGraph; // Graph object, contains the connectivity
                               // information from the neighbourlist
@@ -39,11 +44,312 @@ primitive::ringNetwork(std::vector<std::vector<int>> nList, int maxDepth) {
   fullGraph = primitive::countAllRingsFromIndex(nList, maxDepth);
 
   // Remove all non-SP rings using the Franzblau algorithm.
-  fullGraph = primitive::removeNonSPrings(&fullGraph);
+  primitive::removeNonSPrings(&fullGraph);
 
+  sprof::count("rings", fullGraph.rings.size());
   // The rings vector of vectors inside the fullGraph graph object is the ring
-  // network information we want
-  return fullGraph.rings;
+  // network information we want (copied out of the arena)
+  std::vector<std::vector<int>> rings;
+  rings.reserve(fullGraph.rings.size());
+  for (auto &ring : fullGraph.rings) {
+    rings.emplace_back(ring.begin(), ring.end());
+  }
+  return rings;
+}
+
+/**
+ * @details Finds the same primitive rings as primitive::ringNetwork, but
+ * adds them straight into a ring::RingsBySize, which keeps them in one bucket
+ * per ring size for the topological network criteria. The global ID of every
+ * ring is its index in the vector returned by primitive::ringNetwork.
+ * @param[in] nList Row-ordered neighbour list by index (and NOT the atom ID)
+ * @param[in] maxDepth The maximum depth upto which rings will be searched.
+ * @return The rings, grouped by ring size.
+ */
+ring::RingsBySize
+primitive::ringNetworkBySize(const std::vector<std::vector<int>> &nList,
+                             int maxDepth) {
+  sprof::StageTimer timer("rings");
+  smem::ScratchScope scope;
+  //
+  primitive::Graph fullGraph; // Graph object, contains the connectivity
+                              // information from the neighbourlist
+
+  // Find all possible rings, and remove the non-SP rings
+  fullGraph = primitive::countAllRingsFromIndex(nList, maxDepth);
+  primitive::removeNonSPrings(&fullGraph);
+
+  sprof::count("rings", fullGraph.rings.size());
+  // Copy the rings out of the arena, into their buckets
+  ring::RingsBySize rings;
+  for (auto &iring : fullGraph.rings) {
+    rings.add(std::vector<int>(iring.begin(), iring.end()));
+  }
+  return rings;
+}
+
+namespace {
+
+// Marks every vertex within maxHops of a marked vertex, over the edges of
+// both neighbour lists
+void growRegion(std::vector<char> &region,
+                const std::vector<std::vector<int>> &nList,
+                const std::vector<std::vector<int>> &oldList, int maxHops) {
+  std::vector<int> front;
+  for (int iatom = 0; iatom < region.size(); iatom++) {
+    if (region[iatom]) {
+      front.push_back(iatom);
+    }
+  }
+  std::vector<int> next;
+  for (int hop = 0; hop < maxHops && !front.empty(); hop++) {
+    next.clear();
+    for (int iatom : front) {
+      for (auto *list : {&nList, &oldList}) {
+        // The first element is iatom itself
+        for (int j = 1; j < (*list)[iatom].size(); j++) {
+          int jatom = (*list)[iatom][j];
+          if (!region[jatom]) {
+            region[jatom] = 1;
+            next.push_back(jatom);
+          }
+        } // end of loop through neighbours
+      }
+    } // end of loop through the current front
+    front.swap(next);
+  } // end of loop through hops
+}
+
+} // namespace
+
+/**
+ * @details Updates the primitive rings of the previous frame (saved in the
+ * primitive::RingTracker) to those of the neighbour list nList, and returns
+ * them. The result is identical, ring for ring and in the same order, to
+ * what primitive::ringNetwork would return for nList.
+ *
+ * primitive::countAllRingsFromIndex finds every ring from its lowest vertex
+ * (the root, which is the first element of the ring), looking at vertices at
+ * most maxDepth-1 bonds away from it. Whether a ring is primitive only
+ * depends on paths shorter than half the ring, which also stay within
+ * maxDepth-1 bonds of the root. The rings of a root which is more than
+ * maxDepth-1 bonds away (in the previous or the current frame) from every
+ * vertex whose neighbours changed are therefore the same as in the
+ * previous frame, and are kept. The search is only repeated from the roots
+ * near a change, on the current graph, with the same backtracking and
+ * shortest-path functions as ringNetwork.
+ *
+ * The rings are searched from scratch on the first call, or if maxDepth or
+ * the number of vertices has changed.
+ * @param[in, out] tracker The neighbour list and rings of the previous frame,
+ *  which are replaced by those of this frame.
+ * @param[in] nList Row-ordered neighbour list by index (and NOT the atom ID)
+ * @param[in] maxDepth The maximum depth upto which rings will be searched.
+ * @return A vector of vectors of the rings; each ring contains the atom indices
+ * of the ring members.
+ */
+std::vector<std::vector<int>>
+primitive::ringNetworkIncremental(primitive::RingTracker &tracker,
+                                  const std::vector<std::vector<int>> &nList,
+                                  int maxDepth) {
+  int nVertices = nList.size(); // Number of vertices in the graph
+  // -------------------
+  // Search from scratch
+  if (tracker.maxDepth != maxDepth || tracker.nList.size() != nVertices) {
+    tracker.rings = primitive::ringNetwork(nList, maxDepth);
+    tracker.nList = nList;
+    tracker.maxDepth = maxDepth;
+    tracker.nFull++;
+    return tracker.rings;
+  } // first frame
+  sprof::StageTimer timer("rings");
+  tracker.nIncremental++;
+  // -------------------
+  // Vertices whose neighbours (or their order) changed
+  std::vector<char> region(nVertices, 0);
+  bool anyChange = false;
+  for (int iatom = 0; iatom < nVertices; iatom++) {
+    if (nList[iatom] != tracker.nList[iatom]) {
+      region[iatom] = 1;
+      anyChange = true;
+    }
+  } // end of comparison
+  if (!anyChange) {
+    sprof::count("rings", tracker.rings.size());
+    return tracker.rings;
+  } // nothing changed
+  // Roots whose rings may have changed
+  growRegion(region, nList, tracker.nList, maxDepth - 1);
+  // -------------------
+  // Search again from these roots
+  std::vector<std::vector<int>> newRings =
+      primitive::ringNetworkFromRoots(nList, maxDepth, region);
+  tracker.nRootsSearched += std::count(region.begin(), region.end(), 1);
+  // -------------------
+  // Merge with the rings kept from the previous frame. Both are sorted by
+  // their root
+  std::vector<std::vector<int>> rings;
+  rings.reserve(tracker.rings.size());
+  auto newRing = newRings.begin();
+  for (auto &oldRing : tracker.rings) {
+    if (region[oldRing[0]]) {
+      continue;
+    }
+    for (; newRing != newRings.end() && (*newRing)[0] < oldRing[0];
+         ++newRing) {
+      rings.push_back(std::move(*newRing));
+    }
+    rings.push_back(std::move(oldRing));
+  } // end of loop through the previous rings
+  for (; newRing != newRings.end(); ++newRing) {
+    rings.push_back(std::move(*newRing));
+  }
+  // -------------------
+  tracker.rings = std::move(rings);
+  tracker.nList = nList;
+  sprof::count("rings", tracker.rings.size());
+  return tracker.rings;
+}
+
+namespace {
+
+// Number of bonds to the root of the vertices out of its reach
+const int farAway = 1 << 20;
+
+// Number of bonds from root to every vertex within maxHops of it (in the
+// whole graph of nList), written into distance. The vertices reached are
+// added to touched, so that distance can be reset afterwards
+void bondsFromRoot(const std::vector<std::vector<int>> &nList, int root,
+                   int maxHops, std::pmr::vector<int> &distance,
+                   std::vector<int> &touched) {
+  distance[root] = 0;
+  touched.push_back(root);
+  for (int first = 0; first < touched.size(); first++) {
+    int iatom = touched[first];
+    if (distance[iatom] >= maxHops) {
+      continue;
+    }
+    // The first element is iatom itself
+    for (int j = 1; j < nList[iatom].size(); j++) {
+      int jatom = nList[iatom][j];
+      if (distance[jatom] == farAway) {
+        distance[jatom] = distance[iatom] + 1;
+        touched.push_back(jatom);
+      }
+    } // end of loop through neighbours
+  }   // end of breadth-first search
+}
+
+// Primitive rings of nList, searched from the marked roots (or from every
+// vertex if roots is null), in ascending order with every lower vertex
+// already out of the graph, just as in primitive::countAllRingsFromIndex.
+// If ringSizes is not empty, only the rings of these sizes (at most maxDepth)
+// are kept, and the search is pruned with the number of bonds back to the
+// root
+std::vector<std::vector<int>>
+searchRings(const std::vector<std::vector<int>> &nList, int maxDepth,
+            const std::vector<char> *roots, const std::vector<int> &ringSizes) {
+  smem::ScratchScope scope;
+  primitive::Graph fullGraph = primitive::populateGraphFromIndices(nList);
+  int nVertices = nList.size();
+  if (!ringSizes.empty()) {
+    int largest = 0; // Largest ring size wanted
+    fullGraph.ringSizes.assign(maxDepth + 1, 0);
+    for (int ringSize : ringSizes) {
+      if (ringSize >= 3 && ringSize <= maxDepth) {
+        fullGraph.ringSizes[ringSize] = 1;
+        largest = std::max(largest, ringSize);
+      }
+    } // end of loop through ring sizes
+    maxDepth = largest;
+    fullGraph.rootDistance.assign(nVertices, farAway);
+  } // only some ring sizes
+  std::vector<int> visited;
+  std::vector<int> touched; // Vertices with a distance from the root
+  int removedUpTo = 0;      // Vertices below this are out of the graph
+  for (int iatom = 0; iatom < nVertices && maxDepth >= 3; iatom++) {
+    if (roots && !(*roots)[iatom]) {
+      continue;
+    }
+    for (; removedUpTo < iatom; removedUpTo++) {
+      fullGraph.pts[removedUpTo].inGraph = false;
+    }
+    if (!fullGraph.rootDistance.empty()) {
+      bondsFromRoot(nList, iatom, maxDepth - 1, fullGraph.rootDistance,
+                    touched);
+    } // distances for pruning
+    visited.clear();
+    primitive::findRings(&fullGraph, iatom, &visited, maxDepth, 0);
+    for (int jatom : touched) {
+      fullGraph.rootDistance[jatom] = farAway;
+    }
+    touched.clear();
+  } // end of loop through roots
+  primitive::restoreEdgesFromIndices(&fullGraph, nList);
+  primitive::removeNonSPrings(&fullGraph);
+  // Copy the rings out of the arena
+  std::vector<std::vector<int>> rings;
+  rings.reserve(fullGraph.rings.size());
+  for (auto &ring : fullGraph.rings) {
+    rings.emplace_back(ring.begin(), ring.end());
+  }
+  return rings;
+}
+
+} // namespace
+
+/**
+ * @details Finds the same primitive rings as primitive::ringNetwork, but only
+ * those of the requested sizes, and in the same order. Rings are searched
+ * for up to the largest requested size. A path is abandoned as soon as the
+ * number of bonds back to its root (found beforehand with a breadth-first
+ * search from the root) would make the ring larger than that, and only the
+ * rings of the requested sizes are kept. These are then checked with the same
+ * (exact) shortest-path criterion, which does not depend on the other rings.
+ * The topological network criteria for bulk ice, for instance, only need the
+ * hexagonal (and pentagonal) rings.
+ * @param[in] nList Row-ordered neighbour list by index (and NOT the atom ID)
+ * @param[in] ringSizes The ring sizes to search for
+ * @return A vector of vectors of the rings; each ring contains the atom indices
+ * of the ring members.
+ */
+std::vector<std::vector<int>>
+primitive::ringNetworkOfSizes(const std::vector<std::vector<int>> &nList,
+                              const std::vector<int> &ringSizes) {
+  sprof::StageTimer timer("rings");
+  int maxDepth = 0; // Largest ring size
+  for (int ringSize : ringSizes) {
+    maxDepth = std::max(maxDepth, ringSize);
+  }
+  std::vector<std::vector<int>> rings =
+      searchRings(nList, maxDepth, nullptr, ringSizes);
+  sprof::count("rings", rings.size());
+  return rings;
+}
+
+/**
+ * @details Finds the primitive rings whose root (their lowest vertex, which
+ * is the first element of the ring) is one of the marked vertices. These are
+ * exactly the rings with these roots returned by primitive::ringNetwork, in
+ * the same order: the roots are searched in ascending order, with every lower
+ * vertex already removed from the graph, just as in
+ * primitive::countAllRingsFromIndex, and the non-SP rings are removed with the
+ * same shortest-path function. Only the vertices within maxDepth-1 bonds of a
+ * root are ever looked at. If ring sizes are given, only rings of these sizes
+ * are searched for, as in primitive::ringNetworkOfSizes.
+ * @param[in] nList Row-ordered neighbour list by index (and NOT the atom ID)
+ * @param[in] maxDepth The maximum depth upto which rings will be searched.
+ * @param[in] roots Non-zero for the vertices (by index) to search from
+ * @param[in] ringSizes The ring sizes to search for (every size up to maxDepth
+ *  if empty)
+ * @return The rings with these roots, sorted by their root; each ring
+ * contains the atom indices of the ring members.
+ */
+std::vector<std::vector<int>>
+primitive::ringNetworkFromRoots(const std::vector<std::vector<int>> &nList,
+                                int maxDepth, const std::vector<char> &roots,
+                                const std::vector<int> &ringSizes) {
+  return searchRings(nList, maxDepth, &roots, ringSizes);
 }
 
 /**
@@ -55,6 +361,11 @@ primitive::ringNetwork(std::vector<std::vector<int>> nList, int maxDepth) {
  *   - primitive::findRings (for getting all rings, using backtracking)
  *   - primitive::restoreEdgesFromIndices (restores back-up of the edges since
  * some may have been removed)
+ *
+ *  Like every Graph, the result is allocated from smem::scratch. When this is
+ * called inside a smem::ScratchScope, the rings must be copied out before the
+ * outermost scope ends (see primitive::ringNetwork); called with no scope
+ * open, the Graph lives on the heap.
  *  @param[in] neighHbondList Row-ordered neighbour list by atom index (not ID).
  *  @param[in] maxDepth The maximum depth upto which rings will be searched.
  *   This means that rings larger than maxDepth will not be generated.
@@ -84,7 +395,7 @@ primitive::countAllRingsFromIndex(std::vector<std::vector<int>> neighHbondList,
   } // loop through every vertex
   // ------------------------------
   // Restore back-up of the edges (some may have been removed)
-  fullGraph = primitive::restoreEdgesFromIndices(&fullGraph, neighHbondList);
+  primitive::restoreEdgesFromIndices(&fullGraph, neighHbondList);
   // ------------------------------
 
   return fullGraph;
@@ -150,11 +461,17 @@ int primitive::findRings(Graph *fullGraph, int v, std::vector<int> *visited,
     n = fullGraph->pts[v].neighListIndex[j]; // Neighbour index
     // Has a ring been found?!
     if (depth > 2 && n == root) {
-      // Add the visited vector to the rings vector of vector
-      fullGraph->rings.push_back(*visited);
+      // Add the visited vector to the rings vector of vector, if rings of
+      // this size are wanted
+      if (fullGraph->ringSizes.empty() || fullGraph->ringSizes[depth]) {
+        fullGraph->rings.emplace_back(visited->begin(), visited->end());
+      }
     } // A ring has been found!
-    // Otherwise search all the neighbours which have not been searched already
-    else if (fullGraph->pts[n].inGraph) {
+    // Otherwise search all the neighbours which have not been searched
+    // already, unless the path cannot get back to the root within maxDepth
+    else if (fullGraph->pts[n].inGraph &&
+             (fullGraph->rootDistance.empty() ||
+              depth + fullGraph->rootDistance[n] <= maxDepth)) {
       fullGraph->pts[n].inGraph = false; // Set to false now
       // Recursive call
       primitive::findRings(fullGraph, n, visited, maxDepth, depth, root);
@@ -183,7 +500,8 @@ int primitive::findRings(Graph *fullGraph, int v, std::vector<int> *visited,
  * @details Fills a Graph object with information from the PointCloud and the
  *  neighbour list. The indices in the neighbour list in the Vertex object are
  *  NOT the atom IDs (they are the atom indices according to the input
- *  PointCloud). The input neighbour list is by atom ID.
+ *  PointCloud). The input neighbour list is by atom ID. The Graph is allocated
+ *  from smem::scratch, so it must not outlive an open smem::ScratchScope.
  * @param[in] yCloud The input PointCloud.
  * @param[in] neighHbondList The row-ordered neighbour list, containing atom
  *  IDs, and not the atom indices.
@@ -194,7 +512,6 @@ primitive::Graph primitive::populateGraphFromNListID(
     std::vector<std::vector<int>> neighHbondList) {
   //
   primitive::Graph fullGraph; // Contains all the information of the pointCloud
-  primitive::Vertex iVertex;  // The vertex corresponding to a particular point
   int nnumNeighbours;         // Number of nearest neighbours for iatom
   std::vector<int> iNeigh;    // Neighbours of the current iatom
   int jatomID;                // Atom ID of the nearest neighbour
@@ -222,11 +539,10 @@ primitive::Graph primitive::populateGraphFromNListID(
       iNeigh.push_back(jatomIndex);
     } // end of loop through nearest neighbours
     // -----
-    // Update iVertex
-    iVertex.atomIndex = iatom;
-    iVertex.neighListIndex = iNeigh;
-    // Add to the Graph object
-    fullGraph.pts.push_back(iVertex);
+    // Add the vertex for iatom to the Graph object
+    fullGraph.pts.emplace_back();
+    fullGraph.pts.back().atomIndex = iatom;
+    fullGraph.pts.back().neighListIndex.assign(iNeigh.begin(), iNeigh.end());
   } // end of loop through every iatom
   // ------------------------------
 
@@ -240,6 +556,8 @@ primitive::Graph primitive::populateGraphFromNListID(
  *  PointCloud). The input neighbour list is by index NOT atom IDs. Otherwise,
  *  this function does the same thing as primitive::populateGraphFromNListID.
  * The only difference is that this function takes the neighbour list BY INDEX.
+ * The Graph is allocated from smem::scratch, so it must not outlive an open
+ * smem::ScratchScope.
  * @param[in] nList The row-ordered neighbour list, containing atom
  *  indices (according to the input PointCloud).
  * @return The Graph object for the current frame.
@@ -248,20 +566,19 @@ primitive::Graph
 primitive::populateGraphFromIndices(std::vector<std::vector<int>> nList) {
   //
   primitive::Graph fullGraph; // Contains all the information of the pointCloud
-  primitive::Vertex iVertex;  // The vertex corresponding to a particular point
-  int nnumNeighbours;         // Number of nearest neighbours for iatom
-  int iatom, jatom;           // Atom index being saved
+  int iatom;                  // Atom index being saved
   // ------------------------------
   // Loop through every point in nList
+  fullGraph.pts.reserve(nList.size());
   for (int i = 0; i < nList.size(); i++) {
     iatom = nList[i][0]; // Atom index of i
     // neighListIndex is simply the i^th row of nList
     //
-    // Update iVertex
-    iVertex.atomIndex = iatom;
-    iVertex.neighListIndex = nList[i];
-    // Add to the Graph object
-    fullGraph.pts.push_back(iVertex);
+    // Add the vertex to the Graph object
+    fullGraph.pts.emplace_back();
+    fullGraph.pts.back().atomIndex = iatom;
+    fullGraph.pts.back().neighListIndex.assign(nList[i].begin(),
+                                               nList[i].end());
   } // end of loop through iatom
 
   return fullGraph;
@@ -277,18 +594,18 @@ primitive::populateGraphFromIndices(std::vector<std::vector<int>> nList) {
  *  lists of component Vertex objects may have been depleted.
  * @param[in] nList The row-ordered neighbour list, containing atom
  *  indices (according to the input PointCloud).
- * @return The Graph object for the current frame.
+ * @return The Graph object for the current frame (fullGraph itself).
  */
-primitive::Graph
+primitive::Graph &
 primitive::restoreEdgesFromIndices(Graph *fullGraph,
-                                   std::vector<std::vector<int>> nList) {
+                                   const std::vector<std::vector<int>> &nList) {
   //
   // ------------------------------
   // Loop through every point in nList
   for (int i = 0; i < nList.size(); i++) {
     // neighListIndex is simply the i^th row of nList
     // Update the neighListIndex list in the graph object
-    fullGraph->pts[i].neighListIndex = nList[i];
+    fullGraph->pts[i].neighListIndex.assign(nList[i].begin(), nList[i].end());
   } // end of loop through iatom
 
   return *fullGraph;
@@ -302,21 +619,19 @@ primitive::restoreEdgesFromIndices(Graph *fullGraph,
  * @param[in] fullGraph The Graph object for the current frame. This also
  *  contains the rings vector of vectors, which has all possible rings (possibly
  *  inclding non-SP rings).
- * @return The Graph object for the current frame.
+ * @return The Graph object for the current frame (fullGraph itself).
  */
-primitive::Graph primitive::removeNonSPrings(primitive::Graph *fullGraph) {
+primitive::Graph &primitive::removeNonSPrings(primitive::Graph *fullGraph) {
   //
   int nVertices = fullGraph->pts.size(); // Number of vertices in the graph
   int nRings = fullGraph->rings.size();  // Number of rings
   std::vector<bool> ringsToRemove; // Vector containing the logical values for
                                    // removal of the current ring index
-  std::vector<int> currentRing;    // Current ring being evaluated
   int ringSize;                    // Length of the current ring
   bool removeRing; // Logical for removing the current ring (true) or not
-  std::vector<std::vector<int>>
-      emptyTempRings; // Empty vector of vectors to swap
-  std::vector<std::vector<int>>
-      primitiveRings; // Vector of vectors of rings after removing non SP rings
+  std::pmr::vector<std::pmr::vector<int>> primitiveRings(
+      fullGraph->rings.get_allocator()); // Vector of vectors of rings after
+                                         // removing non SP rings
   int currentV;       // Current vertex
   int currentN;       // Current neighbour
   int dist_r;         // Distance over ring
@@ -332,7 +647,8 @@ primitive::Graph primitive::removeNonSPrings(primitive::Graph *fullGraph) {
   // -------------------
   // Loop through every ring
   for (int iRing = 0; iRing < nRings; iRing++) {
-    currentRing = fullGraph->rings[iRing]; // Current ring
+    const std::pmr::vector<int> &currentRing =
+        fullGraph->rings[iRing];           // Current ring
     ringSize = currentRing.size();         // Length of the current ring
     removeRing = false;                    // init
     // Loop through every j^th vertex
@@ -366,13 +682,12 @@ primitive::Graph primitive::removeNonSPrings(primitive::Graph *fullGraph) {
   // Remove all the rings whose indices are given in the ringsToRemove vector
   for (int i = 0; i < ringsToRemove.size(); i++) {
     if (!ringsToRemove[i]) {
-      primitiveRings.push_back(fullGraph->rings[i]);
+      primitiveRings.push_back(std::move(fullGraph->rings[i]));
     } // updates new copy
   }   // end of loop through ringsToRemove
   // -------------------
   // Update the graph rings with the primitiveRings
-  emptyTempRings.swap(fullGraph->rings);
-  fullGraph->rings = primitiveRings;
+  fullGraph->rings.swap(primitiveRings);
   // -------------------
   return *fullGraph;
 }
@@ -443,8 +758,10 @@ int primitive::shortestPath(Graph *fullGraph, int v, int goal,
  */
 primitive::Graph primitive::clearGraph(Graph *currentGraph) {
   //
-  std::vector<primitive::Vertex> tempPts;
-  std::vector<std::vector<int>> tempRings;
+  std::pmr::vector<primitive::Vertex> tempPts(
+      currentGraph->pts.get_allocator());
+  std::pmr::vector<std::pmr::vector<int>> tempRings(
+      currentGraph->rings.get_allocator());
   tempPts.swap(currentGraph->pts);
   tempRings.swap(currentGraph->rings);
   return *currentGraph;
@@ -0,0 +1,218 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#ifndef __ACCUMULATORS_H_
+#define __ACCUMULATORS_H_
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/** @file accumulators.hpp
+ *  @brief Streaming histograms, moments and quantiles of per-atom values.
+ */
+
+/**
+ *  @addtogroup sstat
+ *  @{
+ */
+
+/** @brief Distributions accumulated over a whole trajectory.
+ *  @details Dumping every value of a per-atom or per-bond quantity (the
+ * @f$c_{ij}@f$ of every bond, or the @f$q_3@f$ and @f$q_6@f$ of every atom)
+ * for every frame produces files with billions of lines, which then have to
+ * be histogrammed offline. A sstat::Distribution instead folds each value in
+ * as it is computed, into
+ *
+ * - a histogram with fixed bins (plus counts of the values below and above
+ *   the range),
+ * - the count, mean, variance, minimum and maximum (Welford's algorithm),
+ * - optionally, estimates of some quantiles (the median, for instance) with
+ *   the P² algorithm of Jain and Chlamtac, which uses five markers per
+ *   quantile instead of keeping the values.
+ *
+ * Each thread accumulates into its own distributions (sstat::distribution),
+ * which are merged when they are written out (sstat::writeAll), at the end
+ * of the run or at checkpoints. Histograms and moments merge exactly. The P²
+ * markers cannot be merged, so after a merge the quantiles are interpolated
+ * from the histogram instead.
+ */
+
+namespace sstat {
+
+/** @class Histogram
+ * @brief Counts of values in nBins equal bins between low and high.
+ */
+class Histogram {
+public:
+  Histogram() = default;
+  Histogram(double low, double high, int nBins);
+
+  //! Adds a value
+  void add(double value) {
+    if (value < low) {
+      underflow++;
+    } else if (value >= high) {
+      overflow++;
+    } else {
+      int ibin = static_cast<int>((value - low) * scale);
+      counts[ibin < nBins() ? ibin : nBins() - 1]++;
+    }
+  }
+
+  //! Adds the counts of another histogram with the same bins
+  void merge(const Histogram &other);
+
+  //! Interpolated quantile p (between 0 and 1) of the values in range
+  double quantile(double p) const;
+
+  //! Number of bins
+  int nBins() const { return counts.size(); }
+
+  //! Centre of a bin
+  double binCentre(int ibin) const { return low + (ibin + 0.5) / scale; }
+
+  //! Width of every bin
+  double binWidth() const { return 1.0 / scale; }
+
+  double low = 0.0;                 //! Lower end of the first bin
+  double high = 1.0;                //! Upper end of the last bin
+  std::vector<std::uint64_t> counts; //! Values in each bin
+  std::uint64_t underflow = 0;      //! Values below low
+  std::uint64_t overflow = 0;       //! Values at or above high
+
+private:
+  double scale = 1.0; //! Bins per unit
+};
+
+/** @struct Moments
+ * @brief Running count, mean, variance and range (Welford's algorithm).
+ */
+struct Moments {
+  std::uint64_t n = 0; //! Number of values
+  double mean = 0.0;   //! Mean
+  double m2 = 0.0;     //! Sum of squared deviations from the mean
+  double min = 0.0;    //! Smallest value
+  double max = 0.0;    //! Largest value
+
+  //! Adds a value
+  void add(double value) {
+    if (n == 0) {
+      min = max = value;
+    } else {
+      min = value < min ? value : min;
+      max = value > max ? value : max;
+    }
+    n++;
+    double delta = value - mean;
+    mean += delta / n;
+    m2 += delta * (value - mean);
+  }
+
+  //! Combines the moments of another set of values (Chan et al.)
+  void merge(const Moments &other);
+
+  //! Sample variance
+  double variance() const { return n > 1 ? m2 / (n - 1) : 0.0; }
+};
+
+/** @class P2Quantile
+ * @brief Estimate of one quantile of a stream of values, with the P²
+ * algorithm (five markers, constant memory).
+ */
+class P2Quantile {
+public:
+  explicit P2Quantile(double p = 0.5);
+
+  //! Adds a value
+  void add(double value);
+
+  //! The current estimate (NaN if no values have been added)
+  double value() const;
+
+  //! The quantile estimated (between 0 and 1)
+  double probability() const { return p; }
+
+private:
+  double p;
+  std::uint64_t count = 0;
+  std::array<double, 5> heights{};   //! Marker heights
+  std::array<double, 5> positions{}; //! Actual marker positions
+  std::array<double, 5> desired{};   //! Desired marker positions
+  std::array<double, 5> increments{}; //! Increments of the desired positions
+};
+
+/** @class Distribution
+ * @brief Histogram, moments and (optionally) P² quantiles of one quantity.
+ */
+class Distribution {
+public:
+  Distribution() = default;
+  Distribution(double low, double high, int nBins,
+               std::vector<double> quantiles = std::vector<double>());
+
+  //! Adds a value
+  void add(double value) {
+    histogram.add(value);
+    moments.add(value);
+    for (auto &estimate : estimates) {
+      estimate.add(value);
+    }
+  }
+
+  //! Adds the values of another distribution with the same bins
+  void merge(const Distribution &other);
+
+  //! Quantile p: the P² estimate if there is one (and nothing was merged
+  //! in), otherwise interpolated from the histogram
+  double quantile(double p) const;
+
+  //! Quantiles which are reported when the distribution is written out
+  std::vector<double> quantiles() const { return probabilities; }
+
+  //! Writes the moments, quantiles and histogram to a text file
+  int write(const std::string &fileName) const;
+
+  Histogram histogram; //! Counts in fixed bins
+  Moments moments;     //! Count, mean, variance and range
+
+private:
+  std::vector<double> probabilities;  //! Quantiles to report
+  std::vector<P2Quantile> estimates;  //! P² estimates of the quantiles
+  bool merged = false;                //! Values from other threads merged in
+};
+
+//! Sets the quantiles estimated (with P²) by distributions created from now on
+void setQuantiles(std::vector<double> quantiles);
+
+//! The distribution of a quantity for the calling thread, created with the
+//! given bins on first use
+Distribution &distribution(const std::string &name, double low, double high,
+                           int nBins = 200);
+
+//! The distributions of every quantity, merged over all threads
+std::map<std::string, Distribution> mergedDistributions();
+
+//! Writes every merged distribution to path + name + "-histogram.txt"
+int writeAll(const std::string &path = "");
+
+//! Clears every distribution (of every thread)
+void reset();
+
+} // namespace sstat
+
+#endif // __ACCUMULATORS_H_
@@ -17,6 +17,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -30,7 +31,6 @@
 // Internal
 #include <cage.hpp>
 #include <mol_sys.hpp>
-#include <seams_input.hpp>
 
 /** @file bond.hpp
  *  @brief File for bond-related analyses (hydrogen bonds, bonded atoms for data
@@ -75,7 +75,7 @@ namespace bond {
 std::vector<std::vector<int>>
 populateHbonds(std::string filename,
                molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-               std::vector<std::vector<int>> nList, int targetFrame, int Htype);
+               const std::vector<std::vector<int>> &nList, int targetFrame, int Htype);
 
 //! Create a vector of vectors (similar to the neighbour list conventions)
 //! containing the hydrogen bond connectivity information. Decides the
@@ -85,7 +85,7 @@ populateHbonds(std::string filename,
 std::vector<std::vector<int>>
 populateHbondsWithInputClouds(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                molSys::PointCloud<molSys::Point<double>, double> *hCloud,
-               std::vector<std::vector<int>> nList);
+               const std::vector<std::vector<int>> &nList);
 
 //! Calculates the distance of the hydrogen bond between O and H (of different
 //! atoms), given the respective pointClouds and the indices to each atom
@@ -94,31 +94,69 @@ getHbondDistanceOH(molSys::PointCloud<molSys::Point<double>, double> *oCloud,
                    molSys::PointCloud<molSys::Point<double>, double> *hCloud,
                    int oAtomIndex, int hAtomIndex);
 
-//! Create a vector of vectors containing bond connectivity information. May
+/** @struct BondList
+ * @brief Bonds for the data file write-outs, packed into a flat array of 64-bit
+ * keys instead of a vector of two-element vectors.
+ * @details The first atom of a bond is stored in the upper 32 bits of its key
+ * and the second atom in the lower 32 bits, in the order in which the bond was
+ * added. Atom IDs and indices are never negative, so that sorting the keys
+ * orders the bonds by their first atom and then by their second atom, just
+ * like sorting the equivalent vector of vectors.
+ */
+struct BondList {
+  std::vector<std::uint64_t> keys; //! One key per bond
+
+  //! Packs the bond between iatom and jatom into a key
+  static std::uint64_t pack(int iatom, int jatom) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(iatom))
+            << 32) |
+           static_cast<std::uint32_t>(jatom);
+  }
+  //! Appends the bond between iatom and jatom
+  void add(int iatom, int jatom) { keys.push_back(pack(iatom, jatom)); }
+  //! Number of bonds
+  std::size_t size() const { return keys.size(); }
+  //! First atom of a bond
+  int first(std::size_t ibond) const {
+    return static_cast<int>(keys[ibond] >> 32);
+  }
+  //! Second atom of a bond
+  int second(std::size_t ibond) const {
+    return static_cast<int>(keys[ibond] & 0xffffffffu);
+  }
+};
+
+//! Packs bonds given as a vector of vectors (for instance those read in with
+//! sinp::readBonds) into a BondList
+BondList packBonds(const std::vector<std::vector<int>> &bonds);
+
+//! Sorts the bonds (with a radix sort on the keys) and removes duplicates
+void sortUniqueBonds(BondList &bonds);
+
+//! Create a packed list containing bond connectivity information. May
 //! contain duplicates! Gets the bond information from the vector of vectors
 //! containing the neighbour list by index
-std::vector<std::vector<int>>
-populateBonds(std::vector<std::vector<int>> nList,
+BondList
+populateBonds(const std::vector<std::vector<int>> &nList,
               molSys::PointCloud<molSys::Point<double>, double> *yCloud);
 
-//! Create a vector of vectors containing bond connectivity information
+//! Create a packed list containing bond connectivity information
 //! Gets the bond information from the vector of vectors
 //! containing the neighbour list by index. Bonds between dummy atoms are not
 //! filled.
-std::vector<std::vector<int>>
-populateBonds(std::vector<std::vector<int>> nList,
+BondList
+populateBonds(const std::vector<std::vector<int>> &nList,
               molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-              std::vector<cage::iceType> atomTypes);
+              const std::vector<cage::iceType> &atomTypes);
 
-//! Creates a vector of vectors containing bond connectivity information from
+//! Creates a packed list containing bond connectivity information from
 //! the rings vector of vectors and cage information
-std::vector<std::vector<int>>
-createBondsFromCages(std::vector<std::vector<int>> rings,
-                     std::vector<cage::Cage> *cageList, cage::cageType type,
-                     int *nRings);
+BondList createBondsFromCages(const std::vector<std::vector<int>> &rings,
+                              std::vector<cage::Cage> *cageList,
+                              cage::cageType type, int *nRings);
 
 //! Remove duplicate bonds
-std::vector<std::vector<int>> trimBonds(std::vector<std::vector<int>> bonds);
+BondList trimBonds(BondList bonds);
 
 } // namespace bond
 
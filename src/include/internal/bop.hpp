@@ -179,9 +179,9 @@ struct QlmAtom {
  neighbours
  *  @param[in] isSlice This decides whether there is a slice or not
  */
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 getCorrel(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-          std::vector<std::vector<int>> nList, bool isSlice = false);
+          const std::vector<std::vector<int>> &nList, bool isSlice = false);
 
 /**
  *  Function that classifies every particle's #molSys::atom_state_type ice
@@ -190,9 +190,9 @@ getCorrel(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
  *  @param[in] isSlice This decides whether there is a slice or not
  *  @param[in] nList Row-ordered neighbour list by atom ID
  */
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 getIceTypeNoPrint(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                  std::vector<std::vector<int>> nList, bool isSlice = false);
+                  const std::vector<std::vector<int>> &nList, bool isSlice = false);
 
 // Classifies each atom according to the CHILL algorithm
 /**
@@ -207,21 +207,21 @@ getIceTypeNoPrint(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
  *  @param[in] outputFileName Name of the output file, to which the ice types
  will be written out.
  */
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 getIceType(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-           std::vector<std::vector<int>> nList, std::string path,
+           const std::vector<std::vector<int>> &nList, std::string path,
            int firstFrame, bool isSlice = false,
            std::string outputFileName = "chill.txt");
 
 //! Gets c_ij and then classifies bond types according to the CHILL+ algorithm
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 getCorrelPlus(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-              std::vector<std::vector<int>> nList, bool isSlice = false);
+              const std::vector<std::vector<int>> &nList, bool isSlice = false);
 
 //! Classifies each atom according to the CHILL+ algorithm
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 getIceTypePlus(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-               std::vector<std::vector<int>> nList, std::string path,
+               const std::vector<std::vector<int>> &nList, std::string path,
                int firstFrame, bool isSlice = false,
                std::string outputFileName = "chillPlus.txt");
 
@@ -229,13 +229,13 @@ getIceTypePlus(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
 //! cluster
 std::vector<double>
 getq6(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-      std::vector<std::vector<int>> nList, bool isSlice = false);
+      const std::vector<std::vector<int>> &nList, bool isSlice = false);
 
 //! 'Test' condition for classifying hexagonal ice using averaged q6 and q3
 //! Checks water
 //! According to https://!pubs.rsc.org/en/content/articlehtml/2011/cp/c1cp22167a
 //! Gets c_ij and then classifies bond types according to the CHILL+ algorithm
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 reclassifyWater(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                 std::vector<double> *q6);
 
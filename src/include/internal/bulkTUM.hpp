@@ -47,8 +47,15 @@ namespace tum3 {
 //! Topological unit matching for bulk water. If printClusters is true,
 //! individual clusters of connected cages are printed.
 int topoUnitMatchingBulk(
-    std::string path, std::vector<std::vector<int>> rings,
-    std::vector<std::vector<int>> nList,
+    std::string path, const std::vector<std::vector<int>> &rings,
+    const std::vector<std::vector<int>> &nList,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int firstFrame,
+    bool printClusters, bool onlyTetrahedral);
+
+//! Topological unit matching for rings already sorted by size
+int topoUnitMatchingBulk(
+    std::string path, const ring::RingsBySize &rings,
+    const std::vector<std::vector<int>> &nList,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int firstFrame,
     bool printClusters, bool onlyTetrahedral);
 
@@ -60,24 +67,25 @@ Eigen::MatrixXd buildRefDDC(std::string fileName);
 
 //! Shape-matching for a target HC
 int shapeMatchHC(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                 const Eigen::MatrixXd &refPoints, cage::Cage cageUnit,
-                 std::vector<std::vector<int>> rings,
-                 std::vector<std::vector<int>> nList, std::vector<double> *quat,
+                 const Eigen::MatrixXd &refPoints, const cage::Cage &cageUnit,
+                 const std::vector<std::vector<int>> &rings,
+                 const nneigh::Adjacency &bonded, std::vector<double> *quat,
                  double *rmsd);
 
 //! Shape-matching for a target DDC
 int shapeMatchDDC(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                   const Eigen::MatrixXd &refPoints,
-                  std::vector<cage::Cage> cageList, int cageIndex,
-                  std::vector<std::vector<int>> rings,
+                  const std::vector<cage::Cage> &cageList, int cageIndex,
+                  const std::vector<std::vector<int>> &rings,
                   std::vector<double> *quat, double *rmsd);
 
 //! Calulate the RMSD for each ring, using RMSD values (rmsd) obtained from the
 //! shape-matching of each cage
-int updateRMSDatom(std::vector<std::vector<int>> rings, cage::Cage cageUnit,
-                   double rmsd, std::vector<double> *rmsdPerAtom,
+int updateRMSDatom(const std::vector<std::vector<int>> &rings,
+                   const cage::Cage &cageUnit, double rmsd,
+                   std::vector<double> *rmsdPerAtom,
                    std::vector<int> *noOfCommonAtoms,
-                   std::vector<cage::iceType> atomTypes);
+                   const std::vector<cage::iceType> &atomTypes);
 
 //! Average the RMSD per atom
 int averageRMSDatom(std::vector<double> *rmsdPerAtom,
@@ -92,17 +100,23 @@ topoBulkCriteria(std::string path, std::vector<std::vector<int>> rings,
                  int firstFrame, int *numHC, int *numDDC,
                  std::vector<ring::strucType> *ringType);
 
+//! Finds the cluster of every cage (cages of the same type sharing rings),
+//! numbered in the order of their lowest cage index; -1 for single cages
+std::vector<int> cageClusterIDs(const std::vector<cage::Cage> &cageList,
+                                int nCages, int nRings);
+
 //! Clustering
-//! Clusters cages using the Stillinger algorithm and prints out individual XYZ
-//! files of clusters.
+//! Clusters cages (with a ring to cage index and union-find) and prints out
+//! individual XYZ files of clusters.
 int clusterCages(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                 std::string path, std::vector<std::vector<int>> rings,
-                 std::vector<cage::Cage> cageList, int numHC, int numDDC);
+                 std::string path, const std::vector<std::vector<int>> &rings,
+                 const std::vector<cage::Cage> &cageList, int numHC,
+                 int numDDC);
 
 //! Gets the atoms in the cages of a given cluster
-std::vector<int> atomsFromCages(std::vector<std::vector<int>> rings,
-                                std::vector<cage::Cage> cageList,
-                                std::vector<int> clusterCages);
+std::vector<int> atomsFromCages(const std::vector<std::vector<int>> &rings,
+                                const std::vector<cage::Cage> &cageList,
+                                const std::vector<int> &clusterCages);
 
 } // namespace tum3
 
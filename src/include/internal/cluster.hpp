@@ -82,7 +82,7 @@ int singleClusterLinkedList(
 int clusterAnalysis(std::string path,
                     molSys::PointCloud<molSys::Point<double>, double> *iceCloud,
                     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                    std::vector<std::vector<int>> nList,
+                    const std::vector<std::vector<int>> &nList,
                     std::vector<std::vector<int>> &iceNeighbourList,
                     double cutoff, int firstFrame,
                     std::string bopAnalysis = "q6");
@@ -90,7 +90,7 @@ int clusterAnalysis(std::string path,
 //! Recenters the coordinates of a pointCloud
 int recenterClusterCloud(
     molSys::PointCloud<molSys::Point<double>, double> *iceCloud,
-    std::vector<std::vector<int>> nList);
+    const std::vector<std::vector<int>> &nList);
 
 } // namespace clump
 
@@ -0,0 +1,80 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#ifndef __COMPRESSED_INPUT_H_
+#define __COMPRESSED_INPUT_H_
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+/** @file compressed_input.hpp
+ *  @brief File for reading gzip and zstd compressed text input.
+ */
+
+/**
+ *  @addtogroup sinp
+ *  @{
+ */
+
+/** @brief Transparent decompression for the text readers.
+ *  @details The text readers (sinp::readLammpsTrj, sinp::readLammpsTrjO,
+ * sinp::readLammpsTrjreduced, sinp::readXYZ and sinp::readBonds) open their
+ * files with sinp::openInput, so compressed files can be used in place of the
+ * original ones. The compression is decided by the first bytes of the file,
+ * not by its extension:
+ *
+ * - gzip (.gz), decompressed with zlib. Files made up of several gzip members
+ *   (such as those written by bgzip or pigz --independent) are read in full.
+ * - zstd (.zst), if d-SEAMS was built with zstd (DSEAMS_WITH_ZSTD). Files made
+ *   up of several zstd frames (pzstd, zstd --seekable) are read in full.
+ * - anything else is read as a plain text file.
+ *
+ * A compressed file is decompressed on a background thread, a few blocks ahead
+ * of the reader, so that decompression overlaps with parsing.
+ *
+ * Since the LAMMPS readers are called once per frame, a compressed file is
+ * indexed the first time a frame other than the first is requested: one pass
+ * over the file records where every frame starts in the decompressed text,
+ * along with access points every few MB from which decompression can be
+ * restarted (a gzip deflate block boundary with the preceding 32 KB of
+ * output, or the start of a gzip member or zstd frame). Reading a frame then
+ * only decompresses the text from the access point before it. The index is
+ * kept for as long as the file is unchanged.
+ */
+
+namespace sinp {
+
+/** @enum class Compression
+ * @brief Compression of an input file.
+ */
+enum class Compression { none, gzip, zstd };
+
+//! The compression of a file, according to its first bytes
+Compression compression(const std::string &filename);
+
+//! True if files with this compression can be read
+bool compressionSupported(Compression method);
+
+//! Opens a (possibly compressed) text file. For a LAMMPS trajectory,
+//! targetFrame is the frame about to be read (the first frame is 1): the
+//! stream may then start after some of the frames before it, and framesBefore
+//! is set to the number of frames skipped
+std::unique_ptr<std::istream> openInput(std::string filename,
+                                        int targetFrame = 1,
+                                        int *framesBefore = nullptr);
+
+} // namespace sinp
+
+#endif // __COMPRESSED_INPUT_H_
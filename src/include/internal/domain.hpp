@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#ifndef __DOMAIN_H_
+#define __DOMAIN_H_
+
+#include <array>
+#include <vector>
+
+#include <mol_sys.hpp>
+#include <pipeline.hpp>
+
+/** @file domain.hpp
+ *  @brief Spatial domain decomposition of single, very large frames.
+ */
+
+/**
+ *  @addtogroup sdom
+ *  @{
+ */
+
+/** @brief Computes the per-frame products of a spipe::Pipeline subdomain by
+ * subdomain.
+ *  @details For very large systems even one frame takes long on a single
+ * thread, and the neighbour list and hydrogen bonds (whose loops scale with
+ * the square of the number of atoms) dominate. With more than one subdomain
+ * in spipe::Settings::domains, the box is split into a grid of subdomains.
+ * Every atom is owned by the subdomain it lies in. Each subdomain also sees
+ * the halo atoms around it, in a shell whose width is the reach of the
+ * products of the frame:
+ *
+ * - the neighbour list and the hydrogen bonds: the cutoff radius;
+ * - the bond correlations: twice the cutoff (the q3 of the neighbours);
+ * - the rings: the cutoff times maxDepth (every vertex looked at by the ring
+ *   search is within maxDepth-1 bonds of the root of the ring).
+ *
+ * The products are computed on every subdomain separately, on several
+ * threads, and stitched together by ownership. An atom's neighbours,
+ * hydrogen bonds and bond correlations come from the subdomain which owns it,
+ * and a ring comes from the subdomain which owns its root (its lowest atom
+ * index), so that every ring is counted exactly once. Since the atoms of a
+ * subdomain keep their relative order, the stitched lists are identical,
+ * element for element, to those of the whole frame.
+ *
+ * A dimension is only split if the halos of neighbouring subdomains do not
+ * overlap across the periodic boundary (that is, if the width of a subdomain
+ * plus both halos fits into the box); otherwise it is left whole.
+ */
+
+namespace sdom {
+
+/** @struct Domain
+ * @brief The atoms seen by one subdomain.
+ */
+struct Domain {
+  std::vector<int> atoms;  //! Indices of the owned and halo atoms, ascending
+  std::vector<char> owned; //! Whether each of these atoms is owned
+};
+
+//! Width of the halo needed for a set of per-frame products
+double haloWidth(const spipe::Settings &settings,
+                 const std::vector<spipe::Product> &products);
+
+//! Splits the box into a grid of subdomains, with halos of the given width
+std::vector<Domain>
+decompose(const molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+          std::array<int, 3> nDomains, double halo);
+
+//! Fills a PointCloud with the atoms of a subdomain, in the same order
+int localCloud(const molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+               const Domain &domain,
+               molSys::PointCloud<molSys::Point<double>, double> *outCloud);
+
+//! True if the settings split the frames into more than one subdomain
+bool isDecomposed(const spipe::Settings &settings);
+
+//! Computes the neighbour list, hydrogen bonds, rings and bond correlations
+//! in the schedule, subdomain by subdomain, and stitches them together
+int computeProducts(const spipe::Settings &settings,
+                    const std::vector<spipe::Product> &order,
+                    const std::vector<int> &ringSizes, spipe::FrameData &data);
+
+} // namespace sdom
+
+#endif // __DOMAIN_H_
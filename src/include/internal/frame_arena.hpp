@@ -0,0 +1,145 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#ifndef __FRAME_ARENA_H_
+#define __FRAME_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+/** @file frame_arena.hpp
+ *  @brief Arena for the short-lived scratch data of the per-frame analyses.
+ */
+
+/**
+ *  @addtogroup smem
+ *  @{
+ */
+
+/** @brief Scratch memory for the analysis of a frame.
+ *  @details Searching for rings creates and destroys a very large number of
+ * small vectors every frame (the neighbours of every vertex, and every
+ * candidate ring, most of which are not primitive). Inside a
+ * smem::ScratchScope, such containers take their memory from an arena
+ * belonging to the calling thread instead of the heap: allocating is a
+ * pointer increment, freeing does nothing, and everything is released at
+ * once when the outermost scope ends.
+ *
+ * The arena keeps one block of memory, which grows to the largest amount
+ * used by a single scope, so that after the first few frames no memory is
+ * requested from the heap at all, and memory use stays bounded by that of
+ * one frame.
+ *
+ * Containers which must outlive the scope (for instance the rings returned
+ * to the caller) have to be copied into ordinary containers before the scope
+ * ends. Outside of a scope, smem::scratch returns the heap, so the same code
+ * is safe to call without one.
+ */
+
+namespace smem {
+
+/** @struct ArenaStats
+ * @brief Allocation counters of the arena of one thread.
+ */
+struct ArenaStats {
+  std::uint64_t allocations = 0;         //! Allocations served by the arena
+  std::uint64_t bytes = 0;               //! Bytes handed out by the arena
+  std::uint64_t upstreamAllocations = 0; //! Blocks requested from the heap
+  std::uint64_t releases = 0;            //! Number of scopes ended
+  std::size_t capacity = 0;              //! Size of the retained block
+  std::size_t peakBytes = 0;             //! Most bytes used in one scope
+};
+
+/** @class FrameArena
+ * @brief A monotonic memory resource over a retained block, which is
+ * enlarged (when released) to the most memory used since the last release.
+ */
+class FrameArena : public std::pmr::memory_resource {
+public:
+  //! Starts with a block of initialBytes (by default, the first release
+  //! sizes the block)
+  explicit FrameArena(std::size_t initialBytes = 0);
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  //! Frees everything allocated since the last release
+  void release();
+
+  //! Allocation counters
+  const ArenaStats &stats() const { return counters; }
+
+  //! Number of smem::ScratchScope objects open on this arena
+  int depth = 0;
+
+private:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void *, std::size_t, std::size_t) override {}
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+  void resetBuffer();
+
+  /** @class HeapCounter
+   * @brief Upstream of the monotonic resource, counting the blocks it needs
+   * beyond the retained one.
+   */
+  class HeapCounter : public std::pmr::memory_resource {
+  public:
+    std::uint64_t *allocations = nullptr;
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *p, std::size_t bytes,
+                       std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const
+        noexcept override {
+      return this == &other;
+    }
+  };
+
+  std::vector<std::byte> block;     //! Retained block
+  HeapCounter heap;                 //! Heap, for blocks beyond the retained one
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+  std::size_t used = 0;             //! Bytes handed out since the last release
+  ArenaStats counters;
+};
+
+/** @class ScratchScope
+ * @brief While at least one scope is open on a thread, smem::scratch returns
+ * the arena of that thread. The arena is released when the outermost scope
+ * ends, so no container using it may outlive that scope.
+ */
+class ScratchScope {
+public:
+  ScratchScope();
+  ~ScratchScope();
+  ScratchScope(const ScratchScope &) = delete;
+  ScratchScope &operator=(const ScratchScope &) = delete;
+};
+
+//! Memory resource for scratch data: the arena of the calling thread inside
+//! a ScratchScope, and the heap otherwise
+std::pmr::memory_resource *scratch();
+
+//! Allocation counters of the arena of the calling thread
+ArenaStats stats();
+
+} // namespace smem
+
+#endif // __FRAME_ARENA_H_
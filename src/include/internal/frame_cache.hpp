@@ -0,0 +1,123 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#ifndef __FRAME_CACHE_H_
+#define __FRAME_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <mol_sys.hpp>
+
+/** @file frame_cache.hpp
+ *  @brief On-disk cache of neighbour lists, hydrogen-bond networks and rings.
+ */
+
+/**
+ *  @addtogroup scache
+ *  @{
+ */
+
+/** @brief Cache of the expensive per-frame intermediates.
+ *  @details Neighbour lists, hydrogen-bond networks and primitive rings take
+ * most of the time of an analysis, but only depend on the frame and on a few
+ * parameters (the cutoff, the hydrogen atom type, maxDepth). When the same
+ * trajectory is analysed again, for instance to try other classification or
+ * output options, they can be read back instead of being computed again.
+ *
+ * Once a cache directory has been opened (with scache::enable), the functions
+ * in this namespace look their result up in it first, and store it after
+ * computing it otherwise. They take the same arguments, and return the same
+ * lists, as the functions they wrap; with no cache directory they just call
+ * those functions.
+ *
+ * Entries are content-addressed: the key of an entry is a 64-bit hash of
+ * everything the result depends on. That is, the coordinates, IDs and types
+ * of the input PointCloud, the input neighbour list, the parameters, the
+ * precision of the distance kernels and (for the hydrogen bonds, which are
+ * read from the trajectory) the size, modification time and first block of
+ * the trajectory file. A changed input therefore simply misses the cache.
+ *
+ * Every entry is one file, named after the kind of list and the key, holding
+ * a header followed by the list in compressed-row form: the offset of every
+ * row (uint64, number of rows + 1) and the values (int32).
+ */
+
+namespace scache {
+
+//! Version of the entry format, written to every entry
+const std::uint32_t formatVersion = 1;
+
+/** @struct EntryHeader
+ * @brief Fixed-size header at the start of every cache entry.
+ */
+struct EntryHeader {
+  char magic[8];          //! Always "DSEAMSCA"
+  std::uint32_t version;  //! Format version
+  std::uint32_t reserved; //! Padding
+  std::uint64_t key;      //! Key of the entry
+  std::uint64_t nRows;    //! Number of rows of the list
+  std::uint64_t nValues;  //! Total number of values
+};
+
+//! Uses (and creates, if needed) a directory for the cache entries
+int enable(std::string directory);
+
+//! Stops using the cache
+void disable();
+
+//! True if a cache directory is in use
+bool isEnabled();
+
+//! Hash of the coordinates, IDs and types of a PointCloud
+std::uint64_t hashCloud(
+    const molSys::PointCloud<molSys::Point<double>, double> *yCloud);
+
+//! Hash of a row-ordered list (a neighbour list, for instance)
+std::uint64_t hashList(const std::vector<std::vector<int>> &list);
+
+//! Hash identifying a trajectory file (size, modification time and the
+//! first block of the file)
+std::uint64_t hashTrajectory(const std::string &filename);
+
+//! Reads the entry of a kind with a key into list; false if there is none
+bool load(const std::string &kind, std::uint64_t key,
+          std::vector<std::vector<int>> *list);
+
+//! Writes an entry of a kind with a key
+int store(const std::string &kind, std::uint64_t key,
+          const std::vector<std::vector<int>> &list);
+
+//! nneigh::neighListO, looked up in the cache first
+std::vector<std::vector<int>>
+neighListO(double rcutoff,
+           molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+           int typeI);
+
+//! bond::populateHbonds, looked up in the cache first
+std::vector<std::vector<int>>
+populateHbonds(std::string filename,
+               molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+               const std::vector<std::vector<int>> &nList, int targetFrame,
+               int Htype);
+
+//! primitive::ringNetwork, looked up in the cache first
+std::vector<std::vector<int>>
+ringNetwork(const std::vector<std::vector<int>> &nList, int maxDepth);
+
+} // namespace scache
+
+#endif // __FRAME_CACHE_H_
@@ -0,0 +1,138 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#ifndef __FRAME_SOURCE_H_
+#define __FRAME_SOURCE_H_
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mol_sys.hpp>
+
+/** @file frame_source.hpp
+ *  @brief File for reading the frames of a trajectory ahead of the analysis.
+ */
+
+/**
+ *  @addtogroup sinp
+ *  @{
+ */
+
+/** @brief Read-ahead of trajectory frames.
+ *  @details A frame loop which reads a frame and then analyses it leaves the
+ * disk idle during the analysis, and the cores idle while the frame is parsed.
+ * A sinp::FrameSource reads the frames of a loop (firstFrame, firstFrame +
+ * frameGap, ... up to finalFrame) on background threads, with the usual sinp
+ * readers, while the analysis of the earlier frames is running. Up to depth
+ * frames are kept ready; sinp::FrameSource::nextFrame hands them out in order.
+ *
+ * In Lua, the loop
+ *
+ *   for frame=targetFrame,finalFrame,frameGap do
+ *     readFrameOnlyOne(trajectory,frame,resCloud,oxygenAtomType,...)
+ *
+ * becomes
+ *
+ *   frames = prefetchFrameOnlyOne(trajectory,targetFrame,finalFrame,frameGap,
+ *                                 oxygenAtomType,...)
+ *   while nextFrame(frames,resCloud) do
+ *     frame = resCloud.currentFrame
+ */
+
+namespace sinp {
+
+/** @enum class FrameReader
+ * @brief The sinp reader used for every frame.
+ */
+enum class FrameReader {
+  allAtoms, //! sinp::readLammpsTrj
+  oneType,  //! sinp::readLammpsTrjO
+  reduced,  //! sinp::readLammpsTrjreduced
+  twoTypes  //! sinp::readLammpsTrj, split into the atoms of typeI and typeJ
+};
+
+/** @class FrameSource
+ * @brief Reads the frames of a loop over a trajectory ahead of time.
+ *
+ * Frames are read by nThreads background threads, into a ring of depth
+ * PointClouds. A thread only starts on a frame once there is a free slot for
+ * it, so at most depth frames are held in memory.
+ *
+ * With FrameReader::twoTypes, every frame is read once and split into two
+ * PointClouds, like sinp::readLammpsTrjreduced for typeI (sliced, if isSlice
+ * is set) and for typeJ (never sliced); nextFrame hands out both.
+ */
+class FrameSource {
+public:
+  FrameSource(std::string filename, int firstFrame, int finalFrame,
+              int frameGap, FrameReader reader, int typeI = -1,
+              bool isSlice = false,
+              std::array<double, 3> coordLow = std::array<double, 3>{0, 0, 0},
+              std::array<double, 3> coordHigh = std::array<double, 3>{0, 0,
+                                                                      0},
+              int depth = 2, int nThreads = 1, int typeJ = -1);
+  ~FrameSource();
+  FrameSource(const FrameSource &) = delete;
+  FrameSource &operator=(const FrameSource &) = delete;
+
+  //! Moves the next frame into yCloud (waiting for it, if it is not ready
+  //! yet), and the atoms of typeJ into jCloud for FrameReader::twoTypes.
+  //! Returns false once every frame of the loop has been handed out
+  bool nextFrame(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                 molSys::PointCloud<molSys::Point<double>, double> *jCloud =
+                     nullptr);
+
+  //! Number of frames handed out so far
+  int framesRead();
+
+  //! Number of frames in the loop
+  int size() const { return nFrames; }
+
+private:
+  /** @struct Slot
+   * @brief A frame being read, or ready to be handed out.
+   */
+  struct Slot {
+    molSys::PointCloud<molSys::Point<double>, double> cloud; //! The frame
+    molSys::PointCloud<molSys::Point<double>, double> jCloud; //! typeJ atoms
+    molSys::PointCloud<molSys::Point<double>, double> atoms; //! Every atom
+    int index = -1;     //! Position of the frame in the loop
+    bool ready = false; //! The frame has been read
+  };
+
+  void run();
+  void readFrame(int frame, Slot *slot);
+
+  std::string filename;
+  int firstFrame, frameGap, nFrames;
+  FrameReader reader;
+  int typeI, typeJ;
+  bool isSlice;
+  std::array<double, 3> coordLow, coordHigh;
+  std::vector<Slot> slots;
+  int nClaimed = 0;  // Frames started on by the threads
+  int nConsumed = 0; // Frames handed out
+  bool stop = false;
+  std::mutex mtx;
+  std::condition_variable slotFree, frameReady;
+  std::vector<std::thread> workers;
+};
+
+} // namespace sinp
+
+#endif // __FRAME_SOURCE_H_
@@ -22,13 +22,16 @@
 #include <iterator>
 #include <math.h>
 #include <memory>
+#include <memory_resource>
 #include <sstream>
 #include <string>
 #include <sys/stat.h>
 #include <vector>
 
 #include <cage.hpp>
+#include <frame_arena.hpp>
 #include <mol_sys.hpp>
+#include <ring_set.hpp>
 #include <seams_input.hpp>
 #include <seams_output.hpp>
 
@@ -86,11 +89,16 @@ namespace primitive {
  * vertices.
  * - @b inGraph : Bool qualifier, which is true by default. Setting it to
  * false removes the vertex from the graph.
+ *
+ * The neighbours are kept in smem::scratch memory, chosen when the Vertex is
+ * constructed: the arena of the thread inside a smem::ScratchScope, and the
+ * heap otherwise.
  */
 struct Vertex {
-  int atomIndex;                   //! This is the index according to pointCloud
-  std::vector<int> neighListIndex; //! Contains the INDICES (not the atomIDs)
-                                   //! of the neighbouring vertices
+  int atomIndex; //! This is the index according to pointCloud
+  std::pmr::vector<int> neighListIndex{
+      smem::scratch()}; //! Contains the INDICES (not the atomIDs)
+                        //! of the neighbouring vertices
   bool inGraph =
       true; //! True by default. Setting it to false removes it from the graph
 };
@@ -104,21 +112,83 @@ struct Vertex {
  * according to the PointCloud.
  * - @b rings : A row-ordered vector of vectors for the rings generated,
  * containing the indices (not IDs) of each member of the rings.
+ * - @b ringSizes : If not empty, non-zero for the ring sizes which are kept
+ * by primitive::findRings (by default every size is kept).
+ * - @b rootDistance : If not empty, the number of bonds between the current
+ * root and every vertex (or a large value beyond maxDepth). The search then
+ * skips paths which cannot get back to the root within maxDepth.
+ *
+ * All are kept in smem::scratch memory, like the neighbours of each Vertex.
+ * A Graph built inside a smem::ScratchScope (as in primitive::ringNetwork)
+ * must therefore not outlive the outermost scope of its thread: the rings
+ * have to be copied into ordinary vectors before the scope ends. A Graph
+ * built with no scope open lives on the heap, and has no such restriction.
  */
 struct Graph {
-  std::vector<Vertex> pts; //! Collection of vertices. The index of each should
-                           //! be the same as that in pointCloud
-  std::vector<std::vector<int>>
-      rings; //! List of all the rings (of every size) found
+  std::pmr::vector<Vertex> pts{
+      smem::scratch()}; //! Collection of vertices. The index of each should
+                        //! be the same as that in pointCloud
+  std::pmr::vector<std::pmr::vector<int>> rings{
+      smem::scratch()}; //! List of all the rings (of every size) found
+  std::pmr::vector<char> ringSizes{
+      smem::scratch()}; //! Ring sizes kept (every size if empty)
+  std::pmr::vector<int> rootDistance{
+      smem::scratch()}; //! Bonds to the root (no pruning if empty)
+};
+
+/*! @struct RingTracker
+ * @brief The neighbour list and primitive rings of the previous frame, from
+ * which primitive::ringNetworkIncremental updates the rings of the next frame.
+ *
+ * Contains specifically the members:
+ * - @b nList : The neighbour list (by index) the rings were found for.
+ * - @b rings : The primitive rings of nList, exactly as returned by
+ * primitive::ringNetwork.
+ * - @b maxDepth : The maximum depth the rings were searched for (-1 before
+ * the first frame).
+ */
+struct RingTracker {
+  std::vector<std::vector<int>> nList; //! Neighbour list (by index)
+  std::vector<std::vector<int>> rings; //! Primitive rings of nList
+  int maxDepth = -1;                   //! Maximum ring size searched for
+  int nFull = 0;        //! Number of frames searched from scratch
+  int nIncremental = 0; //! Number of frames updated incrementally
+  long long nRootsSearched = 0; //! Vertices searched again, in total
 };
 
 //! Returns a vector of vectors containing the rings (of all sizes), by atom
 //! index, given the neighbour list also by index (preferably the
 //! hydrogen-bonded neighbour list). Internally uses the Graph and Vertex
 //! objects.
-std::vector<std::vector<int>> ringNetwork(std::vector<std::vector<int>> nList,
+std::vector<std::vector<int>> ringNetwork(const std::vector<std::vector<int>> &nList,
                                           int maxDepth);
 
+//! Returns the same rings as primitive::ringNetwork, sorted into buckets by
+//! ring size
+ring::RingsBySize ringNetworkBySize(const std::vector<std::vector<int>> &nList,
+                                int maxDepth);
+
+//! Returns the rings of primitive::ringNetwork of the requested sizes only,
+//! pruning the search as soon as a path cannot close into one of them
+std::vector<std::vector<int>>
+ringNetworkOfSizes(const std::vector<std::vector<int>> &nList,
+                   const std::vector<int> &ringSizes);
+
+//! Returns the rings of primitive::ringNetwork whose lowest vertex (the root)
+//! is one of the marked vertices, searching only from these roots (and keeping
+//! only the requested ring sizes, if any)
+std::vector<std::vector<int>>
+ringNetworkFromRoots(const std::vector<std::vector<int>> &nList, int maxDepth,
+                     const std::vector<char> &roots,
+                     const std::vector<int> &ringSizes = {});
+
+//! Returns the same rings as primitive::ringNetwork, but only searches again
+//! around the vertices whose neighbours changed since the previous frame
+std::vector<std::vector<int>>
+ringNetworkIncremental(RingTracker &tracker,
+                       const std::vector<std::vector<int>> &nList,
+                       int maxDepth);
+
 //! Creates a graph object and fills it with the information from a neighbour
 //! list and pointCloud created before. NOTE: the neighbourListIndex contains
 //! the indices and NOT the atom IDs as in the neighbour list
@@ -134,15 +204,16 @@ Graph populateGraphFromIndices(std::vector<std::vector<int>> nList);
 //! Re-fills the neighbour lists of a graph object from a neighbour
 //! list of INDICES NOT ATOM IDs created before. NOTE: the neighbourListIndex
 //! contains the indices and NOT the atom IDs as in the neighbour list
-Graph restoreEdgesFromIndices(Graph *fullGraph,
-                              std::vector<std::vector<int>> nList);
+Graph &restoreEdgesFromIndices(Graph *fullGraph,
+                               const std::vector<std::vector<int>> &nList);
 
-//! Creates a vector of vectors of all possible rings
+//! Creates a vector of vectors of all possible rings. Inside a
+//! smem::ScratchScope, the returned Graph must not outlive the scope
 Graph countAllRingsFromIndex(std::vector<std::vector<int>> neighHbondList,
                              int maxDepth);
 
 //! Removes the non-SP rings, using the Franzblau shortest path criterion
-Graph removeNonSPrings(Graph *fullGraph);
+Graph &removeNonSPrings(Graph *fullGraph);
 
 //! Main function that searches for all rings
 int findRings(Graph *fullGraph, int v, std::vector<int> *visited, int maxDepth,
@@ -16,6 +16,7 @@
 #define __GENERIC_H_
 
 #include <array>
+#include <cmath>
 #include <iostream>
 #include <math.h>
 #include <mol_sys.hpp>
@@ -125,6 +126,63 @@ periodicDist(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
   return sqrt(r2);
 }
 
+/**
+ *  @brief Inline generic function for obtaining the unwrapped periodic distance
+ *  between two particles, from coordinates packed in the precision T.
+ *  @details The result is the same as that of gen::periodicDist for the
+ *  double precision packed coordinates.
+ *  @param[in] coords The packed coordinates and box lengths.
+ *  @param[in] iatom The index of the @f$ i^{th} @f$ atom.
+ *  @param[in] jatom The index of the @f$ j^{th} @f$ atom.
+ *  @return The unwrapped periodic distance.
+ */
+template <typename T>
+inline T periodicDist(const molSys::Coordinates<T> &coords, int iatom,
+                      int jatom) {
+  T dx = coords.x[iatom] - coords.x[jatom];
+  T dy = coords.y[iatom] - coords.y[jatom];
+  T dz = coords.z[iatom] - coords.z[jatom];
+
+  // Correct for periodicity
+  dx -= coords.box[0] * std::round(dx / coords.box[0]);
+  dy -= coords.box[1] * std::round(dy / coords.box[1]);
+  dz -= coords.box[2] * std::round(dz / coords.box[2]);
+
+  return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/**
+ *  @brief Inline generic function for obtaining the unwrapped periodic
+ *  distances between the particle iatom and every particle with an index of
+ *  jStart or more, from coordinates packed in the precision T.
+ *  @details The loop has no branches, so that the compiler can vectorize it.
+ *  The distances are the same as those of gen::periodicDist for the double
+ *  precision packed coordinates.
+ *  @param[in] coords The packed coordinates and box lengths.
+ *  @param[in] iatom The index of the @f$ i^{th} @f$ atom.
+ *  @param[in] jStart The index of the first particle to get the distance to.
+ *  @param[out] dist The distances, by index (dist[jatom] for jatom >= jStart).
+ */
+template <typename T>
+inline void periodicDistances(const molSys::Coordinates<T> &coords, int iatom,
+                              int jStart, std::vector<T> &dist) {
+  int nop = coords.x.size();
+  const T xi = coords.x[iatom], yi = coords.y[iatom], zi = coords.z[iatom];
+  const T lx = coords.box[0], ly = coords.box[1], lz = coords.box[2];
+  const T *x = coords.x.data(), *y = coords.y.data(), *z = coords.z.data();
+  T *r = dist.data();
+
+  for (int jatom = jStart; jatom < nop; jatom++) {
+    T dx = xi - x[jatom];
+    T dy = yi - y[jatom];
+    T dz = zi - z[jatom];
+    dx -= lx * std::round(dx / lx);
+    dy -= ly * std::round(dy / ly);
+    dz -= lz * std::round(dz / lz);
+    r[jatom] = std::sqrt(dx * dx + dy * dy + dz * dz);
+  } // end of loop through jatom
+}
+
 /**
  *  Inline generic function for obtaining
  *  the unwrapped periodic distance between one particle and another point,
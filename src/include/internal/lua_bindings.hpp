@@ -0,0 +1,293 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#ifndef __LUA_BINDINGS_H_
+#define __LUA_BINDINGS_H_
+
+#include <deque>
+#include <vector>
+
+#include <bond.hpp>
+#include <frame_cache.hpp>
+#include <frame_source.hpp>
+#include <franzblau.hpp>
+#include <mol_sys.hpp>
+#include <neighbours.hpp>
+#include <ring_set.hpp>
+
+#include <sol/sol.hpp>
+
+/** @file lua_bindings.hpp
+ *  @brief Types shared between the C++ library and the Lua scripts.
+ */
+
+/**
+ *  @addtogroup slua
+ *  @{
+ */
+
+/** @brief Lua usertypes with reference semantics.
+ *  @details Every PointCloud, neighbour list and ring list seen by a Lua
+ * script is owned on the C++ side: either by main, which hands pointers to
+ * resCloud, nList, rings etc. to Lua, or by a slua::Store. Lua only holds
+ * references to them, so that passing them to the registered functions never
+ * copies any atoms or lists.
+ *
+ * The functions which fill a PointCloud (sinp::readLammpsTrjreduced,
+ * chill::getCorrel and so on) return a reference to the PointCloud they were
+ * given, and functions reading neighbour lists or rings take them by const
+ * reference. Older scripts which assign the result back, as in
+ * resCloud=readFrameOnlyOne(trajectory,frame,resCloud,...), therefore keep
+ * working, with resCloud still referring to the same object.
+ *
+ * slua::NeighbourList and slua::RingSet are the same C++ type, and so the
+ * same usertype to sol: a script can pass a neighbour list where rings are
+ * expected (or the other way around) without any error. The distinction is
+ * by naming convention only, documenting which of them a function reads or
+ * fills. They are not separate wrapper types, since the library functions
+ * registered directly in main take and return plain vectors of vectors.
+ */
+
+namespace slua {
+
+//! Row-ordered neighbour list (by atom ID or index)
+using NeighbourList = std::vector<std::vector<int>>;
+//! Rings, each a vector of atom indices (the same type as NeighbourList)
+using RingSet = std::vector<std::vector<int>>;
+
+/** @struct Store
+ * @brief Owns the objects created from Lua with newPointCloud,
+ * newNeighbourList, newRingSet, newRingsBySize, ringsBySize, newVerletList,
+ * newRingTracker and the prefetchFrame functions.
+ *
+ * std::deque never moves its elements, so the references handed to Lua stay
+ * valid for as long as the Store lives. The Store must outlive the Lua state.
+ */
+struct Store {
+  std::deque<molSys::PointCloud<molSys::Point<double>, double>> clouds;
+  std::deque<NeighbourList> neighbourLists;
+  std::deque<RingSet> ringSets;
+  std::deque<ring::RingsBySize> ringsBySize;
+  std::deque<nneigh::VerletList> verletLists;
+  std::deque<primitive::RingTracker> ringTrackers;
+  std::deque<sinp::FrameSource> frameSources;
+  int prefetchDepth = 2;   //! Frames read ahead by every FrameSource
+  int prefetchThreads = 1; //! Threads reading frames for every FrameSource
+};
+
+/**
+ * @details Registers the PointCloud usertype and the constructors for
+ * C++-owned objects. PointCloud has no Lua constructor of its own, so that
+ * Lua never owns (and never garbage-collects) a PointCloud which a function
+ * may have returned a reference to.
+ * @param[in] lua The Lua state
+ * @param[in] store Owner of the objects created from Lua
+ */
+inline void registerTypes(sol::state &lua, Store &store) {
+  using Cloud = molSys::PointCloud<molSys::Point<double>, double>;
+  // -----------------
+  // PointCloud: read-only view of the frame information
+  lua.new_usertype<Cloud>(
+      "PointCloud", sol::no_constructor, "nop", sol::readonly(&Cloud::nop),
+      "currentFrame", sol::readonly(&Cloud::currentFrame), "box",
+      sol::readonly(&Cloud::box), "boxLow", sol::readonly(&Cloud::boxLow),
+      "size", [](const Cloud &cloud) { return cloud.pts.size(); });
+  // -----------------
+  // RingsBySize: rings bucketed by size, for the ring analyses
+  lua.new_usertype<ring::RingsBySize>(
+      "RingsBySize", sol::no_constructor, "size", &ring::RingsBySize::size,
+      "maxRingSize", &ring::RingsBySize::maxRingSize, "count",
+      &ring::RingsBySize::count);
+  // -----------------
+  // VerletList: neighbour list state kept across frames
+  lua.new_usertype<nneigh::VerletList>(
+      "VerletList", sol::no_constructor, "skin", &nneigh::VerletList::skin,
+      "nBuilds", sol::readonly(&nneigh::VerletList::nBuilds), "nReuses",
+      sol::readonly(&nneigh::VerletList::nReuses));
+  // -----------------
+  // RingTracker: rings of the previous frame, updated incrementally
+  lua.new_usertype<primitive::RingTracker>(
+      "RingTracker", sol::no_constructor, "nFull",
+      sol::readonly(&primitive::RingTracker::nFull), "nIncremental",
+      sol::readonly(&primitive::RingTracker::nIncremental));
+  // -----------------
+  // FrameSource: frames of a loop, read ahead on background threads
+  lua.new_usertype<sinp::FrameSource>(
+      "FrameSource", sol::no_constructor, "size", &sinp::FrameSource::size,
+      "framesRead", &sinp::FrameSource::framesRead);
+  // -----------------
+  // C++-owned objects for scripts which need more than the predefined ones
+  lua.set_function("newPointCloud", [&store]() -> Cloud & {
+    store.clouds.emplace_back();
+    return store.clouds.back();
+  });
+  lua.set_function("newNeighbourList", [&store]() -> NeighbourList & {
+    store.neighbourLists.emplace_back();
+    return store.neighbourLists.back();
+  });
+  lua.set_function("newRingSet", [&store]() -> RingSet & {
+    store.ringSets.emplace_back();
+    return store.ringSets.back();
+  });
+  lua.set_function("newRingsBySize", [&store]() -> ring::RingsBySize & {
+    store.ringsBySize.emplace_back();
+    return store.ringsBySize.back();
+  });
+  lua.set_function("ringsBySize",
+                   [&store](const RingSet &rings) -> ring::RingsBySize & {
+                     store.ringsBySize.emplace_back(rings);
+                     return store.ringsBySize.back();
+                   });
+  lua.set_function("newVerletList",
+                   [&store](sol::optional<double> skin) -> nneigh::VerletList & {
+                     store.verletLists.emplace_back();
+                     if (skin) {
+                       store.verletLists.back().skin = *skin;
+                     }
+                     return store.verletLists.back();
+                   });
+  lua.set_function("newRingTracker", [&store]() -> primitive::RingTracker & {
+    store.ringTrackers.emplace_back();
+    return store.ringTrackers.back();
+  });
+  // -----------------
+  // Frame loops read ahead: the arguments are those of the matching reader
+  // (readFrameOnlyOne, readFrame and readFrameOnlyOneAllAtoms), with the
+  // single frame replaced by the first frame, last frame and frame gap
+  lua.set_function(
+      "prefetchFrameOnlyOne",
+      [&store](std::string filename, int firstFrame, int finalFrame,
+               int frameGap, int typeI, bool isSlice,
+               std::array<double, 3> coordLow,
+               std::array<double, 3> coordHigh) -> sinp::FrameSource & {
+        store.frameSources.emplace_back(
+            filename, firstFrame, finalFrame, frameGap,
+            sinp::FrameReader::reduced, typeI, isSlice, coordLow, coordHigh,
+            store.prefetchDepth, store.prefetchThreads);
+        return store.frameSources.back();
+      });
+  lua.set_function(
+      "prefetchFrame",
+      [&store](std::string filename, int firstFrame, int finalFrame,
+               int frameGap, int typeI, bool isSlice,
+               std::array<double, 3> coordLow,
+               std::array<double, 3> coordHigh) -> sinp::FrameSource & {
+        store.frameSources.emplace_back(
+            filename, firstFrame, finalFrame, frameGap,
+            sinp::FrameReader::oneType, typeI, isSlice, coordLow, coordHigh,
+            store.prefetchDepth, store.prefetchThreads);
+        return store.frameSources.back();
+      });
+  lua.set_function(
+      "prefetchFrameOnlyOneAllAtoms",
+      [&store](std::string filename, int firstFrame, int finalFrame,
+               int frameGap, bool isSlice, std::array<double, 3> coordLow,
+               std::array<double, 3> coordHigh) -> sinp::FrameSource & {
+        store.frameSources.emplace_back(
+            filename, firstFrame, finalFrame, frameGap,
+            sinp::FrameReader::allAtoms, -1, isSlice, coordLow, coordHigh,
+            store.prefetchDepth, store.prefetchThreads);
+        return store.frameSources.back();
+      });
+  lua.set_function("nextFrame",
+                   [](sinp::FrameSource &source, Cloud &cloud) {
+                     return source.nextFrame(&cloud);
+                   });
+  // -----------------
+  // Sizes of lists (neighbour lists or rings alike), without converting them
+  // into Lua tables
+  lua.set_function("listSize",
+                   [](const NeighbourList &list) { return list.size(); });
+}
+
+/**
+ * @details Registers in-place versions of the functions which build
+ * neighbour lists and rings. These fill an existing list (for instance the
+ * nList, hbnList and ringsAllSizes objects set up by main), instead of
+ * creating a new Lua-owned list every frame, which Lua would only free at its
+ * next garbage collection.
+ * @param[in] lua The Lua state
+ */
+inline void registerInPlace(sol::state &lua) {
+  using Cloud = molSys::PointCloud<molSys::Point<double>, double>;
+  lua.set_function("neighborListInto", [](NeighbourList &out, double rcutoff,
+                                          Cloud &cloud, int typeI) {
+    out = scache::neighListO(rcutoff, &cloud, typeI);
+  });
+  lua.set_function("neighborListVerletInto",
+                   [](NeighbourList &out, nneigh::VerletList &verlet,
+                      double rcutoff, Cloud &cloud, int typeI) {
+                     out = nneigh::neighListOVerlet(verlet, rcutoff, &cloud,
+                                                    typeI);
+                   });
+  lua.set_function("getHbondNetworkInto",
+                   [](NeighbourList &out, std::string filename, Cloud &cloud,
+                      const NeighbourList &nList, int targetFrame, int Htype) {
+                     out = scache::populateHbonds(filename, &cloud, nList,
+                                                  targetFrame, Htype);
+                   });
+  lua.set_function("getHbondNetworkFromCloudsInto",
+                   [](NeighbourList &out, Cloud &cloud, Cloud &hCloud,
+                      const NeighbourList &nList) {
+                     out = bond::populateHbondsWithInputClouds(&cloud, &hCloud,
+                                                               nList);
+                   });
+  lua.set_function("bondNetworkByIndexInto",
+                   [](NeighbourList &out, Cloud &cloud,
+                      const NeighbourList &nList) {
+                     out = nneigh::neighbourListByIndex(&cloud, nList);
+                   });
+  lua.set_function("getPrimitiveRingsInto", [](RingSet &out,
+                                               const NeighbourList &nList,
+                                               int maxDepth) {
+    out = scache::ringNetwork(nList, maxDepth);
+  });
+  lua.set_function("getPrimitiveRingsIncrementalInto",
+                   [](RingSet &out, primitive::RingTracker &tracker,
+                      const NeighbourList &nList, int maxDepth) {
+                     out = primitive::ringNetworkIncremental(tracker, nList,
+                                                             maxDepth);
+                   });
+  lua.set_function("getPrimitiveRingsBySizeInto",
+                   [](ring::RingsBySize &out, const NeighbourList &nList,
+                      int maxDepth) {
+                     out = primitive::ringNetworkBySize(nList, maxDepth);
+                   });
+  // Only the rings of some sizes, like {5, 6} for the bulk ice criteria
+  lua.set_function("getPrimitiveRingsOfSizesInto",
+                   [](RingSet &out, const NeighbourList &nList,
+                      std::vector<int> ringSizes) {
+                     out = primitive::ringNetworkOfSizes(nList, ringSizes);
+                   });
+}
+
+/**
+ * @details Picks out both overloads of a ring analysis: the one taking the
+ * rings as a vector of vectors (a RingSet from newRingSet or
+ * getPrimitiveRings), and the one taking them bucketed by size (from
+ * ringsBySize or getPrimitiveRingsBySizeInto). Sol calls whichever matches
+ * the rings the script passes.
+ * @param[in] byVector The analysis, with the rings as a vector of vectors
+ * @param[in] bySize The analysis, with the rings as a ring::RingsBySize
+ */
+template <typename... Args>
+auto ringOverloads(
+    int (*byVector)(std::string, const RingSet &, Args...),
+    int (*bySize)(std::string, const ring::RingsBySize &, Args...)) {
+  return sol::overload(byVector, bySize);
+}
+
+} // namespace slua
+
+#endif // __LUA_BINDINGS_H_
@@ -174,6 +174,8 @@ template <typename S, typename T> struct PointCloud {
   std::vector<T> box;    //! Periodic box lengths
   std::vector<T> boxLow; //! xlo, ylo, zlo
   std::unordered_map<int, int> idIndexMap;
+  std::vector<int> fileOrder; //! Index of the k-th atom read in, if the atoms
+                              //! have been reordered (otherwise empty)
 };
 
 //! Creates an unordered map, with the atomIDs as keys and molecular IDs as the
@@ -199,6 +201,109 @@ int searchMolList(std::vector<std::vector<int>> molList, int molIDtoFind);
 //!//! Function for clearing vectors in PointCloud after multiple usage
 molSys::PointCloud<molSys::Point<double>, double>
 clearPointCloud(molSys::PointCloud<molSys::Point<double>, double> *yCloud);
+
+/** @enum class molSys::Precision
+ * @brief Precision of the coordinates used by the pairwise distance kernels
+ * (the neighbour lists and the RDF).
+ * @details With single precision, the coordinates are copied into floats
+ * before the pair loops, which halves the memory traffic and doubles the
+ * number of SIMD lanes. Histograms and normalizations are still accumulated
+ * in double precision. The default is full (double) precision, unless the
+ * library was built with DSEAMS_SINGLE_PRECISION.
+ */
+enum class Precision {
+  full,  //! Double precision coordinates
+  single //! Single precision coordinates
+};
+
+/** @struct Coordinates
+ *  @brief Coordinates of a PointCloud, packed into contiguous arrays of type T
+ * (a structure of arrays) for the pairwise distance kernels.
+ */
+template <typename T> struct Coordinates {
+  std::vector<T> x, y, z; //! Coordinates, by index
+  std::vector<int> type;  //! Type IDs, by index
+  std::array<T, 3> box;   //! Periodic box lengths
+};
+
+//! Copies the coordinates, types and box of a PointCloud into a Coordinates
+template <typename T>
+void packCoordinates(
+    const molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    Coordinates<T> &coords);
+
+// The kernels are compiled for float and double only
+extern template struct Coordinates<float>;
+extern template struct Coordinates<double>;
+extern template void
+packCoordinates(const molSys::PointCloud<molSys::Point<double>, double> *,
+                Coordinates<float> &);
+extern template void
+packCoordinates(const molSys::PointCloud<molSys::Point<double>, double> *,
+                Coordinates<double> &);
+
+//! Sets the precision of the pairwise distance kernels
+void setPrecision(Precision value);
+
+//! Returns the precision of the pairwise distance kernels
+Precision precision();
+
+//! Calls work with the coordinates of yCloud, packed in the current precision.
+//! The coordinates are packed again on every call; they are not cached across
+//! the neighbour lists or RDFs computed for the same frame
+template <typename Work>
+void withCoordinates(
+    const molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    Work &&work) {
+  if (precision() == Precision::single) {
+    Coordinates<float> coords;
+    packCoordinates(yCloud, coords);
+    work(coords);
+  } else {
+    Coordinates<double> coords;
+    packCoordinates(yCloud, coords);
+    work(coords);
+  }
+}
+
+/** @enum class molSys::AtomOrder
+ * @brief Order of the atoms (PointCloud::pts) of every frame read in.
+ * @details Atoms close to each other in space are usually far apart in a
+ * LAMMPS dump, so the neighbour list, ring and bond order parameter loops jump
+ * all over memory. Along a space-filling curve, neighbouring atoms mostly have
+ * nearby indices instead. The trajectory readers put the atoms in this order
+ * after reading each frame, and record the order in which they were read in
+ * PointCloud::fileOrder, so that the per-atom output files still list the
+ * atoms in the order of the trajectory.
+ */
+enum class AtomOrder {
+  file,   //! The order of the trajectory file
+  morton, //! Along a Morton (Z-order) curve
+  hilbert //! Along a Hilbert curve
+};
+
+//! Sets the order of the atoms of every frame read in from now on
+void setAtomOrder(AtomOrder value);
+
+//! Returns the order of the atoms of every frame read in
+AtomOrder atomOrder();
+
+//! Permutes the atoms of a PointCloud along a space-filling curve, updating
+//! the idIndexMap and the fileOrder
+int reorderAtoms(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                 AtomOrder order);
+
+//! Index (in pts) of the k-th atom in the order in which the atoms were read
+inline int
+fileIndex(const molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+          int k) {
+  return yCloud->fileOrder.empty() ? k : yCloud->fileOrder[k];
+}
+
+//! Position of every atom (by index) in the order in which the atoms were read
+std::vector<int> filePositions(
+    const molSys::PointCloud<molSys::Point<double>, double> *yCloud);
+
 } // namespace molSys
 
 #endif // __MOL_SYS_H_
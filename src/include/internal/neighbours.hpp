@@ -15,6 +15,11 @@
 #ifndef __NEIGHBOURS_H_
 #define __NEIGHBOURS_H_
 
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
 #include <generic.hpp>
 #include <mol_sys.hpp>
 
@@ -50,6 +55,87 @@
  */
 
 namespace nneigh {
+
+/** @struct VerletList
+ * @brief Neighbour list state kept from one frame to the next, so that the
+ * neighbour list of a frame can be obtained from the previous one.
+ * @details When the list is built, every pair of atoms closer than
+ * rcutoff+skin is saved. As long as no atom has moved by more than skin/2
+ * since then (atoms are matched across frames by their atom IDs), every pair
+ * within rcutoff in the current frame is one of the saved pairs, so only these
+ * need to be checked. Create one VerletList per neighbour list that is updated
+ * frame after frame, and pass it to nneigh::neighListOVerlet.
+ */
+struct VerletList {
+  double skin = 0.5;     //! Extra distance added to the cutoff of saved pairs
+  double rcutoff = -1.0; //! Cutoff of the last build (-1 if never built)
+  int typeI = -1;        //! Atom type of the last build
+  std::vector<int> atomIDs;  //! Atom ID of every index at the last build
+  std::vector<int> types;    //! Atom type of every index at the last build
+  std::unordered_map<int, int> refIndex; //! Atom ID to index, at the last build
+  std::vector<std::array<double, 3>> refPos; //! Coordinates at the last build
+  std::vector<double> refBox;                //! Box lengths at the last build
+  std::vector<std::pair<int, int>> pairs; //! Saved pairs (indices, i < j)
+  molSys::Precision precision = molSys::Precision::full; //! Of the last build
+  int nBuilds = 0;  //! Number of times the saved pairs were rebuilt
+  int nReuses = 0;  //! Number of frames which reused the saved pairs
+};
+
+/** @class Adjacency
+ * @brief Answers whether an atom is in the neighbour list of another atom in
+ * constant time.
+ * @details The topological criteria (ring::basalConditions,
+ * prism3::basalPrismConditions, pntToPnt::relOrderHC and so on) test many
+ * pairs of atoms for every candidate pair of rings. Build one Adjacency per
+ * frame from the neighbour list by index, and pass it to all of them by
+ * reference.
+ *
+ * Every (row, neighbour) pair of the neighbour list is stored as a 64-bit key
+ * in an open-addressed hash table with linear probing, kept at most half full.
+ * Just like a lookup in the neighbour list itself, the pairs are directed:
+ * (iatom, jatom) is present if jatom is one of the neighbours on row iatom.
+ */
+class Adjacency {
+public:
+  Adjacency() = default;
+  //! Builds the table from a row-ordered neighbour list (by index)
+  explicit Adjacency(const std::vector<std::vector<int>> &nList);
+
+  //! True if jatom is a neighbour on row iatom of the neighbour list
+  bool areBonded(int iatom, int jatom) const {
+    if (slots.empty()) {
+      return false;
+    }
+    std::uint64_t key = pack(iatom, jatom);
+    for (std::size_t slot = hash(key) & mask;; slot = (slot + 1) & mask) {
+      if (slots[slot] == key) {
+        return true;
+      }
+      if (slots[slot] == emptySlot) {
+        return false;
+      }
+    } // end of probing
+  }
+
+  //! Number of (row, neighbour) pairs stored
+  std::size_t size() const { return nPairs; }
+
+private:
+  static constexpr std::uint64_t emptySlot = ~std::uint64_t{0};
+  static std::uint64_t pack(int iatom, int jatom) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(iatom))
+            << 32) |
+           static_cast<std::uint32_t>(jatom);
+  }
+  static std::size_t hash(std::uint64_t key) {
+    return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+  }
+
+  std::vector<std::uint64_t> slots; //! The keys, or emptySlot
+  std::size_t mask = 0;             //! Number of slots - 1
+  std::size_t nPairs = 0;           //! Number of keys stored
+};
+
 //! All these functions use atom IDs and not indices
 
 //! Inefficient @f$O(n^2)@f$ implementation of neighbour lists when there are
@@ -65,6 +151,12 @@ std::vector<std::vector<int>> neighListO(
     double rcutoff, molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     int typeI);
 
+//! Same neighbour list as neighListO, reusing the pairs saved in a
+//! VerletList for as long as the atoms have not moved too far
+std::vector<std::vector<int>> neighListOVerlet(
+    VerletList &verlet, double rcutoff,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int typeI);
+
 //! Inefficient @f$O(n^2)@f$ implementation of neighbour lists
 //! You can only use this for neighbour lists with one type
 std::vector<std::vector<int>> halfNeighList(
@@ -78,7 +170,7 @@ std::vector<std::vector<int>> halfNeighList(
 //! atom indices, according to the pointCloud
 std::vector<std::vector<int>> neighbourListByIndex(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<std::vector<int>> nList);
+    const std::vector<std::vector<int>> &nList);
 
 //! Gets a neighbour list by index, according to a pointCloud given as the
 //! input. Assume no slices or other skullduggery
@@ -0,0 +1,162 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#ifndef __OUTPUT_SINK_H_
+#define __OUTPUT_SINK_H_
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+/** @file output_sink.hpp
+ *  @brief Buffered, asynchronously flushed output files used by the writers in
+ * seams_output.cpp.
+ */
+
+/**
+ *  @addtogroup sout
+ *  @{
+ */
+
+namespace sout {
+
+/** @struct WriteJob
+ * @brief A chunk of formatted output, waiting to be written to an open file
+ * handle by the writer thread.
+ *
+ * The file handle is shared, so that the file is closed only after the last
+ * queued chunk for it has been written out.
+ */
+struct WriteJob {
+  std::shared_ptr<std::FILE> file; //! File the chunk belongs to
+  fmt::memory_buffer data;         //! Formatted output
+  std::string filename;            //! Name of the file, for error messages
+};
+
+/** @class AsyncWriter
+ * @brief A single background thread which writes out filled buffers, so that
+ * disk I/O does not stall the analysis loop.
+ *
+ * Jobs are written in the order in which they were submitted. Files for which
+ * a write failed are recorded, and reported by sout::flushAllSinks and
+ * sout::closeAllSinks.
+ */
+class AsyncWriter {
+public:
+  AsyncWriter();
+  ~AsyncWriter();
+  AsyncWriter(const AsyncWriter &) = delete;
+  AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+  //! Queue a buffer for writing
+  void submit(WriteJob job);
+  //! Block until every queued buffer has been written out
+  void drain();
+  //! Returns (and forgets) the files for which a write has failed
+  std::vector<std::string> takeFailures();
+
+private:
+  void run();
+
+  std::deque<WriteJob> queue;
+  std::vector<std::string> failedFiles;
+  std::mutex mtx;
+  std::condition_variable workReady, workDone;
+  bool busy = false;
+  bool stop = false;
+  std::thread worker;
+};
+
+/** @class OutputSink
+ * @brief An output file kept open for as long as the sink lives, with a large
+ * in-memory buffer filled using fmt.
+ *
+ * Once the buffer grows past flushThreshold it is handed over to the
+ * AsyncWriter. Whatever remains is handed over when the sink is flushed or
+ * destroyed.
+ */
+class OutputSink {
+public:
+  //! Open a file for writing; the file is truncated unless append is true
+  explicit OutputSink(const std::string &filename, bool append = false);
+  ~OutputSink();
+  OutputSink(const OutputSink &) = delete;
+  OutputSink &operator=(const OutputSink &) = delete;
+
+  //! True if the underlying file could be opened
+  bool isOpen() const { return static_cast<bool>(file); }
+
+  //! Format and append to the buffer
+  template <typename... Args>
+  void print(fmt::format_string<Args...> formatStr, Args &&...args) {
+    fmt::format_to(std::back_inserter(buffer), formatStr,
+                   std::forward<Args>(args)...);
+    if (buffer.size() >= flushThreshold) {
+      flush();
+    }
+  }
+
+  //! Append raw bytes to the buffer (used for binary output)
+  void write(const void *data, std::size_t nBytes) {
+    const char *bytes = static_cast<const char *>(data);
+    buffer.append(bytes, bytes + nBytes);
+    if (buffer.size() >= flushThreshold) {
+      flush();
+    }
+  }
+
+  //! Hand the buffered output over to the writer thread
+  void flush();
+
+  //! Buffer size (in bytes) after which output is handed over automatically
+  static constexpr std::size_t flushThreshold = 1 << 20;
+
+private:
+  std::shared_ptr<std::FILE> file;
+  fmt::memory_buffer buffer;
+  std::string filename;
+};
+
+//! The writer thread shared by all sinks
+AsyncWriter &writer();
+
+//! Returns the sink for a file which is appended to over the whole run. The
+//! file is opened in append mode on first use and kept open afterwards
+OutputSink &appendSink(const std::string &filename);
+
+//! Creates the directory (like sout::makePath), but only touches the file
+//! system the first time a particular path is requested
+int ensurePath(const std::string &path);
+
+//! Flush every open sink and wait until all output has reached the disk.
+//! Returns 1 if any write failed since the last call, and 0 otherwise
+int flushAllSinks();
+
+//! Flush and close every sink opened with sout::appendSink. Returns 1 if any
+//! write failed since the last call, and 0 otherwise
+int closeAllSinks();
+
+} // namespace sout
+
+#endif // __OUTPUT_SINK_H_
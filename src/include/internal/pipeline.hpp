@@ -0,0 +1,160 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#ifndef __PIPELINE_H_
+#define __PIPELINE_H_
+
+#include <array>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mol_sys.hpp>
+#include <ring_set.hpp>
+
+/** @file pipeline.hpp
+ *  @brief Single pass over a trajectory for several analyses at once.
+ */
+
+/**
+ *  @addtogroup spipe
+ *  @{
+ */
+
+/** @brief Scheduling of several analyses over one pass of the trajectory.
+ *  @details The topoTwoDim, topoOneDim and bulk blocks of main each run their
+ * own Lua loop over the trajectory, so when more than one of them is switched
+ * on, every frame is read, and its neighbour list, hydrogen-bond network and
+ * rings are built, once per block.
+ *
+ * A spipe::Pipeline instead reads every frame once. Each spipe::Analysis
+ * lists the per-frame products it needs (spipe::Product). The products form a
+ * small dependency graph (rings are built from the hydrogen-bond network,
+ * which is built from the neighbour list and the hydrogen atoms, and so on);
+ * the pipeline computes the products needed by at least one analysis (and
+ * whatever those depend on) once per frame, in dependency order, and then
+ * runs every analysis on them.
+ */
+
+namespace spipe {
+
+/** @enum class Product
+ * @brief Intermediate results shared by the analyses of a frame.
+ */
+enum class Product {
+  frame,      //! Oxygen atoms of the frame (FrameData::cloud)
+  hydrogens,  //! Hydrogen atoms of the frame (FrameData::hCloud)
+  neighbours, //! Neighbour list by atom ID (FrameData::nList)
+  hbonds,     //! Hydrogen-bond network by index (FrameData::hbnList)
+  rings,      //! Primitive rings of the network, by size (FrameData::rings)
+  bop         //! CHILL+ bond correlations, stored in FrameData::cloud
+};
+
+//! Name of a product, for messages and timers
+const char *productName(Product product);
+
+//! Products which have to be computed before a product
+std::vector<Product> dependencies(Product product);
+
+/** @struct Settings
+ * @brief Trajectory, frames and parameters shared by every analysis. These
+ * are the variables set by the vars script of the Lua blocks.
+ */
+struct Settings {
+  std::string trajectory;              //! Trajectory file
+  int firstFrame = 1;                  //! First frame (targetFrame)
+  int finalFrame = 1;                  //! Last frame (inclusive)
+  int frameGap = 1;                    //! Gap between frames
+  int oxygenType = 2;                  //! LAMMPS type of the O atoms
+  int hydrogenType = 1;                //! LAMMPS type of the H atoms
+  double cutoffRadius = 3.5;           //! Neighbour list cutoff
+  int maxDepth = 6;                    //! Largest ring size searched for
+  bool isSlice = false;                //! Only use the atoms inside a slice
+  std::array<double, 3> sliceLow{0, 0, 0};  //! Lower limits of the slice
+  std::array<double, 3> sliceHigh{0, 0, 0}; //! Upper limits of the slice
+  std::string outDir = "runOne/";      //! Output directory
+  int prefetchDepth = 2;               //! Frames read ahead
+  int prefetchThreads = 1;             //! Threads reading frames
+  std::array<int, 3> domains{1, 1, 1}; //! Subdomains along x, y and z
+  int domainThreads = 1;               //! Threads working on the subdomains
+};
+
+/** @struct FrameData
+ * @brief The products of the current frame. Only the products needed by
+ * some analysis are filled in.
+ */
+struct FrameData {
+  molSys::PointCloud<molSys::Point<double>, double> cloud;  //! O atoms
+  molSys::PointCloud<molSys::Point<double>, double> hCloud; //! H atoms
+  std::vector<std::vector<int>> nList;   //! Neighbour list by atom ID
+  std::vector<std::vector<int>> hbnList; //! Hydrogen bonds by index
+  ring::RingsBySize rings;                   //! Primitive rings, by size
+};
+
+/** @struct Analysis
+ * @brief An analysis run on every frame, with the products it reads.
+ */
+struct Analysis {
+  std::string name;           //! Name, for messages
+  std::vector<Product> needs; //! Products read by run
+  std::function<int(const Settings &, FrameData &)> run; //! Per-frame work
+  std::vector<int> ringSizes; //! Ring sizes read by run (all if empty)
+};
+
+/** @class Pipeline
+ * @brief Runs a set of analyses over a single pass of the trajectory.
+ */
+class Pipeline {
+public:
+  explicit Pipeline(Settings settings) : settings(std::move(settings)) {}
+
+  //! Adds an analysis; analyses run in the order in which they were added
+  void add(Analysis analysis);
+
+  //! The products computed for every frame, in the order they are computed
+  std::vector<Product> schedule() const;
+
+  //! The ring sizes searched for (empty if every size up to maxDepth is)
+  std::vector<int> ringSizes() const;
+
+  //! Reads every frame once, and runs all the analyses on it
+  int run();
+
+  //! Number of analyses added
+  int size() const { return analyses.size(); }
+
+private:
+  Settings settings;
+  std::vector<Analysis> analyses;
+};
+
+//! Ring analysis for quasi-two-dimensional ice (ring::polygonRingAnalysis)
+Analysis topoTwoDimAnalysis(double sheetArea);
+
+//! Prism analysis for quasi-one-dimensional ice (ring::prismAnalysis). This
+//! removes the axial translation of the frame, so add it after the other
+//! analyses
+Analysis topoOneDimAnalysis();
+
+//! DDCs and HCs in bulk ice (ring::topoBulkAnalysis)
+Analysis topoBulkAnalysis();
+
+//! CHILL+ classification of bulk ice, written out as a dump file
+Analysis chillPlusAnalysis(std::string outputFileName, std::string dumpName);
+
+} // namespace spipe
+
+#endif // __PIPELINE_H_
@@ -32,6 +32,7 @@
 
 #include <cage.hpp>
 #include <mol_sys.hpp>
+#include <neighbours.hpp>
 #include <seams_input.hpp>
 #include <seams_output.hpp>
 
@@ -64,12 +65,12 @@ double getAvgHeightPrismBlock(
 //! Get the relative ordering of a pair of basal rings for a deformed
 //! prism/perfect prism. Outputs a vector of vectors of indices, such that the
 //! first vector is for the first basal ring, and the second vector is for the
-//! second basal ring. The input neighbour list is with respect to indices, not
+//! second basal ring. The bonds are those of the neighbour list by index, not
 //! IDs
 int relOrderPrismBlock(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<int> basal1, std::vector<int> basal2,
-    std::vector<std::vector<int>> nList, std::vector<int> *outBasal1,
+    const nneigh::Adjacency &bonded, std::vector<int> *outBasal1,
     std::vector<int> *outBasal2);
 
 //! Get the relative ordering of a pair of basal rings for a deformed
@@ -101,13 +102,14 @@ Eigen::MatrixXd getPointSetCage(ring::strucType type);
 //! Matches the order of the basal rings of an HC or a potential HC
 int relOrderHC(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                std::vector<int> basal1, std::vector<int> basal2,
-               std::vector<std::vector<int>> nList,
+               const nneigh::Adjacency &bonded,
                std::vector<int> *matchedBasal1,
                std::vector<int> *matchedBasal2);
 
 //! Matches the order of the basal rings of an DDC or a potential HC
-std::vector<int> relOrderDDC(int index, std::vector<std::vector<int>> rings,
-                             std::vector<cage::Cage> cageList);
+std::vector<int> relOrderDDC(int index,
+                             const std::vector<std::vector<int>> &rings,
+                             const std::vector<cage::Cage> &cageList);
 
 //! Fills up an eigen matrix point set using the basal rings basal1 and basal2,
 //! changing the order of the point set by filling up from the startingIndex
@@ -0,0 +1,101 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#ifndef __PROFILING_H_
+#define __PROFILING_H_
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+
+/** @file profiling.hpp
+ *  @brief Opt-in per-stage timers and counters.
+ */
+
+/**
+ *  @addtogroup sprof
+ *  @{
+ */
+
+/** @brief Timing and counting of the analysis stages.
+ *  @details The functions registered in Lua (reading frames, neighbour
+ * lists, hydrogen bonds, bond order parameters, rings, shape matching and
+ * output) each open a sprof::StageTimer for their stage, and add the number
+ * of items they processed with sprof::count. Nothing is recorded unless
+ * profiling has been switched on with sprof::enable; when it is off a timer
+ * costs a single flag check.
+ *
+ * Times are inclusive: a stage which calls another instrumented function
+ * (for instance bond::populateHbonds, which reads the hydrogen atoms of the
+ * frame) also counts the time spent in the inner stage.
+ */
+
+namespace sprof {
+
+/** @struct StageStats
+ * @brief Accumulated totals for one stage.
+ */
+struct StageStats {
+  std::uint64_t calls = 0; //! Number of times the stage was entered
+  double seconds = 0.0;    //! Total wall-clock time, in seconds
+  std::uint64_t items = 0; //! Items processed (atoms, bonds, rings ...)
+};
+
+/** @class StageTimer
+ * @brief Adds the wall-clock time between its construction and destruction
+ * to a stage. Does nothing if profiling is switched off.
+ */
+class StageTimer {
+public:
+  //! The stage name must be a string literal (it is not copied)
+  explicit StageTimer(const char *stage);
+  ~StageTimer();
+  StageTimer(const StageTimer &) = delete;
+  StageTimer &operator=(const StageTimer &) = delete;
+
+private:
+  const char *name;
+  bool active;
+  std::chrono::steady_clock::time_point start;
+};
+
+//! Switches profiling on or off
+void enable(bool on = true);
+
+//! True if profiling is switched on
+bool isEnabled();
+
+//! Adds to the number of items processed by a stage
+void count(const char *stage, std::uint64_t nItems);
+
+//! Adds a single timed call to a stage
+void addTime(const char *stage, double seconds);
+
+//! Clears every stage
+void reset();
+
+//! Returns a copy of the totals of every stage, sorted by name
+std::map<std::string, StageStats> snapshot();
+
+//! Prints a table of every stage
+void printReport(std::ostream &out = std::cout);
+
+//! Writes the totals of every stage to a JSON file
+int writeJSON(std::string fileName);
+
+} // namespace sprof
+
+#endif // __PROFILING_H_
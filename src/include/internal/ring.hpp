@@ -29,6 +29,7 @@
 
 #include <cage.hpp>
 #include <mol_sys.hpp>
+#include <ring_set.hpp>
 #include <seams_input.hpp>
 #include <seams_output.hpp>
 
@@ -154,9 +155,43 @@ int clearRingList(std::vector<std::vector<int>> &rings);
 
 //! Assign an atomType (equal to the number of nodes in the ring)
 //! given n-membered rings.
-int assignPolygonType(std::vector<std::vector<int>> rings,
+int assignPolygonType(const std::vector<std::vector<int>> &rings,
                       std::vector<int> *atomTypes, std::vector<int> nRings);
 
+/** @struct RingSpatialIndex
+ * @brief Centroids and sizes of the rings of one frame, binned into
+ * cells, for finding the rings near a given ring without testing every pair.
+ *
+ * Centroids are computed from the minimum-image positions of the ring members
+ * relative to the first member, and wrapped back into the box. The radius of a
+ * ring is the largest distance from its centroid to a member, so that two
+ * rings with any pair of members closer than d have centroids closer than
+ * d + radius1 + radius2. Cells are at least as long as pairCutoff plus twice
+ * the largest radius, so that only the neighbouring cells need to be searched.
+ */
+struct RingSpatialIndex {
+  std::vector<std::array<double, 3>> centroids; //! Wrapped ring centroids
+  std::vector<double> radii;        //! Largest centroid-member distance
+  double pairCutoff = 0.0;          //! Member separation the index is built for
+  double maxRadius = 0.0;           //! Largest ring radius
+  std::array<double, 3> boxLength;  //! Box lengths
+  std::array<double, 3> boxLow;     //! Lower box coordinates
+  std::array<int, 3> nCells;        //! Number of cells in each dimension
+  std::array<double, 3> cellLength; //! Length of a cell in each dimension
+  std::vector<int> cellOffsets; //! Rings of cell c are in cellRings[offsets]
+  std::vector<int> cellRings;   //! Ring indices, ordered by cell
+};
+
+//! Builds the spatial index over the rings of one frame
+RingSpatialIndex
+buildRingSpatialIndex(const std::vector<std::vector<int>> &rings,
+                      molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                      double pairCutoff);
+
+//! Rings (with a greater index than iring) which may have a member within
+//! pairCutoff of a member of iring, in ascending order
+std::vector<int> nearbyRings(const RingSpatialIndex &index, int iring);
+
 } // namespace ring
 
 #endif // __RINGS_H_
@@ -0,0 +1,94 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#ifndef __RING_SET_H_
+#define __RING_SET_H_
+
+#include <utility>
+#include <vector>
+
+/** @file ring_set.hpp
+ *  @brief Primitive rings of one frame, grouped by ring size.
+ */
+
+/**
+ *  @addtogroup ring
+ *  @{
+ */
+
+namespace ring {
+
+/** @class RingsBySize
+ * @brief The primitive rings of a frame, stored in one bucket per ring size.
+ * @details The topological network criteria work on the rings of one size at
+ * a time. Instead of scanning and copying the full list of rings for every
+ * ring size (as ring::getSingleRingSize does), the rings are sorted into
+ * buckets once, when the set is built. ofSize then returns the rings of a
+ * size without copying them, in the same order as in the full list, so that
+ * the per-size functions (ring::findPrisms, ring::findHC and so on) see
+ * exactly the vector of vectors they used to.
+ *
+ * Every ring keeps a global ID, which is its index in the full list of rings
+ * (in the order in which primitive::ringNetwork found them). idsOfSize maps
+ * the indices within a bucket back to these IDs.
+ */
+class RingsBySize {
+public:
+  RingsBySize() = default;
+
+  //! Sorts the rings (of all sizes) into buckets
+  explicit RingsBySize(const std::vector<std::vector<int>> &rings);
+
+  //! Adds a ring, whose global ID is the number of rings added before it
+  void add(std::vector<int> ring);
+
+  //! Removes every ring
+  void clear();
+
+  //! Total number of rings
+  int size() const { return location.size(); }
+
+  //! Largest ring size with a bucket (0 if there are no rings)
+  int maxRingSize() const {
+    return buckets.empty() ? 0 : static_cast<int>(buckets.size()) - 1;
+  }
+
+  //! Number of rings of a particular size
+  int count(int ringSize) const { return ofSize(ringSize).size(); }
+
+  //! Rings of a particular size (empty if there are none)
+  const std::vector<std::vector<int>> &ofSize(int ringSize) const;
+
+  //! Global IDs of the rings of a particular size, in the order of ofSize
+  const std::vector<int> &idsOfSize(int ringSize) const;
+
+  //! The ring with a particular global ID
+  const std::vector<int> &ring(int id) const {
+    return buckets[location[id].first][location[id].second];
+  }
+
+  //! Copy of all the rings, by global ID (the original list of rings)
+  std::vector<std::vector<int>> toVector() const;
+
+private:
+  std::vector<std::vector<std::vector<int>>> buckets; //! Rings, by size
+  std::vector<std::vector<int>> ids; //! Global IDs, by size
+  std::vector<std::pair<int, int>>
+      location; //! Size and index within the bucket, by global ID
+};
+
+} // namespace ring
+
+#endif // __RING_SET_H_
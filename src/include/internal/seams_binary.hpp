@@ -0,0 +1,153 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#ifndef __SEAMS_BINARY_H_
+#define __SEAMS_BINARY_H_
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <mol_sys.hpp>
+#include <output_sink.hpp>
+
+/** @file seams_binary.hpp
+ *  @brief File for the compact binary trajectory of per-frame analysis
+ * results.
+ */
+
+/**
+ *  @addtogroup sbin
+ *  @{
+ */
+
+/** @brief Functions for the binary trajectory of analysis results.
+ *  @details Writing a new ASCII dump or data file per frame is expensive for
+ * long trajectories of large systems. When a binary trajectory has been opened
+ * (with sbin::openTrajectory), the per-frame writers in sout record their
+ * results into it instead.
+ *
+ * The file starts with a 16 byte header (the magic string "DSEAMSBT", followed
+ * by the format version and a reserved word). Each frame is then one chunk,
+ * made up of a FrameHeader and the following columns, stored contiguously and
+ * padded to multiples of 8 bytes so that the file can be memory-mapped:
+ *
+ * - atomID, molID and type (int32, one per atom)
+ * - atomClass (int32, one per atom): the classification from the topological
+ *   network criteria (prism or cage type); -1 if not recorded
+ * - iceType (uint8, one per atom): the molSys::atom_state_type
+ * - x, y, z (float64, one per atom)
+ * - rmsd (float64, one per atom); -1 if not recorded
+ * - clusterID (int32, one per atom); -1 for atoms which are not in a cluster
+ * - ringOffsets (uint64, number of rings + 1) and ringAtoms (int32): the rings
+ *   as atom indices (rows of the frame), with ring i stored in
+ *   ringAtoms[ringOffsets[i]..ringOffsets[i+1]).
+ *
+ * The atoms are stored in the order in which they were read in, even if they
+ * have been reordered along a space-filling curve (see molSys::AtomOrder).
+ *
+ * The byte offset of every frame is written to an index file (the trajectory
+ * file name with .idx appended), for random access to frames.
+ */
+
+namespace sbin {
+
+//! Format version written to the file header
+const std::uint32_t formatVersion = 1;
+
+/** @struct FrameHeader
+ * @brief Fixed-size header at the start of every frame chunk.
+ */
+struct FrameHeader {
+  char tag[4];             //! Always "FRME"
+  std::int32_t frame;      //! Frame number
+  std::uint64_t nAtoms;    //! Number of atoms
+  std::uint64_t nRings;    //! Number of rings
+  std::uint64_t nRingAtoms; //! Total number of ring members
+  std::uint64_t chunkBytes; //! Size of the chunk, including this header
+  double boxLow[3];        //! xlo, ylo, zlo
+  double box[3];           //! Box lengths
+};
+
+/** @struct IndexEntry
+ * @brief Position of a frame inside the binary trajectory.
+ */
+struct IndexEntry {
+  std::int32_t frame;    //! Frame number
+  std::int32_t reserved; //! Padding
+  std::uint64_t offset;  //! Byte offset of the FrameHeader
+};
+
+/** @struct FrameRecord
+ * @brief All the results for one frame, column by column.
+ */
+struct FrameRecord {
+  int frame = -1;                    //! Frame number
+  std::vector<double> boxLow, box;   //! Simulation box
+  std::vector<std::int32_t> atomID;  //! Atom IDs
+  std::vector<std::int32_t> molID;   //! Molecule IDs
+  std::vector<std::int32_t> type;    //! LAMMPS atom types
+  std::vector<std::int32_t> atomClass; //! Topological classification
+  std::vector<std::uint8_t> iceType; //! molSys::atom_state_type
+  std::vector<double> x, y, z;       //! Coordinates
+  std::vector<double> rmsd;          //! RMSD per atom from shape-matching
+  std::vector<std::int32_t> clusterID; //! Cluster each atom belongs to
+  std::vector<std::uint64_t> ringOffsets; //! Start of every ring in ringAtoms
+  std::vector<std::int32_t> ringAtoms;    //! Ring members (atom indices)
+};
+
+//! Opens (and truncates) a binary trajectory. Until it is closed, the
+//! per-frame sout writers record into it instead of writing ASCII files
+int openTrajectory(std::string fileName);
+
+//! Writes out the last frame and closes the binary trajectory
+int closeTrajectory();
+
+//! True if a binary trajectory is currently open
+bool isEnabled();
+
+//! Records the atoms of the current frame (IDs, types, coordinates, ice type)
+int recordAtoms(molSys::PointCloud<molSys::Point<double>, double> *yCloud);
+
+//! Records the per-atom topological classification of the current frame
+int recordAtomClass(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                    std::vector<int> &atomClass);
+
+//! Records the per-atom RMSD of the current frame
+int recordRMSD(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+               std::vector<double> &rmsdPerAtom);
+
+//! Records the cluster ID of every atom of the current frame
+int recordClusterIDs(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                     std::vector<int> &clusterID);
+
+//! Records the rings (by atom index) of the current frame
+int recordRings(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                const std::vector<std::vector<int>> &rings);
+
+//! Reads the frame index of a binary trajectory (rebuilding it from the
+//! trajectory itself if the index file is missing)
+std::vector<IndexEntry> readIndex(std::string fileName);
+
+//! Reads a single frame from a binary trajectory
+int readFrame(std::string fileName, int frame, FrameRecord *record);
+
+//! Converts every frame of a binary trajectory back into LAMMPS dump files
+//! and ring files
+int convertToASCII(std::string fileName, std::string path);
+
+} // namespace sbin
+
+#endif // __SEAMS_BINARY_H_
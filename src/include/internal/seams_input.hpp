@@ -54,7 +54,7 @@ std::vector<std::string> getInpFileList(std::string inputFolder);
 
 //! Function for reading in a specified frame (frame number and not timestep
 //! value)
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 readLammpsTrj(std::string filename, int targetFrame,
               molSys::PointCloud<molSys::Point<double>, double> *yCloud,
               bool isSlice = false,
@@ -63,7 +63,7 @@ readLammpsTrj(std::string filename, int targetFrame,
 
 //! Function for reading in a specified frame (frame number and not timestep
 //! value) / This only reads in oxygen atoms
-molSys::PointCloud<molSys::Point<double>, double> readLammpsTrjO(
+molSys::PointCloud<molSys::Point<double>, double> &readLammpsTrjO(
     std::string filename, int targetFrame,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int typeO,
     bool isSlice = false,
@@ -72,7 +72,7 @@ molSys::PointCloud<molSys::Point<double>, double> readLammpsTrjO(
 
 //! Function that reads in only atoms pf the desired type and ignores all atoms
 //! which are not in the slice as well
-molSys::PointCloud<molSys::Point<double>, double> readLammpsTrjreduced(
+molSys::PointCloud<molSys::Point<double>, double> &readLammpsTrjreduced(
     std::string filename, int targetFrame,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int typeI,
     bool isSlice = false,
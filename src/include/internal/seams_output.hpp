@@ -22,6 +22,8 @@
 #include <iostream>
 #include <memory>
 #include <mol_sys.hpp>
+#include <output_sink.hpp>
+#include <seams_binary.hpp>
 #include <sys/stat.h> // stat
 #if defined(_WIN32)
 #include <direct.h> // _mkdir
@@ -82,14 +84,14 @@ inline int makePath(const std::string &path) {
       if (pos == std::string::npos)
 #endif
         return 1;
-      if (!makePath(path.substr(0, pos)))
+      if (makePath(path.substr(0, pos)) != 0)
         return 1;
     }
 // now, try to create again
 #if defined(_WIN32)
-    return 0 == _mkdir(path.c_str());
+    return 0 == _mkdir(path.c_str()) ? 0 : 1;
 #else
-    return 0 == mkdir(path.c_str(), mode);
+    return 0 == mkdir(path.c_str(), mode) ? 0 : 1;
 #endif
 
   case EEXIST:
@@ -107,6 +109,7 @@ inline int makePath(const std::string &path) {
 
 //! Function for printing out ring info, when there is no volume slice
 int writeRings(std::vector<std::vector<int>> rings,
+               molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                std::string filename = "rings.dat");
 
 //! Function for printing out the number of prism blocks, with or without
@@ -160,7 +163,7 @@ int writeMoleculeIDsExpressionSelectOVITO(std::string path, molSys::PointCloud<m
 //! Write a data file for rings
 int writeLAMMPSdata(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                     std::vector<std::vector<int>> rings,
-                    std::vector<std::vector<int>> bonds,
+                    const bond::BondList &bonds,
                     std::string filename = "system-rings.data");
 
 //! Write out a LAMMPS dump file containing the RMSD per atom
@@ -228,9 +231,10 @@ int writeEachCage(std::vector<int> currentCage, int cageNum,
                   molSys::PointCloud<molSys::Point<double>, double> *yCloud);
 
 //! Write out the basal rings of a particular Hexagonal cage
-int writeBasalRingsHex(std::vector<int> currentCage, int cageNum,
-                       std::vector<std::vector<int>> nList,
-                       std::vector<std::vector<int>> rings);
+int writeBasalRingsHex(
+    std::vector<int> currentCage, int cageNum,
+    std::vector<std::vector<int>> nList, std::vector<std::vector<int>> rings,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud);
 
 //! Write out the basal rings for a particular prism
 int writeBasalRingsPrism(
@@ -242,10 +246,14 @@ int writeBasalRingsPrism(
 int writeDump(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
               std::string path, std::string outFile);
 
-//! Function for printing out Q6, Cij and averaged Q3 values as single columns
-//! to text files The file names are cij, q6, q3
+//! Adds the Cij, averaged Q3 and Q6 values of a frame to their histograms
+//! (sstat::distribution), and optionally dumps them to cij.txt, q3.txt and
+//! q6.txt
 int writeHisto(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-               std::vector<std::vector<int>> nList, std::vector<double> avgQ6);
+               const std::vector<std::vector<int>> &nList, const std::vector<double> &avgQ6);
+
+//! Switches the dump of the individual values by writeHisto on or off
+void dumpHistogramValues(bool on = true);
 
 //! Function for printing the largest ice cluster
 int writeCluster(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
@@ -255,6 +263,13 @@ int writeCluster(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
 //! Function for writing out the XYZ files for each cluster
 int writeXYZcluster(std::string path,
                     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                    std::vector<int> atoms, int clusterID, cage::cageType type);
+                    const std::vector<int> &atoms, int clusterID,
+                    cage::cageType type);
+
+//! Writes out the XYZ files of every cluster of a frame in one go
+int writeXYZclusters(
+    std::string path, molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    const std::vector<std::vector<int>> &clusterAtoms,
+    const std::vector<cage::cageType> &clusterTypes);
 } // namespace sout
 #endif // __SEAMS_OUTPUT_H_
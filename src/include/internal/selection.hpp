@@ -19,12 +19,15 @@
 #include <sys/stat.h>
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <mol_sys.hpp>
@@ -45,9 +48,97 @@
 
 namespace gen {
 
+/** @brief A region of space, given as a predicate on the coordinates of a
+ *  point, which is true if the point lies inside the region
+ */
+using Region = std::function<bool(double, double, double)>;
+
+/** @struct MolIndex
+ * @brief Flat index of the atoms belonging to each molecule.
+ *
+ * The indices (not IDs) of the atoms of molecule molID are
+ * atoms[offsets[k]] to atoms[offsets[k+1]-1], where k is molIDindex[molID].
+ */
+struct MolIndex {
+  std::unordered_map<int, int> molIDindex; //! Position of each molID
+  std::vector<int> offsets;                //! Start of each molecule in atoms
+  std::vector<int> atoms;                  //! Atom indices, by molecule
+};
+
+//! Slab region (the same volume slice used by sinp::atomInSlice)
+Region slabRegion(std::array<double, 3> coordLow,
+                  std::array<double, 3> coordHigh);
+
+//! Spherical region of a given radius around a center
+Region sphereRegion(std::array<double, 3> center, double radius);
+
+//! Cylindrical region of infinite length along the axis dimension (0, 1 or 2
+//! for x, y or z), passing through center
+Region cylinderRegion(std::array<double, 3> center, double radius, int axis);
+
+//! Build the flat molID to atom index lookup for a PointCloud
+MolIndex buildMolIndex(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud);
+
+/** @struct RegionSelection
+ * @brief Membership of every atom in each of several regions, packed into one
+ * bitmask per atom.
+ *
+ * The atom with index iatom is inside region r if bit r%64 of
+ * masks[iatom*nWords + r/64] is set.
+ */
+struct RegionSelection {
+  int nRegions = 0;                 //! Number of regions
+  int nWords = 0;                   //! 64-bit words in the mask of each atom
+  std::vector<std::uint64_t> masks; //! Bitmasks, by atom index
+
+  //! True if the atom with index iatom is inside region r
+  bool contains(int iatom, int r) const {
+    return (masks[iatom * nWords + r / 64] >> (r % 64)) & 1u;
+  }
+};
+
+//! Finds the atoms inside each of several regions, in a single pass through
+//! the atoms of a PointCloud
+RegionSelection
+selectRegions(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+              const std::vector<Region> &regions);
+
+//! Extends every region of a selection to whole molecules: if even one atom of
+//! a molecule is inside a region, then all atoms of that molecule are
+void expandToMolecules(RegionSelection &selection, const MolIndex &molIndex);
+
+//! Indices of the atoms inside each region of a selection
+std::vector<std::vector<int>>
+regionAtomLists(const RegionSelection &selection);
+
+//! Sets the inSlice bool of every atom according to region r of a selection
+void setInSliceFromSelection(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    const RegionSelection &selection, int r,
+    bool clearPreviousSliceSelection = true);
+
+//! Indices of the atoms inside each of several regions, optionally extended
+//! to whole molecules
+std::vector<std::vector<int>>
+atomsInRegions(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+               const std::vector<Region> &regions, bool wholeMolecules = true);
+
+//! Set the inSlice bool of every atom of molecule molID, using the MolIndex
+void setMoleculeInSlice(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    const MolIndex &molIndex, int molID, bool inSliceValue = true);
+
+//! Given a pointCloud set the inSlice bool for every atom, if the molecules
+//! are inside the given region. If even one atom of a molecule is inside the
+//! region, then all atoms of that molecule will be inside the region
+void moleculesInRegion(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    Region region, bool clearPreviousSliceSelection = true);
+
 //! Given a pointCloud containing certain atom types,
 //! this returns a pointCloud containing atoms of only the desired type
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 getPointCloudOneAtomType(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     molSys::PointCloud<molSys::Point<double>, double> *outCloud,
@@ -90,6 +181,37 @@ void setAtomsWithSameMolID(
 
 namespace ring {
 
+/** @struct AtomRingIndex
+ * @brief Inverted (compressed row) index of the rings each atom belongs to.
+ *
+ * The rings containing the atom with index iatom are
+ * rings[offsets[iatom]] to rings[offsets[iatom+1]-1].
+ */
+struct AtomRingIndex {
+  std::vector<int> offsets; //! Start of each atom in rings
+  std::vector<int> rings;   //! Ring indices, by atom
+};
+
+//! Build the atom to ring index for rings (by atom index) over nAtoms atoms
+AtomRingIndex buildAtomRingIndex(const std::vector<std::vector<int>> &rings,
+                                 int nAtoms);
+
+//! Select edge molecules and atoms which are part of rings, such that rings
+//! formed with even one atom inside the given region will be included in the
+//! selection. Modifies the inSlice bool of oCloud and yCloud
+void getEdgeMoleculesInRingsRegion(
+    const std::vector<std::vector<int>> &rings,
+    molSys::PointCloud<molSys::Point<double>, double> *oCloud,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    gen::Region region, bool identicalCloud = false);
+
+//! Region version of ring::printSliceGetEdgeMoleculesInRings
+void printRegionGetEdgeMoleculesInRings(
+    std::string path, const std::vector<std::vector<int>> &rings,
+    molSys::PointCloud<molSys::Point<double>, double> *oCloud,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    gen::Region region, bool identicalCloud = false);
+
 //! Select edge molecules and atoms which are part of rings, such that rings
 //! formed with even one atom in the slice will be included in the selection
 //! Modifies the inSlice bool of a given PointCloud (this may be the same)
@@ -99,7 +221,7 @@ namespace ring {
 //! to the presence of the atom in the slice 
 //! (this can be done using the gen::moleculesInSingleSlice function. 
 void getEdgeMoleculesInRings(
-    std::vector<std::vector<int>> rings, molSys::PointCloud<molSys::Point<double>, double> *oCloud,
+    const std::vector<std::vector<int>> &rings, molSys::PointCloud<molSys::Point<double>, double> *oCloud,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, 
     std::array<double, 3> coordLow, std::array<double, 3> coordHigh,
     bool identicalCloud=false);
@@ -112,7 +234,7 @@ void getEdgeMoleculesInRings(
 //! Prints out molecule IDs individually of molecules in the slice, and also prints out a LAMMPS
 //! data file of just the molecules and atoms in the slice  
 void printSliceGetEdgeMoleculesInRings(
-    std::string path, std::vector<std::vector<int>> rings, 
+    std::string path, const std::vector<std::vector<int>> &rings, 
     molSys::PointCloud<molSys::Point<double>, double> *oCloud,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, 
     std::array<double, 3> coordLow, std::array<double, 3> coordHigh,
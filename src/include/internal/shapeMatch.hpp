@@ -17,6 +17,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -25,6 +26,7 @@
 #include <sstream>
 #include <string>
 #include <sys/stat.h>
+#include <thread>
 #include <vector>
 
 #include <absOrientation.hpp>
@@ -39,7 +41,7 @@ namespace match {
 //! Shape-matching for a pair of polygon basal rings. Returns true if the pair
 //! of basal rings form a prism block.
 bool matchPrism(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                std::vector<std::vector<int>> nList,
+                const nneigh::Adjacency &bonded,
                 const Eigen::MatrixXd &refPoints, std::vector<int> *basal1,
                 std::vector<int> *basal2, std::vector<double> *rmsdPerAtom,
                 bool isPerfect = true);
@@ -48,14 +50,23 @@ bool matchPrism(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
 //! of basal rings form a prism block.
 bool matchUntetheredPrism(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<std::vector<int>> nList, const Eigen::MatrixXd &refPoints,
+    const nneigh::Adjacency &bonded, const Eigen::MatrixXd &refPoints,
     std::vector<int> *basal1, std::vector<int> *basal2,
     std::vector<double> *rmsdPerAtom);
 
+//! Shape-matching for a pair of polygon basal rings, like the version above,
+//! but returning the RMSD of each basal ring instead of updating the RMSD per
+//! atom.
+bool matchUntetheredPrism(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    const nneigh::Adjacency &bonded, const Eigen::MatrixXd &refPoints,
+    std::vector<int> *basal1, std::vector<int> *basal2, double *rmsdBasal1,
+    double *rmsdBasal2);
+
 //! Shape-matching for a pair of polygon basal rings, comparing with a complete
 //! prism block. Returns true if the pair of basal rings form a prism block.
 bool matchPrismBlock(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                     std::vector<std::vector<int>> nList,
+                     const nneigh::Adjacency &bonded,
                      const Eigen::MatrixXd &refPoints, std::vector<int> *basal1,
                      std::vector<int> *basal2, int *beginIndex);
 
@@ -69,6 +80,53 @@ int updatePerAtomRMSDRing(std::vector<int> basalRing, int startingIndex,
 int updateRMSDRing(std::vector<int> basalRing, int startingIndex,
                    double rmsdVal, std::vector<double> *rmsdPerAtom);
 
+//! Sets the number of threads used to shape-match cages and prism blocks
+//! (0 uses every hardware thread)
+void setThreads(int nThreads);
+
+//! Returns the number of threads used to shape-match cages and prism blocks
+int threads();
+
+/**
+ * @details Calls work(i) for every i in [0, n), spread over maxThreads threads
+ * (by default match::threads()). The threads claim blocks of grain indices in
+ * turn, so the order in which work is called is not fixed; work should only
+ * write to the results of its own index.
+ * @param[in] n Number of items
+ * @param[in] work Function called with the index of every item
+ * @param[in] grain Number of indices claimed by a thread at a time
+ * @param[in] maxThreads Number of threads to use
+ */
+template <typename Work>
+void parallelFor(int n, Work &&work, int grain = 1,
+                 int maxThreads = match::threads()) {
+  int nThreads = std::min(maxThreads, (n + grain - 1) / grain);
+  if (nThreads <= 1) {
+    for (int i = 0; i < n; i++) {
+      work(i);
+    }
+    return;
+  } // serial
+  std::atomic<int> next{0}; // First index of the next unclaimed block
+  auto run = [&]() {
+    for (int first = next.fetch_add(grain); first < n;
+         first = next.fetch_add(grain)) {
+      int last = std::min(first + grain, n);
+      for (int i = first; i < last; i++) {
+        work(i);
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int t = 1; t < nThreads; t++) {
+    workers.emplace_back(run);
+  }
+  run(); // The calling thread works too
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
 } // namespace match
 
 #endif // __SHAPEMATCH_H_
@@ -50,8 +50,15 @@ namespace ring {
 //! Find out rings in the bulk, looping through all ring sizes upto the
 //! maxDepth The input ringsAllSizes array has rings of every size.
 int bulkPolygonRingAnalysis(
-    std::string path, std::vector<std::vector<int>> rings,
-    std::vector<std::vector<int>> nList,
+    std::string path, const std::vector<std::vector<int>> &rings,
+    const std::vector<std::vector<int>> &nList,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int maxDepth,
+    int firstFrame);
+
+//! Bulk ring analysis for rings already sorted by size
+int bulkPolygonRingAnalysis(
+    std::string path, const ring::RingsBySize &rings,
+    const std::vector<std::vector<int>> &nList,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int maxDepth,
     int firstFrame);
 
@@ -60,8 +67,14 @@ int bulkPolygonRingAnalysis(
 //! Find out which rings are DDCs or HCs, which are comprised of 6-membered
 //! primitive rings. Start with a neighbour list (by index) and a vector of
 //! vectors of rings (also by index). TODO: try 'square' ice and ice0
-int topoBulkAnalysis(std::string path, std::vector<std::vector<int>> rings,
-                     std::vector<std::vector<int>> nList,
+int topoBulkAnalysis(std::string path, const std::vector<std::vector<int>> &rings,
+                     const std::vector<std::vector<int>> &nList,
+                     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                     int firstFrame, bool onlyTetrahedral = true);
+
+//! DDC and HC analysis for rings already sorted by size
+int topoBulkAnalysis(std::string path, const ring::RingsBySize &rings,
+                     const std::vector<std::vector<int>> &nList,
                      molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                      int firstFrame, bool onlyTetrahedral = true);
 
@@ -84,7 +97,7 @@ std::vector<int> findMixedRings(std::vector<std::vector<int>> rings,
 //! Returns a vector containing all the ring IDs which are HC rings
 std::vector<int> findHC(std::vector<std::vector<int>> rings,
                         std::vector<strucType> *ringType,
-                        std::vector<std::vector<int>> nList,
+                        const std::vector<std::vector<int>> &nList,
                         std::vector<cage::Cage> *cageList);
 
 //! First condition for the DDC: There must be at least 3 other
@@ -103,17 +116,17 @@ bool conditionThreeDDC(std::vector<std::vector<int>> rings,
                        std::vector<int> *peripheralRings);
 
 //! Tests whether two rings are basal rings (true) or not (false)
-bool basalConditions(std::vector<std::vector<int>> nList,
+bool basalConditions(const nneigh::Adjacency &bonded,
                      std::vector<int> *basal1, std::vector<int> *basal2);
 
 //! Tests whether the last two elements of a triplet are neighbours of two atom
 //! IDs passed in
-bool basalNeighbours(std::vector<std::vector<int>> nList,
+bool basalNeighbours(const nneigh::Adjacency &bonded,
                      std::vector<int> *triplet, int atomOne, int atomTwo);
 
 //! Tests to check that elements of a triplet are not neighbours of a ring
 //! (vector) passed
-bool notNeighboursOfRing(std::vector<std::vector<int>> nList,
+bool notNeighboursOfRing(const nneigh::Adjacency &bonded,
                          std::vector<int> *triplet, std::vector<int> *ring);
 
 //! Finds the prismatic rings from basal rings iring and jring
@@ -144,24 +157,25 @@ namespace prism3 {
 //! Find out which rings are prisms.
 int findBulkPrisms(std::vector<std::vector<int>> rings,
                    std::vector<ring::strucType> *ringType,
-                   std::vector<std::vector<int>> nList,
+                   const std::vector<std::vector<int>> &nList,
                    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                    std::vector<double> *rmsdPerAtom, double heightCutoff = 8);
 
 //! Tests whether two rings are basal rings (true) or not (false) for a prism
 //! (strict criterion)
-bool basalPrismConditions(std::vector<std::vector<int>> nList,
+bool basalPrismConditions(const nneigh::Adjacency &bonded,
                           std::vector<int> *basal1, std::vector<int> *basal2);
 
 //! Reduced criterion: Two candidate basal rings of a prism block should have
 //! at least one bond between them
-bool relaxedPrismConditions(std::vector<std::vector<int>> nList,
+bool relaxedPrismConditions(const nneigh::Adjacency &bonded,
                             std::vector<int> *basal1, std::vector<int> *basal2);
 
 //! Check to see that candidate basal prisms are not really far from each other
 bool basalRingsSeparation(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<int> basal1, std::vector<int> basal2, double heightCutoff = 8);
+    const std::vector<int> &basal1, const std::vector<int> &basal2,
+    double heightCutoff = 8);
 } // namespace prism3
 
 #endif // __TOPO_BULK_H_
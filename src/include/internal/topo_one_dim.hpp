@@ -51,18 +51,18 @@ namespace ring {
 std::vector<int> findPrisms(
     std::vector<std::vector<int>> rings, std::vector<strucType> *ringType,
     int *nPerfectPrisms, int *nImperfectPrisms,
-    std::vector<std::vector<int>> nList,
+    const std::vector<std::vector<int>> &nList,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<double> *rmsdPerAtom, bool doShapeMatching = false);
 
 //! Tests whether two rings are basal rings (true) or not (false) for a prism
 //! (strict criterion)
-bool basalPrismConditions(std::vector<std::vector<int>> nList,
+bool basalPrismConditions(const nneigh::Adjacency &bonded,
                           std::vector<int> *basal1, std::vector<int> *basal2);
 
 //! Reduced criterion: Two candidate basal rings of a prism block should have at
 //! least one bond between them
-bool relaxedPrismConditions(std::vector<std::vector<int>> nList,
+bool relaxedPrismConditions(const nneigh::Adjacency &bonded,
                             std::vector<int> *basal1, std::vector<int> *basal2);
 
 //! Checks whether two 4-membered rings are parallel in one dimension or not to
@@ -71,6 +71,10 @@ bool discardExtraTetragonBlocks(
     std::vector<int> *basal1, std::vector<int> *basal2,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud);
 
+//! Checks whether a single ring is perpendicular to the axial dimension
+bool isAxialRing(const std::vector<int> &basal,
+                 molSys::PointCloud<molSys::Point<double>, double> *yCloud);
+
 //! Saves only axial rings out of all possible rings
 std::vector<std::vector<int>> keepAxialRingsOnly(
     std::vector<std::vector<int>> rings,
@@ -78,8 +82,15 @@ std::vector<std::vector<int>> keepAxialRingsOnly(
 
 //! Find out which rings are prisms, looping through all ring sizes upto the
 //! maxDepth The input ringsAllSizes array has rings of every size.
-int prismAnalysis(std::string path, std::vector<std::vector<int>> rings,
-                  std::vector<std::vector<int>> nList,
+int prismAnalysis(std::string path, const std::vector<std::vector<int>> &rings,
+                  const std::vector<std::vector<int>> &nList,
+                  molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                  int maxDepth, int *atomID, int firstFrame, int currentFrame,
+                  bool doShapeMatching = false);
+
+//! Prism analysis for rings already sorted by size
+int prismAnalysis(std::string path, const ring::RingsBySize &rings,
+                  const std::vector<std::vector<int>> &nList,
                   molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                   int maxDepth, int *atomID, int firstFrame, int currentFrame,
                   bool doShapeMatching = false);
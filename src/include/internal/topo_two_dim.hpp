@@ -48,8 +48,15 @@ namespace ring {
 //! Find out which rings are prisms, looping through all ring sizes upto the
 //! maxDepth The input ringsAllSizes array has rings of every size.
 int polygonRingAnalysis(
-    std::string path, std::vector<std::vector<int>> rings,
-    std::vector<std::vector<int>> nList,
+    std::string path, const std::vector<std::vector<int>> &rings,
+    const std::vector<std::vector<int>> &nList,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int maxDepth,
+    double sheetArea, int firstFrame);
+
+//! Polygon ring analysis for rings already sorted by size
+int polygonRingAnalysis(
+    std::string path, const ring::RingsBySize &rings,
+    const std::vector<std::vector<int>> &nList,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int maxDepth,
     double sheetArea, int firstFrame);
 
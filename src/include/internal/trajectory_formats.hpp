@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#ifndef __TRAJECTORY_FORMATS_H_
+#define __TRAJECTORY_FORMATS_H_
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <mol_sys.hpp>
+
+/** @file trajectory_formats.hpp
+ *  @brief File for the readers of binary trajectory formats (DCD, XTC and
+ * LAMMPS binary dumps).
+ */
+
+/**
+ *  @addtogroup sinp
+ *  @{
+ */
+
+/** @brief Readers for binary trajectory formats.
+ *  @details The LAMMPS readers (sinp::readLammpsTrj, sinp::readLammpsTrjO and
+ * sinp::readLammpsTrjreduced) hand files in these formats over to
+ * sinp::readBinaryTrj, so every Lua script can read them without changes. The
+ * format is decided by the file extension:
+ *
+ * - .dcd : CHARMM/NAMD/LAMMPS DCD files (either byte order).
+ * - .xtc : GROMACS XTC files, with the xdrfile coordinate compression.
+ *   Coordinates and box lengths are converted from nm to Angstrom.
+ * - .bin : LAMMPS binary dumps (dump atom or dump custom), with either
+ *   unscaled (x, xu) or scaled (xs, xsu) coordinates.
+ * - anything else is a LAMMPS text dump.
+ *
+ * DCD and XTC files only contain coordinates. The atom IDs, molecule IDs and
+ * types are taken from a topology, set with sinp::setTopology from the first
+ * frame of a LAMMPS text dump: the atoms of every frame are matched to the
+ * topology atoms in order of increasing atom ID, which is the order in which
+ * LAMMPS writes DCD files. Since neither format stores the origin of the box,
+ * its lower corner is also taken from the topology. Without a topology, the
+ * atoms are numbered from 1, have type 1, and the box starts at 0.
+ *
+ * The byte offset of every frame is found once per file (from the header for
+ * DCD files, and by skipping from frame header to frame header otherwise),
+ * and kept for as long as the file is unchanged, so that any frame is read
+ * directly.
+ */
+
+namespace sinp {
+
+/** @enum class TrajectoryFormat
+ * @brief Supported trajectory formats.
+ */
+enum class TrajectoryFormat { lammpsText, lammpsBinary, dcd, xtc };
+
+//! The format of a trajectory, according to its file extension
+TrajectoryFormat trajectoryFormat(const std::string &filename);
+
+//! Sets the atom IDs, molecule IDs, types and box origin used for DCD and XTC
+//! files, from the first frame of a LAMMPS text dump
+int setTopology(std::string filename);
+
+//! Byte offsets of every frame of a DCD, XTC or LAMMPS binary file
+std::vector<std::int64_t> frameOffsets(std::string filename);
+
+//! Number of frames in a DCD, XTC or LAMMPS binary file
+int countFrames(std::string filename);
+
+//! Reads one frame (the first frame is 1) of a DCD, XTC or LAMMPS binary file.
+//! Only atoms of type typeI are saved, unless typeI is -1. Atoms outside the
+//! slice are flagged, or not saved at all if dropOutsideSlice is true
+int readBinaryTrj(std::string filename, int targetFrame,
+                  molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                  int typeI = -1, bool dropOutsideSlice = false,
+                  bool isSlice = false,
+                  std::array<double, 3> coordLow = std::array<double, 3>{0, 0,
+                                                                         0},
+                  std::array<double, 3> coordHigh = std::array<double, 3>{
+                      0, 0, 0});
+
+} // namespace sinp
+
+#endif // __TRAJECTORY_FORMATS_H_
@@ -25,21 +25,28 @@
 #include "opt_parser.h"
 
 // Newer pointCloud
+#include <accumulators.hpp>
 #include <bond.hpp>
 #include <bop.hpp>
 #include <bulkTUM.hpp>
 #include <cluster.hpp>
+#include <frame_cache.hpp>
 #include <franzblau.hpp>
 #include <generic.hpp>
+#include <lua_bindings.hpp>
 #include <mol_sys.hpp>
 #include <neighbours.hpp>
+#include <pipeline.hpp>
+#include <profiling.hpp>
 #include <rdf2d.hpp>
 #include <ring.hpp>
+#include <seams_binary.hpp>
 #include <seams_input.hpp>
 #include <seams_output.hpp>
 #include <topo_bulk.hpp>
 #include <topo_one_dim.hpp>
 #include <topo_two_dim.hpp>
+#include <trajectory_formats.hpp>
 #include <selection.hpp>
 
 // Externally bundled-input libraries
@@ -58,19 +65,148 @@ int main(int argc, char *argv[]) {
   YAML::Node config = YAML::LoadFile(result["c"].as<std::string>());
   // This is a dummy used to figure out the order of options (cmd > yml)
   std::string script, tFile;
+  // Owner of the objects created from Lua (must outlive the Lua state)
+  slua::Store luaStore;
   // Initialize Lua
   sol::state lua;
   // Use all libraries
   lua.open_libraries();
+  // Usertypes and in-place functions, shared by every block
+  slua::registerTypes(lua, luaStore);
+  slua::registerInPlace(lua);
   // Get the trajectory string
   if (config["trajectory"]) {
     tFile = config["trajectory"].as<std::string>();
   } // end of getting the trajectory
+  // Atom IDs and types for DCD and XTC trajectories
+  if (config["topology"]) {
+    sinp::setTopology(config["topology"].as<std::string>());
+  } // end of setting the topology
   // Get variable file string
   std::string vars = config["variables"].as<std::string>();
+  // Record per-frame results in a binary trajectory instead of ASCII files
+  if (config["binaryOutput"]) {
+    sbin::openTrajectory(config["binaryOutput"].as<std::string>());
+  } // end of opening the binary trajectory
+  // Time the stages of the analysis, and print a summary at the end
+  if (config["timings"]) {
+    sprof::enable(config["timings"].as<bool>());
+  } // end of switching on the timers
+  // Frames read ahead by the prefetchFrame functions of the Lua scripts
+  if (config["prefetchFrames"]) {
+    luaStore.prefetchDepth = config["prefetchFrames"].as<int>();
+  } // end of setting the read-ahead depth
+  if (config["prefetchThreads"]) {
+    luaStore.prefetchThreads = config["prefetchThreads"].as<int>();
+  } // end of setting the number of reading threads
+  // Precision of the neighbour list and RDF distance kernels
+  if (config["precision"]) {
+    std::string precision = config["precision"].as<std::string>();
+    if (precision == "single") {
+      molSys::setPrecision(molSys::Precision::single);
+    } else if (precision == "double") {
+      molSys::setPrecision(molSys::Precision::full);
+    } else {
+      std::cerr << "Unknown precision " << precision
+                << " in the configuration file. Use single or double.\n";
+      return 1;
+    }
+  } // end of setting the precision
+  // Threads shape-matching the cages and prism blocks (topological unit
+  // matching)
+  if (config["tumThreads"]) {
+    match::setThreads(config["tumThreads"].as<int>());
+  } // end of setting the shape-matching threads
+  // Order of the atoms of every frame read in (along a space-filling curve)
+  if (config["atomOrder"]) {
+    std::string atomOrder = config["atomOrder"].as<std::string>();
+    if (atomOrder == "file") {
+      molSys::setAtomOrder(molSys::AtomOrder::file);
+    } else if (atomOrder == "morton") {
+      molSys::setAtomOrder(molSys::AtomOrder::morton);
+    } else if (atomOrder == "hilbert") {
+      molSys::setAtomOrder(molSys::AtomOrder::hilbert);
+    } else {
+      std::cerr << "Unknown atom order " << atomOrder
+                << " in the configuration file. Use file, morton or hilbert.\n";
+      return 1;
+    }
+  } // end of setting the atom order
+  // Histograms of the bond order parameters (writeHistogram)
+  if (config["histogramValues"]) {
+    sout::dumpHistogramValues(config["histogramValues"].as<bool>());
+  } // end of switching on the raw values
+  if (config["histogramQuantiles"]) {
+    sstat::setQuantiles(
+        config["histogramQuantiles"].as<std::vector<double>>());
+  } // end of setting the quantiles
+  // Reuse the neighbour lists, hydrogen bonds and rings of earlier runs
+  if (config["cacheDir"]) {
+    if (scache::enable(config["cacheDir"].as<std::string>()) != 0) {
+      return 1;
+    }
+  } // end of opening the cache
+  // --------------------------------------
+  // Every enabled analysis in a single pass over the trajectory, instead of
+  // one Lua loop per block
+  bool usePipeline = config["pipeline"] && config["pipeline"].as<bool>();
+  if (usePipeline) {
+    // The frames and parameters are taken from the variables script
+    lua.script_file(vars);
+    spipe::Settings settings;
+    settings.trajectory = tFile;
+    settings.firstFrame = lua.get_or<int>("targetFrame", settings.firstFrame);
+    settings.finalFrame = lua.get_or<int>("finalFrame", settings.finalFrame);
+    settings.frameGap = lua.get_or<int>("frameGap", settings.frameGap);
+    settings.oxygenType =
+        lua.get_or<int>("oxygenAtomType", settings.oxygenType);
+    settings.hydrogenType =
+        lua.get_or<int>("hydrogenAtomType", settings.hydrogenType);
+    settings.cutoffRadius =
+        lua.get_or<double>("cutoffRadius", settings.cutoffRadius);
+    settings.maxDepth = lua.get_or<int>("maxDepth", settings.maxDepth);
+    settings.isSlice = lua.get_or<bool>("isSlice", settings.isSlice);
+    settings.sliceLow = lua.get_or<std::array<double, 3>>("sliceLowerLimits",
+                                                          settings.sliceLow);
+    settings.sliceHigh = lua.get_or<std::array<double, 3>>(
+        "sliceUpperLimits", settings.sliceHigh);
+    settings.outDir = lua.get_or<std::string>("outDir", settings.outDir);
+    settings.prefetchDepth = luaStore.prefetchDepth;
+    settings.prefetchThreads = luaStore.prefetchThreads;
+    // Split every frame into subdomains, computed on several threads
+    if (config["domains"]) {
+      settings.domains = config["domains"].as<std::array<int, 3>>();
+    }
+    if (config["domainThreads"]) {
+      settings.domainThreads = config["domainThreads"].as<int>();
+    }
+    // The analyses of the enabled blocks
+    spipe::Pipeline pipeline(settings);
+    if (config["bulk"]["use"].as<bool>()) {
+      if (config["bulk"]["bondOrderParameters"].as<bool>()) {
+        pipeline.add(spipe::chillPlusAnalysis(
+            lua.get_or<std::string>("chillPlus_noMod", "chillPlus.txt"),
+            lua.get_or<std::string>("dumpChillP", "waterChillP.lammpstrj")));
+      }
+      if (config["bulk"]["topologicalNetworkCriterion"].as<bool>()) {
+        pipeline.add(spipe::topoBulkAnalysis());
+      }
+    } // end of bulk analyses
+    if (config["topoTwoDim"]["use"].as<bool>()) {
+      pipeline.add(spipe::topoTwoDimAnalysis(
+          lua.get_or<double>("confiningSheetArea", 0.0)));
+    }
+    // The prism analysis moves the atoms, so it runs last
+    if (config["topoOneDim"]["use"].as<bool>()) {
+      pipeline.add(spipe::topoOneDimAnalysis());
+    }
+    if (pipeline.run() != 0) {
+      return 1;
+    }
+  } // end of pipeline
   // --------------------------------------
   // Structure determination block for TWO-DIMENSIONAL ICE
-  if (config["topoTwoDim"]["use"].as<bool>()) {
+  if (!usePipeline && config["topoTwoDim"]["use"].as<bool>()) {
     // Use the variables script
     lua.script_file(vars);
     // -----------------
@@ -110,18 +246,23 @@ int main(int argc, char *argv[]) {
     // Generic requirements
     lua.set_function("readFrameOnlyOne", sinp::readLammpsTrjreduced);
     lua.set_function("readFrameOnlyOneAllAtoms", sinp::readLammpsTrj); // reads in all atoms regardless of type  
-    lua.set_function("neighborList", nneigh::neighListO);
+    lua.set_function("neighborList", scache::neighListO);
     // -----------------
     // Topological Network Method Specific Functions
     // Generic requirements (read in only inside the slice)
-    lua.set_function("getHbondNetwork", bond::populateHbonds);
+    lua.set_function("getHbondNetwork", scache::populateHbonds);
     lua.set_function("bondNetworkByIndex", nneigh::neighbourListByIndex);
     // -----------------
     // Primitive rings
-    lua.set_function("getPrimitiveRings", primitive::ringNetwork);
+    lua.set_function("getPrimitiveRings", scache::ringNetwork);
+    // -----------------
+    // Binary trajectory
+    lua.set_function("binaryToASCII", sbin::convertToASCII);
     // -----------------
     // Quasi-two-dimensional ice
-    lua.set_function("ringAnalysis", ring::polygonRingAnalysis);
+    lua.set_function("ringAnalysis",
+                     slua::ringOverloads(ring::polygonRingAnalysis,
+                                         ring::polygonRingAnalysis));
     // --------------------------
     // RDF functions
     lua.set_function("calcRDF", rdf2::rdf2Danalysis_AA);
@@ -133,7 +274,7 @@ int main(int argc, char *argv[]) {
   } // end of two-dimensional ice block
   // --------------------------------------
   // Structure determination block for ONE-DIMENSIONAL ICE
-  if (config["topoOneDim"]["use"].as<bool>()) {
+  if (!usePipeline && config["topoOneDim"]["use"].as<bool>()) {
     // Use the script
     lua.script_file(vars);
     // -----------------
@@ -174,18 +315,23 @@ int main(int argc, char *argv[]) {
     // Generic requirements
     lua.set_function("readFrameOnlyOne", sinp::readLammpsTrjreduced);
     lua.set_function("readFrameOnlyOneAllAtoms", sinp::readLammpsTrj); // reads in all atoms regardless of type  
-    lua.set_function("neighborList", nneigh::neighListO);
+    lua.set_function("neighborList", scache::neighListO);
     // -----------------
     // Topological Network Method Specific Functions
     // Generic requirements (read in only inside the slice)
-    lua.set_function("getHbondNetwork", bond::populateHbonds);
+    lua.set_function("getHbondNetwork", scache::populateHbonds);
     lua.set_function("bondNetworkByIndex", nneigh::neighbourListByIndex);
     // -----------------
     // Primitive rings
-    lua.set_function("getPrimitiveRings", primitive::ringNetwork);
+    lua.set_function("getPrimitiveRings", scache::ringNetwork);
+    // -----------------
+    // Binary trajectory
+    lua.set_function("binaryToASCII", sbin::convertToASCII);
     // -----------------
     // Quasi-one-dimensional ice
-    lua.set_function("prismAnalysis", ring::prismAnalysis);
+    lua.set_function("prismAnalysis",
+                     slua::ringOverloads(ring::prismAnalysis,
+                                         ring::prismAnalysis));
     // --------------------------
     // Use the script
     lua.script_file(lscript);
@@ -194,7 +340,7 @@ int main(int argc, char *argv[]) {
   } // end of one-dimensional ice block
   // --------------------------------------
   // Ice Structure Determination for BULK ICE
-  if (config["bulk"]["use"].as<bool>()) {
+  if (!usePipeline && config["bulk"]["use"].as<bool>()) {
     // Use the variables script
     lua.script_file(vars);
     // Variables which must be declared in C++
@@ -242,9 +388,11 @@ int main(int argc, char *argv[]) {
     // Writing stuff
     lua.set_function("writeDump", sout::writeDump);
     lua.set_function("writeHistogram", sout::writeHisto);
+    lua.set_function("writeHistogramCheckpoint",
+                     []() { return sstat::writeAll(); });
     // Generic requirements
     lua.set_function("readFrame", sinp::readLammpsTrjO);
-    lua.set_function("neighborList", nneigh::neighListO);
+    lua.set_function("neighborList", scache::neighListO);
     // CHILL+ and modifications
     lua.set_function("chillPlus_cij", chill::getCorrelPlus);
     lua.set_function("chillPlus_iceType", chill::getIceTypePlus);
@@ -265,26 +413,44 @@ int main(int argc, char *argv[]) {
     lua.set_function("selectInSingleSlice", gen::moleculesInSingleSlice);
     lua.set_function("selectEdgeAtomsInRingsWithinSlice", ring::getEdgeMoleculesInRings);
     lua.set_function("selectAtomsInSliceWithRingEdgeAtoms", ring::printSliceGetEdgeMoleculesInRings);
+    // Regions (slab, sphere or cylinder) for selections
+    lua.set_function("slabRegion", gen::slabRegion);
+    lua.set_function("sphereRegion", gen::sphereRegion);
+    lua.set_function("cylinderRegion", gen::cylinderRegion);
+    lua.set_function("selectInRegion", gen::moleculesInRegion);
+    // Atom indices inside many regions (such as the slabs of a profile) at once
+    lua.set_function("atomsInRegions", gen::atomsInRegions);
+    lua.set_function("selectEdgeAtomsInRingsWithinRegion", ring::getEdgeMoleculesInRingsRegion);
+    lua.set_function("selectAtomsInRegionWithRingEdgeAtoms", ring::printRegionGetEdgeMoleculesInRings);
     // -----------------
     // Topological Network Methods
     // Generic requirements (read in only inside the slice)
     lua.set_function("readFrameOnlyOne", sinp::readLammpsTrjreduced);
     lua.set_function("readFrameOnlyOneAllAtoms", sinp::readLammpsTrj); // reads in all atoms regardless of type  
-    lua.set_function("getHbondNetwork", bond::populateHbonds);
+    lua.set_function("getHbondNetwork", scache::populateHbonds);
     lua.set_function("getHbondNetworkFromClouds", bond::populateHbondsWithInputClouds);
     lua.set_function("bondNetworkByIndex", nneigh::neighbourListByIndex);
     // -----------------
     // Primitive rings
-    lua.set_function("getPrimitiveRings", primitive::ringNetwork);
+    lua.set_function("getPrimitiveRings", scache::ringNetwork);
+    // -----------------
+    // Binary trajectory
+    lua.set_function("binaryToASCII", sbin::convertToASCII);
     // Function for just getting and writing out the ring numbers
-    lua.set_function("bulkRingNumberAnalysis", ring::bulkPolygonRingAnalysis);
+    lua.set_function("bulkRingNumberAnalysis",
+                     slua::ringOverloads(ring::bulkPolygonRingAnalysis,
+                                         ring::bulkPolygonRingAnalysis));
     // -----------------
     // Bulk ice, using the topological network criterion
-    lua.set_function("bulkTopologicalNetworkCriterion", ring::topoBulkAnalysis);
+    lua.set_function("bulkTopologicalNetworkCriterion",
+                     slua::ringOverloads(ring::topoBulkAnalysis,
+                                         ring::topoBulkAnalysis));
     // --------------------------
     // Bulk ice, using the TUM (Topological Unit Matching Criterion). No need to
     // use bulkTopologicalNetworkCriterion if you use this function
-    lua.set_function("bulkTopoUnitMatching", tum3::topoUnitMatchingBulk);
+    lua.set_function("bulkTopoUnitMatching",
+                     slua::ringOverloads(tum3::topoUnitMatchingBulk,
+                                         tum3::topoUnitMatchingBulk));
     // --------------------------
     // Use the script
     lua.script_file(lscript);
@@ -292,6 +458,14 @@ int main(int argc, char *argv[]) {
 
   } // end of bulk ice structure determination block
   // --------------------------------------
+  // Write out everything still buffered by the output sinks
+  {
+    sprof::StageTimer timer("output.flush");
+    sstat::writeAll();
+    sbin::closeTrajectory();
+    sout::closeAllSinks();
+  }
+  // --------------------------------------
 
   std::cout << rang::style::bold
             << fmt::format("Welcome to the Black Parade.\nYou ran:-\n")
@@ -303,6 +477,11 @@ int main(int argc, char *argv[]) {
             << fmt::format("\nQuasi-two-dimensional Ice Analysis: {}",
                            config["topoTwoDim"]["use"].as<bool>())
             << "\n";
+  // Time spent in each stage, if the timers were switched on
+  sprof::printReport();
+  if (config["timingsFile"]) {
+    sprof::writeJSON(config["timingsFile"].as<std::string>());
+  } // end of writing the timings
 
   return 0;
 }
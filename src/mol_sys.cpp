@@ -12,9 +12,87 @@
 // If not, see <https://opensource.org/licenses/MIT>.
 //-----------------------------------------------------------------------------------
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <mol_sys.hpp>
+#include <profiling.hpp>
+
+namespace {
+
+// Precision of the pairwise distance kernels, shared by every thread
+std::atomic<molSys::Precision> &currentPrecision() {
+#ifdef DSEAMS_SINGLE_PRECISION
+  static std::atomic<molSys::Precision> value{molSys::Precision::single};
+#else
+  static std::atomic<molSys::Precision> value{molSys::Precision::full};
+#endif
+  return value;
+}
+
+// Order of the atoms of every frame read in, shared by every thread
+std::atomic<molSys::AtomOrder> &currentAtomOrder() {
+  static std::atomic<molSys::AtomOrder> value{molSys::AtomOrder::file};
+  return value;
+}
+
+// Bits per dimension of the space-filling curves (3 x 21 bits fit in a key)
+const int curveBits = 21;
+
+// Spreads the lowest 21 bits of v out to every third bit
+std::uint64_t spreadBits(std::uint64_t v) {
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffff;
+  v = (v | v << 16) & 0x1f0000ff0000ff;
+  v = (v | v << 8) & 0x100f00f00f00f00f;
+  v = (v | v << 4) & 0x10c30c30c30c30c3;
+  v = (v | v << 2) & 0x1249249249249249;
+  return v;
+}
+
+// Position of a cell along the Morton curve, with the bits of x, y and z
+// interleaved (x most significant)
+std::uint64_t mortonKey(const std::array<std::uint32_t, 3> &cell) {
+  return spreadBits(cell[0]) << 2 | spreadBits(cell[1]) << 1 |
+         spreadBits(cell[2]);
+}
+
+// Position of a cell along the Hilbert curve. The cell coordinates are turned
+// into the transposed Hilbert index (J. Skilling, AIP Conf. Proc. 707, 381
+// (2004)), whose bits are interleaved like those of a Morton key
+std::uint64_t hilbertKey(std::array<std::uint32_t, 3> cell) {
+  const std::uint32_t highBit = 1u << (curveBits - 1);
+  // Inverse undo
+  for (std::uint32_t q = highBit; q > 1; q >>= 1) {
+    std::uint32_t p = q - 1;
+    for (int k = 0; k < 3; k++) {
+      if (cell[k] & q) {
+        cell[0] ^= p; // invert
+      } else {
+        std::uint32_t t = (cell[0] ^ cell[k]) & p; // exchange
+        cell[0] ^= t;
+        cell[k] ^= t;
+      }
+    }
+  } // end of loop through the bits
+  // Gray encode
+  for (int k = 1; k < 3; k++) {
+    cell[k] ^= cell[k - 1];
+  }
+  std::uint32_t t = 0;
+  for (std::uint32_t q = highBit; q > 1; q >>= 1) {
+    if (cell[2] & q) {
+      t ^= q - 1;
+    }
+  }
+  for (int k = 0; k < 3; k++) {
+    cell[k] ^= t;
+  }
+  return mortonKey(cell);
+}
+
+} // namespace
 
 /**
  * @details Function for clearing PointCloud if it is already
@@ -33,6 +111,7 @@ molSys::PointCloud<molSys::Point<double>, double> molSys::clearPointCloud(
   tempBox.swap(yCloud->box);
   tempBox1.swap(yCloud->boxLow);
   yCloud->idIndexMap.clear();
+  yCloud->fileOrder.clear();
 
   return *yCloud;
 }
@@ -142,3 +221,159 @@ int molSys::searchMolList(std::vector<std::vector<int>> molList,
 
   return index;
 }
+
+/**
+ * @details Copies the coordinates and type IDs of every point, along with
+ * the box lengths, into the contiguous arrays of a molSys::Coordinates,
+ * converting them to T. The arrays are indexed like yCloud->pts.
+ * @param[in] yCloud The input PointCloud
+ * @param[out] coords The packed coordinates
+ */
+template <typename T>
+void molSys::packCoordinates(
+    const molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    molSys::Coordinates<T> &coords) {
+  int nop = yCloud->pts.size();
+
+  coords.x.resize(nop);
+  coords.y.resize(nop);
+  coords.z.resize(nop);
+  coords.type.resize(nop);
+  for (int iatom = 0; iatom < nop; iatom++) {
+    coords.x[iatom] = static_cast<T>(yCloud->pts[iatom].x);
+    coords.y[iatom] = static_cast<T>(yCloud->pts[iatom].y);
+    coords.z[iatom] = static_cast<T>(yCloud->pts[iatom].z);
+    coords.type[iatom] = yCloud->pts[iatom].type;
+  } // end of loop through the points
+  for (int k = 0; k < 3; k++) {
+    coords.box[k] = k < yCloud->box.size() ? static_cast<T>(yCloud->box[k])
+                                           : static_cast<T>(0);
+  }
+}
+
+template struct molSys::Coordinates<float>;
+template struct molSys::Coordinates<double>;
+template void molSys::packCoordinates(
+    const molSys::PointCloud<molSys::Point<double>, double> *,
+    molSys::Coordinates<float> &);
+template void molSys::packCoordinates(
+    const molSys::PointCloud<molSys::Point<double>, double> *,
+    molSys::Coordinates<double> &);
+
+/**
+ * @details Sets the precision used by the neighbour list and RDF kernels
+ * from now on (see molSys::Precision).
+ * @param[in] value The new precision
+ */
+void molSys::setPrecision(molSys::Precision value) {
+  currentPrecision().store(value);
+}
+
+/**
+ * @details Returns the precision used by the neighbour list and RDF kernels.
+ */
+molSys::Precision molSys::precision() { return currentPrecision().load(); }
+
+/**
+ * @details Sets the order in which the trajectory readers put the atoms of
+ * every frame read in from now on (see molSys::AtomOrder). The default is the
+ * order of the trajectory file.
+ * @param[in] value The new order
+ */
+void molSys::setAtomOrder(molSys::AtomOrder value) {
+  currentAtomOrder().store(value);
+}
+
+/**
+ * @details Returns the order in which the trajectory readers put the atoms.
+ */
+molSys::AtomOrder molSys::atomOrder() { return currentAtomOrder().load(); }
+
+/**
+ * @details Sorts the atoms of a PointCloud along a Morton or Hilbert curve,
+ * through the bounding box of the atoms split into 2^21 cells per dimension.
+ * Atoms in the same cell keep their relative order. The idIndexMap is
+ * updated, and the fileOrder is set so that molSys::fileIndex still gives the
+ * atoms in the order in which they were read. Nothing is done for
+ * molSys::AtomOrder::file.
+ * @param[in, out] yCloud The PointCloud to reorder
+ * @param[in] order The space-filling curve to order the atoms along
+ */
+int molSys::reorderAtoms(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    molSys::AtomOrder order) {
+  int nop = yCloud->pts.size(); // Number of atoms
+  if (order == molSys::AtomOrder::file || nop < 2) {
+    return 0;
+  }
+  sprof::StageTimer timer("reorder");
+  // ----------------
+  // Bounding box of the atoms (unwrapped coordinates can lie outside the box)
+  std::array<double, 3> low = {yCloud->pts[0].x, yCloud->pts[0].y,
+                               yCloud->pts[0].z};
+  std::array<double, 3> high = low;
+  for (auto &pnt : yCloud->pts) {
+    std::array<double, 3> r = {pnt.x, pnt.y, pnt.z};
+    for (int k = 0; k < 3; k++) {
+      low[k] = std::min(low[k], r[k]);
+      high[k] = std::max(high[k], r[k]);
+    }
+  } // end of finding the bounding box
+  // ----------------
+  // Position of every atom along the curve
+  const std::uint32_t maxCell = (1u << curveBits) - 1;
+  std::array<double, 3> cellsPerLength;
+  for (int k = 0; k < 3; k++) {
+    cellsPerLength[k] = high[k] > low[k] ? maxCell / (high[k] - low[k]) : 0.0;
+  }
+  std::vector<std::pair<std::uint64_t, int>> keys(nop); // Key and old index
+  for (int iatom = 0; iatom < nop; iatom++) {
+    const auto &pnt = yCloud->pts[iatom];
+    std::array<double, 3> r = {pnt.x, pnt.y, pnt.z};
+    std::array<std::uint32_t, 3> cell;
+    for (int k = 0; k < 3; k++) {
+      cell[k] = std::min(maxCell, static_cast<std::uint32_t>(
+                                      (r[k] - low[k]) * cellsPerLength[k]));
+    }
+    keys[iatom].first = order == molSys::AtomOrder::hilbert
+                            ? hilbertKey(cell)
+                            : mortonKey(cell);
+    keys[iatom].second = iatom;
+  } // end of loop through atoms
+  // Ties are broken by the old index, so the order is always the same
+  std::sort(keys.begin(), keys.end());
+  // ----------------
+  // Permute the atoms
+  std::vector<molSys::Point<double>> pts(nop);
+  std::vector<int> newIndex(nop); // New index of every old index
+  for (int i = 0; i < nop; i++) {
+    pts[i] = std::move(yCloud->pts[keys[i].second]);
+    newIndex[keys[i].second] = i;
+  }
+  std::vector<int> fileOrder(nop);
+  for (int k = 0; k < nop; k++) {
+    fileOrder[k] = newIndex[molSys::fileIndex(yCloud, k)];
+  }
+  yCloud->pts.swap(pts);
+  yCloud->fileOrder.swap(fileOrder);
+  for (int iatom = 0; iatom < nop; iatom++) {
+    yCloud->idIndexMap[yCloud->pts[iatom].atomID] = iatom;
+  }
+
+  return 0;
+}
+
+/**
+ * @details Returns the position of every atom in the order in which the atoms
+ * were read, which is the inverse of the PointCloud::fileOrder. Loops over the
+ * atoms in this order can use it to visit each pair of atoms only once.
+ * @param[in] yCloud The input PointCloud
+ */
+std::vector<int> molSys::filePositions(
+    const molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  std::vector<int> position(yCloud->pts.size());
+  for (int k = 0; k < yCloud->pts.size(); k++) {
+    position[molSys::fileIndex(yCloud, k)] = k;
+  }
+  return position;
+}
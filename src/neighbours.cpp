@@ -12,14 +12,95 @@
 // If not, see <https://opensource.org/licenses/MIT>.
 //-----------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <type_traits>
 #include <math.h>
 #include <neighbours.hpp>
+#include <profiling.hpp>
+
+namespace {
+
+// Matches atoms of any type in visitPairs
+const int anyType = std::numeric_limits<int>::min();
+
+// Atom ID of every index, found from the idIndexMap. hasID is false for the
+// indices which are not in the map. If several IDs map to the same index, the
+// first one in the map is used
+void atomIDsByIndex(
+    const molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    std::vector<int> &atomIDs, std::vector<bool> &hasID) {
+  atomIDs.assign(yCloud->nop, -1);
+  hasID.assign(yCloud->nop, false);
+  for (auto &p : yCloud->idIndexMap) {
+    if (p.second >= 0 && p.second < yCloud->nop && !hasID[p.second]) {
+      atomIDs[p.second] = p.first;
+      hasID[p.second] = true;
+    }
+  } // end of loop through the map
+}
+
+// Calls visit(iatom, jatom) for every pair of atoms of types typeI and typeJ
+// (or of any type, with anyType) within rcutoff, in the order of the
+// brute-force loops: by iatom, and then by jatom, starting from iatom+1 if
+// upper is true and from 0 otherwise. The distances are computed with the
+// packed coordinates, in their precision. Stops as soon as visit returns
+// false, and returns false in that case
+template <typename T, typename Visit>
+bool visitPairs(const molSys::Coordinates<T> &coords, int typeI, int typeJ,
+                bool upper, double rcutoff, Visit &visit) {
+  int nop = coords.x.size();
+  T cutoff = static_cast<T>(rcutoff);
+  std::vector<T> dist(nop); // Distances from iatom
+
+  for (int iatom = 0; iatom < nop; iatom++) {
+    if (typeI != anyType && coords.type[iatom] != typeI) {
+      continue;
+    }
+    int jStart = upper ? iatom + 1 : 0;
+    gen::periodicDistances(coords, iatom, jStart, dist);
+    for (int jatom = jStart; jatom < nop; jatom++) {
+      if (typeJ != anyType && coords.type[jatom] != typeJ) {
+        continue;
+      }
+      // If the distance is greater than rcutoff, continue
+      if (dist[jatom] > cutoff) {
+        continue;
+      }
+      if (!visit(iatom, jatom)) {
+        return false;
+      }
+    } // end of loop through jatom
+  }   // end of loop through iatom
+  return true;
+}
+
+// Fills the first element of every row of a neighbour list with the atom ID
+// of that index
+std::vector<std::vector<int>> initNeighList(const std::vector<int> &atomIDs,
+                                            const std::vector<bool> &hasID) {
+  std::vector<std::vector<int>> nList;
+  for (int iatom = 0; iatom < atomIDs.size(); iatom++) {
+    if (!hasID[iatom]) {
+      std::cerr << "Something is wrong with your idIndexMap!\n";
+      continue;
+    }
+    nList.push_back(std::vector<int>()); // Empty vector for the index iatom
+    // Fill the first element with the atom ID of iatom itself
+    nList[iatom].push_back(atomIDs[iatom]);
+  } // end of init
+  return nList;
+}
+
+} // namespace
 
 /**
  * @details Function for building neighbour lists for each
  *  particle. Inefficient brute-force \f$ O(n^2) \f$ implementation.
  *  This generates the full neighbour list, by ID.
+ *  The distances are computed in the precision set with
+ *  molSys::setPrecision.
  * @param[in] rcutoff Distance cutoff, within which two atoms are neighbours.
  * @param[in] yCloud The input molSys::PointCloud
  * @param[in] typeI Type ID of particles of type I.
@@ -30,76 +111,30 @@ std::vector<std::vector<int>>
 nneigh::neighList(double rcutoff,
                   molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                   int typeI, int typeJ) {
-  std::vector<std::vector<int>> nList; // Vector of vector of ints
-  int jatomIndex;                      // Atom ID corresponding to jatom
-  int iatomIndex;                      // Atom ID corresponding to iatom
-  double r_ij;                         // cutoff
+  std::vector<int> atomIDs; // Atom ID of every index
+  std::vector<bool> hasID;  // Whether an index has an atom ID
 
-  // Initialize with nop (irrespective of type)
-  // Initialize and fill the first element with the current atom ID whose
-  // neighbour list will be filled
-  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
-    // Find the atom ID (key) given the index or iatom (value)
-    auto itr = std::find_if(
-        yCloud->idIndexMap.begin(), yCloud->idIndexMap.end(),
-        [&iatom](const std::pair<int, int> &p) { return p.second == iatom; });
-    // If found:
-    if (itr == yCloud->idIndexMap.end()) {
-      std::cerr << "Something is wrong with your idIndexMap!\n";
-      continue;
-    } else {
-      iatomIndex = itr->first;
-    } // End of finding the atom ID to fill as the first element in the
-      // neighbour list
-    nList.push_back(std::vector<int>()); // Empty vector for the index iatom
-    // Fill the first element with the atom ID of iatom itself
-    nList[iatom].push_back(iatomIndex);
-  } // end of init
+  // Initialize with nop (irrespective of type), and fill the first element
+  // with the current atom ID whose neighbour list will be filled
+  atomIDsByIndex(yCloud, atomIDs, hasID);
+  std::vector<std::vector<int>> nList = initNeighList(atomIDs, hasID);
 
   // pairs of atoms of type I and J
   // Loop through every iatom and find nearest neighbours within rcutoff
-  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
-    if (yCloud->pts[iatom].type != typeI) {
-      continue;
+  auto addPair = [&](int iatom, int jatom) {
+    if (!hasID[iatom] || !hasID[jatom]) {
+      std::cerr << "Something is wrong with your idIndexMap!\n";
+      return false;
     }
-    // Loop through the other atoms
-    for (int jatom = 0; jatom < yCloud->nop; jatom++) {
-      if (yCloud->pts[jatom].type != typeJ) {
-        continue;
-      }
-      // If the distance is greater than rcutoff, continue
-      r_ij = gen::periodicDist(yCloud, iatom, jatom);
-      if (r_ij > rcutoff) {
-        continue;
-      }
-
-      // Get the atom IDs for iatom and jatom
-      auto gotI = std::find_if(
-          yCloud->idIndexMap.begin(), yCloud->idIndexMap.end(),
-          [&iatom](const std::pair<int, int> &p) { return p.second == iatom; });
-      if (gotI == yCloud->idIndexMap.end()) {
-        std::cerr << "Something is wrong with your idIndexMap!\n";
-        return nList;
-      } else {
-        iatomIndex = gotI->first;
-      } // End of finding the atom ID for iatom
-      // Find the atom ID of jatom
-      auto gotJ = std::find_if(
-          yCloud->idIndexMap.begin(), yCloud->idIndexMap.end(),
-          [&jatom](const std::pair<int, int> &p) { return p.second == jatom; });
-      if (gotJ == yCloud->idIndexMap.end()) {
-        std::cerr << "Something is wrong with your idIndexMap!\n";
-        return nList;
-      } else {
-        jatomIndex = gotJ->first;
-      } // End of finding the atom ID for jatom
-      // Update the neighbour indices with atom IDs for iatom and jatom both
-      // (full list)
-      nList[iatom].push_back(jatomIndex);
-      nList[jatom].push_back(iatomIndex);
-
-    } // End of loop through jatom
-  }   // End of loop for iatom
+    // Update the neighbour indices with atom IDs for iatom and jatom both
+    // (full list)
+    nList[iatom].push_back(atomIDs[jatom]);
+    nList[jatom].push_back(atomIDs[iatom]);
+    return true;
+  };
+  molSys::withCoordinates(yCloud, [&](const auto &coords) {
+    visitPairs(coords, typeI, typeJ, false, rcutoff, addPair);
+  });
 
   return nList;
 }
@@ -109,6 +144,8 @@ nneigh::neighList(double rcutoff,
  *  particle of only one type. Inefficient brute-force \f$ O(n^2) \f$
  * implementation. This generates the full neighbour list, by ID. This function
  * will only work for building a neighbour list between one type of particles.
+ *  The distances are computed in the precision set with
+ *  molSys::setPrecision.
  * @param[in] rcutoff Distance cutoff, within which two atoms are neighbours.
  * @param[in] yCloud The input molSys::PointCloud
  * @param[in] typeI Type ID of the \f$ i^{th} \f$ particle type.
@@ -118,78 +155,201 @@ std::vector<std::vector<int>>
 nneigh::neighListO(double rcutoff,
                    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                    int typeI) {
-  std::vector<std::vector<int>>
-      nList;      // Vector of vectors of the neighbour list
-  double r_ij;    // Distance between iatom and jatom
-  int iatomIndex; // Atomic ID of the atom with index iatom
-  int jatomIndex; // Atomic ID of the atom with index jatom
-  int indexYay;
-  std::vector<int> tempListIatom;
+  sprof::StageTimer timer("neighbours");
+  std::vector<int> atomIDs; // Atom ID of every index
+  std::vector<bool> hasID;  // Whether an index has an atom ID
 
   // Initialize and fill the first element with the current atom ID whose
   // neighbour list will be filled
-  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
-    // Find the atom ID (key) given the index or iatom (value)
-    auto itr = std::find_if(
-        yCloud->idIndexMap.begin(), yCloud->idIndexMap.end(),
-        [&iatom](const std::pair<int, int> &p) { return p.second == iatom; });
-    // If found:
-    if (itr == yCloud->idIndexMap.end()) {
-      std::cerr << "Something is wrong with your idIndexMap!\n";
-      continue;
-    } else {
-      iatomIndex = itr->first;
-    } // End of finding the atom ID to fill as the first element in the
-      // neighbour list
-    nList.push_back(std::vector<int>()); // Empty vector for the index iatom
-    // Fill the first element with the atom ID of iatom itself
-    nList[iatom].push_back(iatomIndex);
-  } // end of init
+  atomIDsByIndex(yCloud, atomIDs, hasID);
+  std::vector<std::vector<int>> nList = initNeighList(atomIDs, hasID);
 
   // Loop through every iatom and find nearest neighbours within rcutoff
-  for (int iatom = 0; iatom < yCloud->nop - 1; iatom++) {
-    if (yCloud->pts[iatom].type != typeI) {
-      continue;
+  auto addPair = [&](int iatom, int jatom) {
+    if (!hasID[iatom] || !hasID[jatom]) {
+      std::cerr << "Something is wrong with your idIndexMap!\n";
+      return false;
     }
-    // Loop through the other atoms
-    for (int jatom = iatom + 1; jatom < yCloud->nop; jatom++) {
-      if (yCloud->pts[jatom].type != typeI) {
-        continue;
+    // Update the neighbour indices with atom IDs for iatom and jatom both
+    // (full list)
+    nList[iatom].push_back(atomIDs[jatom]);
+    nList[jatom].push_back(atomIDs[iatom]);
+    return true;
+  };
+  molSys::withCoordinates(yCloud, [&](const auto &coords) {
+    visitPairs(coords, typeI, typeI, true, rcutoff, addPair);
+  });
+
+  sprof::count("neighbours", yCloud->nop);
+  return nList;
+}
+
+namespace {
+
+// Distance moved by the atom iatom since the last build (minimum image)
+double movedSinceBuild(
+    const molSys::PointCloud<molSys::Point<double>, double> *yCloud, int iatom,
+    const std::array<double, 3> &refPos) {
+  std::array<double, 3> dr = {yCloud->pts[iatom].x - refPos[0],
+                              yCloud->pts[iatom].y - refPos[1],
+                              yCloud->pts[iatom].z - refPos[2]};
+  double r2 = 0.0;
+  for (int k = 0; k < 3; k++) {
+    dr[k] -= yCloud->box[k] * round(dr[k] / yCloud->box[k]);
+    r2 += dr[k] * dr[k];
+  }
+  return sqrt(r2);
+}
+
+// Saves every pair of atoms of type typeI closer than rcutoff+skin, along
+// with the positions, IDs and box of this frame
+void buildVerletPairs(nneigh::VerletList &verlet, double rcutoff,
+                      molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                      int typeI) {
+  sprof::StageTimer timer("neighbours.rebuild");
+  int nop = yCloud->nop;
+  double pairCutoff = rcutoff + verlet.skin;
+
+  verlet.rcutoff = rcutoff;
+  verlet.typeI = typeI;
+  verlet.refBox = yCloud->box;
+  verlet.atomIDs.resize(nop);
+  verlet.types.resize(nop);
+  verlet.refPos.resize(nop);
+  verlet.refIndex.clear();
+  verlet.refIndex.reserve(nop);
+  for (int iatom = 0; iatom < nop; iatom++) {
+    verlet.atomIDs[iatom] = yCloud->pts[iatom].atomID;
+    verlet.types[iatom] = yCloud->pts[iatom].type;
+    verlet.refPos[iatom] = {yCloud->pts[iatom].x, yCloud->pts[iatom].y,
+                            yCloud->pts[iatom].z};
+    verlet.refIndex[yCloud->pts[iatom].atomID] = iatom;
+  } // end of saving the reference frame
+
+  // Pairs are saved in the order in which neighListO visits them
+  verlet.pairs.clear();
+  auto savePair = [&](int iatom, int jatom) {
+    verlet.pairs.emplace_back(iatom, jatom);
+    return true;
+  };
+  molSys::withCoordinates(yCloud, [&](const auto &coords) {
+    visitPairs(coords, typeI, typeI, true, pairCutoff, savePair);
+  });
+  verlet.precision = molSys::precision();
+  verlet.nBuilds++;
+}
+
+} // namespace
+
+/**
+ * @details Builds the same full neighbour list (by ID) as nneigh::neighListO,
+ * but only checks the pairs saved in the nneigh::VerletList. The saved pairs
+ * are rebuilt (by brute force) on the first call, when the cutoff, atom type,
+ * number of atoms or the set of atom IDs changes, or when
+ * \f$ 2 d_{max} + |\Delta L| > skin \f$, where \f$ d_{max} \f$ is the
+ * largest distance moved by an atom of type typeI since the last build and
+ * \f$ |\Delta L| \f$ is the change in the box lengths. Otherwise, no pair
+ * can have come within rcutoff without already being within rcutoff+skin at
+ * the last build.
+ *
+ * Atoms are matched across frames by their atom IDs, so that the saved pairs
+ * can be reused even if the atoms are written out in a different order.
+ * @param[in, out] verlet Saved pairs, updated whenever they are rebuilt.
+ * @param[in] rcutoff Distance cutoff, within which two atoms are neighbours.
+ * @param[in] yCloud The input molSys::PointCloud
+ * @param[in] typeI Type ID of the \f$ i^{th} \f$ particle type.
+ * @return Row-ordered full neighbour list, by atom ID.
+ */
+std::vector<std::vector<int>> nneigh::neighListOVerlet(
+    nneigh::VerletList &verlet, double rcutoff,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int typeI) {
+  sprof::StageTimer timer("neighbours");
+  int nop = yCloud->nop;
+  std::vector<std::vector<int>> nList(nop);
+  bool rebuild = verlet.rcutoff != rcutoff || verlet.typeI != typeI ||
+                 verlet.precision != molSys::precision() ||
+                 verlet.atomIDs.size() != static_cast<size_t>(nop) ||
+                 verlet.refBox.size() != yCloud->box.size();
+  bool sameOrder = true;         // Atoms are in the order of the last build
+  std::vector<int> currentIndex; // Index now, of each index at the last build
+
+  // -----------------
+  // Check whether the saved pairs can still be used
+  if (!rebuild) {
+    double boxShift = 0.0; // Change in the box lengths
+    for (size_t k = 0; k < yCloud->box.size(); k++) {
+      boxShift += pow(yCloud->box[k] - verlet.refBox[k], 2.0);
+    }
+    boxShift = sqrt(boxShift);
+    double maxMoved = 0.0; // Largest distance moved since the last build
+    currentIndex.resize(nop, -1);
+    for (int iatom = 0; iatom < nop; iatom++) {
+      int refAtom = iatom; // Index of this atom at the last build
+      if (yCloud->pts[iatom].atomID != verlet.atomIDs[iatom]) {
+        sameOrder = false;
+        auto itr = verlet.refIndex.find(yCloud->pts[iatom].atomID);
+        if (itr == verlet.refIndex.end()) {
+          rebuild = true;
+          break;
+        }
+        refAtom = itr->second;
       }
-      // If the distance is greater than rcutoff, continue
-      r_ij = gen::periodicDist(yCloud, iatom, jatom);
-      if (r_ij > rcutoff) {
-        continue;
+      if (currentIndex[refAtom] != -1 ||
+          verlet.types[refAtom] != yCloud->pts[iatom].type) {
+        rebuild = true;
+        break;
+      }
+      currentIndex[refAtom] = iatom;
+      if (yCloud->pts[iatom].type == typeI) {
+        maxMoved = std::max(
+            maxMoved, movedSinceBuild(yCloud, iatom, verlet.refPos[refAtom]));
       }
+    } // end of loop through the atoms
+    if (2.0 * maxMoved + boxShift > verlet.skin) {
+      rebuild = true;
+    }
+  } // end of check
 
-      // Get the atom IDs for iatom and jatom
-      auto gotI = std::find_if(
-          yCloud->idIndexMap.begin(), yCloud->idIndexMap.end(),
-          [&iatom](const std::pair<int, int> &p) { return p.second == iatom; });
-      if (gotI == yCloud->idIndexMap.end()) {
-        std::cerr << "Something is wrong with your idIndexMap!\n";
-        return nList;
-      } else {
-        iatomIndex = gotI->first;
-      } // End of finding the atom ID for iatom
-      // Find the atom ID of jatom
-      auto gotJ = std::find_if(
-          yCloud->idIndexMap.begin(), yCloud->idIndexMap.end(),
-          [&jatom](const std::pair<int, int> &p) { return p.second == jatom; });
-      if (gotJ == yCloud->idIndexMap.end()) {
-        std::cerr << "Something is wrong with your idIndexMap!\n";
-        return nList;
-      } else {
-        jatomIndex = gotJ->first;
-      } // End of finding the atom ID for jatom
-      // Update the neighbour indices with atom IDs for iatom and jatom both
-      // (full list)
-      nList[iatom].push_back(jatomIndex);
-      nList[jatom].push_back(iatomIndex);
-
-    } // End of loop through jatom
-  }   // End of loop for iatom
+  if (rebuild) {
+    buildVerletPairs(verlet, rcutoff, yCloud, typeI);
+    sameOrder = true;
+  } else {
+    verlet.nReuses++;
+  }
 
+  // -----------------
+  // The saved pairs, as indices of the current frame
+  std::vector<std::pair<int, int>> reordered;
+  if (!sameOrder) {
+    reordered.reserve(verlet.pairs.size());
+    for (auto &pair : verlet.pairs) {
+      int iatom = currentIndex[pair.first];
+      int jatom = currentIndex[pair.second];
+      reordered.emplace_back(std::min(iatom, jatom), std::max(iatom, jatom));
+    }
+    std::sort(reordered.begin(), reordered.end());
+  }
+  const std::vector<std::pair<int, int>> &pairs =
+      sameOrder ? verlet.pairs : reordered;
+
+  // -----------------
+  // Fill the neighbour list, with the atom ID of each atom first
+  for (int iatom = 0; iatom < nop; iatom++) {
+    nList[iatom].push_back(yCloud->pts[iatom].atomID);
+  }
+  molSys::withCoordinates(yCloud, [&](const auto &coords) {
+    using T = std::decay_t<decltype(coords.x[0])>;
+    T cutoff = static_cast<T>(rcutoff);
+    for (auto &pair : pairs) {
+      if (gen::periodicDist(coords, pair.first, pair.second) > cutoff) {
+        continue;
+      }
+      nList[pair.first].push_back(yCloud->pts[pair.second].atomID);
+      nList[pair.second].push_back(yCloud->pts[pair.first].atomID);
+    } // end of loop through the saved pairs
+  });
+
+  sprof::count("neighbours", nop);
   return nList;
 }
 
@@ -198,6 +358,8 @@ nneigh::neighListO(double rcutoff,
  *  particle of only one type. Inefficient brute-force \f$ O(n^2) \f$
  *  implementation. This generates the half neighbour list, by ID. This function
  *  will only work for building a neighbour list between one type of particles.
+ *  The distances are computed in the precision set with
+ *  molSys::setPrecision.
  * @param[in] rcutoff Distance cutoff, within which two atoms are neighbours.
  * @param[in] yCloud The input molSys::PointCloud
  * @param[in] typeI Type ID of the \f$ i^{th} \f$ particle type.
@@ -207,76 +369,27 @@ std::vector<std::vector<int>>
 nneigh::halfNeighList(double rcutoff,
                       molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                       int typeI) {
-  std::vector<std::vector<int>>
-      nList;      // Vector of vectors of the neighbour list
-  double r_ij;    // Distance between iatom and jatom
-  int iatomIndex; // Atomic ID of the atom with index iatom
-  int jatomIndex; // Atomic ID of the atom with index jatom
-  int indexYay;
-  std::vector<int> tempListIatom;
+  std::vector<int> atomIDs; // Atom ID of every index
+  std::vector<bool> hasID;  // Whether an index has an atom ID
 
   // Initialize and fill the first element with the current atom ID whose
   // neighbour list will be filled
-  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
-    // Find the atom ID (key) given the index or iatom (value)
-    auto itr = std::find_if(
-        yCloud->idIndexMap.begin(), yCloud->idIndexMap.end(),
-        [&iatom](const std::pair<int, int> &p) { return p.second == iatom; });
-    // If found:
-    if (itr == yCloud->idIndexMap.end()) {
-      std::cerr << "Something is wrong with your idIndexMap!\n";
-      continue;
-    } else {
-      iatomIndex = itr->first;
-    } // End of finding the atom ID to fill as the first element in the
-      // neighbour list
-    nList.push_back(std::vector<int>()); // Empty vector for the index iatom
-    // Fill the first element with the atom ID of iatom itself
-    nList[iatom].push_back(iatomIndex);
-  } // end of init
+  atomIDsByIndex(yCloud, atomIDs, hasID);
+  std::vector<std::vector<int>> nList = initNeighList(atomIDs, hasID);
 
   // Loop through every iatom and find nearest neighbours within rcutoff
-  for (int iatom = 0; iatom < yCloud->nop - 1; iatom++) {
-    if (yCloud->pts[iatom].type != typeI) {
-      continue;
+  auto addPair = [&](int iatom, int jatom) {
+    if (!hasID[iatom] || !hasID[jatom]) {
+      std::cerr << "Something is wrong with your idIndexMap!\n";
+      return false;
     }
-    // Loop through the other atoms
-    for (int jatom = iatom + 1; jatom < yCloud->nop; jatom++) {
-      if (yCloud->pts[jatom].type != typeI) {
-        continue;
-      }
-      // If the distance is greater than rcutoff, continue
-      r_ij = gen::periodicDist(yCloud, iatom, jatom);
-      if (r_ij > rcutoff) {
-        continue;
-      }
-
-      // Get the atom IDs for iatom and jatom
-      auto gotI = std::find_if(
-          yCloud->idIndexMap.begin(), yCloud->idIndexMap.end(),
-          [&iatom](const std::pair<int, int> &p) { return p.second == iatom; });
-      if (gotI == yCloud->idIndexMap.end()) {
-        std::cerr << "Something is wrong with your idIndexMap!\n";
-        return nList;
-      } else {
-        iatomIndex = gotI->first;
-      } // End of finding the atom ID for iatom
-      // Find the atom ID of jatom
-      auto gotJ = std::find_if(
-          yCloud->idIndexMap.begin(), yCloud->idIndexMap.end(),
-          [&jatom](const std::pair<int, int> &p) { return p.second == jatom; });
-      if (gotJ == yCloud->idIndexMap.end()) {
-        std::cerr << "Something is wrong with your idIndexMap!\n";
-        return nList;
-      } else {
-        jatomIndex = gotJ->first;
-      } // End of finding the atom ID for jatom
-      // Update the neighbour indices with atom IDs for iatom and jatom both
-      // (full list)
-      nList[iatom].push_back(jatomIndex);
-
-    } // End of loop through jatom
-  }   // End of loop for iatom
+    // Update the neighbour indices with the atom ID of jatom only (half list)
+    nList[iatom].push_back(atomIDs[jatom]);
+    return true;
+  };
+  molSys::withCoordinates(yCloud, [&](const auto &coords) {
+    visitPairs(coords, typeI, typeI, true, rcutoff, addPair);
+  });
 
   return nList;
 }
@@ -295,8 +408,6 @@ std::vector<std::vector<int>> nneigh::getNewNeighbourListByIndex(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, double cutoff) {
   //
   std::vector<std::vector<int>> nList;
-  double r_ij; // Distance between iatom and jatom
-  std::vector<int> tempListIatom;
 
   // Initialize and fill the first element with the current atom ID whose
   // neighbour list will be filled
@@ -308,22 +419,16 @@ std::vector<std::vector<int>> nneigh::getNewNeighbourListByIndex(
   } // end of init
   // -------------------------------------------------------
   // Loop through every iatom and find nearest neighbours within rcutoff
-  for (int iatom = 0; iatom < yCloud->nop - 1; iatom++) {
-    // Loop through the other atoms
-    for (int jatom = iatom + 1; jatom < yCloud->nop; jatom++) {
-      // If the distance is greater than rcutoff, continue
-      r_ij = gen::periodicDist(yCloud, iatom, jatom);
-      if (r_ij > cutoff) {
-        continue;
-      }
-
-      // Update the neighbour indices with atom IDs for iatom and jatom both
-      // (full list)
-      nList[iatom].push_back(jatom);
-      nList[jatom].push_back(iatom);
-
-    } // End of loop through jatom
-  }   // End of loop for iatom
+  auto addPair = [&](int iatom, int jatom) {
+    // Update the neighbour indices with atom IDs for iatom and jatom both
+    // (full list)
+    nList[iatom].push_back(jatom);
+    nList[jatom].push_back(iatom);
+    return true;
+  };
+  molSys::withCoordinates(yCloud, [&](const auto &coords) {
+    visitPairs(coords, anyType, anyType, true, cutoff, addPair);
+  });
 
   return nList;
 } // end of function
@@ -340,7 +445,8 @@ std::vector<std::vector<int>> nneigh::getNewNeighbourListByIndex(
  */
 std::vector<std::vector<int>> nneigh::neighbourListByIndex(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<std::vector<int>> nList) {
+    const std::vector<std::vector<int>> &nList) {
+  sprof::StageTimer timer("neighbours.byIndex");
   //
   std::vector<std::vector<int>> indexNlist; // Desired neighbour list of indices
   int iatomID, jatomID;                     // Atom IDs
@@ -396,3 +502,41 @@ int nneigh::clearNeighbourList(std::vector<std::vector<int>> &nList) {
 
   return 0;
 }
+
+/**
+ * @details Stores every (row, neighbour) pair of the neighbour list, skipping
+ * the first element of each row (the central atom). The table has a power of
+ * two number of slots, at least twice the number of pairs.
+ * @param[in] nList Row-ordered neighbour list (by index)
+ */
+nneigh::Adjacency::Adjacency(const std::vector<std::vector<int>> &nList) {
+  std::size_t maxPairs = 0;
+  for (auto &row : nList) {
+    if (row.size() > 1) {
+      maxPairs += row.size() - 1;
+    }
+  } // end of counting the pairs
+  if (maxPairs == 0) {
+    return;
+  } // no neighbours at all
+  std::size_t nSlots = 16;
+  while (nSlots < 2 * maxPairs) {
+    nSlots *= 2;
+  } // end of sizing the table
+  slots.assign(nSlots, emptySlot);
+  mask = nSlots - 1;
+
+  for (int iatom = 0; iatom < nList.size(); iatom++) {
+    for (int j = 1; j < nList[iatom].size(); j++) {
+      std::uint64_t key = pack(iatom, nList[iatom][j]);
+      std::size_t slot = hash(key) & mask;
+      while (slots[slot] != emptySlot && slots[slot] != key) {
+        slot = (slot + 1) & mask;
+      } // end of probing
+      if (slots[slot] == emptySlot) {
+        slots[slot] = key;
+        nPairs++;
+      } // new pair
+    }   // end of loop through the neighbours
+  }     // end of loop through the rows
+}
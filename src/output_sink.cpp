@@ -0,0 +1,247 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#include <output_sink.hpp>
+#include <seams_output.hpp>
+
+namespace {
+
+/**
+ * @details Owns the writer thread along with the per-run sinks and the
+ * directories already created. The sinks are declared after the writer, so
+ * that they are destroyed (and hand over their remaining output) before the
+ * writer thread is drained and joined.
+ */
+struct SinkRegistry {
+  sout::AsyncWriter asyncWriter;
+  std::unordered_map<std::string, std::unique_ptr<sout::OutputSink>> sinks;
+  std::unordered_set<std::string> createdPaths;
+  std::mutex mtx;
+};
+
+SinkRegistry &registry() {
+  static SinkRegistry reg;
+  return reg;
+}
+
+// Prints the files for which a write failed; returns 1 if there were any
+int reportFailures(sout::AsyncWriter &asyncWriter) {
+  std::vector<std::string> failed = asyncWriter.takeFailures();
+  for (auto &name : failed) {
+    std::cerr << "Could not write all the output to " << name << ".\n";
+  }
+  return failed.empty() ? 0 : 1;
+}
+
+} // namespace
+
+/**
+ * @details Starts the background thread which writes out queued buffers.
+ */
+sout::AsyncWriter::AsyncWriter() : worker(&sout::AsyncWriter::run, this) {}
+
+/**
+ * @details Writes out everything still in the queue and joins the thread.
+ */
+sout::AsyncWriter::~AsyncWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop = true;
+  }
+  workReady.notify_all();
+  worker.join();
+}
+
+/**
+ * @details Adds a buffer to the back of the queue. Empty buffers are ignored.
+ */
+void sout::AsyncWriter::submit(sout::WriteJob job) {
+  if (!job.file || job.data.size() == 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    queue.push_back(std::move(job));
+  }
+  workReady.notify_one();
+}
+
+/**
+ * @details Blocks until the queue is empty and the thread is idle.
+ */
+void sout::AsyncWriter::drain() {
+  std::unique_lock<std::mutex> lock(mtx);
+  workDone.wait(lock, [this] { return queue.empty() && !busy; });
+}
+
+/**
+ * @details Returns the names of the files for which a write has failed since
+ * the last call, in the order in which the failures happened.
+ */
+std::vector<std::string> sout::AsyncWriter::takeFailures() {
+  std::lock_guard<std::mutex> lock(mtx);
+  std::vector<std::string> failed;
+  failed.swap(failedFiles);
+  return failed;
+}
+
+/**
+ * @details Loop run by the writer thread. The file handle of each job is
+ * released after it has been written, which closes the file once the sink
+ * owning it is gone too. Each chunk is flushed to the file right away, so that
+ * a short write (a full disk, say) is caught here and recorded against the
+ * file name.
+ */
+void sout::AsyncWriter::run() {
+  std::unique_lock<std::mutex> lock(mtx);
+  while (true) {
+    workReady.wait(lock, [this] { return stop || !queue.empty(); });
+    if (queue.empty()) {
+      // stop was requested and there is nothing left to write
+      break;
+    }
+    sout::WriteJob job = std::move(queue.front());
+    queue.pop_front();
+    busy = true;
+    lock.unlock();
+    // Write outside the lock, so that the analysis thread can keep queueing
+    std::size_t nWritten =
+        std::fwrite(job.data.data(), 1, job.data.size(), job.file.get());
+    bool failed =
+        nWritten != job.data.size() || std::fflush(job.file.get()) != 0;
+    job.file.reset();
+    lock.lock();
+    if (failed) {
+      failedFiles.push_back(std::move(job.filename));
+    }
+    busy = false;
+    if (queue.empty()) {
+      workDone.notify_all();
+    }
+  } // end of loop
+}
+
+/**
+ * @details Opens the file for writing. Since the file handle is
+ * shared with the queued jobs, the file is closed by whichever of the two
+ * lets go of it last.
+ */
+sout::OutputSink::OutputSink(const std::string &filename, bool append)
+    : filename(filename) {
+  std::FILE *fp = std::fopen(filename.c_str(), append ? "ab" : "wb");
+  if (fp == nullptr) {
+    std::cerr << "Could not open " << filename << " for writing.\n";
+    return;
+  }
+  file = std::shared_ptr<std::FILE>(fp, [](std::FILE *f) { std::fclose(f); });
+}
+
+/**
+ * @details Hands over whatever output is still buffered.
+ */
+sout::OutputSink::~OutputSink() { flush(); }
+
+/**
+ * @details Moves the buffer into a job for the writer thread. Output for a
+ * file that could not be opened is discarded.
+ */
+void sout::OutputSink::flush() {
+  if (buffer.size() == 0) {
+    return;
+  }
+  if (!file) {
+    buffer.clear();
+    return;
+  }
+  sout::WriteJob job;
+  job.file = file;
+  job.data = std::move(buffer);
+  job.filename = filename;
+  buffer = fmt::memory_buffer();
+  sout::writer().submit(std::move(job));
+}
+
+/**
+ * @details Returns the writer thread shared by all the sinks.
+ */
+sout::AsyncWriter &sout::writer() { return registry().asyncWriter; }
+
+/**
+ * @details Looks up the sink for a file which is written to frame after
+ * frame (for instance clusterStats.dat or nPrisms.dat). The file is opened in
+ * append mode the first time, exactly as the writers used to do every frame,
+ * and stays open until sout::closeAllSinks is called.
+ */
+sout::OutputSink &sout::appendSink(const std::string &filename) {
+  SinkRegistry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  auto it = reg.sinks.find(filename);
+  if (it == reg.sinks.end()) {
+    it = reg.sinks
+             .emplace(filename,
+                      std::make_unique<sout::OutputSink>(filename, true))
+             .first;
+  }
+  return *(it->second);
+}
+
+/**
+ * @details Creates a directory with sout::makePath the first time it is
+ * asked for. Once the directory exists, later calls for the same path return
+ * immediately; a failed attempt is retried on the next call.
+ */
+int sout::ensurePath(const std::string &path) {
+  SinkRegistry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  if (reg.createdPaths.count(path) != 0) {
+    return 0;
+  }
+  int ret = sout::makePath(path);
+  if (ret == 0) {
+    reg.createdPaths.insert(path);
+  }
+  return ret;
+}
+
+/**
+ * @details Flushes every per-run sink and waits for the writer thread to
+ * finish, so that all output files are complete on disk. Every file for which
+ * a write failed is reported on stderr.
+ */
+int sout::flushAllSinks() {
+  SinkRegistry &reg = registry();
+  {
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    for (auto &sink : reg.sinks) {
+      sink.second->flush();
+    }
+  }
+  reg.asyncWriter.drain();
+  return reportFailures(reg.asyncWriter);
+}
+
+/**
+ * @details Flushes and closes every per-run sink. A sink requested again
+ * afterwards re-opens its file in append mode. Every file for which a write
+ * failed is reported on stderr.
+ */
+int sout::closeAllSinks() {
+  SinkRegistry &reg = registry();
+  {
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    reg.sinks.clear();
+  }
+  reg.asyncWriter.drain();
+  return reportFailures(reg.asyncWriter);
+}
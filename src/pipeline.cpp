@@ -0,0 +1,318 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#include <algorithm>
+#include <iostream>
+
+#include <bond.hpp>
+#include <bop.hpp>
+#include <domain.hpp>
+#include <frame_cache.hpp>
+#include <franzblau.hpp>
+#include <frame_source.hpp>
+#include <neighbours.hpp>
+#include <pipeline.hpp>
+#include <profiling.hpp>
+#include <seams_binary.hpp>
+#include <seams_output.hpp>
+#include <topo_bulk.hpp>
+#include <topo_one_dim.hpp>
+#include <topo_two_dim.hpp>
+
+namespace {
+
+// Adds product to order after everything it depends on (a depth-first
+// topological sort of the product graph)
+void scheduleProduct(spipe::Product product,
+                     std::vector<spipe::Product> *order) {
+  if (std::find(order->begin(), order->end(), product) != order->end()) {
+    return;
+  } // already scheduled
+  for (auto dependency : spipe::dependencies(product)) {
+    scheduleProduct(dependency, order);
+  }
+  order->push_back(product);
+}
+
+// Computes one product of the current frame. The frame itself (and the
+// hydrogen atoms) are read by the frame loop in spipe::Pipeline::run. Only
+// the rings of ringSizes are searched for, unless it is empty
+void computeProduct(spipe::Product product, const spipe::Settings &settings,
+                    const std::vector<int> &ringSizes,
+                    spipe::FrameData &data) {
+  switch (product) {
+  case spipe::Product::neighbours:
+    data.nList = scache::neighListO(settings.cutoffRadius, &data.cloud,
+                                    settings.oxygenType);
+    break;
+  case spipe::Product::hbonds:
+    data.hbnList = bond::populateHbondsWithInputClouds(
+        &data.cloud, &data.hCloud, data.nList);
+    data.hbnList = nneigh::neighbourListByIndex(&data.cloud, data.hbnList);
+    break;
+  case spipe::Product::rings:
+    if (!ringSizes.empty()) {
+      data.rings = ring::RingsBySize(
+          primitive::ringNetworkOfSizes(data.hbnList, ringSizes));
+    } else if (scache::isEnabled()) {
+      data.rings = ring::RingsBySize(
+          scache::ringNetwork(data.hbnList, settings.maxDepth));
+    } else {
+      data.rings =
+          primitive::ringNetworkBySize(data.hbnList, settings.maxDepth);
+    } // rings from the cache, if there is one
+    break;
+  case spipe::Product::bop:
+    chill::getCorrelPlus(&data.cloud, data.nList, settings.isSlice);
+    break;
+  default:
+    break;
+  } // end of switch
+}
+
+} // namespace
+
+/**
+ * @details Returns the name of a product, as used in messages.
+ * @param[in] product The product
+ */
+const char *spipe::productName(spipe::Product product) {
+  switch (product) {
+  case spipe::Product::frame:
+    return "frame";
+  case spipe::Product::hydrogens:
+    return "hydrogens";
+  case spipe::Product::neighbours:
+    return "neighbours";
+  case spipe::Product::hbonds:
+    return "hbonds";
+  case spipe::Product::rings:
+    return "rings";
+  case spipe::Product::bop:
+    return "bop";
+  }
+  return "unknown";
+}
+
+/**
+ * @details Returns the products which have to be computed (for the same
+ * frame) before a product can be computed. These are the edges of the
+ * dependency graph of the products.
+ * @param[in] product The product
+ */
+std::vector<spipe::Product> spipe::dependencies(spipe::Product product) {
+  switch (product) {
+  case spipe::Product::neighbours:
+    return {spipe::Product::frame};
+  case spipe::Product::hbonds:
+    return {spipe::Product::neighbours, spipe::Product::hydrogens};
+  case spipe::Product::rings:
+    return {spipe::Product::hbonds};
+  case spipe::Product::bop:
+    return {spipe::Product::neighbours};
+  default:
+    return {};
+  }
+}
+
+/**
+ * @details Adds an analysis to the pipeline. The analyses are run on every
+ * frame in the order in which they were added.
+ * @param[in] analysis The analysis
+ */
+void spipe::Pipeline::add(spipe::Analysis analysis) {
+  analyses.push_back(std::move(analysis));
+}
+
+/**
+ * @details Collects the products needed by the analyses, together with the
+ * products these depend on, and orders them so that every product comes after
+ * its dependencies. Each product appears only once, however many analyses
+ * need it.
+ */
+std::vector<spipe::Product> spipe::Pipeline::schedule() const {
+  std::vector<spipe::Product> order;
+  // Every frame has to be read
+  scheduleProduct(spipe::Product::frame, &order);
+  for (auto &analysis : analyses) {
+    for (auto product : analysis.needs) {
+      scheduleProduct(product, &order);
+    }
+  } // end of loop through the analyses
+  return order;
+}
+
+/**
+ * @details Collects the ring sizes read by the analyses which need rings,
+ * leaving out sizes larger than maxDepth. If any of them reads rings of every
+ * size, the result is empty, and every ring up to maxDepth is searched for.
+ * This is also the case while a binary trajectory is open, since the rings of
+ * every size are recorded into it.
+ */
+std::vector<int> spipe::Pipeline::ringSizes() const {
+  if (sbin::isEnabled()) {
+    return {};
+  } // every ring is recorded
+  std::vector<int> sizes;
+  for (auto &analysis : analyses) {
+    if (std::find(analysis.needs.begin(), analysis.needs.end(),
+                  spipe::Product::rings) == analysis.needs.end()) {
+      continue;
+    } // no rings
+    if (analysis.ringSizes.empty()) {
+      return {};
+    } // every ring size
+    for (int ringSize : analysis.ringSizes) {
+      if (ringSize <= settings.maxDepth) {
+        sizes.push_back(ringSize);
+      }
+    }
+  } // end of loop through the analyses
+  std::sort(sizes.begin(), sizes.end());
+  sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+  return sizes;
+}
+
+/**
+ * @details Reads the frames (firstFrame to finalFrame, every frameGap frames)
+ * ahead of time with sinp::FrameSource, the hydrogen atoms only if some
+ * product needs them (from the same read of the frame as the oxygen atoms).
+ * For every frame, the scheduled products are computed once, and then every
+ * analysis is run on them.
+ */
+int spipe::Pipeline::run() {
+  //
+  if (analyses.empty()) {
+    std::cerr << "There are no analyses in the pipeline.\n";
+    return 1;
+  } // nothing to do
+  std::vector<spipe::Product> order = schedule();
+  std::vector<int> sizes = ringSizes();
+  bool needHydrogens = std::find(order.begin(), order.end(),
+                                 spipe::Product::hydrogens) != order.end();
+  // The frames of the loop. If the H atoms are needed, every frame is read
+  // once, and the O and H atoms are both copied out of it
+  sinp::FrameSource frames(
+      settings.trajectory, settings.firstFrame, settings.finalFrame,
+      settings.frameGap,
+      needHydrogens ? sinp::FrameReader::twoTypes : sinp::FrameReader::reduced,
+      settings.oxygenType, settings.isSlice, settings.sliceLow,
+      settings.sliceHigh, settings.prefetchDepth, settings.prefetchThreads,
+      settings.hydrogenType);
+  spipe::FrameData data;
+  //
+  // Loop through the frames
+  while (frames.nextFrame(&data.cloud, &data.hCloud)) {
+    sprof::StageTimer timer("pipeline");
+    sprof::count("pipeline", 1);
+    // Shared products, in dependency order (subdomain by subdomain, if the
+    // frames are split into subdomains)
+    if (sdom::isDecomposed(settings)) {
+      if (sdom::computeProducts(settings, order, sizes, data) != 0) {
+        return 1;
+      }
+    } else {
+      for (auto product : order) {
+        computeProduct(product, settings, sizes, data);
+      }
+    } // end of products
+    // Every analysis, on the same products
+    for (auto &analysis : analyses) {
+      if (analysis.run(settings, data) != 0) {
+        std::cerr << "The " << analysis.name
+                  << " analysis failed for frame " << data.cloud.currentFrame
+                  << ".\n";
+        return 1;
+      } // error
+    } // end of loop through the analyses
+  } // end of loop through the frames
+
+  return 0;
+}
+
+/**
+ * @details Ring analysis for quasi-two-dimensional ice, on the rings of the
+ * hydrogen-bond network (like ringAnalysis in the Lua scripts).
+ * @param[in] sheetArea Area of the confining sheet (confiningSheetArea)
+ */
+spipe::Analysis spipe::topoTwoDimAnalysis(double sheetArea) {
+  return {"topoTwoDim",
+          {spipe::Product::rings},
+          [sheetArea](const spipe::Settings &settings, spipe::FrameData &data) {
+            return ring::polygonRingAnalysis(
+                settings.outDir, data.rings, data.hbnList, &data.cloud,
+                settings.maxDepth, sheetArea, settings.firstFrame);
+          },
+          {}};
+}
+
+/**
+ * @details Prism analysis for quasi-one-dimensional ice, on the rings of the
+ * hydrogen-bond network (like prismAnalysis in the Lua scripts, without
+ * shape-matching). The atom ID of the first atom (lowestAtomID) is kept
+ * across frames by the analysis.
+ */
+spipe::Analysis spipe::topoOneDimAnalysis() {
+  return {"topoOneDim",
+          {spipe::Product::rings},
+          [atomID = 0](const spipe::Settings &settings,
+                       spipe::FrameData &data) mutable {
+            return ring::prismAnalysis(settings.outDir, data.rings,
+                                       data.hbnList, &data.cloud,
+                                       settings.maxDepth, &atomID,
+                                       settings.firstFrame,
+                                       data.cloud.currentFrame, false);
+          },
+          {}};
+}
+
+/**
+ * @details Finds the DDCs and HCs of bulk ice, on the rings of the
+ * hydrogen-bond network (like bulkTopologicalNetworkCriterion in the Lua
+ * scripts, with onlyTetrahedral set). Only the hexagonal rings are read, so
+ * no other rings are searched for unless another analysis needs them (or a
+ * binary trajectory records them).
+ */
+spipe::Analysis spipe::topoBulkAnalysis() {
+  return {"bulk",
+          {spipe::Product::rings},
+          [](const spipe::Settings &settings, spipe::FrameData &data) {
+            return ring::topoBulkAnalysis(settings.outDir, data.rings,
+                                          data.hbnList, &data.cloud,
+                                          settings.firstFrame, true);
+          },
+          {6}};
+}
+
+/**
+ * @details Classifies every atom according to the CHILL+ algorithm (like
+ * chillPlus_iceType in the Lua scripts), and writes the classified frame out
+ * as a dump file.
+ * @param[in] outputFileName File for the number of atoms of each ice type
+ * @param[in] dumpName Dump file for the classified atoms
+ */
+spipe::Analysis spipe::chillPlusAnalysis(std::string outputFileName,
+                                         std::string dumpName) {
+  return {"bondOrderParameters",
+          {spipe::Product::bop},
+          [outputFileName, dumpName](const spipe::Settings &settings,
+                                     spipe::FrameData &data) {
+            chill::getIceTypePlus(&data.cloud, data.nList, settings.outDir,
+                                  settings.firstFrame, settings.isSlice,
+                                  outputFileName);
+            return sout::writeDump(&data.cloud, settings.outDir, dumpName);
+          },
+          {}};
+}
@@ -201,13 +201,13 @@ double pntToPnt::getAvgHeightPrismBlock(
  * @details Get the relative ordering of a pair of basal rings for a deformed
  * prism/perfect prism. Outputs a vector of vectors of indices, such that the
  * first vector is for the first basal ring, and the second vector is for the
- * second basal ring. The input neighbour list is with respect to indices, not
+ * second basal ring. The bonds are those of the neighbour list by index, not
  * IDs
  */
 int pntToPnt::relOrderPrismBlock(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<int> basal1, std::vector<int> basal2,
-    std::vector<std::vector<int>> nList, std::vector<int> *outBasal1,
+    const nneigh::Adjacency &bonded, std::vector<int> *outBasal1,
     std::vector<int> *outBasal2) {
   //
   int ringSize = basal1.size(); // Number of nodes in basal1 and basal2
@@ -232,10 +232,8 @@ int pntToPnt::relOrderPrismBlock(
       m_k = basal2[m]; // Atom index to find in the neighbour list of iatom
 
       // Find m_k inside l_k neighbour list
-      auto it = std::find(nList[l_k].begin() + 1, nList[l_k].end(), m_k);
-
       // If the element has been found, for l1
-      if (it != nList[l_k].end()) {
+      if (bonded.areBonded(l_k, m_k)) {
         isNeighbour = true;
         iatom = l; // index of basal1
         jatom = m; // index of basal2
@@ -609,7 +607,7 @@ Eigen::MatrixXd pntToPnt::getPointSetCage(ring::strucType type) {
 int pntToPnt::relOrderHC(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<int> basal1, std::vector<int> basal2,
-    std::vector<std::vector<int>> nList, std::vector<int> *matchedBasal1,
+    const nneigh::Adjacency &bonded, std::vector<int> *matchedBasal1,
     std::vector<int> *matchedBasal2) {
   //
   int l1 = basal1[0];           // First element of basal1
@@ -634,9 +632,8 @@ int pntToPnt::relOrderHC(
   for (int i = 0; i < ringSize; i++) {
     iatom = basal2[i]; // Element of basal2
     // Search for the current element in the neighbour list of l1
-    auto it = std::find(nList[l1].begin() + 1, nList[l1].end(), iatom);
     // If iatom is the neighbour of l1
-    if (it != nList[l1].end()) {
+    if (bonded.areBonded(l1, iatom)) {
       neighbourFound = true;
       neighOne = true;
       m_k = iatom;  // Element found
@@ -646,9 +643,8 @@ int pntToPnt::relOrderHC(
     } // iatom is the neighbour of l1
     // l2 neighbour check
     else {
-      auto it1 = std::find(nList[l2].begin() + 1, nList[l2].end(), iatom);
       // If iatom is the neighbour of l2
-      if (it1 != nList[l2].end()) {
+      if (bonded.areBonded(l2, iatom)) {
         neighbourFound = true;
         neighOne = false;
         neighTwo = true;
@@ -680,10 +676,8 @@ int pntToPnt::relOrderHC(
   } // wrap-around
   nextBasal2Element = basal2[index];
   // Search for the next basal element
-  auto it = std::find(nList[nextBasal1Element].begin() + 1,
-                      nList[nextBasal1Element].end(), nextBasal2Element);
   // If this element is found, then the original order is correct
-  if (it != nList[nextBasal1Element].end()) {
+  if (bonded.areBonded(nextBasal1Element, nextBasal2Element)) {
     // Fill up the temporary vector with basal2 elements
     for (int i = 0; i < ringSize; i++) {
       index = m_kIndex + i; // index in basal2
@@ -703,10 +697,8 @@ int pntToPnt::relOrderHC(
     } // wrap-around
     nextBasal2Element = basal2[index];
     // Search for the next basal element
-    auto it = std::find(nList[nextBasal1Element].begin() + 1,
-                        nList[nextBasal1Element].end(), nextBasal2Element);
     // If this element is found, then the original order is correct
-    if (it != nList[nextBasal1Element].end()) {
+    if (bonded.areBonded(nextBasal1Element, nextBasal2Element)) {
       // Fill up the temporary vector with basal2 elements
       for (int i = 0; i < ringSize; i++) {
         index = m_kIndex - i; // index in basal2
@@ -842,9 +834,9 @@ Eigen::MatrixXd pntToPnt::changeHexCageOrder(
  * 4. The next three elements should be wrapped around (multiples of 2), since
  * alternate elements of the equatorial ring are bonded.
  */
-std::vector<int> pntToPnt::relOrderDDC(int index,
-                                       std::vector<std::vector<int>> rings,
-                                       std::vector<cage::Cage> cageList) {
+std::vector<int>
+pntToPnt::relOrderDDC(int index, const std::vector<std::vector<int>> &rings,
+                      const std::vector<cage::Cage> &cageList) {
   //
   std::vector<int> ddcOrder; // Order of the particles in the DDC.
   int nop = 14;              // Number of elements in the DDC
@@ -1087,7 +1079,7 @@ Eigen::MatrixXd pntToPnt::changeDiaCageOrder(
     for (int i = 6; i < 9; i++) {
       currentIndex = i + peripheralStartingIndex;
       // wrap-around
-      if (currentIndex <= 9) {
+      if (currentIndex >= 9) {
         currentIndex -= 3;
       } // end of wrap-around
       wrappedDDC[i] = ddcOrder[currentIndex];
@@ -1097,7 +1089,7 @@ Eigen::MatrixXd pntToPnt::changeDiaCageOrder(
     for (int i = 10; i < 13; i++) {
       currentIndex = i + peripheralStartingIndex;
       // wrap-around
-      if (currentIndex <= 13) {
+      if (currentIndex >= 13) {
         currentIndex -= 3;
       } // end of wrap-around
       wrappedDDC[i] = ddcOrder[currentIndex];
@@ -0,0 +1,169 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#include <profiling.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+
+#include <fmt/format.h>
+
+namespace {
+
+/**
+ * @details Totals of every stage, guarded by a mutex since output is written
+ * from more than one thread.
+ */
+struct ProfileRegistry {
+  std::atomic<bool> enabled{false};
+  std::map<std::string, sprof::StageStats> stages;
+  std::mutex mtx;
+};
+
+ProfileRegistry &registry() {
+  static ProfileRegistry reg;
+  return reg;
+}
+
+} // namespace
+
+/**
+ * @details Starts the clock, if profiling is switched on.
+ */
+sprof::StageTimer::StageTimer(const char *stage)
+    : name(stage), active(sprof::isEnabled()) {
+  if (active) {
+    start = std::chrono::steady_clock::now();
+  }
+}
+
+/**
+ * @details Adds the elapsed time to the stage.
+ */
+sprof::StageTimer::~StageTimer() {
+  if (!active) {
+    return;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  sprof::addTime(name, elapsed.count());
+}
+
+/**
+ * @details Switches the timers and counters on or off. Totals recorded so far
+ * are kept.
+ */
+void sprof::enable(bool on) {
+  registry().enabled.store(on, std::memory_order_relaxed);
+}
+
+/**
+ * @details Checked by every timer and counter before recording anything.
+ */
+bool sprof::isEnabled() {
+  return registry().enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @details Adds nItems to the item count of a stage (for instance the number
+ * of atoms read, or of rings found).
+ */
+void sprof::count(const char *stage, std::uint64_t nItems) {
+  if (!sprof::isEnabled()) {
+    return;
+  }
+  ProfileRegistry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  reg.stages[stage].items += nItems;
+}
+
+/**
+ * @details Records one call of a stage, which took the given time.
+ */
+void sprof::addTime(const char *stage, double seconds) {
+  if (!sprof::isEnabled()) {
+    return;
+  }
+  ProfileRegistry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  sprof::StageStats &stats = reg.stages[stage];
+  stats.calls++;
+  stats.seconds += seconds;
+}
+
+/**
+ * @details Removes every stage.
+ */
+void sprof::reset() {
+  ProfileRegistry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  reg.stages.clear();
+}
+
+/**
+ * @details Copies the totals, so that they can be read without holding the
+ * lock.
+ */
+std::map<std::string, sprof::StageStats> sprof::snapshot() {
+  ProfileRegistry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  return reg.stages;
+}
+
+/**
+ * @details Prints the calls, total and mean time, and items processed of every
+ * stage. Nothing is printed if no stage was recorded.
+ */
+void sprof::printReport(std::ostream &out) {
+  std::map<std::string, sprof::StageStats> stages = sprof::snapshot();
+  if (stages.empty()) {
+    return;
+  }
+  out << fmt::format("\n{:<24} {:>8} {:>12} {:>12} {:>12}\n", "Stage",
+                     "Calls", "Total (s)", "Mean (ms)", "Items");
+  for (auto &stage : stages) {
+    const sprof::StageStats &stats = stage.second;
+    double mean =
+        stats.calls > 0 ? 1000.0 * stats.seconds / stats.calls : 0.0;
+    out << fmt::format("{:<24} {:>8} {:>12.4f} {:>12.4f} {:>12}\n", stage.first,
+                       stats.calls, stats.seconds, mean, stats.items);
+  } // end of loop through stages
+}
+
+/**
+ * @details Writes a JSON object with one entry per stage, e.g.
+ * {"stages": [{"name": "rings", "calls": 1, "seconds": 0.5, "items": 10}]}
+ */
+int sprof::writeJSON(std::string fileName) {
+  std::map<std::string, sprof::StageStats> stages = sprof::snapshot();
+  std::ofstream outputFile(fileName);
+  if (!outputFile.is_open()) {
+    std::cerr << "Could not open " << fileName << " for writing.\n";
+    return 1;
+  }
+  outputFile << "{\n  \"stages\": [";
+  bool first = true;
+  for (auto &stage : stages) {
+    const sprof::StageStats &stats = stage.second;
+    outputFile << fmt::format(
+        "{}\n    {{\"name\": \"{}\", \"calls\": {}, \"seconds\": {:.6f}, "
+        "\"items\": {}}}",
+        first ? "" : ",", stage.first, stats.calls, stats.seconds,
+        stats.items);
+    first = false;
+  } // end of loop through stages
+  outputFile << "\n  ]\n}\n";
+  return 0;
+}
@@ -14,6 +14,33 @@
 
 #include <rdf2d.hpp>
 
+namespace {
+
+// Bins the distance between every pair of atoms within the cutoff. Distances
+// are computed in the precision of the packed coordinates, while the counts
+// are kept as integers
+template <typename T>
+void sampleHistogram(const molSys::Coordinates<T> &coords, double cutoff,
+                     double binwidth, std::vector<int> &histogram) {
+  int nop = coords.x.size();
+  T rcutoff = static_cast<T>(cutoff);
+  T width = static_cast<T>(binwidth);
+  std::vector<T> dist(nop); // Distances from iatom
+
+  for (int iatom = 0; iatom < nop - 1; iatom++) {
+    gen::periodicDistances(coords, iatom, iatom + 1, dist);
+    for (int jatom = iatom + 1; jatom < nop; jatom++) {
+      // Update the histogram if r_ij is within the cutoff
+      if (dist[jatom] <= rcutoff) {
+        int ibin = int(dist[jatom] / width); // Bin in which r_ij falls
+        histogram[ibin] += 2; // Update for iatom and jatom both
+      } // end of histogram update
+    }   // end of loop through jatom
+  }     // end of loop through iatom
+}
+
+} // namespace
+
 // -----------------------------------------------------------------------------------------------------
 // IN-PLANE RDF
 // -----------------------------------------------------------------------------------------------------
@@ -86,10 +113,7 @@ int rdf2::rdf2Danalysis_AA(
     std::string fileName = path + "topoMonolayer/rdf.dat";
     //
     // Comment line
-    std::ofstream outputFile; // For the output file
-    outputFile.open(fileName, std::ios_base::app | std::ios_base::out);
-    outputFile << "# r  g(r)\n";
-    outputFile.close();
+    sout::appendSink(fileName).print("# r  g(r)\n");
     //
     //
     sout::printRDF(fileName, rdfValues, binwidth, nbin);
@@ -103,7 +127,8 @@ int rdf2::rdf2Danalysis_AA(
  * @details Samples the RDF for a particular frame
  *  The input PointCloud only has particles
  *  of type A in it.
- *  - gen::periodicDist (Periodic distance between a pair of atoms).
+ *  - gen::periodicDistances (Periodic distances from one atom, in the
+ *  precision set with molSys::setPrecision).
  * @param[in] yCloud The input PointCloud.
  * @param[in] cutoff Cutoff for the RDF calculation, which should be less than
  *  or equal to half the box length.
@@ -116,27 +141,15 @@ rdf2::sampleRDF_AA(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                    double cutoff, double binwidth, int nbin) {
   //
   std::vector<int> histogram; // Histogram for the RDF
-  double r_ij;                // Unwrapped distance between iatom and jatom
-  int ibin; // Index of the bin in which the distance r_ij falls
 
   // Init the histogram to 0
   histogram.resize(nbin);
 
-  // Loop through pairs of atoms
-  for (int iatom = 0; iatom < yCloud->nop - 1; iatom++) {
-    //
-    // Loop through the next atom in the atom pair
-    for (int jatom = iatom + 1; jatom < yCloud->nop; jatom++) {
-      // Calculate the distance between iatom and jatom
-      r_ij = gen::periodicDist(yCloud, iatom, jatom);
-      // Check if the distance is within the cutoff. Update the histogram if
-      // r_ij is within the cutoff
-      if (r_ij <= cutoff) {
-        ibin = int(r_ij / binwidth); // Bin in which r_ij falls
-        histogram[ibin] += 2;        // Update for iatom and jatom both
-      }                              // end of histogram update
-    }                                // end of loop through jatom
-  }                                  // end of loop through iatom
+  // Loop through pairs of atoms, with the coordinates in the precision set
+  // with molSys::setPrecision
+  molSys::withCoordinates(yCloud, [&](const auto &coords) {
+    sampleHistogram(coords, cutoff, binwidth, histogram);
+  });
 
   // Return the histogram
   return histogram;
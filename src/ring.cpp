@@ -37,7 +37,7 @@ int ring::clearRingList(std::vector<std::vector<int>> &rings) {
  *  depending on it's type as classified by the prism identification scheme.
  * @param[in] nRings Number of rings.
  */
-int ring::assignPolygonType(std::vector<std::vector<int>> rings,
+int ring::assignPolygonType(const std::vector<std::vector<int>> &rings,
                             std::vector<int> *atomTypes,
                             std::vector<int> nRings) {
   // Every value in listPrism corresponds to an index in rings.
@@ -265,3 +265,183 @@ bool ring::compareRings(std::vector<int> ring1, std::vector<int> ring2) {
 
   return result;
 }
+
+/**
+ * @details Builds the per-frame spatial index over ring centroids. For each
+ * ring, the members are unwrapped (minimum image) with respect to the first
+ * member, which gives the centroid and the radius. The centroids are wrapped
+ * back into the box and binned into cells, stored in compressed form (cellOffsets and
+ * cellRings). Each cell is at least pairCutoff + 2*maxRadius long, so that
+ * every ring which can have a member within pairCutoff of a member of another
+ * ring lies in the same or a neighbouring cell.
+ * @param[in] rings The rings (by atom index).
+ * @param[in] yCloud The input PointCloud.
+ * @param[in] pairCutoff The largest member separation which will be queried.
+ * @return The spatial index.
+ */
+ring::RingSpatialIndex ring::buildRingSpatialIndex(
+    const std::vector<std::vector<int>> &rings,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    double pairCutoff) {
+  ring::RingSpatialIndex index;
+  int nRings = rings.size();
+  index.pairCutoff = pairCutoff;
+  for (int k = 0; k < 3; k++) {
+    index.boxLength[k] = k < yCloud->box.size() ? yCloud->box[k] : 0.0;
+    index.boxLow[k] = k < yCloud->boxLow.size() ? yCloud->boxLow[k] : 0.0;
+  }
+  // Minimum-image displacement along one dimension
+  auto minImage = [&index](double dr, int k) {
+    double length = index.boxLength[k];
+    if (length > 0) {
+      dr -= length * std::round(dr / length);
+    }
+    return dr;
+  };
+  index.centroids.resize(nRings);
+  index.radii.resize(nRings);
+  std::vector<std::array<double, 3>> unwrapped;
+  // ----------------
+  // Geometry of every ring
+  for (int iring = 0; iring < nRings; iring++) {
+    const std::vector<int> &members = rings[iring];
+    int ringSize = members.size();
+    unwrapped.resize(ringSize);
+    const molSys::Point<double> &first = yCloud->pts[members[0]];
+    std::array<double, 3> centroid = {0.0, 0.0, 0.0};
+    for (int m = 0; m < ringSize; m++) {
+      const molSys::Point<double> &pnt = yCloud->pts[members[m]];
+      unwrapped[m] = {first.x + minImage(pnt.x - first.x, 0),
+                      first.y + minImage(pnt.y - first.y, 1),
+                      first.z + minImage(pnt.z - first.z, 2)};
+      for (int k = 0; k < 3; k++) {
+        centroid[k] += unwrapped[m][k] / ringSize;
+      }
+    } // end of loop through ring members
+    // Radius
+    double radius = 0.0;
+    for (int m = 0; m < ringSize; m++) {
+      double r2 = 0.0;
+      for (int k = 0; k < 3; k++) {
+        r2 += (unwrapped[m][k] - centroid[k]) * (unwrapped[m][k] - centroid[k]);
+      }
+      radius = std::max(radius, std::sqrt(r2));
+    } // end of loop through ring members
+    // Wrap the centroid back into the box
+    for (int k = 0; k < 3; k++) {
+      if (index.boxLength[k] > 0) {
+        centroid[k] = index.boxLow[k] +
+                      std::fmod(centroid[k] - index.boxLow[k], index.boxLength[k]);
+        if (centroid[k] < index.boxLow[k]) {
+          centroid[k] += index.boxLength[k];
+        }
+      }
+    }
+    index.centroids[iring] = centroid;
+    index.radii[iring] = radius;
+    index.maxRadius = std::max(index.maxRadius, radius);
+  } // end of loop through rings
+  // ----------------
+  // Bin the centroids into cells
+  double reach = pairCutoff + 2.0 * index.maxRadius;
+  int totalCells = 1;
+  for (int k = 0; k < 3; k++) {
+    index.nCells[k] = 1;
+    if (reach > 0 && index.boxLength[k] > reach) {
+      index.nCells[k] = static_cast<int>(index.boxLength[k] / reach);
+    }
+    index.cellLength[k] = index.boxLength[k] > 0
+                              ? index.boxLength[k] / index.nCells[k]
+                              : 1.0;
+    totalCells *= index.nCells[k];
+  }
+  std::vector<int> ringCell(nRings);
+  index.cellOffsets.assign(totalCells + 1, 0);
+  for (int iring = 0; iring < nRings; iring++) {
+    int cell = 0;
+    for (int k = 0; k < 3; k++) {
+      int c = static_cast<int>((index.centroids[iring][k] - index.boxLow[k]) /
+                               index.cellLength[k]);
+      c = std::min(std::max(c, 0), index.nCells[k] - 1);
+      cell = cell * index.nCells[k] + c;
+    }
+    ringCell[iring] = cell;
+    index.cellOffsets[cell + 1]++;
+  } // end of loop through rings
+  for (int c = 0; c < totalCells; c++) {
+    index.cellOffsets[c + 1] += index.cellOffsets[c];
+  }
+  index.cellRings.resize(nRings);
+  std::vector<int> fill(index.cellOffsets.begin(), index.cellOffsets.end() - 1);
+  for (int iring = 0; iring < nRings; iring++) {
+    index.cellRings[fill[ringCell[iring]]++] = iring;
+  }
+
+  return index;
+}
+
+/**
+ * @details Returns the rings, with a greater index than iring, whose centroid
+ * is within pairCutoff + radius(iring) + radius(jring) of the centroid of
+ * iring (minimum image). Every ring with a member within pairCutoff of a member
+ * of iring is included. The indices are sorted, so that pairs are visited in
+ * the same order as a loop over all jring > iring.
+ * @param[in] index The spatial index of the rings.
+ * @param[in] iring The index of the ring.
+ * @return The candidate rings, in ascending order.
+ */
+std::vector<int> ring::nearbyRings(const ring::RingSpatialIndex &index,
+                                   int iring) {
+  std::vector<int> candidates;
+  const std::array<double, 3> &ci = index.centroids[iring];
+  // Cells to search in each dimension: the neighbouring ones, or all of them
+  // if there are fewer than three
+  std::array<std::vector<int>, 3> cellsToSearch;
+  for (int k = 0; k < 3; k++) {
+    int n = index.nCells[k];
+    if (n < 3) {
+      for (int c = 0; c < n; c++) {
+        cellsToSearch[k].push_back(c);
+      }
+    } else {
+      int c = static_cast<int>((ci[k] - index.boxLow[k]) / index.cellLength[k]);
+      c = std::min(std::max(c, 0), n - 1);
+      for (int dc = -1; dc <= 1; dc++) {
+        cellsToSearch[k].push_back((c + dc + n) % n);
+      }
+    }
+  } // end of finding the cells to search
+  // ----------------
+  for (int cx : cellsToSearch[0]) {
+    for (int cy : cellsToSearch[1]) {
+      for (int cz : cellsToSearch[2]) {
+        int cell = (cx * index.nCells[1] + cy) * index.nCells[2] + cz;
+        for (int p = index.cellOffsets[cell]; p < index.cellOffsets[cell + 1];
+             p++) {
+          int jring = index.cellRings[p];
+          if (jring <= iring) {
+            continue;
+          }
+          const std::array<double, 3> &cj = index.centroids[jring];
+          double r2 = 0.0;
+          for (int k = 0; k < 3; k++) {
+            double dr = cj[k] - ci[k];
+            if (index.boxLength[k] > 0) {
+              dr -= index.boxLength[k] * std::round(dr / index.boxLength[k]);
+            }
+            r2 += dr * dr;
+          }
+          double reach =
+              index.pairCutoff + index.radii[iring] + index.radii[jring];
+          // Small tolerance for round-off in the centroids
+          if (r2 <= reach * reach + 1e-8) {
+            candidates.push_back(jring);
+          }
+        } // end of loop through rings in the cell
+      }
+    }
+  } // end of loop through cells
+  std::sort(candidates.begin(), candidates.end());
+
+  return candidates;
+}
@@ -0,0 +1,106 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+#include <ring_set.hpp>
+
+namespace {
+
+// Returned for ring sizes without a bucket
+const std::vector<std::vector<int>> noRings;
+const std::vector<int> noIDs;
+
+} // namespace
+
+/**
+ * @details Sorts the rings into buckets by their size. The global IDs are
+ * the indices in rings.
+ * @param[in] rings The primitive rings, of all sizes.
+ */
+ring::RingsBySize::RingsBySize(const std::vector<std::vector<int>> &rings) {
+  location.reserve(rings.size());
+  for (auto &iring : rings) {
+    add(iring);
+  } // end of loop through the rings
+}
+
+/**
+ * @details Appends a ring to the bucket of its size, creating the bucket if
+ * needed.
+ * @param[in] ring The atom indices of the ring members.
+ */
+void ring::RingsBySize::add(std::vector<int> ring) {
+  int ringSize = ring.size();
+  if (ringSize >= buckets.size()) {
+    buckets.resize(ringSize + 1);
+    ids.resize(ringSize + 1);
+  }
+  location.emplace_back(ringSize, buckets[ringSize].size());
+  ids[ringSize].push_back(location.size() - 1);
+  buckets[ringSize].push_back(std::move(ring));
+}
+
+/**
+ * @details Removes every ring, keeping the buckets, so that the set can be
+ * refilled for the next frame.
+ */
+void ring::RingsBySize::clear() {
+  for (auto &bucket : buckets) {
+    bucket.clear();
+  }
+  for (auto &bucketIDs : ids) {
+    bucketIDs.clear();
+  }
+  location.clear();
+}
+
+/**
+ * @details Returns the bucket of rings of one size. The vector is owned by
+ * the set and is not copied.
+ * @param[in] ringSize The number of members of the rings.
+ * @return The rings with ringSize members, in the order in which they were
+ * added.
+ */
+const std::vector<std::vector<int>> &
+ring::RingsBySize::ofSize(int ringSize) const {
+  if (ringSize < 0 || ringSize >= buckets.size()) {
+    return noRings;
+  }
+  return buckets[ringSize];
+}
+
+/**
+ * @details Returns the global IDs of the rings of one size.
+ * @param[in] ringSize The number of members of the rings.
+ * @return The global ID of every ring of ofSize(ringSize).
+ */
+const std::vector<int> &ring::RingsBySize::idsOfSize(int ringSize) const {
+  if (ringSize < 0 || ringSize >= ids.size()) {
+    return noIDs;
+  }
+  return ids[ringSize];
+}
+
+/**
+ * @details Rebuilds the full list of rings, ordered by global ID.
+ * @return A vector of vectors of all the rings.
+ */
+std::vector<std::vector<int>> ring::RingsBySize::toVector() const {
+  std::vector<std::vector<int>> rings;
+  rings.reserve(location.size());
+  for (int id = 0; id < location.size(); id++) {
+    rings.push_back(ring(id));
+  }
+  return rings;
+}
@@ -0,0 +1,585 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#include <seams_binary.hpp>
+#include <seams_output.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+//! Magic string at the start of a binary trajectory
+const char trajMagic[8] = {'D', 'S', 'E', 'A', 'M', 'S', 'B', 'T'};
+//! Magic string at the start of an index file
+const char indexMagic[8] = {'D', 'S', 'E', 'A', 'M', 'S', 'B', 'I'};
+//! Size of the file header of both the trajectory and the index
+const std::uint64_t fileHeaderBytes = 16;
+
+/**
+ * @details Number of bytes taken up by a column of n values of type T, padded
+ * to a multiple of 8 so that every column starts 8-byte aligned.
+ */
+template <typename T> std::uint64_t columnBytes(std::uint64_t n) {
+  return (n * sizeof(T) + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+/**
+ * @details Columns of the frame currently being filled in, along with the
+ * open trajectory. The frame is written out once results for another frame
+ * arrive, or when the trajectory is closed.
+ */
+struct BinaryTrajectory {
+  std::unique_ptr<sout::OutputSink> sink;
+  std::string fileName;
+  std::uint64_t bytesWritten = 0;
+  std::vector<sbin::IndexEntry> index;
+  bool hasPending = false;
+  sbin::FrameRecord pending;
+};
+
+BinaryTrajectory &trajectory() {
+  static BinaryTrajectory traj;
+  return traj;
+}
+
+/**
+ * @details Appends a column to the sink, followed by the zero padding needed
+ * to reach the next 8-byte boundary.
+ */
+template <typename T>
+void writeColumn(sout::OutputSink &sink, const std::vector<T> &column) {
+  static const char zeros[8] = {0};
+  std::uint64_t nBytes = column.size() * sizeof(T);
+  if (nBytes > 0) {
+    sink.write(column.data(), nBytes);
+  }
+  sink.write(zeros, columnBytes<T>(column.size()) - nBytes);
+}
+
+/**
+ * @details Reads a column of n values of type T (and its padding) from the
+ * stream.
+ */
+template <typename T>
+bool readColumn(std::ifstream &inpFile, std::uint64_t n,
+                std::vector<T> &column) {
+  column.resize(n);
+  if (n > 0) {
+    inpFile.read(reinterpret_cast<char *>(column.data()), n * sizeof(T));
+  }
+  inpFile.seekg(columnBytes<T>(n) - n * sizeof(T), std::ios::cur);
+  return static_cast<bool>(inpFile);
+}
+
+/**
+ * @details Writes the pending frame (if any) to the trajectory and notes its
+ * offset in the index.
+ */
+void commitPending(BinaryTrajectory &traj) {
+  if (!traj.hasPending) {
+    return;
+  }
+  sbin::FrameRecord &rec = traj.pending;
+  std::uint64_t nAtoms = rec.atomID.size();
+  std::uint64_t nRings =
+      rec.ringOffsets.empty() ? 0 : rec.ringOffsets.size() - 1;
+  // ----------------
+  // Header
+  sbin::FrameHeader header;
+  std::memcpy(header.tag, "FRME", 4);
+  header.frame = rec.frame;
+  header.nAtoms = nAtoms;
+  header.nRings = nRings;
+  header.nRingAtoms = rec.ringAtoms.size();
+  for (int k = 0; k < 3; k++) {
+    header.boxLow[k] = k < rec.boxLow.size() ? rec.boxLow[k] : 0.0;
+    header.box[k] = k < rec.box.size() ? rec.box[k] : 0.0;
+  }
+  header.chunkBytes = sizeof(sbin::FrameHeader) +
+                      4 * columnBytes<std::int32_t>(nAtoms) +
+                      columnBytes<std::uint8_t>(nAtoms) +
+                      4 * columnBytes<double>(nAtoms) +
+                      columnBytes<std::int32_t>(nAtoms) +
+                      columnBytes<std::uint64_t>(nRings + 1) +
+                      columnBytes<std::int32_t>(header.nRingAtoms);
+  // ----------------
+  // Columns, in the order documented in seams_binary.hpp
+  if (rec.ringOffsets.empty()) {
+    rec.ringOffsets.push_back(0);
+  }
+  sout::OutputSink &sink = *traj.sink;
+  sink.write(&header, sizeof(header));
+  writeColumn(sink, rec.atomID);
+  writeColumn(sink, rec.molID);
+  writeColumn(sink, rec.type);
+  writeColumn(sink, rec.atomClass);
+  writeColumn(sink, rec.iceType);
+  writeColumn(sink, rec.x);
+  writeColumn(sink, rec.y);
+  writeColumn(sink, rec.z);
+  writeColumn(sink, rec.rmsd);
+  writeColumn(sink, rec.clusterID);
+  writeColumn(sink, rec.ringOffsets);
+  writeColumn(sink, rec.ringAtoms);
+  // ----------------
+  traj.index.push_back({rec.frame, 0, traj.bytesWritten});
+  traj.bytesWritten += header.chunkBytes;
+  traj.hasPending = false;
+}
+
+/**
+ * @details Makes sure that the pending frame is the current frame of yCloud.
+ * If results for a new frame arrive, the previous frame is written out and the
+ * atoms of the new frame are recorded, with every analysis column unset.
+ */
+sbin::FrameRecord &
+currentRecord(BinaryTrajectory &traj,
+              molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  if (traj.hasPending && traj.pending.frame == yCloud->currentFrame &&
+      traj.pending.atomID.size() == yCloud->pts.size()) {
+    return traj.pending;
+  }
+  commitPending(traj);
+  sbin::FrameRecord &rec = traj.pending;
+  int nAtoms = yCloud->pts.size();
+  rec.frame = yCloud->currentFrame;
+  rec.boxLow = yCloud->boxLow;
+  rec.box = yCloud->box;
+  rec.atomID.resize(nAtoms);
+  rec.molID.resize(nAtoms);
+  rec.type.resize(nAtoms);
+  rec.iceType.resize(nAtoms);
+  rec.x.resize(nAtoms);
+  rec.y.resize(nAtoms);
+  rec.z.resize(nAtoms);
+  // The rows are in the order in which the atoms were read in
+  for (int k = 0; k < nAtoms; k++) {
+    int iatom = molSys::fileIndex(yCloud, k);
+    rec.atomID[k] = yCloud->pts[iatom].atomID;
+    rec.molID[k] = yCloud->pts[iatom].molID;
+    rec.type[k] = yCloud->pts[iatom].type;
+    rec.iceType[k] = static_cast<std::uint8_t>(yCloud->pts[iatom].iceType);
+    rec.x[k] = yCloud->pts[iatom].x;
+    rec.y[k] = yCloud->pts[iatom].y;
+    rec.z[k] = yCloud->pts[iatom].z;
+  } // end of loop through atoms
+  rec.atomClass.assign(nAtoms, -1);
+  rec.rmsd.assign(nAtoms, -1.0);
+  rec.clusterID.assign(nAtoms, -1);
+  rec.ringOffsets.assign(1, 0);
+  rec.ringAtoms.clear();
+  traj.hasPending = true;
+  return rec;
+}
+
+/**
+ * @details Scans the chunk headers of a trajectory to rebuild its index.
+ */
+std::vector<sbin::IndexEntry> scanTrajectory(std::ifstream &inpFile) {
+  std::vector<sbin::IndexEntry> index;
+  std::uint64_t offset = fileHeaderBytes;
+  sbin::FrameHeader header;
+  while (true) {
+    inpFile.seekg(offset);
+    if (!inpFile.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+      break;
+    }
+    if (std::memcmp(header.tag, "FRME", 4) != 0 || header.chunkBytes == 0) {
+      std::cerr << "Corrupt frame header in the binary trajectory.\n";
+      break;
+    }
+    index.push_back({header.frame, 0, offset});
+    offset += header.chunkBytes;
+  } // end of loop through chunks
+  return index;
+}
+
+/**
+ * @details Opens a binary trajectory for reading and checks its header.
+ */
+bool openForReading(std::string fileName, std::ifstream &inpFile) {
+  char magic[8];
+  std::uint32_t version[2];
+  inpFile.open(fileName, std::ios::binary);
+  if (!inpFile.is_open()) {
+    std::cerr << "Could not open the binary trajectory " << fileName << "\n";
+    return false;
+  }
+  inpFile.read(magic, 8);
+  inpFile.read(reinterpret_cast<char *>(version), sizeof(version));
+  if (!inpFile || std::memcmp(magic, trajMagic, 8) != 0) {
+    std::cerr << fileName << " is not a d-SEAMS binary trajectory.\n";
+    return false;
+  }
+  if (version[0] != sbin::formatVersion) {
+    std::cerr << "Unsupported binary trajectory version " << version[0]
+              << ".\n";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @details Reads the frame chunk starting at offset into record.
+ */
+bool readChunk(std::ifstream &inpFile, std::uint64_t offset,
+               sbin::FrameRecord *record) {
+  sbin::FrameHeader header;
+  inpFile.seekg(offset);
+  inpFile.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!inpFile || std::memcmp(header.tag, "FRME", 4) != 0) {
+    return false;
+  }
+  record->frame = header.frame;
+  record->boxLow.assign(header.boxLow, header.boxLow + 3);
+  record->box.assign(header.box, header.box + 3);
+  return readColumn(inpFile, header.nAtoms, record->atomID) &&
+         readColumn(inpFile, header.nAtoms, record->molID) &&
+         readColumn(inpFile, header.nAtoms, record->type) &&
+         readColumn(inpFile, header.nAtoms, record->atomClass) &&
+         readColumn(inpFile, header.nAtoms, record->iceType) &&
+         readColumn(inpFile, header.nAtoms, record->x) &&
+         readColumn(inpFile, header.nAtoms, record->y) &&
+         readColumn(inpFile, header.nAtoms, record->z) &&
+         readColumn(inpFile, header.nAtoms, record->rmsd) &&
+         readColumn(inpFile, header.nAtoms, record->clusterID) &&
+         readColumn(inpFile, header.nRings + 1, record->ringOffsets) &&
+         readColumn(inpFile, header.nRingAtoms, record->ringAtoms);
+}
+
+} // namespace
+
+/**
+ * @details Creates the binary trajectory, truncating any existing file. The
+ * results of each frame are buffered in memory and written out through a
+ * sout::OutputSink, so that the writer thread takes care of the disk I/O.
+ */
+int sbin::openTrajectory(std::string fileName) {
+  BinaryTrajectory &traj = trajectory();
+  if (traj.sink) {
+    sbin::closeTrajectory();
+  }
+  traj.sink = std::make_unique<sout::OutputSink>(fileName);
+  if (!traj.sink->isOpen()) {
+    traj.sink.reset();
+    return 1;
+  }
+  traj.fileName = fileName;
+  traj.index.clear();
+  traj.hasPending = false;
+  // ----------------
+  // File header
+  std::uint32_t version[2] = {sbin::formatVersion, 0};
+  traj.sink->write(trajMagic, 8);
+  traj.sink->write(version, sizeof(version));
+  traj.bytesWritten = fileHeaderBytes;
+  return 0;
+}
+
+/**
+ * @details Writes out the last frame, followed by the index file
+ * (fileName.idx), and waits until both are on disk.
+ */
+int sbin::closeTrajectory() {
+  BinaryTrajectory &traj = trajectory();
+  if (!traj.sink) {
+    return 0;
+  }
+  commitPending(traj);
+  traj.sink.reset();
+  // ----------------
+  // Index file
+  {
+    sout::OutputSink indexFile(traj.fileName + ".idx");
+    std::uint32_t version[2] = {sbin::formatVersion, 0};
+    indexFile.write(indexMagic, 8);
+    indexFile.write(version, sizeof(version));
+    if (!traj.index.empty()) {
+      indexFile.write(traj.index.data(),
+                      traj.index.size() * sizeof(sbin::IndexEntry));
+    }
+  }
+  sout::writer().drain();
+  traj.index.clear();
+  return 0;
+}
+
+/**
+ * @details Returns true while a binary trajectory is open.
+ */
+bool sbin::isEnabled() { return static_cast<bool>(trajectory().sink); }
+
+/**
+ * @details Records the atoms of the current frame. This is done automatically
+ * by the other record functions whenever a new frame starts; calling it again
+ * later in the frame updates the ice types, which may have been assigned in
+ * the meantime.
+ */
+int sbin::recordAtoms(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  BinaryTrajectory &traj = trajectory();
+  if (!traj.sink) {
+    return 1;
+  }
+  sbin::FrameRecord &rec = currentRecord(traj, yCloud);
+  for (int k = 0; k < yCloud->pts.size(); k++) {
+    int iatom = molSys::fileIndex(yCloud, k);
+    rec.iceType[k] = static_cast<std::uint8_t>(yCloud->pts[iatom].iceType);
+  } // end of loop through atoms
+  return 0;
+}
+
+/**
+ * @details Records the type assigned to each atom (by index) by one of the
+ * topological network criteria analyses.
+ */
+int sbin::recordAtomClass(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    std::vector<int> &atomClass) {
+  BinaryTrajectory &traj = trajectory();
+  if (!traj.sink) {
+    return 1;
+  }
+  sbin::FrameRecord &rec = currentRecord(traj, yCloud);
+  if (atomClass.size() != rec.atomClass.size()) {
+    std::cerr << "The atom types do not match the number of atoms.\n";
+    return 1;
+  }
+  for (int k = 0; k < atomClass.size(); k++) {
+    rec.atomClass[k] = atomClass[molSys::fileIndex(yCloud, k)];
+  } // end of loop through atoms
+  return 0;
+}
+
+/**
+ * @details Records the RMSD of each atom (by index) from shape-matching.
+ */
+int sbin::recordRMSD(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                     std::vector<double> &rmsdPerAtom) {
+  BinaryTrajectory &traj = trajectory();
+  if (!traj.sink) {
+    return 1;
+  }
+  sbin::FrameRecord &rec = currentRecord(traj, yCloud);
+  if (rmsdPerAtom.size() != rec.rmsd.size()) {
+    std::cerr << "The RMSD values do not match the number of atoms.\n";
+    return 1;
+  }
+  for (int k = 0; k < rmsdPerAtom.size(); k++) {
+    rec.rmsd[k] = rmsdPerAtom[molSys::fileIndex(yCloud, k)];
+  } // end of loop through atoms
+  return 0;
+}
+
+/**
+ * @details Records the ID of the cluster each atom (by index) belongs to, or
+ * -1 for atoms not in any cluster.
+ */
+int sbin::recordClusterIDs(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    std::vector<int> &clusterID) {
+  BinaryTrajectory &traj = trajectory();
+  if (!traj.sink) {
+    return 1;
+  }
+  sbin::FrameRecord &rec = currentRecord(traj, yCloud);
+  if (clusterID.size() != rec.clusterID.size()) {
+    std::cerr << "The cluster IDs do not match the number of atoms.\n";
+    return 1;
+  }
+  for (int k = 0; k < clusterID.size(); k++) {
+    rec.clusterID[k] = clusterID[molSys::fileIndex(yCloud, k)];
+  } // end of loop through atoms
+  return 0;
+}
+
+/**
+ * @details Records the rings of the current frame in compressed form: the
+ * members of all the rings are stored one after the other, with the offsets
+ * marking where each ring starts. Any rings recorded earlier for the same
+ * frame are replaced.
+ */
+int sbin::recordRings(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                      const std::vector<std::vector<int>> &rings) {
+  BinaryTrajectory &traj = trajectory();
+  if (!traj.sink) {
+    return 1;
+  }
+  sbin::FrameRecord &rec = currentRecord(traj, yCloud);
+  rec.ringOffsets.resize(rings.size() + 1);
+  rec.ringOffsets[0] = 0;
+  for (int iring = 0; iring < rings.size(); iring++) {
+    rec.ringOffsets[iring + 1] = rec.ringOffsets[iring] + rings[iring].size();
+  } // end of loop through rings
+  rec.ringAtoms.resize(rec.ringOffsets.back());
+  // The ring members are stored as rows of the frame (atom indices in the
+  // order in which the atoms were read in)
+  std::vector<int> position = molSys::filePositions(yCloud);
+  for (int iring = 0; iring < rings.size(); iring++) {
+    std::uint64_t offset = rec.ringOffsets[iring];
+    for (int k = 0; k < rings[iring].size(); k++) {
+      rec.ringAtoms[offset + k] = position[rings[iring][k]];
+    } // end of loop through ring members
+  } // end of loop through rings
+  return 0;
+}
+
+/**
+ * @details Reads the offsets of all the frames from the index file written
+ * alongside the trajectory. If the index file is missing or unreadable
+ * (for instance if the run was interrupted), the index is rebuilt by
+ * scanning the chunk headers of the trajectory.
+ */
+std::vector<sbin::IndexEntry> sbin::readIndex(std::string fileName) {
+  std::vector<sbin::IndexEntry> index;
+  std::ifstream indexFile(fileName + ".idx", std::ios::binary);
+  if (indexFile.is_open()) {
+    char magic[8];
+    std::uint32_t version[2];
+    indexFile.read(magic, 8);
+    indexFile.read(reinterpret_cast<char *>(version), sizeof(version));
+    if (indexFile && std::memcmp(magic, indexMagic, 8) == 0 &&
+        version[0] == sbin::formatVersion) {
+      sbin::IndexEntry entry;
+      while (indexFile.read(reinterpret_cast<char *>(&entry), sizeof(entry))) {
+        index.push_back(entry);
+      } // end of reading entries
+      return index;
+    }
+  }
+  // ----------------
+  // Rebuild the index from the trajectory itself
+  std::ifstream inpFile;
+  if (!openForReading(fileName, inpFile)) {
+    return index;
+  }
+  return scanTrajectory(inpFile);
+}
+
+/**
+ * @details Reads all the columns of one frame, looking up its offset in the
+ * index. Returns 1 if the frame is not in the trajectory.
+ */
+int sbin::readFrame(std::string fileName, int frame,
+                    sbin::FrameRecord *record) {
+  std::vector<sbin::IndexEntry> index = sbin::readIndex(fileName);
+  std::ifstream inpFile;
+  // ----------------
+  // Find the frame
+  auto it = std::find_if(index.begin(), index.end(),
+                         [frame](const sbin::IndexEntry &entry) {
+                           return entry.frame == frame;
+                         });
+  if (it == index.end()) {
+    std::cerr << "Frame " << frame << " is not in " << fileName << "\n";
+    return 1;
+  }
+  if (!openForReading(fileName, inpFile)) {
+    return 1;
+  }
+  if (!readChunk(inpFile, it->offset, record)) {
+    std::cerr << "Frame " << frame << " of " << fileName << " is corrupt.\n";
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @details Converts a binary trajectory into the usual ASCII output, for
+ * visualization in OVITO. For every frame, a LAMMPS dump file is written to
+ * path/dumpFiles and the rings (if any) to path/ringFiles. If the atoms were
+ * classified, the dump has the columns id mol type x y z rmsd (as in the
+ * topological network criteria dumps), otherwise the ice type labels from
+ * sout::writeDump are used.
+ */
+int sbin::convertToASCII(std::string fileName, std::string path) {
+  // Labels for each molSys::atom_state_type, in the order of the enum
+  static const char *iceLabels[] = {
+      "Ic",          "Ih",             "wat",
+      "intFc",       "clathrate",      "interClathrate",
+      "unclassified", "reIc",          "reIh"};
+  std::vector<sbin::IndexEntry> index = sbin::readIndex(fileName);
+  std::ifstream inpFile;
+  sbin::FrameRecord rec;
+  // ----------------
+  if (index.empty()) {
+    std::cerr << "No frames found in " << fileName << "\n";
+    return 1;
+  }
+  if (!openForReading(fileName, inpFile)) {
+    return 1;
+  }
+  // Make the output directories if they don't exist
+  sout::ensurePath(path);
+  sout::ensurePath(path + "dumpFiles");
+  // ----------------
+  for (auto &entry : index) {
+    if (!readChunk(inpFile, entry.offset, &rec)) {
+      std::cerr << "Frame " << entry.frame << " of " << fileName
+                << " is corrupt.\n";
+      return 1;
+    }
+    int nAtoms = rec.atomID.size();
+    bool hasClass = std::any_of(rec.atomClass.begin(), rec.atomClass.end(),
+                                [](std::int32_t c) { return c != -1; });
+    // ----------------
+    // Dump file
+    sout::OutputSink dumpFile(path + "dumpFiles/dump-" +
+                              std::to_string(rec.frame) + ".lammpstrj");
+    dumpFile.print("ITEM: TIMESTEP\n{}\n", rec.frame);
+    dumpFile.print("ITEM: NUMBER OF ATOMS\n{}\n", nAtoms);
+    dumpFile.print("ITEM: BOX BOUNDS pp pp pp\n");
+    for (int k = 0; k < 3; k++) {
+      dumpFile.print("{:g} {:g}\n", rec.boxLow[k], rec.boxLow[k] + rec.box[k]);
+    }
+    if (hasClass) {
+      dumpFile.print("ITEM: ATOMS id mol type x y z rmsd\n");
+      for (int iatom = 0; iatom < nAtoms; iatom++) {
+        dumpFile.print("{} {} {} {:g} {:g} {:g} {:g}\n", rec.atomID[iatom],
+                       rec.molID[iatom], rec.atomClass[iatom], rec.x[iatom],
+                       rec.y[iatom], rec.z[iatom], rec.rmsd[iatom]);
+      } // end of loop through atoms
+    } else {
+      dumpFile.print("ITEM: ATOMS id mol type x y z\n");
+      for (int iatom = 0; iatom < nAtoms; iatom++) {
+        int iceType = rec.iceType[iatom];
+        if (iceType > molSys::reHex) {
+          iceType = molSys::reHex;
+        }
+        dumpFile.print("{} {} {} {:g} {:g} {:g}\n", rec.atomID[iatom],
+                       rec.molID[iatom], iceLabels[iceType], rec.x[iatom],
+                       rec.y[iatom], rec.z[iatom]);
+      } // end of loop through atoms
+    }
+    // ----------------
+    // Ring file (atom IDs, one ring per line)
+    if (rec.ringOffsets.size() > 1) {
+      sout::ensurePath(path + "ringFiles");
+      sout::OutputSink ringFile(path + "ringFiles/rings-" +
+                                std::to_string(rec.frame) + ".dat");
+      for (int iring = 0; iring + 1 < rec.ringOffsets.size(); iring++) {
+        for (std::uint64_t k = rec.ringOffsets[iring];
+             k < rec.ringOffsets[iring + 1]; k++) {
+          int iatom = rec.ringAtoms[k];
+          ringFile.print("{} ", iatom < nAtoms ? rec.atomID[iatom] : iatom);
+        } // end of loop through ring elements
+        ringFile.print("\n");
+      } // end of loop through rings
+    }
+  } // end of loop through frames
+  sout::writer().drain();
+  return 0;
+}
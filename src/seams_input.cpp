@@ -12,8 +12,11 @@
 // If not, see <https://opensource.org/licenses/MIT>.
 //-----------------------------------------------------------------------------------
 
+#include <compressed_input.hpp>
 #include <generic.hpp>
 #include <seams_input.hpp>
+#include <profiling.hpp>
+#include <trajectory_formats.hpp>
 
 /**
  * @details Get all the ring information, from the R.I.N.G.S. file. Each line
@@ -22,8 +25,7 @@
  * discarded.
  */
 std::vector<std::vector<int>> sinp::readBonds(std::string filename) {
-  std::unique_ptr<std::ifstream> inpFile;
-  inpFile = std::make_unique<std::ifstream>(filename);
+  std::unique_ptr<std::istream> inpFile = sinp::openInput(filename);
   std::vector<std::vector<int>> bonds;
   std::string line;                // Current line being read in
   std::vector<std::string> tokens; // Vector containing word tokens
@@ -42,7 +44,7 @@ std::vector<std::vector<int>> sinp::readBonds(std::string filename) {
   // 388   1361   1042   1548    237      1
   // 272   1536   1582   1701   1905      1
 
-  if (inpFile->is_open()) {
+  if (*inpFile) {
     // ----------------------------------------------------------
     // At this point we know that the file is open
     std::getline((*inpFile), line); // Read in bonds
@@ -63,7 +65,7 @@ std::vector<std::vector<int>> sinp::readBonds(std::string filename) {
     // ----------------------------------------------------------
   } // End of if file open statement
 
-  inpFile->close();
+  inpFile.reset();
 
   return bonds;
 }
@@ -72,8 +74,7 @@ std::vector<std::vector<int>> sinp::readBonds(std::string filename) {
  */
 int sinp::readXYZ(std::string filename,
                   molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
-  std::unique_ptr<std::ifstream> xyzFile;
-  xyzFile = std::make_unique<std::ifstream>(filename);
+  std::unique_ptr<std::istream> xyzFile = sinp::openInput(filename);
   std::string line;                // Current line being read in
   std::vector<std::string> tokens; // Vector containing word tokens
   std::vector<double> numbers;     // Vector containing type double numbers
@@ -101,7 +102,7 @@ int sinp::readXYZ(std::string filename,
   // generated by VMD
   //  O         43.603500       16.926201       15.215700
   //  O         39.912601       14.775100       19.379200
-  if (xyzFile->is_open()) {
+  if (*xyzFile) {
     // ----------------------------------------------------------
     // At this point we know that the XYZ file is open
 
@@ -173,7 +174,7 @@ int sinp::readXYZ(std::string filename,
     // ----------------------------------------------------------
   } // End of if file open statement
 
-  xyzFile->close();
+  xyzFile.reset();
 
   if (yCloud->pts.size() == 1) {
     xHi = xLo + 10;
@@ -207,18 +208,26 @@ int sinp::readXYZ(std::string filename,
  * @param[in] coordHigh Contains the upper limits of the slice, if a slice is to
  *  be created
  */
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 sinp::readLammpsTrj(std::string filename, int targetFrame,
                     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                     bool isSlice, std::array<double, 3> coordLow,
                     std::array<double, 3> coordHigh) {
-  std::unique_ptr<std::ifstream> dumpFile;
-  dumpFile = std::make_unique<std::ifstream>(filename);
+  // DCD, XTC and LAMMPS binary dumps have a reader of their own
+  if (sinp::trajectoryFormat(filename) != sinp::TrajectoryFormat::lammpsText) {
+    sinp::readBinaryTrj(filename, targetFrame, yCloud, -1, false, isSlice,
+                        coordLow, coordHigh);
+    return *yCloud;
+  }
+  sprof::StageTimer timer("parse");
   std::string line;                // Current line being read in
   std::vector<std::string> tokens; // Vector containing word tokens
   std::vector<double> numbers;     // Vector containing type double numbers
   std::vector<double> tilt;        // Vector containing tilt factors
   int currentFrame = 0;            // Current frame being read in
+  // Compressed files may start after some of the frames before targetFrame
+  std::unique_ptr<std::istream> dumpFile =
+      sinp::openInput(filename, targetFrame, &currentFrame);
   int nop = -1;                    // Number of atoms in targetFrame
   bool foundFrame =
       false;            // Determines whether targetFrame has been found or not
@@ -251,7 +260,7 @@ sinp::readLammpsTrj(std::string filename, int targetFrame,
   // -7.9599900000000001e-01 5.0164000000000001e+01
   // ITEM: ATOMS id type x y z
   // 1 1 0 0 0 etc
-  if (dumpFile->is_open()) {
+  if (*dumpFile) {
     // ----------------------------------------------------------
     // At this point we know that the dumpfile is open
     // This loop searches for targetFrame
@@ -409,7 +418,10 @@ sinp::readLammpsTrj(std::string filename, int targetFrame,
   } // Throw exception
   yCloud->currentFrame = targetFrame;
 
-  dumpFile->close();
+  dumpFile.reset();
+  // Put the atoms in the order set with molSys::setAtomOrder
+  molSys::reorderAtoms(yCloud, molSys::atomOrder());
+  sprof::count("parse", yCloud->pts.size());
   return *yCloud;
 }
 
@@ -426,18 +438,26 @@ sinp::readLammpsTrj(std::string filename, int targetFrame,
  * @param[in] coordHigh Contains the upper limits of the slice, if a slice is
  *  to be created
  */
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 sinp::readLammpsTrjO(std::string filename, int targetFrame,
                      molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                      int typeO, bool isSlice, std::array<double, 3> coordLow,
                      std::array<double, 3> coordHigh) {
-  std::unique_ptr<std::ifstream> dumpFile;
-  dumpFile = std::make_unique<std::ifstream>(filename);
+  // DCD, XTC and LAMMPS binary dumps have a reader of their own
+  if (sinp::trajectoryFormat(filename) != sinp::TrajectoryFormat::lammpsText) {
+    sinp::readBinaryTrj(filename, targetFrame, yCloud, typeO, false, isSlice,
+                        coordLow, coordHigh);
+    return *yCloud;
+  }
+  sprof::StageTimer timer("parse");
   std::string line;                // Current line being read in
   std::vector<std::string> tokens; // Vector containing word tokens
   std::vector<double> numbers;     // Vector containing type double numbers
   std::vector<double> tilt;        // Vector containing tilt factors
   int currentFrame = 0;            // Current frame being read in
+  // Compressed files may start after some of the frames before targetFrame
+  std::unique_ptr<std::istream> dumpFile =
+      sinp::openInput(filename, targetFrame, &currentFrame);
   int nop = -1;                    // Number of atoms in targetFrame
   bool foundFrame =
       false;            // Determines whether targetFrame has been found or not
@@ -471,7 +491,7 @@ sinp::readLammpsTrjO(std::string filename, int targetFrame,
   // -7.9599900000000001e-01 5.0164000000000001e+01
   // ITEM: ATOMS id type x y z
   // 1 1 0 0 0 etc
-  if (dumpFile->is_open()) {
+  if (*dumpFile) {
     // ----------------------------------------------------------
     // At this point we know that the dumpfile is open
     // This loop searches for targetFrame
@@ -633,7 +653,10 @@ sinp::readLammpsTrjO(std::string filename, int targetFrame,
   } // Throw exception
   yCloud->currentFrame = targetFrame;
 
-  dumpFile->close();
+  dumpFile.reset();
+  // Put the atoms in the order set with molSys::setAtomOrder
+  molSys::reorderAtoms(yCloud, molSys::atomOrder());
+  sprof::count("parse", yCloud->pts.size());
   return *yCloud;
 }
 
@@ -652,18 +675,26 @@ sinp::readLammpsTrjO(std::string filename, int targetFrame,
  *  @param[in] coordHigh Contains the upper limits of the slice, if a slice is
  *  to be created
  */
-molSys::PointCloud<molSys::Point<double>, double> sinp::readLammpsTrjreduced(
+molSys::PointCloud<molSys::Point<double>, double> &sinp::readLammpsTrjreduced(
     std::string filename, int targetFrame,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int typeI,
     bool isSlice, std::array<double, 3> coordLow,
     std::array<double, 3> coordHigh) {
-  std::unique_ptr<std::ifstream> dumpFile;
-  dumpFile = std::make_unique<std::ifstream>(filename);
+  // DCD, XTC and LAMMPS binary dumps have a reader of their own
+  if (sinp::trajectoryFormat(filename) != sinp::TrajectoryFormat::lammpsText) {
+    sinp::readBinaryTrj(filename, targetFrame, yCloud, typeI, true, isSlice,
+                        coordLow, coordHigh);
+    return *yCloud;
+  }
+  sprof::StageTimer timer("parse");
   std::string line;                // Current line being read in
   std::vector<std::string> tokens; // Vector containing word tokens
   std::vector<double> numbers;     // Vector containing type double numbers
   std::vector<double> tilt;        // Vector containing tilt factors
   int currentFrame = 0;            // Current frame being read in
+  // Compressed files may start after some of the frames before targetFrame
+  std::unique_ptr<std::istream> dumpFile =
+      sinp::openInput(filename, targetFrame, &currentFrame);
   int nop = -1;                    // Number of atoms in targetFrame
   bool foundFrame =
       false;            // Determines whether targetFrame has been found or not
@@ -697,7 +728,7 @@ molSys::PointCloud<molSys::Point<double>, double> sinp::readLammpsTrjreduced(
   // -7.9599900000000001e-01 5.0164000000000001e+01
   // ITEM: ATOMS id type x y z
   // 1 1 0 0 0 etc
-  if (dumpFile->is_open()) {
+  if (*dumpFile) {
     // ----------------------------------------------------------
     // At this point we know that the dumpfile is open
     // This loop searches for targetFrame
@@ -863,6 +894,9 @@ molSys::PointCloud<molSys::Point<double>, double> sinp::readLammpsTrjreduced(
   // Update the frame number
   yCloud->currentFrame = targetFrame;
 
-  dumpFile->close();
+  dumpFile.reset();
+  // Put the atoms in the order set with molSys::setAtomOrder
+  molSys::reorderAtoms(yCloud, molSys::atomOrder());
+  sprof::count("parse", yCloud->pts.size());
   return *yCloud;
 }
@@ -12,8 +12,129 @@
 // If not, see <https://opensource.org/licenses/MIT>.
 //-----------------------------------------------------------------------------------
 
+#include <atomic>
+
+#include <accumulators.hpp>
 #include <seams_input.hpp>
 #include <seams_output.hpp>
+#include <profiling.hpp>
+
+namespace {
+
+// Whether sout::writeHisto also dumps every value
+std::atomic<bool> histogramValues{false};
+
+/**
+ * @details Writes the LAMMPS dump header (timestep, number of atoms and the
+ * orthogonal box bounds) shared by the per-frame dump writers.
+ */
+void printDumpHeader(sout::OutputSink &outputFile,
+                     molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  // ITEM: TIMESTEP
+  outputFile.print("ITEM: TIMESTEP\n{}\n", yCloud->currentFrame);
+  // ITEM: NUMBER OF ATOMS
+  outputFile.print("ITEM: NUMBER OF ATOMS\n{}\n", yCloud->pts.size());
+  // ITEM: BOX BOUNDS pp pp pp
+  outputFile.print("ITEM: BOX BOUNDS pp pp pp\n");
+  // Box lengths
+  for (int k = 0; k < 3; k++) {
+    outputFile.print("{:g} {:g}\n", yCloud->boxLow[k],
+                     yCloud->boxLow[k] + yCloud->box[k]);
+  }
+}
+
+/**
+ * @details Writes the box bounds of a LAMMPS data file.
+ */
+void printDataBox(sout::OutputSink &outputFile,
+                  molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  outputFile.print("{:g} {:g} xlo xhi\n", yCloud->boxLow[0],
+                   yCloud->boxLow[0] + yCloud->box[0]);
+  outputFile.print("{:g} {:g} ylo yhi\n", yCloud->boxLow[1],
+                   yCloud->boxLow[1] + yCloud->box[1]);
+  outputFile.print("{:g} {:g} zlo zhi\n", yCloud->boxLow[2],
+                   yCloud->boxLow[2] + yCloud->box[2]);
+}
+
+/**
+ * @details Writes the Bonds section of a LAMMPS data file.
+ */
+void printDataBonds(sout::OutputSink &outputFile,
+                    const bond::BondList &bonds) {
+  outputFile.print("\nBonds\n\n");
+  // Loop through all bonds
+  for (int ibond = 0; ibond < bonds.size(); ibond++) {
+    outputFile.print("{} 1 {} {}\n", ibond + 1, bonds.first(ibond),
+                     bonds.second(ibond));
+  } // end of for loop for bonds
+}
+
+/**
+ * @details Writes the XYZ file of one cluster (given by atom indices), in the
+ * frame directory bulkTopo/clusterXYZ/frame-N, which must already exist.
+ */
+void printXYZcluster(std::string outputDirName,
+                     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                     const std::vector<int> &atoms, int clusterID,
+                     cage::cageType type) {
+  std::string filename = "cluster-" + std::to_string(clusterID) + ".xyz";
+  sout::OutputSink outputFile(outputDirName + "/" + filename);
+
+  // Format of an XYZ file:
+  //  1970
+  // generated by VMD
+  //  O         43.603500       16.926201       15.215700
+  //  O         39.912601       14.775100       19.379200
+  outputFile.print("{}\n", atoms.size()); // Number of atoms
+  outputFile.print(
+      "Generated by d-SEAMS. 0 type=hc and 1 type =ddc\n"); // Comment line
+  //
+  // Write out all the atom coordinates
+  for (int iatom : atoms) {
+    outputFile.print("{} {:g} {:g} {:g}\n", static_cast<int>(type),
+                     yCloud->pts[iatom].x, yCloud->pts[iatom].y,
+                     yCloud->pts[iatom].z);
+  } // end of loop through all atoms
+}
+
+/**
+ * @details Replaces every atom index in the rings by the position of the atom
+ * in the order in which the atoms were read in, which is what the ring
+ * writers print (and use as the atom ID minus one). The two are the same
+ * unless the atoms have been reordered with molSys::setAtomOrder.
+ */
+std::vector<std::vector<int>>
+ringsInFileOrder(std::vector<std::vector<int>> rings,
+                 molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  if (yCloud->fileOrder.empty()) {
+    return rings;
+  } // not reordered
+  std::vector<int> position = molSys::filePositions(yCloud);
+  for (auto &ring : rings) {
+    for (auto &iatom : ring) {
+      iatom = position[iatom];
+    }
+  } // end of loop through rings
+  return rings;
+}
+
+/**
+ * @details Creates (once per run) the directory for the cluster XYZ files of
+ * the current frame, and returns its name.
+ */
+std::string
+clusterXYZdir(std::string path,
+              molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  sout::ensurePath(path);
+  sout::ensurePath(path + "bulkTopo");
+  sout::ensurePath(path + "bulkTopo/clusterXYZ/");
+  std::string outputDirName = path + "bulkTopo/clusterXYZ/frame-" +
+                              std::to_string(yCloud->currentFrame);
+  sout::ensurePath(outputDirName);
+  return outputDirName;
+}
+
+} // namespace
 
 /**
  * @details  Prints out a LAMMPS data file, with some default options. Only
@@ -21,7 +142,7 @@
  */
 int sout::writeLAMMPSdata(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<std::vector<int>> rings, std::vector<std::vector<int>> bonds,
+    std::vector<std::vector<int>> rings, const bond::BondList &bonds,
     std::string filename) {
   std::ofstream outputFile;
   std::vector<int> atoms;         // Holds all atom IDs to print
@@ -37,6 +158,8 @@ int sout::writeLAMMPSdata(
   if (rings.size() == 0) {
     return 1;
   }
+  // Atoms in the order of the trajectory
+  rings = ringsInFileOrder(rings, yCloud);
   // ----------------
   // Otherwise create file
   // Create output dir if it doesn't exist already
@@ -135,7 +258,8 @@ int sout::writeLAMMPSdata(
   // Write out the atom coordinates
   // Loop through atoms
   for (int i = 0; i < atoms.size(); i++) {
-    iatom = atoms[i] - 1; // The actual index is one less than the ID
+    // The position in the file is one less than the ID
+    iatom = molSys::fileIndex(yCloud, atoms[i] - 1);
     // -----------
     // Pad out
     // Fill in dummy atoms if some have been skipped
@@ -145,7 +269,7 @@ int sout::writeLAMMPSdata(
       // Loop to write out dummy atoms
       for (int j = 0; j < dummyAtoms; j++) {
         dummyID++;
-        jatom = dummyID - 1;
+        jatom = molSys::fileIndex(yCloud, dummyID - 1);
         // 1 molecule-tag atom-type q x y z
         outputFile << dummyID << " " << yCloud->pts[jatom].molID << " 2 0 "
                    << yCloud->pts[jatom].x << " " << yCloud->pts[jatom].y << " "
@@ -166,8 +290,8 @@ int sout::writeLAMMPSdata(
   outputFile << "\nBonds\n\n";
   // Loop through all bonds
   for (int ibond = 0; ibond < bonds.size(); ibond++) {
-    outputFile << ibond + 1 << " 1 " << bonds[ibond][0] << " "
-               << bonds[ibond][1] << "\n";
+    outputFile << ibond + 1 << " 1 " << bonds.first(ibond) << " "
+               << bonds.second(ibond) << "\n";
   }
 
   // Once the datafile has been printed, exit
@@ -180,32 +304,24 @@ int sout::writeLAMMPSdata(
  *  Uses Boost!
  */
 int sout::writeRings(std::vector<std::vector<int>> rings,
+                     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                      std::string filename) {
-  std::ofstream outputFile;
-  // ----------------
-  // Create output dir if it doesn't exist already
-  const char *path = "../output"; // relative to the build directory
-  fs::path dir(path);
-  // if (fs::create_directory(dir)) {
-  //   std::cerr << "Output directory created\n";
-  // }
   // ----------------
   // Write output to file inside the output directory
-  outputFile.open("../output/" + filename);
+  sout::OutputSink outputFile("../output/" + filename);
 
-  // Format:
+  // Format (atom indices, in the order of the trajectory):
   // 272    214    906   1361    388      1
+  rings = ringsInFileOrder(rings, yCloud);
 
   for (int iring = 0; iring < rings.size(); iring++) {
     // Otherwise, write out to the file
     for (int k = 0; k < rings[iring].size(); k++) {
-      outputFile << rings[iring][k] << " ";
+      outputFile.print("{} ", rings[iring][k]);
     } // end of loop through ring elements
-    outputFile << "\n";
+    outputFile.print("\n");
   } // end of loop through rings
 
-  outputFile.close();
-
   return 0;
 }
 
@@ -316,7 +432,8 @@ int sout::writeAllCages(
     if (type == cage::HexC) {
       numHC++;
       sout::writeEachCage((*cageList)[icage].rings, numHC, type, rings, yCloud);
-      sout::writeBasalRingsHex((*cageList)[icage].rings, numHC, nList, rings);
+      sout::writeBasalRingsHex((*cageList)[icage].rings, numHC, nList, rings,
+                               yCloud);
     } // end of write out of HCs
     // Double diamond Cages
     else if (type == cage::DoubleDiaC) {
@@ -359,6 +476,9 @@ int sout::writeEachCage(
   char cageChar[100];         // is icage a DDC, HC or MC?
   int iring;                  // Ring index of the current ring
 
+  // Atoms in the order of the trajectory
+  rings = ringsInFileOrder(rings, yCloud);
+
   if (type == cage::HexC) {
     strcpy(cageChar, "../output/cages/hexCages");
     actualCageType = "hexCages";
@@ -400,7 +520,8 @@ int sout::writeEachCage(
       iring = currentCage[i]; // Current iring
       // Get every node of iring
       for (int j = 0; j < ringSize; j++) {
-        iatomIndex = rings[iring][j] - 1; // C++ indices are one less
+        // C++ indices are one less
+        iatomIndex = molSys::fileIndex(yCloud, rings[iring][j] - 1);
         // Write out the coordinates to the file
         outputFile << yCloud->pts[iatomIndex].x << " ";
         outputFile << yCloud->pts[iatomIndex].y << " ";
@@ -417,7 +538,8 @@ int sout::writeEachCage(
       iring = currentCage[i]; // Current iring
       // Get every node of iring
       for (int j = 0; j < ringSize; j++) {
-        iatomIndex = rings[iring][j] - 1; // C++ indices are one less
+        // C++ indices are one less
+        iatomIndex = molSys::fileIndex(yCloud, rings[iring][j] - 1);
         // Write out the coordinates to the file
         outputFile << yCloud->pts[iatomIndex].x << " ";
         outputFile << yCloud->pts[iatomIndex].y << " ";
@@ -438,9 +560,10 @@ int sout::writeEachCage(
  * @details Function for printing out the basal rings only of the hexagonal cage
  * described by the number cageNum Uses Boost!
  */
-int sout::writeBasalRingsHex(std::vector<int> currentCage, int cageNum,
-                             std::vector<std::vector<int>> nList,
-                             std::vector<std::vector<int>> rings) {
+int sout::writeBasalRingsHex(
+    std::vector<int> currentCage, int cageNum,
+    std::vector<std::vector<int>> nList, std::vector<std::vector<int>> rings,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
   std::ofstream outputFile;
   std::string number = std::to_string(cageNum);
   std::string filename = "basalRings" + number + ".dat";
@@ -626,15 +749,19 @@ int sout::writeBasalRingsHex(std::vector<int> currentCage, int cageNum,
   // For hexagonal cages:
   // Only print out basal1 and basal2
 
+  // In the order of the trajectory
+  std::vector<std::vector<int>> basalRings =
+      ringsInFileOrder({basal1, basal2}, yCloud);
+
   // BASAL1
   for (int i = 0; i < basal1.size(); i++) {
-    outputFile << basal1[i] << " ";
+    outputFile << basalRings[0][i] << " ";
   } // end of loop through basal1
   outputFile << "\n";
 
   // BASAL2
   for (int i = 0; i < basal2.size(); i++) {
-    outputFile << basal2[i] << " ";
+    outputFile << basalRings[1][i] << " ";
   } // end of loop through basal2
 
   // Close the output file
@@ -817,15 +944,19 @@ int sout::writeBasalRingsPrism(
   // For hexagonal cages:
   // Only print out basal1 and basal2
 
+  // In the order of the trajectory
+  std::vector<std::vector<int>> basalRings =
+      ringsInFileOrder({matchedBasal1, matchedBasal2}, yCloud);
+
   // BASAL1
   for (int i = 0; i < matchedBasal1.size(); i++) {
-    outputFile << matchedBasal1[i] << " ";
+    outputFile << basalRings[0][i] << " ";
   } // end of loop through basal1
   outputFile << "\n";
 
   // BASAL2
   for (int i = 0; i < matchedBasal2.size(); i++) {
-    outputFile << matchedBasal2[i] << " ";
+    outputFile << basalRings[1][i] << " ";
   } // end of loop through basal2
 
   // Close the output file
@@ -841,14 +972,12 @@ int sout::writeClusterStats(std::string path, int currentFrame,
                             int largestCluster, int numOfClusters,
                             int smallestCluster, double avgClusterSize,
                             int firstFrame) {
-  std::ofstream outputFile;
   // ----------------
   // Make the output directory if it doesn't exist
-  sout::makePath(path);
+  sout::ensurePath(path);
   // ----------------
   // Write output to file inside the output directory
-  outputFile.open(path + "clusterStats.dat",
-                  std::ios_base::app | std::ios_base::out);
+  sout::OutputSink &outputFile = sout::appendSink(path + "clusterStats.dat");
 
   // Format:
   // Comment line
@@ -857,15 +986,13 @@ int sout::writeClusterStats(std::string path, int currentFrame,
   // ----------------
   // Comment line for the first frame
   if (currentFrame == firstFrame) {
-    outputFile << "Frame largestCluster numOfClusters smallestCluster "
-                  "avgClusterSize\n";
+    outputFile.print("Frame largestCluster numOfClusters smallestCluster "
+                     "avgClusterSize\n");
   }
   // ----------------
 
-  outputFile << currentFrame << " " << largestCluster << " " << numOfClusters
-             << " " << smallestCluster << " " << avgClusterSize << "\n";
-
-  outputFile.close();
+  outputFile.print("{} {} {} {} {:g}\n", currentFrame, largestCluster,
+                   numOfClusters, smallestCluster, avgClusterSize);
 
   return 0;
 }
@@ -1032,41 +1159,37 @@ int sout::writePrismNum(std::string path, std::vector<int> nPrisms,
                         std::vector<int> nDefPrisms,
                         std::vector<double> heightPercent, int maxDepth,
                         int currentFrame, int firstFrame) {
-  std::ofstream outputFile;
   int totalPrisms; // Number of total prisms
   // ----------------
   // Make the output directory if it doesn't exist
-  sout::makePath(path);
+  sout::ensurePath(path);
   std::string outputDirName = path + "topoINT";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   // ----------------
   // Write output to file inside the output directory
-  outputFile.open(path + "topoINT/nPrisms.dat",
-                  std::ios_base::app | std::ios_base::out);
+  sout::OutputSink &outputFile = sout::appendSink(path + "topoINT/nPrisms.dat");
 
   // ----------------
   // Write the comment line if the first frame is being written out
   if (currentFrame == firstFrame) {
-    outputFile << "Frame RingSize Num_of_prisms Height% RingSize ... Height\n";
+    outputFile.print(
+        "Frame RingSize Num_of_prisms Height% RingSize ... Height\n");
   }
   // ----------------
   // Format:
   // Frame RingSize Num_of_prisms Height% RingSize ... Height%
   // 1 3 0 0 4 35 40 ....
 
-  outputFile << currentFrame << " ";
+  outputFile.print("{} ", currentFrame);
 
   for (int ringSize = 3; ringSize <= maxDepth; ringSize++) {
     totalPrisms = nPrisms[ringSize - 3] + nDefPrisms[ringSize - 3];
     // Write out
-    outputFile << ringSize << " " << totalPrisms << " "
-               << nDefPrisms[ringSize - 3] << " " << heightPercent[ringSize - 3]
-               << " ";
+    outputFile.print("{} {} {} {:g} ", ringSize, totalPrisms,
+                     nDefPrisms[ringSize - 3], heightPercent[ringSize - 3]);
   }
 
-  outputFile << "\n";
-
-  outputFile.close();
+  outputFile.print("\n");
 
   return 0;
 }
@@ -1080,19 +1203,16 @@ int sout::writeRingNum(std::string path, int currentFrame,
                        std::vector<double> coverageAreaXZ,
                        std::vector<double> coverageAreaYZ, int maxDepth,
                        int firstFrame) {
-  std::ofstream outputFileXY;
-  std::ofstream outputFileXZ;
-  std::ofstream outputFileYZ;
   // ----------------
   // Make the output directory if it doesn't exist
-  sout::makePath(path);
+  sout::ensurePath(path);
   std::string outputDirName = path + "topoMonolayer";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   // ----------------
   // Coverage Area of XY
   // Write output to file inside the output directory
-  outputFileXY.open(path + "topoMonolayer/coverageAreaXY.dat",
-                    std::ios_base::app | std::ios_base::out);
+  sout::OutputSink &outputFileXY =
+      sout::appendSink(path + "topoMonolayer/coverageAreaXY.dat");
 
   // Format:
   // Comment line
@@ -1101,32 +1221,30 @@ int sout::writeRingNum(std::string path, int currentFrame,
   // ----------------
   // Add comment for the first frame
   if (currentFrame == firstFrame) {
-    outputFileXY << "Frame RingSize Num_of_rings CoverageAreaXY% RingSize ... "
-                    "CoverageAreaXY%\n";
+    outputFileXY.print("Frame RingSize Num_of_rings CoverageAreaXY% RingSize "
+                       "... CoverageAreaXY%\n");
   }
   // ----------------
 
-  outputFileXY << currentFrame << " ";
+  outputFileXY.print("{} ", currentFrame);
 
   for (int ringSize = 3; ringSize <= maxDepth; ringSize++) {
-    outputFileXY << ringSize << " " << nRings[ringSize - 3] << " "
-                 << coverageAreaXY[ringSize - 3] << " ";
+    outputFileXY.print("{} {} {:g} ", ringSize, nRings[ringSize - 3],
+                       coverageAreaXY[ringSize - 3]);
   }
 
-  outputFileXY << "\n";
-
-  outputFileXY.close();
+  outputFileXY.print("\n");
   // ----------------
   // Coverage Area of XZ
   // Write output to file inside the output directory
-  outputFileXZ.open(path + "topoMonolayer/coverageAreaXZ.dat",
-                    std::ios_base::app | std::ios_base::out);
+  sout::OutputSink &outputFileXZ =
+      sout::appendSink(path + "topoMonolayer/coverageAreaXZ.dat");
 
   // ----------------
   // Add comment for the first frame
   if (currentFrame == firstFrame) {
-    outputFileXZ << "Frame RingSize Num_of_rings CoverageAreaXZ% RingSize ... "
-                    "CoverageAreaXZ%\n";
+    outputFileXZ.print("Frame RingSize Num_of_rings CoverageAreaXZ% RingSize "
+                       "... CoverageAreaXZ%\n");
   }
   // ----------------
 
@@ -1134,27 +1252,25 @@ int sout::writeRingNum(std::string path, int currentFrame,
   // Frame RingSize Num_of_prisms Height% RingSize ... Height%
   // 1 3 0 0 4 35 40 ....
 
-  outputFileXZ << currentFrame << " ";
+  outputFileXZ.print("{} ", currentFrame);
 
   for (int ringSize = 3; ringSize <= maxDepth; ringSize++) {
-    outputFileXZ << ringSize << " " << nRings[ringSize - 3] << " "
-                 << coverageAreaXZ[ringSize - 3] << " ";
+    outputFileXZ.print("{} {} {:g} ", ringSize, nRings[ringSize - 3],
+                       coverageAreaXZ[ringSize - 3]);
   }
 
-  outputFileXZ << "\n";
-
-  outputFileXZ.close();
+  outputFileXZ.print("\n");
   // ----------------
   // Coverage Area of YZ
   // Write output to file inside the output directory
-  outputFileYZ.open(path + "topoMonolayer/coverageAreaYZ.dat",
-                    std::ios_base::app | std::ios_base::out);
+  sout::OutputSink &outputFileYZ =
+      sout::appendSink(path + "topoMonolayer/coverageAreaYZ.dat");
 
   // ----------------
   // Add comment for the first frame
   if (currentFrame == firstFrame) {
-    outputFileYZ << "Frame RingSize Num_of_rings CoverageAreaYZ% RingSize ... "
-                    "CoverageAreaYZ%\n";
+    outputFileYZ.print("Frame RingSize Num_of_rings CoverageAreaYZ% RingSize "
+                       "... CoverageAreaYZ%\n");
   }
   // ----------------
 
@@ -1162,16 +1278,14 @@ int sout::writeRingNum(std::string path, int currentFrame,
   // Frame RingSize Num_of_prisms Height% RingSize ... Height%
   // 1 3 0 0 4 35 40 ....
 
-  outputFileYZ << currentFrame << " ";
+  outputFileYZ.print("{} ", currentFrame);
 
   for (int ringSize = 3; ringSize <= maxDepth; ringSize++) {
-    outputFileYZ << ringSize << " " << nRings[ringSize - 3] << " "
-                 << coverageAreaYZ[ringSize - 3] << " ";
+    outputFileYZ.print("{} {} {:g} ", ringSize, nRings[ringSize - 3],
+                       coverageAreaYZ[ringSize - 3]);
   }
 
-  outputFileYZ << "\n";
-
-  outputFileYZ.close();
+  outputFileYZ.print("\n");
 
   return 0;
 }
@@ -1183,17 +1297,16 @@ int sout::writeRingNumBulk(std::string path, int currentFrame,
                        std::vector<int> nRings,
                        int maxDepth,
                        int firstFrame) {
-  std::ofstream outputFile;
   // ----------------
   // Make the output directory if it doesn't exist
-  sout::makePath(path);
+  sout::ensurePath(path);
   std::string outputDirName = path + "bulkTopo";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   // ----------------
   // Ring output file
   // Write output to file inside the output directory
-  outputFile.open(path + "bulkTopo/num_rings.dat",
-                    std::ios_base::app | std::ios_base::out);
+  sout::OutputSink &outputFile =
+      sout::appendSink(path + "bulkTopo/num_rings.dat");
 
   // Format:
   // Comment line
@@ -1202,19 +1315,17 @@ int sout::writeRingNumBulk(std::string path, int currentFrame,
   // ----------------
   // Add comment for the first frame
   if (currentFrame == firstFrame) {
-    outputFile << "Frame RingSize Num_of_rings RingSize Num_of_rings...\n";
+    outputFile.print("Frame RingSize Num_of_rings RingSize Num_of_rings...\n");
   }
   // ----------------
 
-  outputFile << currentFrame << " ";
+  outputFile.print("{} ", currentFrame);
 
   for (int ringSize = 3; ringSize <= maxDepth; ringSize++) {
-    outputFile << ringSize << " " << nRings[ringSize - 3] << " ";
+    outputFile.print("{} {} ", ringSize, nRings[ringSize - 3]);
   }
 
-  outputFile << "\n";
-
-  outputFile.close();
+  outputFile.print("\n");
 
   return 0;
 }
@@ -1226,21 +1337,18 @@ int sout::writeRingNumBulk(std::string path, int currentFrame,
 int sout::printRDF(std::string fileName, std::vector<double> *rdfValues,
                    double binwidth, int nbin) {
   //
-  std::ofstream outputFile; // For the output file
-  double r;                 // Distance for the current bin
+  double r; // Distance for the current bin
 
   // Append to the file
-  outputFile.open(fileName, std::ios_base::app | std::ios_base::out);
+  sout::OutputSink &outputFile = sout::appendSink(fileName);
 
   // Loop through all the bins
   for (int ibin = 0; ibin < nbin; ibin++) {
     //
     r = binwidth * (ibin + 0.5); // Current distance for ibin
-    outputFile << r << " " << (*rdfValues)[ibin] << "\n";
+    outputFile.print("{:g} {:g}\n", r, (*rdfValues)[ibin]);
   } // end of loop through all bins
 
-  outputFile.close();
-
   return 0;
 }
 
@@ -1251,17 +1359,15 @@ int sout::printRDF(std::string fileName, std::vector<double> *rdfValues,
 int sout::writeTopoBulkData(std::string path, int currentFrame, int numHC,
                             int numDDC, int mixedRings, int basalRings,
                             int prismaticRings, int firstFrame) {
-  //
-  std::ofstream outputFile;
   // ----------------
   // Make the output directory if it doesn't exist
-  sout::makePath(path);
+  sout::ensurePath(path);
   std::string outputDirName = path + "bulkTopo";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   // ----------------
   // Write output to file inside the output directory
-  outputFile.open(path + "bulkTopo/cageData.dat",
-                  std::ios_base::app | std::ios_base::out);
+  sout::OutputSink &outputFile =
+      sout::appendSink(path + "bulkTopo/cageData.dat");
 
   // Format:
   // Frame RingSize Num_of_prisms Height% RingSize ... Height%
@@ -1269,15 +1375,13 @@ int sout::writeTopoBulkData(std::string path, int currentFrame, int numHC,
   // -------------------
   // If first frame then write the comment line
   if (currentFrame == firstFrame) {
-    outputFile << "Frame HCnumber DDCnumber MixedRingNumber PrismaticRings "
-                  "basalRings\n";
+    outputFile.print("Frame HCnumber DDCnumber MixedRingNumber PrismaticRings "
+                     "basalRings\n");
   }
   // -------------------
-  outputFile << currentFrame << " " << numHC << " " << numDDC << " "
-             << mixedRings << " " << prismaticRings << " " << basalRings
-             << "\n";
+  outputFile.print("{} {} {} {} {} {}\n", currentFrame, numHC, numDDC,
+                   mixedRings, prismaticRings, basalRings);
 
-  outputFile.close();
   return 0;
 } // end of function
 
@@ -1289,33 +1393,37 @@ int sout::writeLAMMPSdumpCages(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<double> rmsdPerAtom, std::vector<int> atomTypes,
     std::string path, int firstFrame) {
-  std::ofstream outputFile;
-  int iatom; // Index, not atom ID
   std::string filename =
       "dump-" + std::to_string(yCloud->currentFrame) + ".lammpstrj";
   // ----------------
   // Make the output directory if it doesn't exist
   std::string outputDirName = path + "bulkTopo/dumpFiles";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   // ----------------
   // Write out information about the data types
   if (yCloud->currentFrame == firstFrame) {
-    outputFile.open(path + "bulkTopo/typeInfo.dat");
-    outputFile << "Atom types in the dump files are:\n";
-    outputFile << " Type 0 (dummy) = unidentified phase\n";
-    outputFile << " Type 1 (hc) = atom belonging to a Hexagonal Cage.\n";
-    outputFile << " Type 2 (ddc) = atom belonging to a Double-Diamond Cage\n";
-    outputFile << " Type 3 (mixed) = atom belonging to a mixed ring shared by "
-                  "a DDC and HC\n";
-    outputFile
-        << " Type 4 (pnc) = atom belonging to a pair of pentagonal rings\n";
-    outputFile << " Type 5 (mixed2) = atom belonging to a pentagonal "
-                  "nanochannel, shared by DDCs/HCs\n";
-    outputFile.close();
+    sout::OutputSink infoFile(path + "bulkTopo/typeInfo.dat");
+    infoFile.print("Atom types in the dump files are:\n");
+    infoFile.print(" Type 0 (dummy) = unidentified phase\n");
+    infoFile.print(" Type 1 (hc) = atom belonging to a Hexagonal Cage.\n");
+    infoFile.print(" Type 2 (ddc) = atom belonging to a Double-Diamond Cage\n");
+    infoFile.print(" Type 3 (mixed) = atom belonging to a mixed ring shared by "
+                   "a DDC and HC\n");
+    infoFile.print(
+        " Type 4 (pnc) = atom belonging to a pair of pentagonal rings\n");
+    infoFile.print(" Type 5 (mixed2) = atom belonging to a pentagonal "
+                   "nanochannel, shared by DDCs/HCs\n");
   } // end of writing out information
   // ----------------
+  // Record into the binary trajectory instead, if there is one
+  if (sbin::isEnabled()) {
+    sbin::recordAtomClass(yCloud, atomTypes);
+    sbin::recordRMSD(yCloud, rmsdPerAtom);
+    return 0;
+  }
+  // ----------------
   // Write output to file inside the output directory
-  outputFile.open(path + "bulkTopo/dumpFiles/" + filename);
+  sout::OutputSink outputFile(path + "bulkTopo/dumpFiles/" + filename);
   // ----------------------------------------------------
   // Header Format
 
@@ -1332,42 +1440,24 @@ int sout::writeLAMMPSdumpCages(
   // -----------------
   // -------
   // Write the header
-  // ITEM: TIMESTEP
-  outputFile << "ITEM: TIMESTEP\n";
-  // Write out frame number
-  outputFile << yCloud->currentFrame << "\n";
-  // ITEM: NUMBER OF ATOMS
-  outputFile << "ITEM: NUMBER OF ATOMS\n";
-  // Number of atoms
-  outputFile << yCloud->pts.size() << "\n";
-  // ITEM: BOX BOUNDS pp pp pp
-  outputFile << "ITEM: BOX BOUNDS pp pp pp\n";
-  // Box lengths
-  outputFile << yCloud->boxLow[0] << " " << yCloud->boxLow[0] + yCloud->box[0]
-             << "\n";
-  outputFile << yCloud->boxLow[1] << " " << yCloud->boxLow[1] + yCloud->box[1]
-             << "\n";
-  outputFile << yCloud->boxLow[2] << " " << yCloud->boxLow[2] + yCloud->box[2]
-             << "\n";
+  printDumpHeader(outputFile, yCloud);
   // ITEM: ATOMS id mol type x y z rmsd
-  outputFile << "ITEM: ATOMS id mol type x y z rmsd\n";
+  outputFile.print("ITEM: ATOMS id mol type x y z rmsd\n");
   // -------
   // Write out the atom coordinates
   // Format
   // ITEM: ATOMS id mol type x y z rmsd
   //
   // Loop through atoms
-  for (int i = 0; i < yCloud->pts.size(); i++) {
-    iatom =
-        yCloud->pts[i].atomID; // The actual ID can be different from the index
-    // Write out coordinates
-    outputFile << iatom << " " << yCloud->pts[i].molID << " " << atomTypes[i]
-               << " " << yCloud->pts[i].x << " " << yCloud->pts[i].y << " "
-               << yCloud->pts[i].z << " " << rmsdPerAtom[i] << "\n";
+  for (int k = 0; k < yCloud->pts.size(); k++) {
+    int i = molSys::fileIndex(yCloud, k); // In the order read in
+    // The actual ID can be different from the index
+    outputFile.print("{} {} {} {:g} {:g} {:g} {:g}\n", yCloud->pts[i].atomID,
+                     yCloud->pts[i].molID, atomTypes[i], yCloud->pts[i].x,
+                     yCloud->pts[i].y, yCloud->pts[i].z, rmsdPerAtom[i]);
 
   } // end of loop through all atoms in pointCloud
   // -----------------------------------------------------
-  outputFile.close(); // Close the file
   return 0;
 } // end of function
 
@@ -1379,18 +1469,23 @@ int sout::writeLAMMPSdumpINT(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<double> rmsdPerAtom, std::vector<int> atomTypes, int maxDepth,
     std::string path) {
+  // ----------------
+  // Record into the binary trajectory instead, if there is one
+  if (sbin::isEnabled()) {
+    sbin::recordAtomClass(yCloud, atomTypes);
+    sbin::recordRMSD(yCloud, rmsdPerAtom);
+    return 0;
+  }
   //
-  std::ofstream outputFile;
-  int iatom; // Index, not atom ID
   std::string filename =
       "dump-" + std::to_string(yCloud->currentFrame) + ".lammpstrj";
   // ----------------
   // Make the output directory if it doesn't exist
   std::string outputDirName = path + "topoINT/dumpFiles";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   // ----------------
   // Write output to file inside the output directory
-  outputFile.open(path + "topoINT/dumpFiles/" + filename);
+  sout::OutputSink outputFile(path + "topoINT/dumpFiles/" + filename);
   // ----------------------------------------------------
   // Header Format
 
@@ -1407,38 +1502,21 @@ int sout::writeLAMMPSdumpINT(
   // -----------------
   // -------
   // Write the header
-  // ITEM: TIMESTEP
-  outputFile << "ITEM: TIMESTEP\n";
-  // Write out frame number
-  outputFile << yCloud->currentFrame << "\n";
-  // ITEM: NUMBER OF ATOMS
-  outputFile << "ITEM: NUMBER OF ATOMS\n";
-  // Number of atoms
-  outputFile << yCloud->pts.size() << "\n";
-  // ITEM: BOX BOUNDS pp pp pp
-  outputFile << "ITEM: BOX BOUNDS pp pp pp\n";
-  // Box lengths
-  outputFile << yCloud->boxLow[0] << " " << yCloud->boxLow[0] + yCloud->box[0]
-             << "\n";
-  outputFile << yCloud->boxLow[1] << " " << yCloud->boxLow[1] + yCloud->box[1]
-             << "\n";
-  outputFile << yCloud->boxLow[2] << " " << yCloud->boxLow[2] + yCloud->box[2]
-             << "\n";
+  printDumpHeader(outputFile, yCloud);
   // ITEM: ATOMS id mol type x y z rmsd
-  outputFile << "ITEM: ATOMS id mol type x y z rmsd\n";
+  outputFile.print("ITEM: ATOMS id mol type x y z rmsd\n");
   // -------
   // Write out the atom coordinates
   // Format
   // ITEM: ATOMS id mol type x y z rmsd
   //
   // Loop through atoms
-  for (int i = 0; i < yCloud->pts.size(); i++) {
-    iatom =
-        yCloud->pts[i].atomID; // The actual ID can be different from the index
-    // Write out coordinates
-    outputFile << iatom << " " << yCloud->pts[i].molID << " " << atomTypes[i]
-               << " " << yCloud->pts[i].x << " " << yCloud->pts[i].y << " "
-               << yCloud->pts[i].z << " " << rmsdPerAtom[i] << "\n";
+  for (int k = 0; k < yCloud->pts.size(); k++) {
+    int i = molSys::fileIndex(yCloud, k); // In the order read in
+    // The actual ID can be different from the index
+    outputFile.print("{} {} {} {:g} {:g} {:g} {:g}\n", yCloud->pts[i].atomID,
+                     yCloud->pts[i].molID, atomTypes[i], yCloud->pts[i].x,
+                     yCloud->pts[i].y, yCloud->pts[i].z, rmsdPerAtom[i]);
 
   } // end of loop through all atoms in pointCloud
   // -----------------------------------------------------
@@ -1453,18 +1531,16 @@ int sout::writeLAMMPSdumpSlice(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::string path) {
   //
-  std::ofstream outputFile;
-  int iatom; // Index, not atom ID
   std::string filename =
       "dump-" + std::to_string(yCloud->currentFrame) + ".lammpstrj";
   // ----------------
   // Make the output directory if it doesn't exist
-  sout::makePath(path+"selection");
+  sout::ensurePath(path+"selection");
   std::string outputDirName = path + "selection/dumpFiles";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   // ----------------
   // Write output to file inside the output directory
-  outputFile.open(path + "selection/dumpFiles/" + filename);
+  sout::OutputSink outputFile(path + "selection/dumpFiles/" + filename);
   // ----------------------------------------------------
   // Header Format
 
@@ -1481,38 +1557,22 @@ int sout::writeLAMMPSdumpSlice(
   // -----------------
   // -------
   // Write the header
-  // ITEM: TIMESTEP
-  outputFile << "ITEM: TIMESTEP\n";
-  // Write out frame number
-  outputFile << yCloud->currentFrame << "\n";
-  // ITEM: NUMBER OF ATOMS
-  outputFile << "ITEM: NUMBER OF ATOMS\n";
-  // Number of atoms
-  outputFile << yCloud->pts.size() << "\n";
-  // ITEM: BOX BOUNDS pp pp pp
-  outputFile << "ITEM: BOX BOUNDS pp pp pp\n";
-  // Box lengths
-  outputFile << yCloud->boxLow[0] << " " << yCloud->boxLow[0] + yCloud->box[0]
-             << "\n";
-  outputFile << yCloud->boxLow[1] << " " << yCloud->boxLow[1] + yCloud->box[1]
-             << "\n";
-  outputFile << yCloud->boxLow[2] << " " << yCloud->boxLow[2] + yCloud->box[2]
-             << "\n";
+  printDumpHeader(outputFile, yCloud);
   // ITEM: ATOMS id mol type x y z rmsd
-  outputFile << "ITEM: ATOMS id mol type x y z inSlice\n";
+  outputFile.print("ITEM: ATOMS id mol type x y z inSlice\n");
   // -------
   // Write out the atom coordinates
   // Format
   // ITEM: ATOMS id mol type x y z rmsd
   //
   // Loop through atoms
-  for (int i = 0; i < yCloud->pts.size(); i++) {
-    iatom =
-        yCloud->pts[i].atomID; // The actual ID can be different from the index
-    // Write out coordinates
-    outputFile << iatom << " " << yCloud->pts[i].molID << " " << yCloud->pts[i].type
-               << " " << yCloud->pts[i].x << " " << yCloud->pts[i].y << " "
-               << yCloud->pts[i].z << " " << yCloud->pts[i].inSlice << "\n";
+  for (int k = 0; k < yCloud->pts.size(); k++) {
+    int i = molSys::fileIndex(yCloud, k); // In the order read in
+    // The actual ID can be different from the index
+    outputFile.print("{} {} {} {:g} {:g} {:g} {:d}\n", yCloud->pts[i].atomID,
+                     yCloud->pts[i].molID, yCloud->pts[i].type,
+                     yCloud->pts[i].x, yCloud->pts[i].y, yCloud->pts[i].z,
+                     static_cast<int>(yCloud->pts[i].inSlice));
 
   } // end of loop through all atoms in pointCloud
   // -----------------------------------------------------
@@ -1528,13 +1588,16 @@ int sout::writeLAMMPSdataAllPrisms(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<std::vector<int>> nList, std::vector<int> atomTypes,
     int maxDepth, std::string path, bool doShapeMatching) {
+  // ----------------
+  // Record into the binary trajectory instead, if there is one
+  if (sbin::isEnabled()) {
+    sbin::recordAtomClass(yCloud, atomTypes);
+    return 0;
+  }
   //
-  std::ofstream outputFile;
-  int iatom; // Index, not atom ID
   int bondTypes = 1;
   // Bond stuff
-  std::vector<std::vector<int>> bonds; // Vector of vector, with each row
-                                       // containing the atom IDs of each bond
+  bond::BondList bonds; // Packed bonds, by atom ID
   std::string filename =
       "system-prisms-" + std::to_string(yCloud->currentFrame) + ".data";
 
@@ -1544,14 +1607,14 @@ int sout::writeLAMMPSdataAllPrisms(
   //
   // ----------------
   // Make the output directory if it doesn't exist
-  sout::makePath(path);
+  sout::ensurePath(path);
   std::string outputDirName = path + "topoINT";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   outputDirName = path + "topoINT/dataFiles/";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   // ----------------
   // Write output to file inside the output directory
-  outputFile.open(path + "topoINT/dataFiles/" + filename);
+  sout::OutputSink outputFile(path + "topoINT/dataFiles/" + filename);
   // FORMAT:
   //  Comment Line
   //  4 atoms
@@ -1581,74 +1644,58 @@ int sout::writeLAMMPSdataAllPrisms(
   // -------
   // Write the header
   // Write comment line
-  outputFile << "Written out by D-SEAMS\n";
+  outputFile.print("Written out by D-SEAMS\n");
   // Write out the number of atoms
-  outputFile << yCloud->pts.size() << " "
-             << "atoms"
-             << "\n";
+  outputFile.print("{} atoms\n", yCloud->pts.size());
   // Number of bonds
-  outputFile << bonds.size() << " bonds"
-             << "\n";
-  outputFile << "0 angles\n0 dihedrals\n0 impropers\n";
+  outputFile.print("{} bonds\n", bonds.size());
+  outputFile.print("0 angles\n0 dihedrals\n0 impropers\n");
   // There are maxDepth-2 total types of prisms + dummy
   if (doShapeMatching) {
-    outputFile << 2 * maxDepth - 2 << " atom types\n";
+    outputFile.print("{} atom types\n", 2 * maxDepth - 2);
   } else {
-    outputFile << maxDepth << " atom types\n";
+    outputFile.print("{} atom types\n", maxDepth);
   }
   // Bond types
-  outputFile
-      << bondTypes
-      << " bond types\n0 angle types\n0 dihedral types\n0 improper types\n";
+  outputFile.print(
+      "{} bond types\n0 angle types\n0 dihedral types\n0 improper types\n",
+      bondTypes);
   // Box lengths
-  outputFile << yCloud->boxLow[0] << " " << yCloud->boxLow[0] + yCloud->box[0]
-             << " xlo xhi\n";
-  outputFile << yCloud->boxLow[1] << " " << yCloud->boxLow[1] + yCloud->box[1]
-             << " ylo yhi\n";
-  outputFile << yCloud->boxLow[2] << " " << yCloud->boxLow[2] + yCloud->box[2]
-             << " zlo zhi\n";
+  printDataBox(outputFile, yCloud);
   // Masses
-  outputFile << "\nMasses\n\n";
-  outputFile << "1 15.999400 # dummy\n";
-  outputFile << "2 1.0 # mixedRings \n";
+  outputFile.print("\nMasses\n\n");
+  outputFile.print("1 15.999400 # dummy\n");
+  outputFile.print("2 1.0 # mixedRings \n");
   // There are maxDepth-2 other prism types
   for (int ringSize = 3; ringSize <= maxDepth; ringSize++) {
-    outputFile << ringSize << " 15.999400 # prism" << ringSize << "\n";
+    outputFile.print("{} 15.999400 # prism{}\n", ringSize, ringSize);
   } // end of writing out perfect atom types
   // Write out the types for the deformed prism blocks
   if (doShapeMatching) {
     for (int ringSize = maxDepth + 1; ringSize <= 2 * maxDepth - 2;
          ringSize++) {
       int p = ringSize - maxDepth + 2;
-      outputFile << ringSize << " 15.999400 # deformPrism" << p << "\n";
+      outputFile.print("{} 15.999400 # deformPrism{}\n", ringSize, p);
     } // end of writing out perfect atom types
   }   // Deformed prism types
   // Atoms
-  outputFile << "\nAtoms\n\n";
+  outputFile.print("\nAtoms\n\n");
   // -------
   // Write out the atom coordinates
   // Loop through atoms
-  for (int i = 0; i < yCloud->pts.size(); i++) {
-    iatom =
-        yCloud->pts[i].atomID; // The actual ID can be different from the index
-    // Write out coordinates
+  for (int k = 0; k < yCloud->pts.size(); k++) {
+    int i = molSys::fileIndex(yCloud, k); // In the order read in
+    // The actual ID can be different from the index
     // atomID molecule-tag atom-type q x y z
-    outputFile << iatom << " " << yCloud->pts[i].molID << " " << atomTypes[i]
-               << " 0 " << yCloud->pts[i].x << " " << yCloud->pts[i].y << " "
-               << yCloud->pts[i].z << "\n";
+    outputFile.print("{} {} {} 0 {:g} {:g} {:g}\n", yCloud->pts[i].atomID,
+                     yCloud->pts[i].molID, atomTypes[i], yCloud->pts[i].x,
+                     yCloud->pts[i].y, yCloud->pts[i].z);
 
   } // end of loop through all atoms in pointCloud
 
   // Print the bonds now!
-  outputFile << "\nBonds\n\n";
-  // Loop through all bonds
-  for (int ibond = 0; ibond < bonds.size(); ibond++) {
-    //
-    outputFile << ibond + 1 << " 1 " << bonds[ibond][0] << " "
-               << bonds[ibond][1] << "\n";
-  } // end of for loop for bonds
+  printDataBonds(outputFile, bonds);
 
-  outputFile.close();
   // Once the datafile has been printed, exit
   return 0;
 }
@@ -1662,13 +1709,16 @@ int sout::writeLAMMPSdataAllRings(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<std::vector<int>> nList, std::vector<int> atomTypes,
     int maxDepth, std::string path, bool isMonolayer) {
+  // ----------------
+  // Record into the binary trajectory instead, if there is one
+  if (sbin::isEnabled()) {
+    sbin::recordAtomClass(yCloud, atomTypes);
+    return 0;
+  }
   //
-  std::ofstream outputFile;
-  int iatom; // Index, not atom ID
   int bondTypes = 1;
   // Bond stuff
-  std::vector<std::vector<int>> bonds; // Vector of vector, with each row
-                                       // containing the atom IDs of each bond
+  bond::BondList bonds; // Packed bonds, by atom ID
   std::string filename =
       "system-rings-" + std::to_string(yCloud->currentFrame) + ".data";
   std::string pathName, pathFolder;
@@ -1688,14 +1738,14 @@ int sout::writeLAMMPSdataAllRings(
     pathName = "bulkTopo/dataFiles/";
   }
   
-  sout::makePath(path);
+  sout::ensurePath(path);
   std::string outputDirName = path + pathFolder;
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   outputDirName = path + pathName;
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
 
   // Write output to file inside the output directory
-  outputFile.open(path + pathName + filename);
+  sout::OutputSink outputFile(path + pathName + filename);
 
   // FORMAT:
   //  Comment Line
@@ -1726,62 +1776,46 @@ int sout::writeLAMMPSdataAllRings(
   // -------
   // Write the header
   // Write comment line
-  outputFile << "Written out by D-SEAMS\n";
+  outputFile.print("Written out by D-SEAMS\n");
   // Write out the number of atoms
-  outputFile << yCloud->pts.size() << " "
-             << "atoms"
-             << "\n";
+  outputFile.print("{} atoms\n", yCloud->pts.size());
   // Number of bonds
-  outputFile << bonds.size() << " bonds"
-             << "\n";
-  outputFile << "0 angles\n0 dihedrals\n0 impropers\n";
+  outputFile.print("{} bonds\n", bonds.size());
+  outputFile.print("0 angles\n0 dihedrals\n0 impropers\n");
   // There are maxDepth-2 total types of prisms + dummy
-  outputFile << maxDepth << " atom types\n";
+  outputFile.print("{} atom types\n", maxDepth);
   // Bond types
-  outputFile
-      << bondTypes
-      << " bond types\n0 angle types\n0 dihedral types\n0 improper types\n";
+  outputFile.print(
+      "{} bond types\n0 angle types\n0 dihedral types\n0 improper types\n",
+      bondTypes);
   // Box lengths
-  outputFile << yCloud->boxLow[0] << " " << yCloud->boxLow[0] + yCloud->box[0]
-             << " xlo xhi\n";
-  outputFile << yCloud->boxLow[1] << " " << yCloud->boxLow[1] + yCloud->box[1]
-             << " ylo yhi\n";
-  outputFile << yCloud->boxLow[2] << " " << yCloud->boxLow[2] + yCloud->box[2]
-             << " zlo zhi\n";
+  printDataBox(outputFile, yCloud);
   // Masses
-  outputFile << "\nMasses\n\n";
-  outputFile << "1 15.999400 # dummy\n";
-  outputFile << "2 1.0 # \n";
+  outputFile.print("\nMasses\n\n");
+  outputFile.print("1 15.999400 # dummy\n");
+  outputFile.print("2 1.0 # \n");
   // There are maxDepth-2 other prism types
   for (int ringSize = 3; ringSize <= maxDepth; ringSize++) {
-    outputFile << ringSize << " 15.999400 # ring" << ringSize << "\n";
+    outputFile.print("{} 15.999400 # ring{}\n", ringSize, ringSize);
   } // end of writing out atom types
   // Atoms
-  outputFile << "\nAtoms\n\n";
+  outputFile.print("\nAtoms\n\n");
   // -------
   // Write out the atom coordinates
   // Loop through atoms
-  for (int i = 0; i < yCloud->pts.size(); i++) {
-    iatom =
-        yCloud->pts[i].atomID; // The actual ID can be different from the index
-    // Write out coordinates
+  for (int k = 0; k < yCloud->pts.size(); k++) {
+    int i = molSys::fileIndex(yCloud, k); // In the order read in
+    // The actual ID can be different from the index
     // atomID molecule-tag atom-type q x y z
-    outputFile << iatom << " " << yCloud->pts[i].molID << " " << atomTypes[i]
-               << " 0 " << yCloud->pts[i].x << " " << yCloud->pts[i].y << " "
-               << yCloud->pts[i].z << "\n";
+    outputFile.print("{} {} {} 0 {:g} {:g} {:g}\n", yCloud->pts[i].atomID,
+                     yCloud->pts[i].molID, atomTypes[i], yCloud->pts[i].x,
+                     yCloud->pts[i].y, yCloud->pts[i].z);
 
   } // end of loop through all atoms in pointCloud
 
   // Print the bonds now!
-  outputFile << "\nBonds\n\n";
-  // Loop through all bonds
-  for (int ibond = 0; ibond < bonds.size(); ibond++) {
-    //
-    outputFile << ibond + 1 << " 1 " << bonds[ibond][0] << " "
-               << bonds[ibond][1] << "\n";
-  } // end of for loop for bonds
+  printDataBonds(outputFile, bonds);
 
-  outputFile.close();
   // Once the datafile has been printed, exit
   return 0;
 }
@@ -1806,8 +1840,7 @@ int sout::writeLAMMPSdataPrisms(
   int jatom; // Array index is 1 less than the ID (index for dummy atom)
   int bondTypes = 1;
   // Bond stuff
-  std::vector<std::vector<int>> bonds; // Vector of vector, with each row
-                                       // containing the atom IDs of each bond
+  bond::BondList bonds; // Packed bonds, by atom ID
   bool atomOne, atomTwo;               // If bond atoms are in the prism or not
   bool isPrismBond;
 
@@ -1816,12 +1849,14 @@ int sout::writeLAMMPSdataPrisms(
   if (listPrism.size() == 0) {
     return 1;
   }
+  // Atoms in the order of the trajectory
+  rings = ringsInFileOrder(rings, yCloud);
 
   // ---------------
   // Get the bonds
   if (useBondFile) {
     // Bonds from file
-    bonds = sinp::readBonds(bondFile);
+    bonds = bond::packBonds(sinp::readBonds(bondFile));
   } // get bonds from file
   else {
     bonds = bond::populateBonds(nList, yCloud);
@@ -1927,7 +1962,8 @@ int sout::writeLAMMPSdataPrisms(
   // Write out the atom coordinates
   // Loop through atoms
   for (int i = 0; i < atoms.size(); i++) {
-    iatom = atoms[i] - 1; // The actual index is one less than the ID
+    // The position in the file is one less than the ID
+    iatom = molSys::fileIndex(yCloud, atoms[i] - 1);
     // -----------
     // Pad out
     // Fill in dummy atoms if some have been skipped
@@ -1937,7 +1973,7 @@ int sout::writeLAMMPSdataPrisms(
       // Loop to write out dummy atoms
       for (int j = 0; j < dummyAtoms; j++) {
         dummyID++;
-        jatom = dummyID - 1;
+        jatom = molSys::fileIndex(yCloud, dummyID - 1);
         // 1 molecule-tag atom-type q x y z
         outputFile << dummyID << " " << yCloud->pts[jatom].molID << " 2 0 "
                    << yCloud->pts[jatom].x << " " << yCloud->pts[jatom].y << " "
@@ -1958,7 +1994,7 @@ int sout::writeLAMMPSdataPrisms(
   if (atoms[atoms.size() - 1] != yCloud->nop) {
     //
     for (int id = atoms[atoms.size() - 1] + 1; id <= yCloud->nop; id++) {
-      jatom = id - 1;
+      jatom = molSys::fileIndex(yCloud, id - 1);
       outputFile << id << " " << yCloud->pts[jatom].molID << " 2 0 "
                  << yCloud->pts[jatom].x << " " << yCloud->pts[jatom].y << " "
                  << yCloud->pts[jatom].z << "\n";
@@ -1975,21 +2011,22 @@ int sout::writeLAMMPSdataPrisms(
     atomTwo = false;
     // --------
     // Check if the bond is in the prism or not
-    auto it = std::find(atoms.begin() + 1, atoms.end(), bonds[ibond][0]);
+    auto it = std::find(atoms.begin() + 1, atoms.end(), bonds.first(ibond));
     if (it != atoms.end()) {
       atomOne = true;
-    } else if (bonds[ibond][0] == atoms[0]) {
+    } else if (bonds.first(ibond) == atoms[0]) {
       atomOne = true;
-    } else if (bonds[ibond][0] == atoms[atoms.size() - 1]) {
+    } else if (bonds.first(ibond) == atoms[atoms.size() - 1]) {
       atomOne = true;
     }
 
-    auto it1 = std::find(atoms.begin() + 1, atoms.end(), bonds[ibond][1]);
+    auto it1 =
+        std::find(atoms.begin() + 1, atoms.end(), bonds.second(ibond));
     if (it1 != atoms.end()) {
       atomTwo = true;
-    } else if (bonds[ibond][1] == atoms[0]) {
+    } else if (bonds.second(ibond) == atoms[0]) {
       atomTwo = true;
-    } else if (bonds[ibond][1] == atoms[atoms.size() - 1]) {
+    } else if (bonds.second(ibond) == atoms[atoms.size() - 1]) {
       atomTwo = true;
     }
 
@@ -2001,12 +2038,12 @@ int sout::writeLAMMPSdataPrisms(
     // --------
     if (isPrismBond) {
       // is inside the prism (type 1)
-      outputFile << ibond + 1 << " 1 " << bonds[ibond][0] << " "
-                 << bonds[ibond][1] << "\n";
+      outputFile << ibond + 1 << " 1 " << bonds.first(ibond) << " "
+                 << bonds.second(ibond) << "\n";
     } else {
       // not inside the prism (type 2)
-      outputFile << ibond + 1 << " 2 " << bonds[ibond][0] << " "
-                 << bonds[ibond][1] << "\n";
+      outputFile << ibond + 1 << " 2 " << bonds.first(ibond) << " "
+                 << bonds.second(ibond) << "\n";
     }
 
   } // end of for loop for bonds
@@ -2037,8 +2074,7 @@ int sout::writeLAMMPSdataCages(
   int bondTypes = 1;
   std::string actualCageType; // The actual name of the cage types
   // Bond stuff
-  std::vector<std::vector<int>> bonds; // Vector of vector, with each row
-                                       // containing the atom IDs of each bond
+  bond::BondList bonds; // Packed bonds, by atom ID
   int nRings = 0;                      // Number of rings
 
   // ----------------
@@ -2051,6 +2087,8 @@ int sout::writeLAMMPSdataCages(
   if (numCages == 0) {
     return 1;
   }
+  // Atoms in the order of the trajectory
+  rings = ringsInFileOrder(rings, yCloud);
   // ---------------
   // Get the bonds
   bonds = bond::createBondsFromCages(rings, cageList, type, &nRings);
@@ -2174,7 +2212,8 @@ int sout::writeLAMMPSdataCages(
   // Write out the atom coordinates
   // Loop through atoms
   for (int i = 0; i < atoms.size(); i++) {
-    iatom = atoms[i] - 1; // The actual index is one less than the ID
+    // The position in the file is one less than the ID
+    iatom = molSys::fileIndex(yCloud, atoms[i] - 1);
     // -----------
     // Pad out
     // Fill in dummy atoms if some have been skipped
@@ -2184,7 +2223,7 @@ int sout::writeLAMMPSdataCages(
       // Loop to write out dummy atoms
       for (int j = 0; j < dummyAtoms; j++) {
         dummyID++;
-        jatom = dummyID - 1;
+        jatom = molSys::fileIndex(yCloud, dummyID - 1);
         // 1 molecule-tag atom-type q x y z
         outputFile << dummyID << " " << yCloud->pts[jatom].molID << " 2 0 "
                    << yCloud->pts[jatom].x << " " << yCloud->pts[jatom].y << " "
@@ -2205,7 +2244,7 @@ int sout::writeLAMMPSdataCages(
   if (atoms[atoms.size() - 1] != yCloud->nop) {
     //
     for (int id = atoms[atoms.size() - 1] + 1; id <= yCloud->nop; id++) {
-      jatom = id - 1;
+      jatom = molSys::fileIndex(yCloud, id - 1);
       outputFile << id << " " << yCloud->pts[jatom].molID << " 2 0 "
                  << yCloud->pts[jatom].x << " " << yCloud->pts[jatom].y << " "
                  << yCloud->pts[jatom].z << "\n";
@@ -2217,8 +2256,8 @@ int sout::writeLAMMPSdataCages(
   // Loop through all bonds
   for (int ibond = 0; ibond < bonds.size(); ibond++) {
     // write out the bond
-    outputFile << ibond + 1 << " 1 " << bonds[ibond][0] << " "
-               << bonds[ibond][1] << "\n";
+    outputFile << ibond + 1 << " 1 " << bonds.first(ibond) << " "
+               << bonds.second(ibond) << "\n";
 
   } // end of for loop for bonds
 
@@ -2234,13 +2273,24 @@ int sout::writeLAMMPSdataCages(
  */
 int sout::writeDump(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                     std::string path, std::string outFile) {
-  std::ofstream outputFile;
+  sprof::StageTimer timer("output");
+  // Labels for each molSys::atom_state_type, in the order of the enum
+  static const char *iceLabels[] = {
+      "Ic",          "Ih",             "wat",
+      "intFc",       "clathrate",      "interClathrate",
+      "unclassified", "reIc",          "reIh"};
+  // ----------------
+  // Record into the binary trajectory instead, if there is one
+  if (sbin::isEnabled()) {
+    sbin::recordAtoms(yCloud);
+    return 0;
+  }
   // ----------------
   // Make the output directory if it doesn't exist
-  sout::makePath(path);
+  sout::ensurePath(path);
   // ----------------
-  // Create a new file in the output directory
-  outputFile.open(path + outFile, std::ios_base::app);
+  // The dump file is appended to every frame, so it is kept open
+  sout::OutputSink &outputFile = sout::appendSink(path + outFile);
 
   // Append stuff
   // -----------------------
@@ -2257,100 +2307,77 @@ int sout::writeDump(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
   // -7.9599900000000001e-01 5.0164000000000001e+01
   // ITEM: ATOMS id type x y z
   // 1 1 0 0 0 etc
-  outputFile << "ITEM: TIMESTEP\n";
-  outputFile << yCloud->currentFrame << "\n";
-  outputFile << "ITEM: NUMBER OF ATOMS\n";
-  outputFile << yCloud->nop << "\n";
-  outputFile << "ITEM: BOX BOUNDS pp pp pp\n";
+  outputFile.print("ITEM: TIMESTEP\n{}\n", yCloud->currentFrame);
+  outputFile.print("ITEM: NUMBER OF ATOMS\n{}\n", yCloud->nop);
+  outputFile.print("ITEM: BOX BOUNDS pp pp pp\n");
   for (int k = 0; k < yCloud->boxLow.size(); k++) {
-    outputFile << yCloud->boxLow[k] << " "
-               << yCloud->boxLow[k] + yCloud->box[k]; // print xlo xhi etc
+    // print xlo xhi etc
+    outputFile.print("{:g} {:g}", yCloud->boxLow[k],
+                     yCloud->boxLow[k] + yCloud->box[k]);
     // print out the tilt factors too if it is a triclinic box
     if (yCloud->box.size() == 2 * yCloud->boxLow.size()) {
-      outputFile << " "
-                 << yCloud->box[k + yCloud->boxLow.size()]; // this would be +2
-                                                            // for a 2D box
+      // this would be +2 for a 2D box
+      outputFile.print(" {:g}", yCloud->box[k + yCloud->boxLow.size()]);
     }
-    outputFile << "\n"; // print end of line
-  }                     // end of printing box lengths
-  outputFile << "ITEM: ATOMS id mol type x y z\n";
+    outputFile.print("\n"); // print end of line
+  }                         // end of printing box lengths
+  outputFile.print("ITEM: ATOMS id mol type x y z\n");
   // -----------------------
   // Atom lines
-  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
-    outputFile << yCloud->pts[iatom].atomID << " " << yCloud->pts[iatom].molID;
-
-    // Cubic ice
-    if (yCloud->pts[iatom].iceType == molSys::cubic) {
-      outputFile << " Ic " << yCloud->pts[iatom].x << " "
-                 << yCloud->pts[iatom].y << " " << yCloud->pts[iatom].z << "\n";
-    } // end of cubic ice
-    // Hexagonal ice
-    else if (yCloud->pts[iatom].iceType == molSys::hexagonal) {
-      outputFile << " Ih " << yCloud->pts[iatom].x << " "
-                 << yCloud->pts[iatom].y << " " << yCloud->pts[iatom].z << "\n";
-    } // end hexagonal ice
-    // water
-    else if (yCloud->pts[iatom].iceType == molSys::water) {
-      outputFile << " wat " << yCloud->pts[iatom].x << " "
-                 << yCloud->pts[iatom].y << " " << yCloud->pts[iatom].z << "\n";
-    } // end water
-    // interfacial
-    else if (yCloud->pts[iatom].iceType == molSys::interfacial) {
-      outputFile << " intFc " << yCloud->pts[iatom].x << " "
-                 << yCloud->pts[iatom].y << " " << yCloud->pts[iatom].z << "\n";
-    } // end interfacial
-    // clathrate
-    else if (yCloud->pts[iatom].iceType == molSys::clathrate) {
-      outputFile << " clathrate " << yCloud->pts[iatom].x << " "
-                 << yCloud->pts[iatom].y << " " << yCloud->pts[iatom].z << "\n";
-    } // end clathrate
-    // interClathrate
-    else if (yCloud->pts[iatom].iceType == molSys::interClathrate) {
-      outputFile << " interClathrate " << yCloud->pts[iatom].x << " "
-                 << yCloud->pts[iatom].y << " " << yCloud->pts[iatom].z << "\n";
-    } // end interClathrate
-    // unclassified
-    else if (yCloud->pts[iatom].iceType == molSys::unclassified) {
-      outputFile << " unclassified " << yCloud->pts[iatom].x << " "
-                 << yCloud->pts[iatom].y << " " << yCloud->pts[iatom].z << "\n";
-    } // end unclassified
-    // reCubic
-    else if (yCloud->pts[iatom].iceType == molSys::reCubic) {
-      outputFile << " reIc " << yCloud->pts[iatom].x << " "
-                 << yCloud->pts[iatom].y << " " << yCloud->pts[iatom].z << "\n";
-    } // end reCubic
-    // reHexagonal
-    else {
-      outputFile << " reIh " << yCloud->pts[iatom].x << " "
-                 << yCloud->pts[iatom].y << " " << yCloud->pts[iatom].z << "\n";
-    } // end reHex
-
+  for (int k = 0; k < yCloud->nop; k++) {
+    int iatom = molSys::fileIndex(yCloud, k); // In the order read in
+    int iceType = yCloud->pts[iatom].iceType;
+    // Anything beyond the last label is reclassified as hexagonal
+    if (iceType < molSys::cubic || iceType > molSys::reHex) {
+      iceType = molSys::reHex;
+    }
+    outputFile.print("{} {} {} {:g} {:g} {:g}\n", yCloud->pts[iatom].atomID,
+                     yCloud->pts[iatom].molID, iceLabels[iceType],
+                     yCloud->pts[iatom].x, yCloud->pts[iatom].y,
+                     yCloud->pts[iatom].z);
   } // end of loop through all atoms
 
-  // Close the file
-  outputFile.close();
   return 0;
 }
 
 /**
- * @details Function for printing out values of averaged Q6, averaged Q3 and Cij
- * values
+ * @details Switches the dump of every individual value by sout::writeHisto
+ * (to cij.txt, q3.txt and q6.txt) on or off. It is off by default, since the
+ * histograms accumulated by sout::writeHisto hold the same distributions.
+ * @param[in] on True to dump the values
+ */
+void sout::dumpHistogramValues(bool on) { histogramValues = on; }
+
+/**
+ * @details Adds the Cij values, and the averaged Q3 and Q6 values, of every
+ * atom of the frame to the distributions named cij, q3 and q6 (see
+ * sstat::distribution), which are written out by sstat::writeAll at
+ * checkpoints and at the end of the run. If sout::dumpHistogramValues has
+ * been switched on, the values are also appended, one per line, to cij.txt,
+ * q3.txt and q6.txt.
  */
 int sout::writeHisto(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-                     std::vector<std::vector<int>> nList,
-                     std::vector<double> avgQ6) {
-  std::ofstream cijFile;
-  std::ofstream q3File;
-  std::ofstream q6File;
-  // Create a new file in the output directory
+                     const std::vector<std::vector<int>> &nList,
+                     const std::vector<double> &avgQ6) {
+  sprof::StageTimer timer("output");
+  //
   int nNumNeighbours;
   double avgQ3;
-
-  cijFile.open("cij.txt", std::ofstream::out | std::ofstream::app);
-  q3File.open("q3.txt", std::ofstream::out | std::ofstream::app);
-  q6File.open("q6.txt", std::ofstream::out | std::ofstream::app);
-
-  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
+  bool dumpValues = histogramValues;
+
+  sstat::Distribution &cijDist = sstat::distribution("cij", -1.0, 1.0);
+  sstat::Distribution &q3Dist = sstat::distribution("q3", -1.0, 1.0);
+  sstat::Distribution &q6Dist = sstat::distribution("q6", 0.0, 1.0);
+  // Raw values, only if asked for
+  sout::OutputSink *cijFile = nullptr, *q3File = nullptr, *q6File = nullptr;
+  if (dumpValues) {
+    cijFile = &sout::appendSink("cij.txt");
+    q3File = &sout::appendSink("q3.txt");
+    q6File = &sout::appendSink("q6.txt");
+  } // end of opening the raw dumps
+
+  for (int k = 0; k < yCloud->nop; k++) {
+    int iatom = molSys::fileIndex(yCloud, k); // In the order read in
     if (yCloud->pts[iatom].type != 1) {
       continue;
     }
@@ -2358,19 +2385,22 @@ int sout::writeHisto(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     nNumNeighbours = nList[iatom].size() - 1;
     avgQ3 = 0.0;
     for (int j = 0; j < nNumNeighbours; j++) {
-      cijFile << yCloud->pts[iatom].c_ij[j].c_value << "\n";
-      avgQ3 += yCloud->pts[iatom].c_ij[j].c_value;
+      double cij = yCloud->pts[iatom].c_ij[j].c_value;
+      cijDist.add(cij);
+      if (dumpValues) {
+        cijFile->print("{:g}\n", cij);
+      }
+      avgQ3 += cij;
     } // Loop through neighbours
     avgQ3 /= nNumNeighbours;
-    q3File << avgQ3 << "\n";
-    q6File << avgQ6[iatom] << "\n";
+    q3Dist.add(avgQ3);
+    q6Dist.add(avgQ6[iatom]);
+    if (dumpValues) {
+      q3File->print("{:g}\n", avgQ3);
+      q6File->print("{:g}\n", avgQ6[iatom]);
+    }
   } // loop through all atoms
 
-  // Close the file
-  cijFile.close();
-  q3File.close();
-  q6File.close();
-
   return 0;
 }
 
@@ -2380,12 +2410,9 @@ int sout::writeHisto(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
 int sout::writeCluster(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::string fileName, bool isSlice, int largestIceCluster) {
-  std::ofstream clusterFile;
-  // Create a new file in the output directory
-  clusterFile.open(fileName, std::ofstream::out | std::ofstream::app);
-  clusterFile << yCloud->currentFrame << " " << largestIceCluster << "\n";
-  // Close the file
-  clusterFile.close();
+  // Append to the file, which is kept open for the run
+  sout::appendSink(fileName).print("{} {}\n", yCloud->currentFrame,
+                                   largestIceCluster);
   return 0;
 }
 
@@ -2398,15 +2425,25 @@ int sout::writeLAMMPSdataTopoBulk(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<std::vector<int>> nList, std::vector<cage::iceType> atomTypes,
     std::string path, bool bondsBetweenDummy) {
+  // ----------------
+  // Record into the binary trajectory instead, if there is one. The types are
+  // the same as the atom types in the data file
+  if (sbin::isEnabled()) {
+    std::vector<int> atomClass(atomTypes.size(), 1);
+    for (int i = 0; i < atomTypes.size(); i++) {
+      if (atomTypes[i] >= cage::hc && atomTypes[i] <= cage::mixed2) {
+        atomClass[i] = static_cast<int>(atomTypes[i]) + 1;
+      }
+    } // end of loop through atoms
+    sbin::recordAtomClass(yCloud, atomClass);
+    return 0;
+  }
   //
-  std::ofstream outputFile;
-  int iatom;            // Index, not atom ID
   int currentAtomType;  // Current atom type: a value from 1 to 4
   int numAtomTypes = 6; // DDC, HC, Mixed, dummy, mixed2 and pnc
   int bondTypes = 1;
   // Bond stuff
-  std::vector<std::vector<int>> bonds; // Vector of vector, with each row
-                                       // containing the atom IDs of each bond
+  bond::BondList bonds; // Packed bonds, by atom ID
   std::string filename =
       "system-" + std::to_string(yCloud->currentFrame) + ".data";
 
@@ -2421,14 +2458,14 @@ int sout::writeLAMMPSdataTopoBulk(
   //
   // ----------------
   // Make the output directory if it doesn't exist
-  sout::makePath(path);
+  sout::ensurePath(path);
   std::string outputDirName = path + "bulkTopo";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   outputDirName = path + "bulkTopo/dataFiles/";
-  sout::makePath(outputDirName);
+  sout::ensurePath(outputDirName);
   // ----------------
   // Write output to file inside the output directory
-  outputFile.open(path + "bulkTopo/dataFiles/" + filename);
+  sout::OutputSink outputFile(path + "bulkTopo/dataFiles/" + filename);
   // FORMAT:
   //  Comment Line
   //  4 atoms
@@ -2458,44 +2495,35 @@ int sout::writeLAMMPSdataTopoBulk(
   // -------
   // Write the header
   // Write comment line
-  outputFile << "Written out by D-SEAMS\n";
+  outputFile.print("Written out by D-SEAMS\n");
   // Write out the number of atoms
-  outputFile << yCloud->pts.size() << " "
-             << "atoms"
-             << "\n";
+  outputFile.print("{} atoms\n", yCloud->pts.size());
   // Number of bonds
-  outputFile << bonds.size() << " bonds"
-             << "\n";
-  outputFile << "0 angles\n0 dihedrals\n0 impropers\n";
+  outputFile.print("{} bonds\n", bonds.size());
+  outputFile.print("0 angles\n0 dihedrals\n0 impropers\n");
   // There are maxDepth-2 total types of prisms + dummy
-  outputFile << numAtomTypes << " atom types\n";
+  outputFile.print("{} atom types\n", numAtomTypes);
   // Bond types
-  outputFile
-      << bondTypes
-      << " bond types\n0 angle types\n0 dihedral types\n0 improper types\n";
+  outputFile.print(
+      "{} bond types\n0 angle types\n0 dihedral types\n0 improper types\n",
+      bondTypes);
   // Box lengths
-  outputFile << yCloud->boxLow[0] << " " << yCloud->boxLow[0] + yCloud->box[0]
-             << " xlo xhi\n";
-  outputFile << yCloud->boxLow[1] << " " << yCloud->boxLow[1] + yCloud->box[1]
-             << " ylo yhi\n";
-  outputFile << yCloud->boxLow[2] << " " << yCloud->boxLow[2] + yCloud->box[2]
-             << " zlo zhi\n";
+  printDataBox(outputFile, yCloud);
   // Masses
-  outputFile << "\nMasses\n\n";
-  outputFile << "1 15.999400 # dummy\n";
-  outputFile << "2 15.999400 # hc \n";
-  outputFile << "3 15.999400 # ddc \n";
-  outputFile << "4 15.999400 # mixed \n";
-  outputFile << "5 15.999400 # pnc \n";
-  outputFile << "6 15.999400 # pncHexaMixed \n";
+  outputFile.print("\nMasses\n\n");
+  outputFile.print("1 15.999400 # dummy\n");
+  outputFile.print("2 15.999400 # hc \n");
+  outputFile.print("3 15.999400 # ddc \n");
+  outputFile.print("4 15.999400 # mixed \n");
+  outputFile.print("5 15.999400 # pnc \n");
+  outputFile.print("6 15.999400 # pncHexaMixed \n");
   // Atoms
-  outputFile << "\nAtoms\n\n";
+  outputFile.print("\nAtoms\n\n");
   // -------
   // Write out the atom coordinates
   // Loop through atoms
-  for (int i = 0; i < yCloud->pts.size(); i++) {
-    iatom =
-        yCloud->pts[i].atomID; // The actual ID can be different from the index
+  for (int k = 0; k < yCloud->pts.size(); k++) {
+    int i = molSys::fileIndex(yCloud, k); // In the order read in
     //
     // Get the atom type
     // hc atom type
@@ -2523,21 +2551,16 @@ int sout::writeLAMMPSdataTopoBulk(
     } // dummy
     //
     // Write out coordinates
+    // The actual ID can be different from the index
     // atomID molecule-tag atom-type q x y z
-    outputFile << iatom << " " << yCloud->pts[i].molID << " " << currentAtomType
-               << " 0 " << yCloud->pts[i].x << " " << yCloud->pts[i].y << " "
-               << yCloud->pts[i].z << "\n";
+    outputFile.print("{} {} {} 0 {:g} {:g} {:g}\n", yCloud->pts[i].atomID,
+                     yCloud->pts[i].molID, currentAtomType, yCloud->pts[i].x,
+                     yCloud->pts[i].y, yCloud->pts[i].z);
 
   } // end of loop through all atoms in pointCloud
 
   // Print the bonds now!
-  outputFile << "\nBonds\n\n";
-  // Loop through all bonds
-  for (int ibond = 0; ibond < bonds.size(); ibond++) {
-    //
-    outputFile << ibond + 1 << " 1 " << bonds[ibond][0] << " "
-               << bonds[ibond][1] << "\n";
-  } // end of for loop for bonds
+  printDataBonds(outputFile, bonds);
 
   // Once the datafile has been printed, exit
   return 0;
@@ -2549,45 +2572,27 @@ int sout::writeLAMMPSdataTopoBulk(
  */
 int sout::writeXYZcluster(
     std::string path, molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<int> atoms, int clusterID, cage::cageType type) {
-  //
-  std::ofstream outputFile;
-  std::string filename = "cluster-" + std::to_string(clusterID) + ".xyz";
-  int nAtoms = atoms.size(); // Number of atoms
-  int iatom;                 // Current atom
-  // ----------------
-  // Make the output directory if it doesn't exist
-  sout::makePath(path);
-  std::string outputDirName = path + "bulkTopo";
-  sout::makePath(outputDirName);
-  outputDirName = path + "bulkTopo/clusterXYZ/";
-  sout::makePath(outputDirName);
-  outputDirName = path + "bulkTopo/clusterXYZ/frame-" +
-                  std::to_string(yCloud->currentFrame);
-  sout::makePath(outputDirName);
-  // ----------------
-  // Write output to file inside the output directory
-  outputFile.open(path + "bulkTopo/clusterXYZ/frame-" +
-                  std::to_string(yCloud->currentFrame) + "/" + filename);
+    const std::vector<int> &atoms, int clusterID, cage::cageType type) {
+  printXYZcluster(clusterXYZdir(path, yCloud), yCloud, atoms, clusterID, type);
 
-  // Format of an XYZ file:
-  //  1970
-  // generated by VMD
-  //  O         43.603500       16.926201       15.215700
-  //  O         39.912601       14.775100       19.379200
-  outputFile << nAtoms << "\n"; // Number of atoms
-  outputFile
-      << "Generated by d-SEAMS. 0 type=hc and 1 type =ddc\n"; // Comment line
-  //
-  // Write out all the atom coordinates
-  for (int i = 0; i < nAtoms; i++) {
-    iatom = atoms[i]; // Atom index to be printed out
-    //
-    outputFile << type << " " << yCloud->pts[iatom].x << " "
-               << yCloud->pts[iatom].y << " " << yCloud->pts[iatom].z << "\n";
-  } // end of loop through all atoms
+  return 0;
+}
 
-  outputFile.close();
+/**
+ * @details Writes the XYZ files of all the clusters of the current frame,
+ * numbered from 1 in the order given. The output directory is only set up
+ * once, and every file is handed to the background writer as soon as it has
+ * been formatted.
+ */
+int sout::writeXYZclusters(
+    std::string path, molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    const std::vector<std::vector<int>> &clusterAtoms,
+    const std::vector<cage::cageType> &clusterTypes) {
+  std::string outputDirName = clusterXYZdir(path, yCloud);
+  for (int i = 0; i < clusterAtoms.size(); i++) {
+    printXYZcluster(outputDirName, yCloud, clusterAtoms[i], i + 1,
+                    clusterTypes[i]);
+  } // end of loop through clusters
 
   return 0;
 }
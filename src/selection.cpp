@@ -20,6 +20,161 @@
 // FUNCTIONS FOR SELECTIONS
 // -----------------------------------------------------------------------------------------------------
 
+/**
+ * @details Returns a region which is the volume slice between coordLow and
+ * coordHigh, exactly as checked by sinp::atomInSlice (a dimension with equal
+ * lower and upper limits is not restricted).
+ * This is registered as a Lua function, and is exposed to the user directly.
+ * @param[in] coordLow Contains the lower limits of the slice
+ * @param[in] coordHigh Contains the upper limits of the slice
+ */
+gen::Region gen::slabRegion(std::array<double, 3> coordLow,
+                            std::array<double, 3> coordHigh) {
+  return [coordLow, coordHigh](double x, double y, double z) {
+    return sinp::atomInSlice(x, y, z, coordLow, coordHigh);
+  };
+}
+
+/**
+ * @details Returns a spherical region. Distances are not wrapped across the
+ * periodic boundaries.
+ * This is registered as a Lua function, and is exposed to the user directly.
+ * @param[in] center Coordinates of the center of the sphere
+ * @param[in] radius Radius of the sphere
+ */
+gen::Region gen::sphereRegion(std::array<double, 3> center, double radius) {
+  double rSq = radius * radius;
+  return [center, rSq](double x, double y, double z) {
+    double dx = x - center[0];
+    double dy = y - center[1];
+    double dz = z - center[2];
+    return dx * dx + dy * dy + dz * dz <= rSq;
+  };
+}
+
+/**
+ * @details Returns a cylindrical region of infinite length, whose axis runs
+ * along the dimension axis (0 for x, 1 for y and 2 for z) through center.
+ * Distances are not wrapped across the periodic boundaries.
+ * This is registered as a Lua function, and is exposed to the user directly.
+ * @param[in] center A point on the axis of the cylinder
+ * @param[in] radius Radius of the cylinder
+ * @param[in] axis Dimension along which the cylinder axis runs
+ */
+gen::Region gen::cylinderRegion(std::array<double, 3> center, double radius,
+                                int axis) {
+  double rSq = radius * radius;
+  // The two dimensions perpendicular to the axis
+  int d1 = (axis + 1) % 3;
+  int d2 = (axis + 2) % 3;
+  return [center, rSq, d1, d2](double x, double y, double z) {
+    std::array<double, 3> r = {x, y, z};
+    double da = r[d1] - center[d1];
+    double db = r[d2] - center[d2];
+    return da * da + db * db <= rSq;
+  };
+}
+
+/**
+ * @details Builds a flat index of the atom indices in each molecule, with a
+ * counting sort on the molecule IDs. This replaces repeated lookups in the
+ * multimap from molSys::createMolIDAtomIDMultiMap.
+ * @param[in] yCloud The given input PointCloud
+ */
+gen::MolIndex
+gen::buildMolIndex(molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  //
+  gen::MolIndex molIndex;
+  std::vector<int> fill; // Next free position of each molecule in atoms
+  int k;                 // Position of the molecule
+
+  // Number the molecules and count the atoms in each
+  molIndex.offsets.push_back(0);
+  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
+    auto it = molIndex.molIDindex.emplace(yCloud->pts[iatom].molID,
+                                          molIndex.molIDindex.size());
+    k = it.first->second;
+    if (it.second) {
+      molIndex.offsets.push_back(0);
+    } // new molecule
+    molIndex.offsets[k + 1]++;
+  } // end of loop through atoms
+  // Prefix sum of the counts
+  for (int i = 1; i < molIndex.offsets.size(); i++) {
+    molIndex.offsets[i] += molIndex.offsets[i - 1];
+  } // end of prefix sum
+  // Fill in the atom indices
+  fill.assign(molIndex.offsets.begin(), molIndex.offsets.end() - 1);
+  molIndex.atoms.resize(yCloud->nop);
+  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
+    k = molIndex.molIDindex[yCloud->pts[iatom].molID];
+    molIndex.atoms[fill[k]++] = iatom;
+  } // end of loop through atoms
+
+  return molIndex;
+}
+
+/**
+ * @details Sets the inSlice bool of every atom with the molecule ID molID to
+ * inSliceValue, using a gen::MolIndex built for the same PointCloud.
+ * @param[in] yCloud The given input PointCloud
+ * @param[in] molIndex The flat index of the atoms in each molecule
+ * @param[in] molID The molecule ID
+ * @param[in] inSliceValue The value assigned to the inSlice bools
+ */
+void gen::setMoleculeInSlice(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    const gen::MolIndex &molIndex, int molID, bool inSliceValue) {
+  //
+  auto it = molIndex.molIDindex.find(molID);
+  if (it == molIndex.molIDindex.end()) {
+    return;
+  } // molecule not present
+  int k = it->second;
+  for (int i = molIndex.offsets[k]; i < molIndex.offsets[k + 1]; i++) {
+    yCloud->pts[molIndex.atoms[i]].inSlice = inSliceValue;
+  } // end of loop through atoms of the molecule
+
+  return;
+}
+
+/**
+ * @details Builds the inverted index from atoms to the rings which contain
+ * them, in compressed row form, with two passes over the rings (one to count
+ * and one to fill).
+ * @param[in] rings Vector of vectors of the rings (by atom index)
+ * @param[in] nAtoms Number of atoms in the PointCloud the rings refer to
+ */
+ring::AtomRingIndex
+ring::buildAtomRingIndex(const std::vector<std::vector<int>> &rings,
+                         int nAtoms) {
+  //
+  ring::AtomRingIndex ringIndex;
+  std::vector<int> fill; // Next free position of each atom in rings
+
+  ringIndex.offsets.assign(nAtoms + 1, 0);
+  // Count the rings of each atom
+  for (auto &iring : rings) {
+    for (int iatom : iring) {
+      ringIndex.offsets[iatom + 1]++;
+    } // end of loop through ring members
+  } // end of loop through rings
+  // Prefix sum of the counts
+  for (int i = 1; i <= nAtoms; i++) {
+    ringIndex.offsets[i] += ringIndex.offsets[i - 1];
+  } // end of prefix sum
+  // Fill in the ring indices
+  fill.assign(ringIndex.offsets.begin(), ringIndex.offsets.end() - 1);
+  ringIndex.rings.resize(ringIndex.offsets[nAtoms]);
+  for (int iring = 0; iring < rings.size(); iring++) {
+    for (int iatom : rings[iring]) {
+      ringIndex.rings[fill[iatom]++] = iring;
+    } // end of loop through ring members
+  } // end of loop through rings
+
+  return ringIndex;
+}
+
 /**
  * @details Function that loops through a given input pointCloud and 
  * returns a new pointCloud only containing atoms of a given atom type ID.  
@@ -33,7 +188,7 @@
  * @param[in] coordHigh Contains the upper limits of the slice, if a slice is
  *  to be created
  */
-molSys::PointCloud<molSys::Point<double>, double>
+molSys::PointCloud<molSys::Point<double>, double> &
 gen::getPointCloudOneAtomType(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     molSys::PointCloud<molSys::Point<double>, double> *outCloud,
@@ -76,6 +231,19 @@ gen::getPointCloudOneAtomType(
   // Update the number of particles in the PointCloud
   outCloud->nop = outCloud->pts.size();
 
+  // If the atoms of yCloud have been reordered, the selected atoms keep the
+  // same order, so record the order in which they were read in as well
+  if (!yCloud->fileOrder.empty()) {
+    outCloud->fileOrder.reserve(outCloud->nop);
+    for (int k = 0; k < yCloud->nop; k++) {
+      auto it = outCloud->idIndexMap.find(
+          yCloud->pts[molSys::fileIndex(yCloud, k)].atomID);
+      if (it != outCloud->idIndexMap.end()) {
+        outCloud->fileOrder.push_back(it->second);
+      } // selected atom
+    }   // end of loop through atoms in the order read in
+  }     // reordered atoms
+
   // Box and box lengths 
   outCloud->box = yCloud->box;
   outCloud->boxLow = yCloud->boxLow;
@@ -86,6 +254,161 @@ gen::getPointCloudOneAtomType(
   return *outCloud;
 }
 
+/**
+ * @details Evaluates every region for each atom in turn, so that the
+ * coordinates of the PointCloud are swept through only once, however many
+ * regions (for instance dozens of slabs for a density profile) are given.
+ * The result holds one bitmask per atom, with bit r set if the atom is inside
+ * region r.
+ * @param[in] yCloud The given input PointCloud
+ * @param[in] regions The regions (slabs, spheres, cylinders or any other
+ *  predicates) to evaluate
+ */
+gen::RegionSelection
+gen::selectRegions(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                   const std::vector<gen::Region> &regions) {
+  //
+  gen::RegionSelection selection;
+  std::uint64_t *mask; // Mask of the current atom
+
+  selection.nRegions = regions.size();
+  selection.nWords = (selection.nRegions + 63) / 64;
+  selection.masks.assign(
+      static_cast<std::size_t>(yCloud->nop) * selection.nWords, 0);
+
+  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
+    const auto &point = yCloud->pts[iatom];
+    mask = &selection.masks[static_cast<std::size_t>(iatom) * selection.nWords];
+    for (int r = 0; r < selection.nRegions; r++) {
+      if (regions[r](point.x, point.y, point.z)) {
+        mask[r / 64] |= std::uint64_t{1} << (r % 64);
+      } // the atom is in region r
+    } // end of loop through regions
+  } // end of loop through atoms
+
+  return selection;
+}
+
+/**
+ * @details For every molecule in the gen::MolIndex, the masks of its atoms are
+ * combined with a bitwise OR, and the combined mask is given to each of its
+ * atoms. This handles all the regions of the selection at once, without any
+ * molecule ID lookups. The MolIndex must have been built for the PointCloud
+ * the selection was made from.
+ * @param[in, out] selection The selection, extended to whole molecules
+ * @param[in] molIndex The flat index of the atoms in each molecule
+ */
+void gen::expandToMolecules(gen::RegionSelection &selection,
+                            const gen::MolIndex &molIndex) {
+  //
+  int nWords = selection.nWords;
+  std::vector<std::uint64_t> molMask(nWords); // Combined mask of a molecule
+  std::uint64_t *mask;                        // Mask of an atom
+
+  for (int k = 0; k + 1 < molIndex.offsets.size(); k++) {
+    std::fill(molMask.begin(), molMask.end(), 0);
+    for (int i = molIndex.offsets[k]; i < molIndex.offsets[k + 1]; i++) {
+      mask = &selection.masks[static_cast<std::size_t>(molIndex.atoms[i]) *
+                              nWords];
+      for (int w = 0; w < nWords; w++) {
+        molMask[w] |= mask[w];
+      }
+    } // end of loop through atoms of the molecule
+    for (int i = molIndex.offsets[k]; i < molIndex.offsets[k + 1]; i++) {
+      std::copy(molMask.begin(), molMask.end(),
+                &selection.masks[static_cast<std::size_t>(molIndex.atoms[i]) *
+                                 nWords]);
+    } // end of loop through atoms of the molecule
+  } // end of loop through molecules
+
+  return;
+}
+
+/**
+ * @details Converts a selection into a list of atom indices (in increasing
+ * order) for each region. The lists are counted first, so that each is
+ * allocated only once.
+ * @param[in] selection The selection
+ */
+std::vector<std::vector<int>>
+gen::regionAtomLists(const gen::RegionSelection &selection) {
+  //
+  int nAtoms = selection.nWords > 0 ? selection.masks.size() / selection.nWords
+                                    : 0;
+  std::vector<int> count(selection.nRegions, 0); // Atoms in each region
+  std::vector<std::vector<int>> lists(selection.nRegions);
+
+  for (int iatom = 0; iatom < nAtoms; iatom++) {
+    for (int r = 0; r < selection.nRegions; r++) {
+      count[r] += selection.contains(iatom, r);
+    }
+  } // end of loop through atoms
+  for (int r = 0; r < selection.nRegions; r++) {
+    lists[r].reserve(count[r]);
+  }
+  for (int iatom = 0; iatom < nAtoms; iatom++) {
+    for (int r = 0; r < selection.nRegions; r++) {
+      if (selection.contains(iatom, r)) {
+        lists[r].push_back(iatom);
+      }
+    } // end of loop through regions
+  } // end of loop through atoms
+
+  return lists;
+}
+
+/**
+ * @details Sets the inSlice bool of the atoms inside region r of the
+ * selection to true. The other atoms are set to false if
+ * clearPreviousSliceSelection is true, and are left as they are otherwise.
+ * @param[in] yCloud The PointCloud the selection was made from
+ * @param[in] selection The selection
+ * @param[in] r The region
+ * @param[in] clearPreviousSliceSelection sets the inSlice bool values of atoms
+ *  outside the region to false
+ */
+void gen::setInSliceFromSelection(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    const gen::RegionSelection &selection, int r,
+    bool clearPreviousSliceSelection) {
+  //
+  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
+    if (selection.contains(iatom, r)) {
+      yCloud->pts[iatom].inSlice = true;
+    } else if (clearPreviousSliceSelection) {
+      yCloud->pts[iatom].inSlice = false;
+    }
+  } // end of loop through atoms
+
+  return;
+}
+
+/**
+ * @details Returns the indices of the atoms inside each of the given regions,
+ * found in a single sweep with gen::selectRegions. If wholeMolecules is true,
+ * a gen::MolIndex is built once for the PointCloud and shared by all the
+ * regions, so that every atom of a molecule with at least one atom inside a
+ * region is included.
+ * This is registered as a Lua function, and is exposed to the user directly.
+ * @param[in] yCloud The given input PointCloud
+ * @param[in] regions The regions to evaluate
+ * @param[in] wholeMolecules Extends the regions to whole molecules
+ */
+std::vector<std::vector<int>>
+gen::atomsInRegions(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                    const std::vector<gen::Region> &regions,
+                    bool wholeMolecules) {
+  //
+  gen::RegionSelection selection = gen::selectRegions(yCloud, regions);
+
+  if (wholeMolecules) {
+    gen::expandToMolecules(selection, gen::buildMolIndex(yCloud));
+  } // extend to whole molecules
+
+  return gen::regionAtomLists(selection);
+}
+
+
 /**
  * @details Function that loops through a given input PointCloud and 
  * sets the inSlice bool for every Point according to whether the atom  
@@ -134,8 +457,8 @@ void gen::atomsInSingleSlice(
  * sets the inSlice bool for every Point according to whether the molecule  
  * is in the specified (single) slice or not. If even one atom of a molecule 
  * is inside the region, then all atoms belonging to that molecule should be
- * inside the slice as well (therefore, inSlice would be set to true)
- * NOTE: THIS DOES NOT WORK. ERROR
+ * inside the slice as well (therefore, inSlice would be set to true).
+ * This calls gen::moleculesInRegion with a slab region.
  * @param[in] yCloud The given input PointCloud
  * @param[in] clearPreviousSliceSelection sets all inSlice bool values to false before 
  * adding Points to the slice
@@ -150,60 +473,34 @@ void gen::moleculesInSingleSlice(
     std::array<double, 3> coordLow,
     std::array<double, 3> coordHigh) {
   //
-  bool pointInSlice = true; // If the current point is in the slice, this is true (otherwise this is false)
-  std::unordered_multimap<int, int>
-      molIDAtomIDmap; // Unordered multimap with molecule IDs of the atoms as the keys and the
-                  // atom IDs as the values. More than one atom can have the same molecule ID
-  int iatomMolID; // molID of the current iatom
-  int jatomID;    // atom ID of the current jatom
-  int jatomIndex; // index of jatom
+  gen::moleculesInRegion(yCloud, gen::slabRegion(coordLow, coordHigh),
+                         clearPreviousSliceSelection);
 
-  // --------------------
-  // Get the unordered map of the atom IDs (keys) and the molecular IDs
-  // (values)
-  molIDAtomIDmap = molSys::createMolIDAtomIDMultiMap(yCloud);
-  // --------------------
-  // Set inSlice to false for every atom first
-  if (clearPreviousSliceSelection)
-  {
-    for (int iatom = 0; iatom < yCloud->nop; iatom++) {
-      yCloud->pts[iatom].inSlice = false;
-    }
-  } // end of init
-  // --------------------
+  return;
+}
 
-  // Loop through every iatom and check if the atom is in the slice or not 
-  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
-    // Check if the current atom is in the slice 
-    pointInSlice = sinp::atomInSlice(yCloud->pts[iatom].x, yCloud->pts[iatom].y, yCloud->pts[iatom].z,
-                                               coordLow, coordHigh);
-    //
-    // Set the inSlice bool for the particular Point 
-    if (pointInSlice)
-    {
-      yCloud->pts[iatom].inSlice = true; // iatom is inside the slice
-      // Find mol ID and atoms with that particular molecular ID 
-      iatomMolID = yCloud->pts[iatom].molID; // molecule ID 
-      // -----------
-      // Find all atoms with iatomMolID and set the inSlice bool
-      // to true
-      auto range = molIDAtomIDmap.equal_range(iatomMolID); 
-      // Loop through all atoms with iatomMolID
-      for (auto it = range.first; it != range.second; it++)
-      {
-        // it->second gives the value (in this case, the atom ID)
-        jatomID = it->second; // Atom ID with molecule ID equal to iatomMolID
-        auto gotJ = yCloud->idIndexMap.find(jatomID);
-        jatomIndex = gotJ->second;
-        // Set the jatom inSlice bool to true
-        yCloud->pts[jatomIndex].inSlice = true; // jatomIndex is inside the slice 
-      }
-      // -----------
-    } // the atom is in the slice 
-    else{
-      yCloud->pts[iatom].inSlice = false; // iatom is not in the slice  
-    } // atom is not in the slice
-  }
+/**
+ * @details Function that loops through a given input PointCloud and 
+ * sets the inSlice bool for every Point according to whether the molecule  
+ * is inside the given region or not. If even one atom of a molecule 
+ * is inside the region, then all atoms belonging to that molecule are
+ * inside the selection as well. This is a single-region gen::selectRegions,
+ * extended to whole molecules through a gen::MolIndex.
+ * @param[in] yCloud The given input PointCloud
+ * @param[in] region Predicate which is true for points inside the region
+ * @param[in] clearPreviousSliceSelection sets all inSlice bool values to false before 
+ * adding Points to the selection
+ */
+void gen::moleculesInRegion(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    gen::Region region, bool clearPreviousSliceSelection) {
+  //
+  gen::RegionSelection selection =
+      gen::selectRegions(yCloud, std::vector<gen::Region>{region});
+
+  gen::expandToMolecules(selection, gen::buildMolIndex(yCloud));
+  gen::setInSliceFromSelection(yCloud, selection, 0,
+                               clearPreviousSliceSelection);
 
   return;
 }
@@ -254,6 +551,7 @@ void gen::setAtomsWithSameMolID(
  * of edge atoms which belong to rings that are formed by atoms in the slice. 
  * The output PointCloud may not be the same as the PointCloud used to 
  * construct the nList, and the inSlice bool value can be set for both.
+ * This calls ring::getEdgeMoleculesInRingsRegion with a slab region.
  * @param[in] rings Vector of vectors of the primitive rings (by index) according to oCloud
  * @param[in] oCloud PointCloud of O atoms, used to construct the rings vector of vectors
  * @param[in] yCloud The output PointCloud (may contain more than just the O atoms)
@@ -263,91 +561,94 @@ void gen::setAtomsWithSameMolID(
  * @param[in] coordHigh Contains the upper limits of the slice
  */
 void ring::getEdgeMoleculesInRings(
-    std::vector<std::vector<int>> rings, molSys::PointCloud<molSys::Point<double>, double> *oCloud,
+    const std::vector<std::vector<int>> &rings, molSys::PointCloud<molSys::Point<double>, double> *oCloud,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::array<double, 3> coordLow, std::array<double, 3> coordHigh, bool identicalCloud) {
   //
+  ring::getEdgeMoleculesInRingsRegion(rings, oCloud, yCloud,
+                                      gen::slabRegion(coordLow, coordHigh),
+                                      identicalCloud);
+
+  return;
+}
+
+/**
+ * @details Sets the inSlice bool values of edge atoms which belong to rings
+ * that are formed by atoms inside the region. The rings each atom
+ * participates in are looked up in a ring::AtomRingIndex, and the molecules in
+ * yCloud in a gen::MolIndex, so that the selection is linear in the number of
+ * atoms and ring members. Only the rings of atoms inside the region itself are
+ * added; atoms brought in as edge atoms do not pull in their own rings.
+ * @param[in] rings Vector of vectors of the primitive rings (by index) according to oCloud
+ * @param[in] oCloud PointCloud of O atoms, used to construct the rings vector of vectors
+ * @param[in] yCloud The output PointCloud (may contain more than just the O atoms)
+ * @param[in] region Predicate which is true for points inside the region
+ * @param[in] identicalCloud bool value; if this is true then oCloud and yCloud are the same
+ */
+void ring::getEdgeMoleculesInRingsRegion(
+    const std::vector<std::vector<int>> &rings,
+    molSys::PointCloud<molSys::Point<double>, double> *oCloud,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    gen::Region region, bool identicalCloud) {
+  //
   // A vector of bool values, such that every ring has a value of true (in the slice) or false (not in the slice) 
   std::vector<bool> ringInSlice(rings.size(), false); // all set to false initially.
-  int jatomIndex, jatomID; // Index and ID in oCloud 
-  int jatomIndex1; // Index in yCloud  
-  std::unordered_multimap<int, int>
-      molIDAtomIDmap; // Unordered multimap with molecule IDs of the atoms as the keys and the
-                  // atom IDs as the values. More than one atom can have the same molecule ID
+  std::vector<int> seedAtoms; // Indices of oCloud atoms inside the region
+  ring::AtomRingIndex ringIndex; // Rings of each atom in oCloud
+  gen::MolIndex molIndex;        // Atoms of each molecule in yCloud
+  int iring;                     // Ring index
+  int jatomIndex;                // Index in oCloud
+  int jatomIndex1;               // Index in yCloud
 
   // --------------------
-  // Sets all O atoms within the slice to an inSlice bool value of true. If a single atom of a molecule is in the
-  // slice, then all atoms in the molecule will also be inside the slice 
-  gen::moleculesInSingleSlice(oCloud, true, coordLow, coordHigh);
+  // Sets all O atoms within the region to an inSlice bool value of true. If a single atom of a molecule is in the
+  // region, then all atoms in the molecule will also be inside the selection
+  gen::moleculesInRegion(oCloud, region, true);
   // --------------------
-  // Get the unordered map of the atom IDs (keys) and the molecular IDs
-  // (values)
-  molIDAtomIDmap = molSys::createMolIDAtomIDMultiMap(yCloud);
-  // --------------------
-
-  // Loop through every iatom present in the slice in oCloud
-  // Check to see if iatom is in any ring. If it is present in a ring, set that ring to true 
-  // Change the inSlice bool of every iatom in the ring to true if false. Set also the inSlice bool
-  // of the output cloud if it is not identical. 
-
-  // Loop through every iatom present in the slice in oCloud to determine which rings are in the slice
-  // The indices of oCloud and rings should match (or this will produce unexpected results)
+  // Build the lookups
+  ringIndex = ring::buildAtomRingIndex(rings, oCloud->nop);
+  if (!identicalCloud) {
+    molIndex = gen::buildMolIndex(yCloud);
+  } // only needed to update yCloud
+  // The atoms in the region, before any edge atoms are added
   for (int iatom = 0; iatom < oCloud->nop; iatom++) {
-    // Skip if iatom is not in the slice
-    if (!oCloud->pts[iatom].inSlice)
-    {
-      continue;
-    } // skip for iatom not in slice
-    //
-    // For iatom in the slice, 
-    // loop through all rings to find all the rings it is a part of 
-    for (int iring = 0; iring < rings.size(); iring++)
-    {
+    if (oCloud->pts[iatom].inSlice) {
+      seedAtoms.push_back(iatom);
+    }
+  } // end of loop through oCloud
+  // --------------------
+  // Loop through the rings of every atom in the region, adding the ring
+  // members (and, in yCloud, their molecules) to the selection
+  for (int iatom : seedAtoms) {
+    for (int k = ringIndex.offsets[iatom]; k < ringIndex.offsets[iatom + 1];
+         k++) {
+      iring = ringIndex.rings[k];
       // Skip if iring is in the slice already
-      if (ringInSlice[iring])
-      {
+      if (ringInSlice[iring]) {
         continue;
-      } // skip for iring in slice 
-      // Check and see if iatom is in iring 
-      if(std::find(rings[iring].begin(), rings[iring].end(), iatom)!=rings[iring].end()){
-        // Found iatom; ring is part of the slice 
-        ringInSlice[iring] = true; // update the vector of bool values
-        // --------------------------
-        // Change the inSlice bool of every iatom in oCloud 
-        // (and optionally, yCloud) in the ring to true
-        // Loop through the elements of the ring 
-        for (int j = 0; j < rings[iring].size(); j++)
-        {
-          jatomIndex = rings[iring][j]; // Index of the atom in oCloud 
-          // Set this to true in oCloud 
-          oCloud->pts[jatomIndex].inSlice = true; // part of slice 
-          jatomID = oCloud->pts[jatomIndex].atomID; // Atom ID 
-          // Now if oCloud and yCloud are not the same, use the
-          // atom ID to set the inSlice bool value in yCloud 
-          if (!identicalCloud)
-          {
-            // Find the index corresponding to the same atom in yCloud 
-            auto gotJ = yCloud->idIndexMap.find(jatomID);
-            jatomIndex1 = gotJ->second;
-            // throw if not found ?
-            // Set the jatom inSlice bool to true
-            yCloud->pts[jatomIndex1].inSlice = true; // jatomIndex is inside the slice 
-            // set the inSlice value of all atoms in yCloud with the current molecule ID 
-            gen::setAtomsWithSameMolID(yCloud, molIDAtomIDmap, 
-              yCloud->pts[jatomIndex1].molID, true);
-          } // end of setting values in yCloud 
-        } // end of loop through the elements of the current ring 
-        // --------------------------
-      } // found iatom in the ring
-      //
-    } // end of loop through all rings searching for iatom 
-    //
-  } // end of loop through atoms in oCloud in the slice 
-
-
-  // Optionally add support for molecule slice update if yCloud and oCloud are not identical?
-  // Some other bool?  
-  // IC(ringInSlice);
+      } // skip for iring in slice
+      ringInSlice[iring] = true; // update the vector of bool values
+      // --------------------------
+      // Change the inSlice bool of every atom in the ring to true
+      for (int j = 0; j < rings[iring].size(); j++) {
+        jatomIndex = rings[iring][j]; // Index of the atom in oCloud
+        oCloud->pts[jatomIndex].inSlice = true; // part of slice
+        // Now if oCloud and yCloud are not the same, use the
+        // atom ID to set the inSlice bool value in yCloud
+        if (!identicalCloud) {
+          auto gotJ = yCloud->idIndexMap.find(oCloud->pts[jatomIndex].atomID);
+          if (gotJ == yCloud->idIndexMap.end()) {
+            continue;
+          } // atom not in yCloud
+          jatomIndex1 = gotJ->second;
+          // set the inSlice value of all atoms in yCloud with the current molecule ID
+          gen::setMoleculeInSlice(yCloud, molIndex,
+                                  yCloud->pts[jatomIndex1].molID, true);
+        } // end of setting values in yCloud
+      } // end of loop through the elements of the current ring
+      // --------------------------
+    } // end of loop through the rings of iatom
+  } // end of loop through atoms in oCloud in the region
 
   return;
 }
@@ -373,20 +674,43 @@ void ring::getEdgeMoleculesInRings(
  * @param[in] coordHigh Contains the upper limits of the slice
  */
 void ring::printSliceGetEdgeMoleculesInRings(
-    std::string path, std::vector<std::vector<int>> rings, 
+    std::string path, const std::vector<std::vector<int>> &rings, 
     molSys::PointCloud<molSys::Point<double>, double> *oCloud,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::array<double, 3> coordLow, std::array<double, 3> coordHigh, bool identicalCloud) {
   //
+  ring::printRegionGetEdgeMoleculesInRings(path, rings, oCloud, yCloud,
+                                           gen::slabRegion(coordLow, coordHigh),
+                                           identicalCloud);
+
+  return;
+}
+
+/**
+ * @details Region version of ring::printSliceGetEdgeMoleculesInRings.
+ * Selects the molecules inside the region, together with the edge molecules
+ * of rings formed by atoms inside the region, and writes out their molecule
+ * IDs and a LAMMPS dump file with an inSlice column.
+ * @param[in] rings Vector of vectors of the primitive rings (by index) according to oCloud
+ * @param[in] oCloud PointCloud of O atoms, used to construct the rings vector of vectors
+ * @param[in] yCloud The output PointCloud (may contain more than just the O atoms)
+ * @param[in] region Predicate which is true for points inside the region
+ * @param[in] identicalCloud bool value; if this is true then oCloud and yCloud are the same
+ */
+void ring::printRegionGetEdgeMoleculesInRings(
+    std::string path, const std::vector<std::vector<int>> &rings,
+    molSys::PointCloud<molSys::Point<double>, double> *oCloud,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    gen::Region region, bool identicalCloud) {
+  //
 
   //Given the full yCloud PointCloud, set the inSlice bool for every atom,
-  // if the molecules are inside the specified (single) region. 
-  // gen::atomsInSingleSlice(yCloud, true, coordLow, coordHigh);
-  gen::moleculesInSingleSlice(yCloud, true, coordLow, coordHigh);
+  // if the molecules are inside the region. 
+  gen::moleculesInRegion(yCloud, region, true);
 
-  // Make sure that molecules which participate in the rings inside the slice are also 
+  // Make sure that molecules which participate in the rings inside the region are also 
   // in the selection 
-  ring::getEdgeMoleculesInRings(rings, oCloud, yCloud, coordLow, coordHigh, identicalCloud);
+  ring::getEdgeMoleculesInRingsRegion(rings, oCloud, yCloud, region, identicalCloud);
 
   // Print out the molecule IDs of all the atoms in the slice
   sout::writeMoleculeIDsInSlice(path, yCloud);
@@ -396,8 +720,6 @@ void ring::printSliceGetEdgeMoleculesInRings(
   // Print out the dump of all atoms and molecules, with an inSlice value printed in a separate column
   // H atoms not included in the slice (TODO: fix)
   sout::writeLAMMPSdumpSlice(yCloud, path); 
-  
-  IC(rings[0]);
 
   return;
 }
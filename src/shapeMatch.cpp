@@ -14,13 +14,23 @@
 
 #include <shapeMatch.hpp>
 
+namespace {
+
+// Threads used to shape-match cages and prism blocks, shared by every thread
+std::atomic<int> &currentThreads() {
+  static std::atomic<int> value{1};
+  return value;
+}
+
+} // namespace
+
 /**
  * @details Shape-matching for a pair of polygon basal rings. Returns true if
  * the pair of basal rings form a prism block.
  */
 bool match::matchPrism(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<std::vector<int>> nList, const Eigen::MatrixXd &refPoints,
+    const nneigh::Adjacency &bonded, const Eigen::MatrixXd &refPoints,
     std::vector<int> *basal1, std::vector<int> *basal2,
     std::vector<double> *rmsdPerAtom, bool isPerfect) {
   //
@@ -49,14 +59,14 @@ bool match::matchPrism(
   // -----------------------
   // Getting the target Eigen vectors
   // Get the re-ordered matched basal rings, ordered with respect to each other
-  pntToPnt::relOrderPrismBlock(yCloud, *basal1, *basal2, nList, &matchedBasal1,
-                               &matchedBasal2);
+  pntToPnt::relOrderPrismBlock(yCloud, *basal1, *basal2, bonded,
+                               &matchedBasal1, &matchedBasal2);
   // -----------------------
   // Match the basal rings with a complete prism block, given the relatively
   // ordered basal rings This actually only needs to be done for deformed prism
   // blocks
   bool blockMatch = match::matchPrismBlock(
-      yCloud, nList, refPoints, &matchedBasal1, &matchedBasal2, &startingIndex);
+      yCloud, bonded, refPoints, &matchedBasal1, &matchedBasal2, &startingIndex);
   // -----------------------
   // Check for deformed prisms
   if (!isPerfect) {
@@ -109,9 +119,37 @@ bool match::matchPrism(
  */
 bool match::matchUntetheredPrism(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<std::vector<int>> nList, const Eigen::MatrixXd &refPoints,
+    const nneigh::Adjacency &bonded, const Eigen::MatrixXd &refPoints,
     std::vector<int> *basal1, std::vector<int> *basal2,
     std::vector<double> *rmsdPerAtom) {
+  double rmsd1, rmsd2; // RMSD of each basal ring
+  //
+  if (!match::matchUntetheredPrism(yCloud, bonded, refPoints, basal1, basal2,
+                                   &rmsd1, &rmsd2)) {
+    return false;
+  }
+  // ------------
+  // Update the RMSD (obtained for each ring) for each particle
+  // Basal1
+  match::updateRMSDRing(*basal1, 0, rmsd1, rmsdPerAtom);
+  // Basal2
+  match::updateRMSDRing(*basal2, 0, rmsd2, rmsdPerAtom);
+  // ------------
+
+  return true;
+} // end of function
+
+/**
+ * @details Shape-matching for a pair of polygon basal rings, which only reads
+ * the PointCloud, so that pairs can be matched on several threads at once.
+ * Returns true if the pair of basal rings form a prism block, in which case
+ * rmsdBasal1 and rmsdBasal2 are set to the RMSD of each basal ring.
+ */
+bool match::matchUntetheredPrism(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    const nneigh::Adjacency &bonded, const Eigen::MatrixXd &refPoints,
+    std::vector<int> *basal1, std::vector<int> *basal2, double *rmsdBasal1,
+    double *rmsdBasal2) {
   //
   int ringSize = (*basal1).size(); // Number of nodes in each basal ring
   std::vector<int> matchedBasal1,
@@ -143,7 +181,7 @@ bool match::matchUntetheredPrism(
   // ordered basal rings This actually only needs to be done for deformed prism
   // blocks
   bool blockMatch = match::matchPrismBlock(
-      yCloud, nList, refPoints, &matchedBasal1, &matchedBasal2, &startingIndex);
+      yCloud, bonded, refPoints, &matchedBasal1, &matchedBasal2, &startingIndex);
   // -----------------------
   // Check to see if the prism matches the reference prism block
   if (!blockMatch) {
@@ -172,12 +210,8 @@ bool match::matchUntetheredPrism(
   //   return false;
   // } // If not aligned, it is not a prism block
   // ------------
-  // Update the RMSD (obtained for each ring) for each particle
-  // Basal1
-  match::updateRMSDRing(matchedBasal1, startingIndex, rmsd1, rmsdPerAtom);
-  // Basal2
-  match::updateRMSDRing(matchedBasal2, startingIndex, rmsd2, rmsdPerAtom);
-  // ------------
+  *rmsdBasal1 = rmsd1;
+  *rmsdBasal2 = rmsd2;
 
   return true;
 } // end of function
@@ -250,7 +284,7 @@ int match::updateRMSDRing(std::vector<int> basalRing, int startingIndex,
 //! prism block. Returns true if the pair of basal rings form a prism block.
 bool match::matchPrismBlock(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<std::vector<int>> nList, const Eigen::MatrixXd &refPoints,
+    const nneigh::Adjacency &bonded, const Eigen::MatrixXd &refPoints,
     std::vector<int> *basal1, std::vector<int> *basal2, int *beginIndex) {
   //
   int ringSize = (*basal1).size(); // Number of nodes in the basal rings
@@ -355,3 +389,23 @@ bool match::matchPrismBlock(
   // Return
   return isMatch;
 }
+
+/**
+ * @details Sets the number of threads used from now on to shape-match the
+ * cages in tum3::topoUnitMatchingBulk and the candidate prism blocks in
+ * prism3::findBulkPrisms. The default is a single thread.
+ * @param[in] nThreads Number of threads; 0 uses every hardware thread
+ */
+void match::setThreads(int nThreads) {
+  if (nThreads <= 0) {
+    nThreads =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  currentThreads().store(nThreads);
+}
+
+/**
+ * @details Returns the number of threads used to shape-match cages and prism
+ * blocks.
+ */
+int match::threads() { return currentThreads().load(); }
@@ -13,6 +13,21 @@
 //-----------------------------------------------------------------------------------
 
 #include <topo_bulk.hpp>
+#include <profiling.hpp>
+
+namespace {
+
+// A pair of basal rings found by prism3::findBulkPrisms, for the first basal
+// ring it is stored with
+struct PrismPair {
+  int jring;         // Second basal ring
+  bool isMatched;    // Found by shape-matching (otherwise by the strict
+                     // criteria, without an RMSD)
+  double rmsd1 = -1; // RMSD of the first basal ring
+  double rmsd2 = -1; // RMSD of the second basal ring
+};
+
+} // namespace
 
 // -----------------------------------------------------------------------------------------------------
 // BULK RING SEARCH ONLY
@@ -23,8 +38,8 @@
  * of vectors) of all sizes, upto maxDepth (the largest ring size). 
  * - ring::clearRingList (Clears the vector of vectors for rings of a single
  * type, to prevent excessive memory being blocked).
- * - ring::getSingleRingSize (Fill a vector of vectors for rings of a particular
- * ring size).
+ * - ring::RingsBySize::ofSize (The rings of a particular ring size, without
+ * copying them).
  * - ring::findPrisms (Now that rings of a particular size have been obtained,
  * prism blocks are found and saved).
  * - topoparam::normHeightPercent (Gets the height% for the prism blocks).
@@ -35,20 +50,19 @@
  * current frame, which can be visualized in OVITO).
  * @param[in] path The string to the output directory, in which files will be
  *  written out.
- * @param[in] rings Row-ordered vector of vectors for rings of a single type.
+ * @param[in] rings The primitive rings of all sizes, bucketed by size.
  * @param[in] nList Row-ordered neighbour list by index.
  * @param[in] yCloud The input PointCloud.
  * @param[in] maxDepth The maximum possible size of the primitive rings.
  * @param[in] firstFrame The first frame to be analyzed
  */
 int ring::bulkPolygonRingAnalysis(
-    std::string path, std::vector<std::vector<int>> rings,
-    std::vector<std::vector<int>> nList,
+    std::string path, const ring::RingsBySize &rings,
+    const std::vector<std::vector<int>> &nList,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int maxDepth,
     int firstFrame) {
+  sprof::StageTimer timer("ringStats");
   //
-  std::vector<std::vector<int>>
-      ringsOneType;           // Vector of vectors of rings of a single size
   int nRings;                 // Number of rings of the current type
   std::vector<int> nRingList; // Vector of the values of the number of rings
                               // for a particular frame
@@ -65,10 +79,8 @@ int ring::bulkPolygonRingAnalysis(
   // Run this loop for rings of sizes upto maxDepth
   // The smallest possible ring is of size 3
   for (int ringSize = 3; ringSize <= maxDepth; ringSize++) {
-    // Clear ringsOneType
-    ring::clearRingList(ringsOneType);
-    // Get rings of the current ring size
-    ringsOneType = ring::getSingleRingSize(rings, ringSize);
+    // Rings of the current ring size
+    const std::vector<std::vector<int>> &ringsOneType = rings.ofSize(ringSize);
     //
     // Continue if there are zero rings of ringSize
     if (ringsOneType.size() == 0) {
@@ -86,16 +98,36 @@ int ring::bulkPolygonRingAnalysis(
   } // end of loop through every possible ringSize
 
   // Get the atom types for all the ring types
-  ring::assignPolygonType(rings, &atomTypes, nRingList);
+  for (int ringSize = 0; ringSize <= rings.maxRingSize(); ringSize++) {
+    ring::assignPolygonType(rings.ofSize(ringSize), &atomTypes, nRingList);
+  }
 
   // Write out the ring information
   sout::writeRingNumBulk(path, yCloud->currentFrame, nRingList, maxDepth, firstFrame);
+  // Save the rings to the binary trajectory, if there is one
+  if (sbin::isEnabled()) {
+    sbin::recordRings(yCloud, rings.toVector());
+  }
   // Write out the lammps data file for the particular frame
   sout::writeLAMMPSdataAllRings(yCloud, nList, atomTypes, maxDepth, path, false);
 
   return 0;
 }
 
+/**
+ * @details Sorts the rings (of all sizes) into a ring::RingsBySize, and runs
+ * the bulk ring analysis on it. This is the version registered in Lua, for
+ * scripts which pass the rings as a vector of vectors.
+ */
+int ring::bulkPolygonRingAnalysis(
+    std::string path, const std::vector<std::vector<int>> &rings,
+    const std::vector<std::vector<int>> &nList,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int maxDepth,
+    int firstFrame) {
+  return ring::bulkPolygonRingAnalysis(path, ring::RingsBySize(rings), nList,
+                                       yCloud, maxDepth, firstFrame);
+}
+
 // -----------------------------------------------------------------------------------------------------
 // DDC / HC ALGORITHMS
 // -----------------------------------------------------------------------------------------------------
@@ -106,8 +138,8 @@ int ring::bulkPolygonRingAnalysis(
  * primitive rings which should also be by index. This is registered as a Lua
  * function and is accessible to the user. Internally, this function calls the
  * following functions:
- * - ring::getSingleRingSize (Saves rings of a single ring size into a new
- * vector of vectors, which is subsequently used for finding DDCs, HCs etc).
+ * - ring::RingsBySize::ofSize (The rings of a single ring size, which are
+ * subsequently used for finding DDCs, HCs etc).
  * - ring::findDDC (Finds the DDCs).
  * - ring::findHC (Finds the HCs).
  * - ring::findMixedRings (Finds the mixed rings, which are shared by DDCs and
@@ -122,7 +154,7 @@ int ring::bulkPolygonRingAnalysis(
  * types, into a LAMMPS data file, which can be visualized in OVITO).
  *  @param[in] path The file path of the output directory to which output files
  * will be written.
- *  @param[in] rings Vector of vectors containing the primitive rings. This
+ *  @param[in] rings The primitive rings, bucketed by size. This
  * contains rings of all sizes.
  *  @param[in] nList Row-ordered neighbour list, by index.
  *  @param[in] yCloud The input PointCloud, with respect to which the indices in
@@ -132,10 +164,11 @@ int ring::bulkPolygonRingAnalysis(
  * finding PNCs (false)
  */
 int ring::topoBulkAnalysis(
-    std::string path, std::vector<std::vector<int>> rings,
-    std::vector<std::vector<int>> nList,
+    std::string path, const ring::RingsBySize &rings,
+    const std::vector<std::vector<int>> &nList,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int firstFrame,
     bool onlyTetrahedral) {
+  sprof::StageTimer timer("topoBulk");
   //
   // Ring IDs of each type will be saved in these vectors
   std::vector<int> listDDC; // Vector for ring indices of DDC
@@ -147,8 +180,6 @@ int ring::topoBulkAnalysis(
                 // ringList, of type enum strucType in gen.hpp
   // Make a list of all the DDCs and HCs
   std::vector<cage::Cage> cageList;
-  std::vector<std::vector<int>>
-      ringsOneType;    // Vector of vectors of rings of a single size
   int initRingSize;    // Todo or not: calculate the PNCs or not
   int maxRingSize = 6; // DDCs and HCs are for 6-membered rings
   std::vector<cage::iceType>
@@ -188,10 +219,8 @@ int ring::topoBulkAnalysis(
   // Init
   // Get rings of size 5 or 6.
   for (int ringSize = initRingSize; ringSize <= maxRingSize; ringSize++) {
-    // Clear ringsOneType
-    ring::clearRingList(ringsOneType);
-    // Get rings of the current ring size
-    ringsOneType = ring::getSingleRingSize(rings, ringSize);
+    // Rings of the current ring size
+    const std::vector<std::vector<int>> &ringsOneType = rings.ofSize(ringSize);
     // Skip for zero rings
     if (ringsOneType.size() == 0) {
       continue;
@@ -239,6 +268,12 @@ int ring::topoBulkAnalysis(
     }
   }
 
+  // Save the rings to the binary trajectory, if there is one. These are the
+  // rings of every size, since spipe::Pipeline searches for all of them while
+  // the binary trajectory is open
+  if (sbin::isEnabled()) {
+    sbin::recordRings(yCloud, rings.toVector());
+  }
   // Print out the lammps data file with the bonds
   sout::writeLAMMPSdataTopoBulk(yCloud, nList, atomTypes, path);
   // To output the bonds between dummy atoms, uncomment the following line
@@ -247,6 +282,20 @@ int ring::topoBulkAnalysis(
   return 0;
 }
 
+/**
+ * @details Sorts the rings (of all sizes) into a ring::RingsBySize, and runs
+ * the DDC and HC analysis on it. This is the version registered in Lua, for
+ * scripts which pass the rings as a vector of vectors.
+ */
+int ring::topoBulkAnalysis(
+    std::string path, const std::vector<std::vector<int>> &rings,
+    const std::vector<std::vector<int>> &nList,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int firstFrame,
+    bool onlyTetrahedral) {
+  return ring::topoBulkAnalysis(path, ring::RingsBySize(rings), nList, yCloud,
+                                firstFrame, onlyTetrahedral);
+}
+
 /**
  * @details Determines which hexagonal rings are DDC rings. This function
  * returns a vector which contains the ring IDs of all the rings which are DDC
@@ -650,7 +699,7 @@ bool ring::conditionThreeDDC(std::vector<std::vector<int>> rings,
  */
 std::vector<int> ring::findHC(std::vector<std::vector<int>> rings,
                               std::vector<ring::strucType> *ringType,
-                              std::vector<std::vector<int>> nList,
+                              const std::vector<std::vector<int>> &nList,
                               std::vector<cage::Cage> *cageList) {
   std::vector<int> listHC;
   int totalRingNum = rings.size(); // Total number of hexagonal rings
@@ -666,6 +715,8 @@ std::vector<int> ring::findHC(std::vector<std::vector<int>> rings,
       isPrismatic; // Flag for checking if the ring is prismatic (true) or not
                    // (false), since the basal rings are checked
   isPrismatic.resize(totalRingNum); // Initialized to false
+  // Bonds between atoms, shared by the basal conditions of every ring pair
+  nneigh::Adjacency bonded(nList);
 
   // Two loops through all the rings are required to find pairs of basal rings
   for (int iring = 0; iring < totalRingNum - 1; iring++) {
@@ -699,7 +750,7 @@ std::vector<int> ring::findHC(std::vector<std::vector<int>> rings,
       // neighbour of either the first (index0; l1) or second (index1; l2)
       // element of basal1. If m_k is the nearest neighbour of l1, m_{k+2} and
       // m_{k+4} must be neighbours of l3 and l5(l5 or l3). Modify for l2.
-      cond2 = ring::basalConditions(nList, &basal1, &basal2);
+      cond2 = ring::basalConditions(bonded, &basal1, &basal2);
       if (cond2 == false) {
         continue;
       }
@@ -765,11 +816,9 @@ std::vector<int> ring::findHC(std::vector<std::vector<int>> rings,
 }
 
 /**
- * @details Check to see if two basal rings are HCs or not, using the neighbour
- * list information. The neighbour list nList is a vector of vectors, containing
- * atom indices (not atom IDs!). The first element of each subvector in nList is
- * the atom index of the particle for which the other elements are the nearest
- * neighbours.
+ * @details Check to see if two basal rings are HCs or not, using the bonds
+ * of the neighbour list (by atom index, not atom ID!), looked up in an
+ * nneigh::Adjacency built from it.
  * Internally, the following functions are called:
  * - ring::basalNeighbours (CONDITION1: @f$ m_{k+2} @f$ and @f$ m_{k+4} @f$ must
  * be bonded to @f$ l_3 @f$ and @f$ l_5 @f$ (if @f$ l_1 @f$ is a neighbour) or
@@ -777,13 +826,13 @@ std::vector<int> ring::findHC(std::vector<std::vector<int>> rings,
  * @f$ (if @f$ l_2 @f$ is a neighbour)).
  * - ring::notNeighboursOfRing (CONDITION2: @f$ m_{k+1} @f$, @f$ m_{k+3} @f$ and
  * @f$ m_{k+5}@f$ must NOT be bonded to any element in basal1).
- * @param[in] nList Vector of vectors of the neighbour list (by index).
+ * @param[in] bonded The bonds of the neighbour list (by index).
  * @param[in] basal1 Vector containing the first candidate basal ring.
  * @param[in] basal2 Vector containing the second candidate basal ring.
  * @return A bool; true if the basal rings being tested fulfill this condition
  *  for being the basal rings of an HC.
  */
-bool ring::basalConditions(std::vector<std::vector<int>> nList,
+bool ring::basalConditions(const nneigh::Adjacency &bonded,
                            std::vector<int> *basal1, std::vector<int> *basal2) {
   int l1 = (*basal1)[0]; // first element of basal1 ring
   int l2 = (*basal1)[1]; // second element of basal1 ring
@@ -811,9 +860,8 @@ bool ring::basalConditions(std::vector<std::vector<int>> nList,
 
     // ---------------
     // CHECK IF M_K MATCHES L1 NEIGHBOURS
-    auto it1 = std::find(nList[l1].begin() + 1, nList[l1].end(), m_k);
     // If m_k was found in l1's nList
-    if (it1 != nList[l1].end()) {
+    if (bonded.areBonded(l1, m_k)) {
       compare1 = (*basal1)[2]; // l3
       compare2 = (*basal1)[4]; // l5
       kIndex = k;              // Saving the array index of m_k
@@ -822,9 +870,8 @@ bool ring::basalConditions(std::vector<std::vector<int>> nList,
     } // m_k found in l1's nList
     // ---------------
     // CHECK IF M_K MATCHES L2 NEIGHBOURS
-    auto it2 = std::find(nList[l2].begin() + 1, nList[l2].end(), m_k);
     // If m_k was found in l1's nList
-    if (it2 != nList[l2].end()) {
+    if (bonded.areBonded(l2, m_k)) {
       compare1 = (*basal1)[3]; // l4
       compare2 = (*basal1)[5]; // l6
       kIndex = k;              // Saving the array index of m_k
@@ -868,7 +915,7 @@ bool ring::basalConditions(std::vector<std::vector<int>> nList,
   // neighbour) Basically, this boils down to checking whether compare1 and
   // compare2 are in the neighbour lists of the last two elements of evenTriplet
 
-  isNeigh = ring::basalNeighbours(nList, &evenTriplet, compare1, compare2);
+  isNeigh = ring::basalNeighbours(bonded, &evenTriplet, compare1, compare2);
 
   // If condition1 is not true, then the candidate
   // rings are not part of an HC
@@ -883,7 +930,7 @@ bool ring::basalConditions(std::vector<std::vector<int>> nList,
   // are in the neighbour lists of all the elements of basal1.
 
   // condition 2. This must be true for an HC
-  notNeigh = ring::notNeighboursOfRing(nList, &oddTriplet, basal1);
+  notNeigh = ring::notNeighboursOfRing(bonded, &oddTriplet, basal1);
 
   // If condition2 is not true, the the candidate rings
   // are not part of an HC
@@ -899,13 +946,13 @@ bool ring::basalConditions(std::vector<std::vector<int>> nList,
 /**
  * @details Tests whether the last two elements of a triplet are neighbours of
  *two atom indices which have been passed in as inputs.
- * @param[in] nList Vector of vectors of the neighbour list (by index).
+ * @param[in] bonded The bonds of the neighbour list (by index).
  * @param[in] triplet Vector containing the current triplet being tested.
  * @param[in] atomOne Index of the first atom.
  * @param[in] atomTwo Index of the second atom.
  * @return A bool; true if the condition is met and false otherwise.
  */
-bool ring::basalNeighbours(std::vector<std::vector<int>> nList,
+bool ring::basalNeighbours(const nneigh::Adjacency &bonded,
                            std::vector<int> *triplet, int atomOne,
                            int atomTwo) {
   // Search for needles in a haystack :)
@@ -917,16 +964,13 @@ bool ring::basalNeighbours(std::vector<std::vector<int>> nList,
   // ----------------------------
   // For first element needle1, which must belong to either atomOne's or
   // atomTwo's neighbour list Search atomOne's neighbours
-  auto it =
-      std::find(nList[atomOne].begin() + 1, nList[atomOne].end(), needle1);
-  if (it != nList[atomOne].end()) {
+  if (bonded.areBonded(atomOne, needle1)) {
     neighbourFound = true;
     neighOne = true;
   } // atomOne's neighbour
   // If it is not atomOne's neighbour, it might be atomTwo's neighbour
   if (!neighOne) {
-    it = std::find(nList[atomTwo].begin() + 1, nList[atomTwo].end(), needle1);
-    if (it != nList[atomTwo].end()) {
+    if (bonded.areBonded(atomTwo, needle1)) {
       neighbourFound = true;
       neighTwo = true;
     } // end of check to see if neighbour was found
@@ -942,9 +986,8 @@ bool ring::basalNeighbours(std::vector<std::vector<int>> nList,
   // if atomOne was a neighbour of needle1, needle2 must be a neighbour of
   // atomTwo
   if (neighOne) {
-    it = std::find(nList[atomTwo].begin() + 1, nList[atomTwo].end(), needle2);
     // It is a neighbour
-    if (it != nList[atomTwo].end()) {
+    if (bonded.areBonded(atomTwo, needle2)) {
       return true;
     }
     // It is not a neighbour
@@ -956,9 +999,8 @@ bool ring::basalNeighbours(std::vector<std::vector<int>> nList,
   // if atomTwo was a neighbour of needle1, needle2 must be a neighbour of
   // atomOne
   else {
-    it = std::find(nList[atomOne].begin() + 1, nList[atomOne].end(), needle2);
     // It is a neighbour
-    if (it != nList[atomOne].end()) {
+    if (bonded.areBonded(atomOne, needle2)) {
       return true;
     }
     // It is not a neighbour
@@ -973,18 +1015,17 @@ bool ring::basalNeighbours(std::vector<std::vector<int>> nList,
  * @details Checks to make sure that the elements of the triplet are NOT
  * neighbours of any elements inside a vector (ring) passed in (false)
  * If any of them are neighbours, this function returns false.
- * @param[in] nList Vector of vectors of the neighbour list (by index).
+ * @param[in] bonded The bonds of the neighbour list (by index).
  * @param[in] triplet Vector containing the current triplet being tested.
  * @param[in] ring Ring passed in.
  * @return A bool; true if the condition is met and false otherwise.
  */
-bool ring::notNeighboursOfRing(std::vector<std::vector<int>> nList,
+bool ring::notNeighboursOfRing(const nneigh::Adjacency &bonded,
                                std::vector<int> *triplet,
                                std::vector<int> *ring) {
   int iatom; // AtomID of the atom to be searched for inside the neighbour
              // lists
   int jatom; // AtomID of in whose neighbour list iatom will be searched for
-  std::vector<int>::iterator it;
 
   for (int i = 0; i < (*triplet).size(); i++) {
     iatom = (*triplet)[i]; // AtomID to be searched for
@@ -994,9 +1035,8 @@ bool ring::notNeighboursOfRing(std::vector<std::vector<int>> nList,
       jatom = (*ring)[j];
       // ------------------
       // Search for iatom in the neighbour list of jatom
-      it = std::find(nList[jatom].begin() + 1, nList[jatom].end(), iatom);
       // It is a neighbour!
-      if (it != nList[jatom].end()) {
+      if (bonded.areBonded(jatom, iatom)) {
         return false;
       }
       // ------------------
@@ -1312,7 +1352,10 @@ int ring::getStrucNumbers(std::vector<ring::strucType> ringType,
  * triplets of the basal rings The neighbour list is also required as an input,
  * which is a vector of vectors, containing atom IDs. The first element of the
  * neighbour list is the atom index of
- * the atom for which the other elements are nearest neighbours.\
+ * the atom for which the other elements are nearest neighbours. The ring pairs
+ * are shape-matched on match::threads() threads, and the rings are then
+ * classified (and the RMSD per atom updated) in the order of the pairs, so
+ * that the results are the same for any number of threads.
  * @param[in] rings The input vector of vectors containing the primitive rings
  *  of a single ring size (number of nodes).
  * @param[in] ringType A vector containing a ring::strucType value (a
@@ -1327,13 +1370,10 @@ int ring::getStrucNumbers(std::vector<ring::strucType> ringType,
  */
 int prism3::findBulkPrisms(
     std::vector<std::vector<int>> rings, std::vector<ring::strucType> *ringType,
-    std::vector<std::vector<int>> nList,
+    const std::vector<std::vector<int>> &nList,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
     std::vector<double> *rmsdPerAtom, double heightCutoff) {
   int totalRingNum = rings.size(); // Total number of rings
-  std::vector<int> basal1;         // First basal ring
-  std::vector<int> basal2;         // Second basal ring
-  bool cond1, cond2; // Conditions for rings to be basal (true) or not (false)
   int ringSize = rings[0].size(); // Number of nodes in each ring
   // Matrix for the reference ring for a given ringSize.
   Eigen::MatrixXd refPointSet(ringSize, 3);
@@ -1341,74 +1381,74 @@ int prism3::findBulkPrisms(
   int axialDim = 2; // Default=z
   refPointSet = pntToPnt::getPointSetRefRing(ringSize, axialDim);
   //
-
-  // Two loops through all the rings are required to find pairs of basal rings
+  // Spatial index over the ring centroids, so that only rings close enough to
+  // pass prism3::basalRingsSeparation are paired up
+  ring::RingSpatialIndex ringIndex =
+      ring::buildRingSpatialIndex(rings, yCloud, heightCutoff);
+  // Bonds between atoms, shared by the conditions of every ring pair
+  nneigh::Adjacency bonded(nList);
+
+  // Prism blocks found with each ring as the first basal ring. Every ring is
+  // paired with the rings near it, with the rings spread over
+  // match::threads() threads; the pairs only read the PointCloud and the bonds
+  std::vector<std::vector<PrismPair>> prismPairs(totalRingNum);
+  match::parallelFor(
+      totalRingNum - 1,
+      [&](int iring) {
+        std::vector<int> basal1 = rings[iring]; // First basal ring
+        std::vector<int> basal2;                // Second basal ring
+        // Loop through the nearby rings to get a pair
+        for (int jring : ring::nearbyRings(ringIndex, iring)) {
+          // Step one: Check to see if basal1 and basal2 have common
+          // elements or not. If they don't, then they cannot be basal rings
+          if (ring::hasCommonElements(basal1, rings[jring])) {
+            continue;
+          }
+          basal2 = rings[jring]; // Assign jring to basal2
+
+          // ------------
+          if (!prism3::basalRingsSeparation(yCloud, basal1, basal2,
+                                            heightCutoff)) {
+            continue;
+          } // the basal rings are too far apart
+
+          // Otherwise
+          // Do shape matching here
+          PrismPair pair;
+          pair.jring = jring;
+          pair.isMatched = match::matchUntetheredPrism(
+              yCloud, bonded, refPointSet, &basal1, &basal2, &pair.rmsd1,
+              &pair.rmsd2);
+          // Strict criteria, if shape-matching fails
+          if (!pair.isMatched &&
+              !prism3::basalPrismConditions(bonded, &basal1, &basal2)) {
+            continue;
+          }
+          // Success! The rings are basal rings of a prism!
+          prismPairs[iring].push_back(pair);
+        } // end of loop through rest of the rings to get the second basal ring
+      },
+      64);
+
+  // Classify the rings and update the RMSD per atom in the order of the ring
+  // pairs, so that the first RMSD written for an atom does not depend on the
+  // number of threads
   for (int iring = 0; iring < totalRingNum - 1; iring++) {
-    cond1 = false;
-    cond2 = false;
-    basal1 = rings[iring]; // Assign iring to basal1
-    // Loop through the other rings to get a pair
-    for (int jring = iring + 1; jring < totalRingNum; jring++) {
-      basal2 = rings[jring]; // Assign jring to basal2
-      // ------------
-      // Put extra check for axial basal rings if shapeMatching is being done
-      // ------------
-      // Step one: Check to see if basal1 and basal2 have common
-      // elements or not. If they don't, then they cannot be basal rings
-      cond1 = ring::hasCommonElements(basal1, basal2);
-      if (cond1 == true) {
-        continue;
+    for (const PrismPair &pair : prismPairs[iring]) {
+      // Update iring
+      if ((*ringType)[iring] == ring::unclassified) {
+        (*ringType)[iring] = ring::Prism;
       }
-
-      // ------------
-      bool smallDist =
-          prism3::basalRingsSeparation(yCloud, basal1, basal2, heightCutoff);
-      if (!smallDist) {
-        continue;
-      } // the basal rings are too far apart
-
-      // Otherwise
-      // Do shape matching here
-      bool isPrism = match::matchUntetheredPrism(yCloud, nList, refPointSet,
-                                                 &basal1, &basal2, rmsdPerAtom);
-
-      // Success! The rings are basal rings of a prism!
-      if (isPrism) {
-        //
-        // Update iring
-        if ((*ringType)[iring] == ring::unclassified) {
-          (*ringType)[iring] = ring::Prism;
-        }
-        // Update jring
-        if ((*ringType)[jring] == ring::unclassified) {
-          (*ringType)[jring] = ring::Prism;
-        }
-      } // end of reduced criteria
-      // Strict criteria
-      else {
-        cond2 = prism3::basalPrismConditions(nList, &basal1, &basal2);
-        // If the condition is false then the strict criterion has not been met
-        if (!cond2) {
-          continue;
-        }
-        // Update iring
-        if ((*ringType)[iring] == ring::unclassified) {
-          (*ringType)[iring] = ring::Prism;
-        }
-        // Update jring
-        if ((*ringType)[jring] == ring::unclassified) {
-          (*ringType)[jring] = ring::Prism;
-        }
-        //
-        // Shape-matching to get the RMSD (if shape-matching is desired)
-
-        // bool isKnownPrism = match::matchPrism(
-        //     yCloud, nList, refPointSet, &basal1, &basal2, rmsdPerAtom, true);
-
-        // -----------
-      } // end of strict criteria
-
-    } // end of loop through rest of the rings to get the second basal ring
+      // Update jring
+      if ((*ringType)[pair.jring] == ring::unclassified) {
+        (*ringType)[pair.jring] = ring::Prism;
+      }
+      // The RMSD is only known for prism blocks found by shape-matching
+      if (pair.isMatched) {
+        match::updateRMSDRing(rings[iring], 0, pair.rmsd1, rmsdPerAtom);
+        match::updateRMSDRing(rings[pair.jring], 0, pair.rmsd2, rmsdPerAtom);
+      }
+    } // end of loop through the pairs of iring
   }   // end of loop through all rings for first basal ring
 
   return 0;
@@ -1416,17 +1456,15 @@ int prism3::findBulkPrisms(
 
 /**
  * @details A function that checks to see if two basal rings are basal rings of
- * a prism block or not, using the neighbour list information. The neighbour
- * list nList is a row-ordered vector of vectors, containing atom indices (not
- * atom IDs!). The first element of each subvector in nList is the atom index of
- * the particle for which the other elements are the nearest neighbours.
- * @param[in] nList Row-ordered neighbour list by atom index.
+ * a prism block or not, using the bonds of the neighbour list (by atom index,
+ * not atom ID!), looked up in an nneigh::Adjacency built from it.
+ * @param[in] bonded The bonds of the neighbour list (by atom index).
  * @param[in] basal1 The vector for one of the basal rings.
  * @param[in] basal2 The vector for the other basal ring.
  * @return A value that is true if the basal rings constitute a prism block,
  *  and false if they do not make up a prism block.
  */
-bool prism3::basalPrismConditions(std::vector<std::vector<int>> nList,
+bool prism3::basalPrismConditions(const nneigh::Adjacency &bonded,
                                   std::vector<int> *basal1,
                                   std::vector<int> *basal2) {
   int l1 = (*basal1)[0]; // first element of basal1 ring
@@ -1450,10 +1488,8 @@ bool prism3::basalPrismConditions(std::vector<std::vector<int>> nList,
     // =================================
     // Checking to seee if m_k is be a neighbour of l1
     // Find m_k inside l1 neighbour list
-    auto it = std::find(nList[l1].begin() + 1, nList[l1].end(), m_k);
-
     // If the element has been found, for l1
-    if (it != nList[l1].end()) {
+    if (bonded.areBonded(l1, m_k)) {
       l1_neighbour = true;
       kIndex = k;
       break;
@@ -1483,11 +1519,8 @@ bool prism3::basalPrismConditions(std::vector<std::vector<int>> nList,
 
       // Checking to see if kAtomID is a neighbour of lAtomID
       // Find kAtomID inside lAtomID neighbour list
-      auto it1 =
-          std::find(nList[lAtomID].begin() + 1, nList[lAtomID].end(), kAtomID);
-
       // If the element has been found, for l1
-      if (it1 != nList[lAtomID].end()) {
+      if (bonded.areBonded(lAtomID, kAtomID)) {
         isNeighbour[k] = true;
       }
     } // Loop through basal2
@@ -1513,7 +1546,7 @@ bool prism3::basalPrismConditions(std::vector<std::vector<int>> nList,
  * should exist between the basal
  * rings.
  */
-bool prism3::relaxedPrismConditions(std::vector<std::vector<int>> nList,
+bool prism3::relaxedPrismConditions(const nneigh::Adjacency &bonded,
                                     std::vector<int> *basal1,
                                     std::vector<int> *basal2) {
   int ringSize =
@@ -1533,10 +1566,8 @@ bool prism3::relaxedPrismConditions(std::vector<std::vector<int>> nList,
     for (int m = 0; m < ringSize; m++) {
       m_k = (*basal2)[m];
       // Find m_k inside l_k neighbour list
-      auto it = std::find(nList[l_k].begin() + 1, nList[l_k].end(), m_k);
-
       // If the element has been found, for l1
-      if (it != nList[l_k].end()) {
+      if (bonded.areBonded(l_k, m_k)) {
         isNeighbour = true;
         break;
       } // found element
@@ -1556,7 +1587,8 @@ bool prism3::relaxedPrismConditions(std::vector<std::vector<int>> nList,
 //! Return true if the basal rings are within the heightCutoff
 bool prism3::basalRingsSeparation(
     molSys::PointCloud<molSys::Point<double>, double> *yCloud,
-    std::vector<int> basal1, std::vector<int> basal2, double heightCutoff) {
+    const std::vector<int> &basal1, const std::vector<int> &basal2,
+    double heightCutoff) {
   //
   int ringSize = basal1.size();
   int l_k, m_k; // Atom indices
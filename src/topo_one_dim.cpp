@@ -13,6 +13,7 @@
 //-----------------------------------------------------------------------------------
 
 #include <topo_one_dim.hpp>
+#include <profiling.hpp>
 
 // -----------------------------------------------------------------------------------------------------
 // PRISM ALGORITHMS
@@ -28,8 +29,8 @@
  * following functions internally:
  * - ring::clearRingList (Clears the vector of vectors for rings of a single
  * type, to prevent excessive memory being blocked).
- * - ring::getSingleRingSize (Fill a vector of vectors for rings of a particular
- * ring size).
+ * - ring::RingsBySize::ofSize (The rings of a particular ring size, without
+ * copying them).
  * - ring::findPrisms (Now that rings of a particular size have been obtained,
  * prism blocks are found and saved).
  * - topoparam::normHeightPercent (Gets the height% for the prism blocks).
@@ -40,20 +41,19 @@
  * current frame, which can be visualized in OVITO).
  * @param[in] path The string to the output directory, in which files will be
  *  written out.
- * @param[in] rings Row-ordered vector of vectors for rings of a single type.
+ * @param[in] rings The primitive rings of all sizes, bucketed by size.
  * @param[in] nList Row-ordered neighbour list by index.
  * @param[in] yCloud The input PointCloud.
  * @param[in] maxDepth The maximum possible size of the primitive rings.
  * @param[in] maxDepth The first frame.
  */
 int ring::prismAnalysis(
-    std::string path, std::vector<std::vector<int>> rings,
-    std::vector<std::vector<int>> nList,
+    std::string path, const ring::RingsBySize &rings,
+    const std::vector<std::vector<int>> &nList,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int maxDepth,
     int *atomID, int firstFrame, int currentFrame, bool doShapeMatching) {
+  sprof::StageTimer timer("topoOneDim");
   //
-  std::vector<std::vector<int>>
-      ringsOneType;           // Vector of vectors of rings of a single size
   std::vector<int> listPrism; // Vector for ring indices of n-sided prism
   std::vector<ring::strucType>
       ringType; // This vector will have a value for each ring inside
@@ -91,10 +91,8 @@ int ring::prismAnalysis(
   // Run this loop for rings of sizes upto maxDepth
   // The smallest possible ring is of size 3
   for (int ringSize = 3; ringSize <= maxDepth; ringSize++) {
-    // Clear ringsOneType
-    ring::clearRingList(ringsOneType);
-    // Get rings of the current ring size
-    ringsOneType = ring::getSingleRingSize(rings, ringSize);
+    // Rings of the current ring size
+    const std::vector<std::vector<int>> &ringsOneType = rings.ofSize(ringSize);
     //
     // Continue if there are zero rings of ringSize
     if (ringsOneType.size() == 0) {
@@ -159,6 +157,10 @@ int ring::prismAnalysis(
     sout::writeLAMMPSdumpINT(yCloud, rmsdPerAtom, atomTypes, maxDepth, path);
   } // reassign prism block types for deformed prisms
 
+  // Save the rings to the binary trajectory, if there is one
+  if (sbin::isEnabled()) {
+    sbin::recordRings(yCloud, rings.toVector());
+  }
   // Write out the lammps data file for the particular frame
   sout::writeLAMMPSdataAllPrisms(yCloud, nList, atomTypes, maxDepth, path,
                                  doShapeMatching);
@@ -166,6 +168,21 @@ int ring::prismAnalysis(
   return 0;
 }
 
+/**
+ * @details Sorts the rings (of all sizes) into a ring::RingsBySize, and runs
+ * the prism analysis on it. This is the version registered in Lua, for
+ * scripts which pass the rings as a vector of vectors.
+ */
+int ring::prismAnalysis(
+    std::string path, const std::vector<std::vector<int>> &rings,
+    const std::vector<std::vector<int>> &nList,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int maxDepth,
+    int *atomID, int firstFrame, int currentFrame, bool doShapeMatching) {
+  return ring::prismAnalysis(path, ring::RingsBySize(rings), nList, yCloud,
+                             maxDepth, atomID, firstFrame, currentFrame,
+                             doShapeMatching);
+}
+
 /**
  * @details Determines which rings are n-sided prisms. This function
  * returns a vector which contains the ring indices of all the rings which are
@@ -192,7 +209,8 @@ int ring::prismAnalysis(
 std::vector<int>
 ring::findPrisms(std::vector<std::vector<int>> rings,
                  std::vector<ring::strucType> *ringType, int *nPerfectPrisms,
-                 int *nImperfectPrisms, std::vector<std::vector<int>> nList,
+                 int *nImperfectPrisms,
+                 const std::vector<std::vector<int>> &nList,
                  molSys::PointCloud<molSys::Point<double>, double> *yCloud,
                  std::vector<double> *rmsdPerAtom, bool doShapeMatching) {
   std::vector<int> listPrism;
@@ -202,8 +220,6 @@ ring::findPrisms(std::vector<std::vector<int>> rings,
   bool cond1, cond2; // Conditions for rings to be basal (true) or not (false)
   bool relaxedCond;  // Condition so that at least one bond exists between the
                      // two basal rings
-  bool isAxialPair;  // Basal rings should be parallel in one dimension to
-                     // prevent overcounting
   int ringSize = rings[0].size(); // Number of nodes in each ring
   *nImperfectPrisms = 0;          // Number of undeformed prisms
   *nPerfectPrisms = 0;            // Number of undeformed prisms
@@ -216,37 +232,61 @@ ring::findPrisms(std::vector<std::vector<int>> rings,
                  yCloud->box.begin();
   refPointSet = pntToPnt::getPointSetRefRing(ringSize, axialDim);
   //
+  // Basal rings must be bonded to each other (both the strict and the relaxed
+  // criteria need at least one bond between them), so they can be no further
+  // apart than the longest bond. Only rings that close are paired up, using a
+  // spatial index over the ring centroids.
+  double longestBond = 0.0;
+  for (auto &iring : rings) {
+    for (int iatom : iring) {
+      for (int k = 1; k < nList[iatom].size(); k++) {
+        longestBond = std::max(
+            longestBond, gen::periodicDist(yCloud, iatom, nList[iatom][k]));
+      } // end of loop through neighbours
+    }
+  } // end of finding the longest bond
+  ring::RingSpatialIndex ringIndex =
+      ring::buildRingSpatialIndex(rings, yCloud, longestBond);
+  // Bonds between atoms, shared by the conditions of every ring pair
+  nneigh::Adjacency bonded(nList);
+  // Whether each ring is axial; only needed for the extra check below
+  std::vector<bool> isAxialRing(totalRingNum, true);
+  if (doShapeMatching == true || ringSize == 4) {
+    for (int iring = 0; iring < totalRingNum; iring++) {
+      isAxialRing[iring] = ring::isAxialRing(rings[iring], yCloud);
+    }
+  } // end of precomputing the ring orientations
 
-  // Two loops through all the rings are required to find pairs of basal rings
+  // Loop through all the rings, pairing each with the rings near it, to find
+  // pairs of basal rings
   for (int iring = 0; iring < totalRingNum - 1; iring++) {
     cond1 = false;
     cond2 = false;
+    // ------------
+    // Put extra check for axial basal rings if shapeMatching is being done
+    // (equivalent to ring::discardExtraTetragonBlocks for every pair)
+    if (!isAxialRing[iring]) {
+      continue;
+    }
     basal1 = rings[iring]; // Assign iring to basal1
-    // Loop through the other rings to get a pair
-    for (int jring = iring + 1; jring < totalRingNum; jring++) {
-      basal2 = rings[jring]; // Assign jring to basal2
-      // ------------
-      // Put extra check for axial basal rings if shapeMatching is being done
-      if (doShapeMatching == true || ringSize == 4) {
-        isAxialPair = false; // init
-        isAxialPair =
-            ring::discardExtraTetragonBlocks(&basal1, &basal2, yCloud);
-        if (isAxialPair == false) {
-          continue;
-        }
+    // Loop through the nearby rings to get a pair
+    for (int jring : ring::nearbyRings(ringIndex, iring)) {
+      if (!isAxialRing[jring]) {
+        continue;
       } // end of check for tetragonal prism blocks
       // ------------
       // Step one: Check to see if basal1 and basal2 have common
       // elements or not. If they don't, then they cannot be basal rings
-      cond1 = ring::hasCommonElements(basal1, basal2);
+      cond1 = ring::hasCommonElements(basal1, rings[jring]);
       if (cond1 == true) {
         continue;
       }
+      basal2 = rings[jring]; // Assign jring to basal2
       // -----------
       // Step two and three: One of the elements of basal2 must be the nearest
       // neighbour of the first (index0; l1) If m_k is the nearest neighbour of
       // l1, m_{k+1} ... m_{k+(n-1)} must be neighbours of l_i+1 etc or l_i-1
-      cond2 = ring::basalPrismConditions(nList, &basal1, &basal2);
+      cond2 = ring::basalPrismConditions(bonded, &basal1, &basal2);
       // If cond2 is false, the strict criteria for prisms has not been met
       if (cond2 == false) {
         // Skip if shape-matching is not desired
@@ -256,7 +296,7 @@ ring::findPrisms(std::vector<std::vector<int>> rings,
         //
         // If shape-matching is to be done:
         // Check for the reduced criteria fulfilment
-        relaxedCond = ring::relaxedPrismConditions(nList, &basal1, &basal2);
+        relaxedCond = ring::relaxedPrismConditions(bonded, &basal1, &basal2);
         // Skip if relaxed criteria are not met
         if (relaxedCond == false) {
           continue;
@@ -264,7 +304,7 @@ ring::findPrisms(std::vector<std::vector<int>> rings,
 
         // Do shape matching here
         bool isDeformedPrism = match::matchPrism(
-            yCloud, nList, refPointSet, &basal1, &basal2, rmsdPerAtom, false);
+            yCloud, bonded, refPointSet, &basal1, &basal2, rmsdPerAtom, false);
 
         // Success! The rings are basal rings of a deformed prism!
         if (isDeformedPrism) {
@@ -314,7 +354,7 @@ ring::findPrisms(std::vector<std::vector<int>> rings,
         // Shape-matching to get the RMSD (if shape-matching is desired)
         if (doShapeMatching) {
           bool isKnownPrism = match::matchPrism(
-              yCloud, nList, refPointSet, &basal1, &basal2, rmsdPerAtom, true);
+              yCloud, bonded, refPointSet, &basal1, &basal2, rmsdPerAtom, true);
         } // end of shape-matching to get rmsd
         //
         // // Now write out axial basal rings for convex hull calculations
@@ -338,17 +378,15 @@ ring::findPrisms(std::vector<std::vector<int>> rings,
 
 /**
  * @details A function that checks to see if two basal rings are basal rings of
- * a prism block or not, using the neighbour list information. The neighbour
- * list nList is a row-ordered vector of vectors, containing atom indices (not
- * atom IDs!). The first element of each subvector in nList is the atom index of
- * the particle for which the other elements are the nearest neighbours.
- * @param[in] nList Row-ordered neighbour list by atom index.
+ * a prism block or not, using the bonds of the neighbour list (by atom index,
+ * not atom ID!), looked up in an nneigh::Adjacency built from it.
+ * @param[in] bonded The bonds of the neighbour list (by atom index).
  * @param[in] basal1 The vector for one of the basal rings.
  * @param[in] basal2 The vector for the other basal ring.
  * @return A value that is true if the basal rings constitute a prism block,
  *  and false if they do not make up a prism block.
  */
-bool ring::basalPrismConditions(std::vector<std::vector<int>> nList,
+bool ring::basalPrismConditions(const nneigh::Adjacency &bonded,
                                 std::vector<int> *basal1,
                                 std::vector<int> *basal2) {
   int l1 = (*basal1)[0]; // first element of basal1 ring
@@ -372,10 +410,8 @@ bool ring::basalPrismConditions(std::vector<std::vector<int>> nList,
     // =================================
     // Checking to seee if m_k is be a neighbour of l1
     // Find m_k inside l1 neighbour list
-    auto it = std::find(nList[l1].begin() + 1, nList[l1].end(), m_k);
-
     // If the element has been found, for l1
-    if (it != nList[l1].end()) {
+    if (bonded.areBonded(l1, m_k)) {
       l1_neighbour = true;
       kIndex = k;
       break;
@@ -405,11 +441,8 @@ bool ring::basalPrismConditions(std::vector<std::vector<int>> nList,
 
       // Checking to see if kAtomID is a neighbour of lAtomID
       // Find kAtomID inside lAtomID neighbour list
-      auto it1 =
-          std::find(nList[lAtomID].begin() + 1, nList[lAtomID].end(), kAtomID);
-
       // If the element has been found, for l1
-      if (it1 != nList[lAtomID].end()) {
+      if (bonded.areBonded(lAtomID, kAtomID)) {
         isNeighbour[k] = true;
       }
     } // Loop through basal2
@@ -433,7 +466,7 @@ bool ring::basalPrismConditions(std::vector<std::vector<int>> nList,
  * @details Relaxed criteria for deformed prism blocks: at least one bond should
  * exist between the basal rings.
  */
-bool ring::relaxedPrismConditions(std::vector<std::vector<int>> nList,
+bool ring::relaxedPrismConditions(const nneigh::Adjacency &bonded,
                                   std::vector<int> *basal1,
                                   std::vector<int> *basal2) {
   int ringSize =
@@ -453,10 +486,8 @@ bool ring::relaxedPrismConditions(std::vector<std::vector<int>> nList,
     for (int m = 0; m < ringSize; m++) {
       m_k = (*basal2)[m];
       // Find m_k inside l_k neighbour list
-      auto it = std::find(nList[l_k].begin() + 1, nList[l_k].end(), m_k);
-
       // If the element has been found, for l1
-      if (it != nList[l_k].end()) {
+      if (bonded.areBonded(l_k, m_k)) {
         isNeighbour = true;
         break;
       } // found element
@@ -487,16 +518,31 @@ bool ring::relaxedPrismConditions(std::vector<std::vector<int>> nList,
 bool ring::discardExtraTetragonBlocks(
     std::vector<int> *basal1, std::vector<int> *basal2,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
-  int ringSize =
-      (*basal1).size(); // Size of the ring; each ring contains n elements
-  int iatomIndex,
-      jatomIndex;  // Indices of the elements in basal1 and basal2 respectively
-  double r_i, r_j; // Coordinates in the axial dimension of iatom and jatom of
-                   // basal1 and basal2 respectively
-  int axialDim;    // 0 for x, 1 for y and 2 for z dimensions respectively
-  // Variables for getting the projected area
-  bool axialBasal1, axialBasal2; // bools for checking if basal1 and basal2 are
-                                 // axial (true) respectively
+  // Now check if basal1 and basal2 are axial or not
+  if (ring::isAxialRing(*basal1, yCloud) &&
+      ring::isAxialRing(*basal2, yCloud)) {
+    return true;
+  } else {
+    return false;
+  } // Check for basal1 and basal2
+}
+
+/**
+ * @details Checks whether a ring is oriented perpendicular to the axial
+ * direction (the dimension with the largest box length), i.e. whether its
+ * largest projected area is onto the plane perpendicular to the axial
+ * dimension. This only depends on the ring itself, so that it can be
+ * evaluated once per ring instead of once per pair of rings.
+ * @param[in] basal The ring.
+ * @param[in] yCloud The input PointCloud.
+ * @return True if the ring is axial, and false otherwise.
+ */
+bool ring::isAxialRing(
+    const std::vector<int> &basal,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  int ringSize = basal.size(); // Size of the ring
+  int iatomIndex, jatomIndex;  // Indices of consecutive ring members
+  int axialDim; // 0 for x, 1 for y and 2 for z dimensions respectively
   double areaXY, areaXZ,
       areaYZ; // Projected area on the XY, XZ and YZ planes respectively
   // ----------------------------------------
@@ -509,100 +555,18 @@ bool ring::discardExtraTetragonBlocks(
   axialDim = std::max_element(yCloud->box.begin(), yCloud->box.end()) -
              yCloud->box.begin();
   // ----------------------------------------
-  // Calculate projected area onto the XY, YZ and XZ planes for basal1
-  axialBasal1 = false; // Init to false
-  axialBasal2 = false; // Init
-
-  // Init the projected area
-  areaXY = 0.0;
-  areaXZ = 0.0;
-  areaYZ = 0.0;
-
-  jatomIndex = (*basal1)[0];
-
-  // All points except the first pair
-  for (int k = 1; k < ringSize; k++) {
-    iatomIndex = (*basal1)[k]; // Current vertex
-
-    // Add to the polygon area
-    // ------
-    // XY plane
-    areaXY += (yCloud->pts[jatomIndex].x + yCloud->pts[iatomIndex].x) *
-              (yCloud->pts[jatomIndex].y - yCloud->pts[iatomIndex].y);
-    // ------
-    // XZ plane
-    areaXZ += (yCloud->pts[jatomIndex].x + yCloud->pts[iatomIndex].x) *
-              (yCloud->pts[jatomIndex].z - yCloud->pts[iatomIndex].z);
-    // ------
-    // YZ plane
-    areaYZ += (yCloud->pts[jatomIndex].y + yCloud->pts[iatomIndex].y) *
-              (yCloud->pts[jatomIndex].z - yCloud->pts[iatomIndex].z);
-    // ------
-    jatomIndex = iatomIndex;
-  }
-
-  // Closure point
-  iatomIndex = (*basal1)[0];
-  // ------
-  // XY plane
-  areaXY += (yCloud->pts[jatomIndex].x + yCloud->pts[iatomIndex].x) *
-            (yCloud->pts[jatomIndex].y - yCloud->pts[iatomIndex].y);
-  // ------
-  // XZ plane
-  areaXZ += (yCloud->pts[jatomIndex].x + yCloud->pts[iatomIndex].x) *
-            (yCloud->pts[jatomIndex].z - yCloud->pts[iatomIndex].z);
-  // ------
-  // YZ plane
-  areaYZ += (yCloud->pts[jatomIndex].y + yCloud->pts[iatomIndex].y) *
-            (yCloud->pts[jatomIndex].z - yCloud->pts[iatomIndex].z);
-  // ------
-  // The actual projected area is half of this
-  areaXY *= 0.5;
-  areaXZ *= 0.5;
-  areaYZ *= 0.5;
-  // Get the absolute value
-  areaXY = fabs(areaXY);
-  areaXZ = fabs(areaXZ);
-  areaYZ = fabs(areaYZ);
-
-  // If the axial dimension is x, y, or z:
-  // then the maximum basal area should be in the YZ, XZ and XY dimensions
-  // respectively
-  // x dim
-  if (axialDim == 0) {
-    if (areaYZ > areaXY && areaYZ > areaXZ) {
-      axialBasal1 = true;
-    } // end of check for axial ring for basal1
-  }   // x dim
-  // y dim
-  else if (axialDim == 1) {
-    if (areaXZ > areaXY && areaXZ > areaYZ) {
-      axialBasal1 = true;
-    } // end of check for axial ring for basal1
-  }   // x dim
-  // z dim
-  else if (axialDim == 2) {
-    if (areaXY > areaXZ && areaXY > areaYZ) {
-      axialBasal1 = true;
-    } // end of check for axial ring for basal1
-  }   // x dim
-  else {
-    std::cerr << "Could not find the axial dimension.\n";
-    return false;
-  }
-  // ----------------------------------------
-  // Calculate projected area onto the XY, YZ and XZ planes for basal2
+  // Calculate projected area onto the XY, YZ and XZ planes
 
   // Init the projected area
   areaXY = 0.0;
   areaXZ = 0.0;
   areaYZ = 0.0;
 
-  jatomIndex = (*basal2)[0];
+  jatomIndex = basal[0];
 
-  // All points except the first pair
-  for (int k = 1; k < ringSize; k++) {
-    iatomIndex = (*basal2)[k]; // Current vertex
+  // All points except the first pair, and then the closure point
+  for (int k = 1; k <= ringSize; k++) {
+    iatomIndex = basal[k % ringSize]; // Current vertex
 
     // Add to the polygon area
     // ------
@@ -621,21 +585,6 @@ bool ring::discardExtraTetragonBlocks(
     jatomIndex = iatomIndex;
   }
 
-  // Closure point
-  iatomIndex = (*basal2)[0];
-  // ------
-  // XY plane
-  areaXY += (yCloud->pts[jatomIndex].x + yCloud->pts[iatomIndex].x) *
-            (yCloud->pts[jatomIndex].y - yCloud->pts[iatomIndex].y);
-  // ------
-  // XZ plane
-  areaXZ += (yCloud->pts[jatomIndex].x + yCloud->pts[iatomIndex].x) *
-            (yCloud->pts[jatomIndex].z - yCloud->pts[iatomIndex].z);
-  // ------
-  // YZ plane
-  areaYZ += (yCloud->pts[jatomIndex].y + yCloud->pts[iatomIndex].y) *
-            (yCloud->pts[jatomIndex].z - yCloud->pts[iatomIndex].z);
-  // ------
   // The actual projected area is half of this
   areaXY *= 0.5;
   areaXZ *= 0.5;
@@ -645,40 +594,25 @@ bool ring::discardExtraTetragonBlocks(
   areaXZ = fabs(areaXZ);
   areaYZ = fabs(areaYZ);
 
-  // Check if xy projected area is the greatest
   // If the axial dimension is x, y, or z:
   // then the maximum basal area should be in the YZ, XZ and XY dimensions
   // respectively
   // x dim
   if (axialDim == 0) {
-    if (areaYZ > areaXY && areaYZ > areaXZ) {
-      axialBasal2 = true;
-    } // end of check for axial ring for basal1
-  }   // x dim
+    return areaYZ > areaXY && areaYZ > areaXZ;
+  } // x dim
   // y dim
   else if (axialDim == 1) {
-    if (areaXZ > areaXY && areaXZ > areaYZ) {
-      axialBasal2 = true;
-    } // end of check for axial ring for basal1
-  }   // x dim
+    return areaXZ > areaXY && areaXZ > areaYZ;
+  } // y dim
   // z dim
   else if (axialDim == 2) {
-    if (areaXY > areaXZ && areaXY > areaYZ) {
-      axialBasal2 = true;
-    } // end of check for axial ring for basal1
-  }   // x dim
+    return areaXY > areaXZ && areaXY > areaYZ;
+  } // z dim
   else {
     std::cerr << "Could not find the axial dimension.\n";
     return false;
   }
-  // ----------------------------------------
-
-  // Now check if basal1 and basal2 are axial or not
-  if (axialBasal1 == true && axialBasal2 == true) {
-    return true;
-  } else {
-    return false;
-  } // Check for basal1 and basal2
 }
 
 /**
@@ -1,4 +1,5 @@
 #include <topo_two_dim.hpp>
+#include <profiling.hpp>
 
 // -----------------------------------------------------------------------------------------------------
 // MONOLAYER ALGORITHMS
@@ -14,8 +15,8 @@
  * following functions internally:
  * - ring::clearRingList (Clears the vector of vectors for rings of a single
  * type, to prevent excessive memory being blocked).
- * - ring::getSingleRingSize (Fill a vector of vectors for rings of a particular
- * ring size).
+ * - ring::RingsBySize::ofSize (The rings of a particular ring size, without
+ * copying them).
  * - ring::findPrisms (Now that rings of a particular size have been obtained,
  * prism blocks are found and saved).
  * - topoparam::normHeightPercent (Gets the height% for the prism blocks).
@@ -26,7 +27,7 @@
  * current frame, which can be visualized in OVITO).
  * @param[in] path The string to the output directory, in which files will be
  *  written out.
- * @param[in] rings Row-ordered vector of vectors for rings of a single type.
+ * @param[in] rings The primitive rings of all sizes, bucketed by size.
  * @param[in] nList Row-ordered neighbour list by index.
  * @param[in] yCloud The input PointCloud.
  * @param[in] maxDepth The maximum possible size of the primitive rings.
@@ -35,13 +36,12 @@
  * @param[in] firstFrame The first frame to be analyzed
  */
 int ring::polygonRingAnalysis(
-    std::string path, std::vector<std::vector<int>> rings,
-    std::vector<std::vector<int>> nList,
+    std::string path, const ring::RingsBySize &rings,
+    const std::vector<std::vector<int>> &nList,
     molSys::PointCloud<molSys::Point<double>, double> *yCloud, int maxDepth,
     double sheetArea, int firstFrame) {
+  sprof::StageTimer timer("topoTwoDim");
   //
-  std::vector<std::vector<int>>
-      ringsOneType;           // Vector of vectors of rings of a single size
   int nRings;                 // Number of rings of the current type
   std::vector<int> nRingList; // Vector of the values of the number of prisms
                               // for a particular frame
@@ -69,10 +69,8 @@ int ring::polygonRingAnalysis(
   // Run this loop for rings of sizes upto maxDepth
   // The smallest possible ring is of size 3
   for (int ringSize = 3; ringSize <= maxDepth; ringSize++) {
-    // Clear ringsOneType
-    ring::clearRingList(ringsOneType);
-    // Get rings of the current ring size
-    ringsOneType = ring::getSingleRingSize(rings, ringSize);
+    // Rings of the current ring size
+    const std::vector<std::vector<int>> &ringsOneType = rings.ofSize(ringSize);
     //
     // Continue if there are zero rings of ringSize
     if (ringsOneType.size() == 0) {
@@ -102,13 +100,33 @@ int ring::polygonRingAnalysis(
   } // end of loop through every possible ringSize
 
   // Get the atom types for all the ring types
-  ring::assignPolygonType(rings, &atomTypes, nRingList);
+  for (int ringSize = 0; ringSize <= rings.maxRingSize(); ringSize++) {
+    ring::assignPolygonType(rings.ofSize(ringSize), &atomTypes, nRingList);
+  }
 
   // Write out the ring information
   sout::writeRingNum(path, yCloud->currentFrame, nRingList, coverageAreaXY,
                      coverageAreaXZ, coverageAreaYZ, maxDepth, firstFrame);
+  // Save the rings to the binary trajectory, if there is one
+  if (sbin::isEnabled()) {
+    sbin::recordRings(yCloud, rings.toVector());
+  }
   // Write out the lammps data file for the particular frame
   sout::writeLAMMPSdataAllRings(yCloud, nList, atomTypes, maxDepth, path);
 
   return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @details Sorts the rings (of all sizes) into a ring::RingsBySize, and runs
+ * the polygon ring analysis on it. This is the version registered in Lua, for
+ * scripts which pass the rings as a vector of vectors.
+ */
+int ring::polygonRingAnalysis(
+    std::string path, const std::vector<std::vector<int>> &rings,
+    const std::vector<std::vector<int>> &nList,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int maxDepth,
+    double sheetArea, int firstFrame) {
+  return ring::polygonRingAnalysis(path, ring::RingsBySize(rings), nList,
+                                   yCloud, maxDepth, sheetArea, firstFrame);
+}
@@ -0,0 +1,1013 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <boost/filesystem.hpp>
+
+#include <generic.hpp>
+#include <profiling.hpp>
+#include <seams_input.hpp>
+#include <trajectory_formats.hpp>
+
+namespace {
+
+// -----------------
+// Byte order
+
+// True if the bytes of values in the file are in the opposite order to the
+// ones on this machine. XDR (used by XTC) is always big-endian
+bool hostIsLittleEndian() {
+  const std::uint32_t one = 1;
+  return *reinterpret_cast<const unsigned char *>(&one) == 1;
+}
+
+template <typename T> T byteSwap(T value) {
+  unsigned char *bytes = reinterpret_cast<unsigned char *>(&value);
+  std::reverse(bytes, bytes + sizeof(T));
+  return value;
+}
+
+// Reads n values, swapping their bytes if required
+template <typename T>
+bool readValues(std::ifstream &file, T *values, std::size_t n, bool swap) {
+  file.read(reinterpret_cast<char *>(values), n * sizeof(T));
+  if (!file) {
+    return false;
+  }
+  if (swap) {
+    for (std::size_t i = 0; i < n; i++) {
+      values[i] = byteSwap(values[i]);
+    }
+  }
+  return true;
+}
+
+template <typename T> bool readValue(std::ifstream &file, T &value, bool swap) {
+  return readValues(file, &value, 1, swap);
+}
+
+// -----------------
+// Per-file state
+
+// Where the frames of a trajectory start, along with what is needed to read
+// them. Found once per file, and kept while the file is unchanged
+struct TrajectoryIndex {
+  sinp::TrajectoryFormat format = sinp::TrajectoryFormat::lammpsText;
+  std::uintmax_t fileSize = 0;       // Size when the index was built
+  std::time_t modified = 0;          // Modification time, likewise
+  std::vector<std::int64_t> offsets; // Byte offset of every frame
+  bool swap = false;    // DCD: the byte order is not that of this machine
+  int natoms = 0;       // DCD: number of atoms in every frame
+  bool hasCell = false; // DCD: every frame starts with the unit cell
+  bool has4D = false;   // DCD: every frame has a fourth coordinate
+};
+
+// Atom IDs, molecule IDs and types of the atoms of DCD and XTC frames, sorted
+// by atom ID
+struct Topology {
+  std::vector<int> atomID, molID, type;
+  std::vector<double> box, boxLow;
+};
+
+struct InputRegistry {
+  std::unordered_map<std::string, std::shared_ptr<const TrajectoryIndex>>
+      indices;
+  std::shared_ptr<const Topology> topology = std::make_shared<Topology>();
+  std::mutex mtx;
+};
+
+InputRegistry &registry() {
+  static InputRegistry reg;
+  return reg;
+}
+
+// One frame as stored in the file, before the atoms are filtered into a
+// PointCloud. Empty atomID, molID and type vectors are taken from the topology
+struct RawFrame {
+  std::vector<int> atomID, molID, type;
+  std::vector<double> x, y, z;
+  std::vector<double> box, boxLow; // As in the LAMMPS text readers
+};
+
+// Fills the box as the LAMMPS text readers do: the lengths and lower corner of
+// the bounding box, followed by the tilt factors for a triclinic box. lo is
+// the lower corner of the (untilted) box
+void setBox(RawFrame &frame, std::array<double, 3> lo, double lx, double ly,
+            double lz, double xy, double xz, double yz) {
+  if (xy == 0.0 && xz == 0.0 && yz == 0.0) {
+    frame.box = {lx, ly, lz};
+    frame.boxLow = {lo[0], lo[1], lo[2]};
+    return;
+  }
+  double xMin = std::min({0.0, xy, xz, xy + xz});
+  double xMax = std::max({0.0, xy, xz, xy + xz});
+  double yMin = std::min(0.0, yz);
+  double yMax = std::max(0.0, yz);
+  frame.box = {lx + xMax - xMin, ly + yMax - yMin, lz, xy, xz, yz};
+  frame.boxLow = {lo[0] + xMin, lo[1] + yMin, lo[2]};
+}
+
+// Lower corner of the box for formats which do not store it
+std::array<double, 3> topologyOrigin(const Topology &topology) {
+  if (topology.boxLow.size() < 3) {
+    return {0.0, 0.0, 0.0};
+  }
+  return {topology.boxLow[0], topology.boxLow[1], topology.boxLow[2]};
+}
+
+// -----------------
+// DCD
+
+// Reads a Fortran record marker (the length of the following record)
+bool dcdMarker(std::ifstream &file, bool swap, std::int32_t &length) {
+  return readValue(file, length, swap);
+}
+
+// Reads the header, and works out the offsets of the frames, which all have
+// the same size
+int indexDCD(const std::string &filename, TrajectoryIndex &index) {
+  std::ifstream file(filename, std::ios::binary);
+  std::int32_t marker, endMarker;
+  if (!readValue(file, marker, false)) {
+    std::cerr << "Could not read the DCD header of " << filename << ".\n";
+    return 1;
+  }
+  if (marker != 84) {
+    if (byteSwap(marker) != 84) {
+      std::cerr << filename << " is not a DCD file.\n";
+      return 1;
+    }
+    index.swap = true;
+  }
+  char cord[4];
+  std::int32_t icntrl[20];
+  file.read(cord, 4);
+  if (!readValues(file, icntrl, 20, index.swap) ||
+      !dcdMarker(file, index.swap, endMarker) ||
+      std::string(cord, 4) != "CORD") {
+    std::cerr << filename << " is not a DCD file.\n";
+    return 1;
+  }
+  bool charmm = icntrl[19] != 0;
+  index.hasCell = charmm && icntrl[10] != 0;
+  index.has4D = charmm && icntrl[11] != 0;
+  if (icntrl[8] != 0) {
+    std::cerr << "DCD files with fixed atoms are not supported.\n";
+    return 1;
+  }
+  // Title block
+  if (!dcdMarker(file, index.swap, marker)) {
+    return 1;
+  }
+  file.seekg(marker + 4, std::ios::cur);
+  // Number of atoms
+  std::int32_t natoms;
+  if (!dcdMarker(file, index.swap, marker) ||
+      !readValue(file, natoms, index.swap) ||
+      !dcdMarker(file, index.swap, endMarker)) {
+    std::cerr << "Could not read the number of atoms in " << filename
+              << ".\n";
+    return 1;
+  }
+  index.natoms = natoms;
+  // Every frame has the same size
+  std::int64_t first = file.tellg();
+  std::int64_t frameBytes =
+      (index.hasCell ? 56 : 0) +
+      (index.has4D ? 4 : 3) * (8 + 4 * static_cast<std::int64_t>(natoms));
+  std::int64_t nFrames =
+      (static_cast<std::int64_t>(index.fileSize) - first) / frameBytes;
+  for (std::int64_t i = 0; i < nFrames; i++) {
+    index.offsets.push_back(first + i * frameBytes);
+  }
+  return 0;
+}
+
+int readDCDframe(std::ifstream &file, const TrajectoryIndex &index,
+                 const Topology &topology, RawFrame &frame) {
+  std::int32_t marker;
+  // Unit cell: A, cos(gamma), B, cos(beta), cos(alpha), C
+  std::array<double, 6> cell = {0, 0, 0, 0, 0, 0};
+  if (index.hasCell) {
+    if (!dcdMarker(file, index.swap, marker) ||
+        !readValues(file, cell.data(), 6, index.swap) ||
+        !dcdMarker(file, index.swap, marker)) {
+      return 1;
+    }
+  }
+  std::vector<float> coord(index.natoms);
+  std::vector<double> *xyz[3] = {&frame.x, &frame.y, &frame.z};
+  for (int k = 0; k < 3; k++) {
+    if (!dcdMarker(file, index.swap, marker) ||
+        !readValues(file, coord.data(), coord.size(), index.swap) ||
+        !dcdMarker(file, index.swap, marker)) {
+      return 1;
+    }
+    xyz[k]->assign(coord.begin(), coord.end());
+  } // end of reading x, y and z
+  // -----------------
+  // Box
+  if (!index.hasCell) {
+    frame.box = topology.box;
+    frame.boxLow = topology.boxLow;
+    return 0;
+  }
+  // Angles are stored either as cosines or in degrees
+  for (int k : {1, 3, 4}) {
+    if (std::fabs(cell[k]) > 1.0) {
+      cell[k] = std::cos(cell[k] * M_PI / 180.0);
+    }
+  }
+  double lx = cell[0];
+  double xy = cell[2] * cell[1];
+  double ly = std::sqrt(cell[2] * cell[2] - xy * xy);
+  double xz = cell[5] * cell[3];
+  double yz = (cell[2] * cell[5] * cell[4] - xy * xz) / ly;
+  double lz = std::sqrt(cell[5] * cell[5] - xz * xz - yz * yz);
+  // Rounding errors of the cosines of right angles
+  double tiny = 1e-8 * std::max({lx, ly, lz});
+  xy = std::fabs(xy) < tiny ? 0.0 : xy;
+  xz = std::fabs(xz) < tiny ? 0.0 : xz;
+  yz = std::fabs(yz) < tiny ? 0.0 : yz;
+  setBox(frame, topologyOrigin(topology), lx, ly, lz, xy, xz, yz);
+  return 0;
+}
+
+// -----------------
+// XTC
+
+const std::int32_t xtcMagic = 1995;
+
+// Size of the XDR opaque data holding nBytes bytes
+std::int64_t xdrPadded(std::int64_t nBytes) { return (nBytes + 3) / 4 * 4; }
+
+// Skips from frame header to frame header
+int indexXTC(const std::string &filename, TrajectoryIndex &index) {
+  std::ifstream file(filename, std::ios::binary);
+  bool swap = hostIsLittleEndian();
+  std::int64_t offset = 0;
+  while (offset < static_cast<std::int64_t>(index.fileSize)) {
+    std::int32_t header[4]; // magic, natoms, step, time
+    file.seekg(offset);
+    if (!readValues(file, header, 4, swap)) {
+      break;
+    }
+    if (header[0] != xtcMagic) {
+      std::cerr << "Frame " << index.offsets.size() + 1 << " of " << filename
+                << " is not an XTC frame.\n";
+      return 1;
+    }
+    // Box (9 floats), then the number of atoms again
+    std::int32_t lsize;
+    file.seekg(offset + 52);
+    if (!readValue(file, lsize, swap)) {
+      break;
+    }
+    std::int64_t frameBytes;
+    if (lsize <= 9) {
+      frameBytes = 56 + 12 * static_cast<std::int64_t>(lsize);
+    } else {
+      // precision, minint[3], maxint[3] and smallidx, then the byte count
+      std::int32_t nBytes;
+      file.seekg(offset + 88);
+      if (!readValue(file, nBytes, swap)) {
+        break;
+      }
+      frameBytes = 92 + xdrPadded(nBytes);
+    }
+    if (offset + frameBytes > static_cast<std::int64_t>(index.fileSize)) {
+      break;
+    } // incomplete last frame
+    index.offsets.push_back(offset);
+    offset += frameBytes;
+  } // end of loop through frames
+  return 0;
+}
+
+// Table of the xdrfile compression
+const int magicints[] = {
+    0,        0,        0,       0,       0,       0,       0,       0,
+    0,        8,        10,      12,      16,      20,      25,      32,
+    40,       50,       64,      80,      101,     128,     161,     203,
+    256,      322,      406,     512,     645,     812,     1024,    1290,
+    1625,     2048,     2580,    3250,    4096,    5060,    6501,    8192,
+    10321,    13003,    16384,   20642,   26007,   32768,   41285,   52015,
+    65536,    82570,    104031,  131072,  165140,  208063,  262144,  330280,
+    416127,   524287,   660561,  832255,  1048576, 1321122, 1664510, 2097152,
+    2642245,  3329021,  4194304, 5284491, 6658042, 8388607, 10568983,
+    13316085, 16777216};
+const int firstIdx = 9;
+const int lastIdx = sizeof(magicints) / sizeof(*magicints);
+
+// Bits needed for an integer smaller than size
+int sizeOfInt(unsigned int size) {
+  unsigned int num = 1;
+  int nBits = 0;
+  while (size >= num && nBits < 32) {
+    nBits++;
+    num <<= 1;
+  }
+  return nBits;
+}
+
+// Bits needed for three integers, each smaller than its size
+int sizeOfInts(const unsigned int sizes[3]) {
+  unsigned int bytes[32];
+  unsigned int nBytes = 1, nBits = 0;
+  bytes[0] = 1;
+  for (int i = 0; i < 3; i++) {
+    unsigned int tmp = 0;
+    unsigned int byteCount;
+    for (byteCount = 0; byteCount < nBytes; byteCount++) {
+      tmp = bytes[byteCount] * sizes[i] + tmp;
+      bytes[byteCount] = tmp & 0xff;
+      tmp >>= 8;
+    }
+    while (tmp != 0) {
+      bytes[byteCount++] = tmp & 0xff;
+      tmp >>= 8;
+    }
+    nBytes = byteCount;
+  }
+  unsigned int num = 1;
+  nBytes--;
+  while (bytes[nBytes] >= num) {
+    nBits++;
+    num *= 2;
+  }
+  return nBits + nBytes * 8;
+}
+
+// Reads the compressed bit stream, most significant bit first
+class BitReader {
+public:
+  explicit BitReader(const std::vector<unsigned char> &data) : data(data) {}
+
+  int bits(int nBits) {
+    int mask = nBits >= 32 ? -1 : (1 << nBits) - 1;
+    int num = 0;
+    while (nBits >= 8) {
+      lastByte = (lastByte << 8) | next();
+      num |= (lastByte >> lastBits) << (nBits - 8);
+      nBits -= 8;
+    }
+    if (nBits > 0) {
+      if (static_cast<int>(lastBits) < nBits) {
+        lastBits += 8;
+        lastByte = (lastByte << 8) | next();
+      }
+      lastBits -= nBits;
+      num |= (lastByte >> lastBits) & ((1 << nBits) - 1);
+    }
+    return num & mask;
+  }
+
+  // Three integers packed together with the given sizes
+  void ints(int nBits, const unsigned int sizes[3], int nums[3]) {
+    int bytes[32];
+    int nBytes = 0;
+    bytes[1] = bytes[2] = bytes[3] = 0;
+    while (nBits > 8) {
+      bytes[nBytes++] = bits(8);
+      nBits -= 8;
+    }
+    if (nBits > 0) {
+      bytes[nBytes++] = bits(nBits);
+    }
+    for (int i = 2; i > 0; i--) {
+      unsigned int num = 0;
+      for (int j = nBytes - 1; j >= 0; j--) {
+        num = (num << 8) | bytes[j];
+        unsigned int p = num / sizes[i];
+        bytes[j] = p;
+        num = num - p * sizes[i];
+      }
+      nums[i] = num;
+    }
+    nums[0] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+  }
+
+  bool overrun() const { return pos > data.size(); }
+
+private:
+  unsigned int next() { return pos < data.size() ? data[pos++] : (pos++, 0); }
+
+  const std::vector<unsigned char> &data;
+  std::size_t pos = 0;
+  unsigned int lastBits = 0;
+  unsigned int lastByte = 0;
+};
+
+// Reads the coordinates of an XTC frame (in nm), undoing the xdrfile
+// compression
+int xtcCoordinates(std::ifstream &file, int natoms, std::vector<float> &xyz) {
+  bool swap = hostIsLittleEndian();
+  xyz.resize(3 * static_cast<std::size_t>(natoms));
+  if (natoms <= 9) {
+    return readValues(file, xyz.data(), xyz.size(), swap) ? 0 : 1;
+  }
+  float precision;
+  std::int32_t minint[3], maxint[3], smallidx, nBytes;
+  if (!readValue(file, precision, swap) || !readValues(file, minint, 3, swap) ||
+      !readValues(file, maxint, 3, swap) ||
+      !readValue(file, smallidx, swap) || !readValue(file, nBytes, swap)) {
+    return 1;
+  }
+  if (smallidx < firstIdx || smallidx >= lastIdx) {
+    return 1;
+  }
+  std::vector<unsigned char> data(nBytes);
+  file.read(reinterpret_cast<char *>(data.data()), nBytes);
+  if (!file) {
+    return 1;
+  }
+  // -----------------
+  unsigned int sizeint[3], sizesmall[3], bitsizeint[3] = {0, 0, 0};
+  unsigned int bitsize;
+  for (int k = 0; k < 3; k++) {
+    sizeint[k] = maxint[k] - minint[k] + 1;
+  }
+  // Sizes too large to be multiplied together are read one by one
+  if ((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff) {
+    for (int k = 0; k < 3; k++) {
+      bitsizeint[k] = sizeOfInt(sizeint[k]);
+    }
+    bitsize = 0;
+  } else {
+    bitsize = sizeOfInts(sizeint);
+  }
+  int smaller = magicints[std::max(firstIdx, smallidx - 1)] / 2;
+  int smallnum = magicints[smallidx] / 2;
+  sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+
+  BitReader reader(data);
+  std::vector<int> intCoords(3 * static_cast<std::size_t>(natoms) + 3);
+  float invPrecision = 1.0 / precision;
+  float *out = xyz.data();
+  int run = 0;
+  int prevcoord[3];
+  int i = 0;
+  while (i < natoms) {
+    int *thiscoord = intCoords.data() + 3 * i;
+    if (bitsize == 0) {
+      for (int k = 0; k < 3; k++) {
+        thiscoord[k] = reader.bits(bitsizeint[k]);
+      }
+    } else {
+      reader.ints(bitsize, sizeint, thiscoord);
+    }
+    i++;
+    for (int k = 0; k < 3; k++) {
+      thiscoord[k] += minint[k];
+      prevcoord[k] = thiscoord[k];
+    }
+    int isSmaller = 0;
+    if (reader.bits(1) == 1) {
+      run = reader.bits(5);
+      isSmaller = run % 3;
+      run -= isSmaller;
+      isSmaller--;
+    }
+    if (run > 0) {
+      if (i + run / 3 > natoms) {
+        return 1;
+      }
+      thiscoord += 3;
+      for (int k = 0; k < run; k += 3) {
+        reader.ints(smallidx, sizesmall, thiscoord);
+        i++;
+        for (int d = 0; d < 3; d++) {
+          thiscoord[d] += prevcoord[d] - smallnum;
+        }
+        if (k == 0) {
+          // The first two atoms of a run are swapped (for water molecules)
+          for (int d = 0; d < 3; d++) {
+            std::swap(thiscoord[d], prevcoord[d]);
+            *out++ = prevcoord[d] * invPrecision;
+          }
+        } else {
+          for (int d = 0; d < 3; d++) {
+            prevcoord[d] = thiscoord[d];
+          }
+        }
+        for (int d = 0; d < 3; d++) {
+          *out++ = thiscoord[d] * invPrecision;
+        }
+      } // end of loop through the run
+    } else {
+      for (int d = 0; d < 3; d++) {
+        *out++ = thiscoord[d] * invPrecision;
+      }
+    }
+    smallidx += isSmaller;
+    if (smallidx < firstIdx || smallidx >= lastIdx) {
+      return 1;
+    }
+    if (isSmaller < 0) {
+      smallnum = smaller;
+      smaller = smallidx > firstIdx ? magicints[smallidx - 1] / 2 : 0;
+    } else if (isSmaller > 0) {
+      smaller = smallnum;
+      smallnum = magicints[smallidx] / 2;
+    }
+    sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+  } // end of loop through atoms
+  return reader.overrun() ? 1 : 0;
+}
+
+int readXTCframe(std::ifstream &file, const Topology &topology,
+                 RawFrame &frame) {
+  bool swap = hostIsLittleEndian();
+  std::int32_t header[3]; // magic, natoms, step
+  float time, box[9];
+  std::int32_t lsize;
+  if (!readValues(file, header, 3, swap) || !readValue(file, time, swap) ||
+      !readValues(file, box, 9, swap) || !readValue(file, lsize, swap) ||
+      header[0] != xtcMagic || lsize != header[1]) {
+    return 1;
+  }
+  std::vector<float> xyz;
+  if (xtcCoordinates(file, lsize, xyz) != 0) {
+    return 1;
+  }
+  // nm to Angstrom
+  frame.x.resize(lsize);
+  frame.y.resize(lsize);
+  frame.z.resize(lsize);
+  for (int iatom = 0; iatom < lsize; iatom++) {
+    frame.x[iatom] = 10.0 * xyz[3 * iatom];
+    frame.y[iatom] = 10.0 * xyz[3 * iatom + 1];
+    frame.z[iatom] = 10.0 * xyz[3 * iatom + 2];
+  }
+  // The box vectors are the rows: (lx,0,0), (xy,ly,0), (xz,yz,lz)
+  setBox(frame, topologyOrigin(topology), 10.0 * box[0], 10.0 * box[4],
+         10.0 * box[8], 10.0 * box[3], 10.0 * box[6], 10.0 * box[7]);
+  return 0;
+}
+
+// -----------------
+// LAMMPS binary dumps
+
+// Header of a frame of a LAMMPS binary dump
+struct LammpsBinHeader {
+  std::int64_t natoms = 0;
+  std::int32_t triclinic = 0;
+  double bounds[6];             // xlo xhi ylo yhi zlo zhi (bounding box)
+  double tilt[3] = {0, 0, 0};   // xy xz yz
+  std::int32_t sizeOne = 0;     // Values per atom
+  std::vector<std::string> columns;
+  std::int32_t nChunks = 0;
+};
+
+// Reads the header of a frame; the file is left at the first chunk
+int lammpsBinHeader(std::ifstream &file, LammpsBinHeader &header) {
+  std::int64_t ntimestep;
+  if (!readValue(file, ntimestep, false)) {
+    return 1;
+  }
+  bool hasColumns = false;
+  // Newer versions write a (negative) magic string length first
+  if (ntimestep < 0) {
+    std::string magic(-ntimestep, '\0');
+    std::int32_t endian, revision;
+    file.read(&magic[0], magic.size());
+    if (!readValue(file, endian, false) || !readValue(file, revision, false) ||
+        !readValue(file, ntimestep, false)) {
+      return 1;
+    }
+    if (endian != 1) {
+      std::cerr << "LAMMPS binary dumps from a machine with a different byte "
+                   "order are not supported.\n";
+      return 1;
+    }
+    hasColumns = revision > 1;
+  }
+  std::int32_t boundary[6];
+  if (!readValue(file, header.natoms, false) ||
+      !readValue(file, header.triclinic, false) ||
+      !readValues(file, boundary, 6, false) ||
+      !readValues(file, header.bounds, 6, false)) {
+    return 1;
+  }
+  if (header.triclinic == 1) {
+    if (!readValues(file, header.tilt, 3, false)) {
+      return 1;
+    }
+  } else if (header.triclinic != 0) {
+    std::cerr << "General triclinic LAMMPS binary dumps are not supported.\n";
+    return 1;
+  }
+  if (!readValue(file, header.sizeOne, false)) {
+    return 1;
+  }
+  header.columns.clear();
+  if (hasColumns) {
+    std::int32_t length;
+    if (!readValue(file, length, false)) {
+      return 1;
+    }
+    file.seekg(length, std::ios::cur); // unit style
+    char timeFlag;
+    file.read(&timeFlag, 1);
+    if (timeFlag) {
+      file.seekg(sizeof(double), std::ios::cur);
+    }
+    if (!readValue(file, length, false)) {
+      return 1;
+    }
+    std::string columns(length, '\0');
+    file.read(&columns[0], length);
+    header.columns = gen::tokenizer(columns);
+  } else if (header.sizeOne == 5 || header.sizeOne == 8) {
+    // dump atom, with or without image flags
+    header.columns = {"id", "type", "xs", "ys", "zs"};
+  }
+  return readValue(file, header.nChunks, false) ? 0 : 1;
+}
+
+// Skips from frame header to frame header
+int indexLammpsBin(const std::string &filename, TrajectoryIndex &index) {
+  std::ifstream file(filename, std::ios::binary);
+  std::int64_t offset = 0;
+  LammpsBinHeader header;
+  while (offset < static_cast<std::int64_t>(index.fileSize)) {
+    file.seekg(offset);
+    if (lammpsBinHeader(file, header) != 0) {
+      break;
+    }
+    for (int ichunk = 0; ichunk < header.nChunks; ichunk++) {
+      std::int32_t n;
+      if (!readValue(file, n, false)) {
+        break;
+      }
+      file.seekg(n * sizeof(double), std::ios::cur);
+    }
+    std::int64_t next = file.tellg();
+    if (!file || next > static_cast<std::int64_t>(index.fileSize)) {
+      break;
+    } // incomplete last frame
+    index.offsets.push_back(offset);
+    offset = next;
+  } // end of loop through frames
+  return 0;
+}
+
+int readLammpsBinFrame(std::ifstream &file, RawFrame &frame) {
+  LammpsBinHeader header;
+  if (lammpsBinHeader(file, header) != 0) {
+    return 1;
+  }
+  // Which column is which
+  int idCol = -1, typeCol = -1, molCol = -1;
+  int xyzCol[3] = {-1, -1, -1};
+  bool scaled = false;
+  for (int i = 0; i < header.columns.size(); i++) {
+    const std::string &col = header.columns[i];
+    if (col == "id") {
+      idCol = i;
+    } else if (col == "type") {
+      typeCol = i;
+    } else if (col == "mol") {
+      molCol = i;
+    }
+    for (int k = 0; k < 3; k++) {
+      std::string axis(1, "xyz"[k]);
+      if (col == axis || col == axis + "u") {
+        xyzCol[k] = i;
+      } else if (col == axis + "s" || col == axis + "su") {
+        xyzCol[k] = i;
+        scaled = true;
+      }
+    }
+  } // end of loop through columns
+  if (idCol < 0 || typeCol < 0 || xyzCol[0] < 0 || xyzCol[1] < 0 ||
+      xyzCol[2] < 0) {
+    std::cerr << "The LAMMPS binary dump needs the columns id, type and the "
+                 "coordinates.\n";
+    return 1;
+  }
+  // -----------------
+  // Box
+  // The bounds are those of the bounding box, as in the text dumps
+  double *b = header.bounds;
+  frame.box = {b[1] - b[0], b[3] - b[2], b[5] - b[4]};
+  frame.boxLow = {b[0], b[2], b[4]};
+  double xy = header.tilt[0], xz = header.tilt[1], yz = header.tilt[2];
+  if (header.triclinic) {
+    frame.box.insert(frame.box.end(), {xy, xz, yz});
+  }
+  // Lower corner and lengths of the untilted box, for scaled coordinates
+  double lo[3] = {b[0] - std::min({0.0, xy, xz, xy + xz}),
+                  b[2] - std::min(0.0, yz), b[4]};
+  double len[3] = {b[1] - std::max({0.0, xy, xz, xy + xz}) - lo[0],
+                   b[3] - std::max(0.0, yz) - lo[1], b[5] - lo[2]};
+  // -----------------
+  // Atoms
+  std::vector<double> buf;
+  frame.atomID.clear();
+  frame.type.clear();
+  frame.molID.clear();
+  frame.x.clear();
+  frame.y.clear();
+  frame.z.clear();
+  for (int ichunk = 0; ichunk < header.nChunks; ichunk++) {
+    std::int32_t n;
+    if (!readValue(file, n, false)) {
+      return 1;
+    }
+    buf.resize(n);
+    if (!readValues(file, buf.data(), n, false)) {
+      return 1;
+    }
+    for (int j = 0; j + header.sizeOne <= n; j += header.sizeOne) {
+      const double *atom = buf.data() + j;
+      int id = atom[idCol];
+      frame.atomID.push_back(id);
+      frame.type.push_back(atom[typeCol]);
+      frame.molID.push_back(molCol >= 0 ? static_cast<int>(atom[molCol]) : id);
+      double x = atom[xyzCol[0]], y = atom[xyzCol[1]], z = atom[xyzCol[2]];
+      if (scaled) {
+        frame.x.push_back(lo[0] + len[0] * x + xy * y + xz * z);
+        frame.y.push_back(lo[1] + len[1] * y + yz * z);
+        frame.z.push_back(lo[2] + len[2] * z);
+      } else {
+        frame.x.push_back(x);
+        frame.y.push_back(y);
+        frame.z.push_back(z);
+      }
+    } // end of loop through atoms in the chunk
+  }   // end of loop through chunks
+  return 0;
+}
+
+// -----------------
+
+// Returns the index of a file, building it if the file is new or has changed
+std::shared_ptr<const TrajectoryIndex> trajectoryIndex(const std::string &filename) {
+  namespace fs = boost::filesystem;
+  boost::system::error_code ec;
+  std::uintmax_t fileSize = fs::file_size(filename, ec);
+  if (ec) {
+    std::cerr << "Fatal Error: The file does not exist or you gave the wrong "
+                 "path.\n";
+    return nullptr;
+  }
+  std::time_t modified = fs::last_write_time(filename, ec);
+  InputRegistry &reg = registry();
+  {
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    auto it = reg.indices.find(filename);
+    if (it != reg.indices.end() && it->second->fileSize == fileSize &&
+        it->second->modified == modified) {
+      return it->second;
+    }
+  }
+  auto index = std::make_shared<TrajectoryIndex>();
+  index->format = sinp::trajectoryFormat(filename);
+  index->fileSize = fileSize;
+  index->modified = modified;
+  int ret = 1;
+  switch (index->format) {
+  case sinp::TrajectoryFormat::dcd:
+    ret = indexDCD(filename, *index);
+    break;
+  case sinp::TrajectoryFormat::xtc:
+    ret = indexXTC(filename, *index);
+    break;
+  case sinp::TrajectoryFormat::lammpsBinary:
+    ret = indexLammpsBin(filename, *index);
+    break;
+  case sinp::TrajectoryFormat::lammpsText:
+    std::cerr << filename << " is not a binary trajectory.\n";
+    break;
+  }
+  if (ret != 0) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  reg.indices[filename] = index;
+  return index;
+}
+
+// True if s ends with suffix (ignoring case)
+bool hasExtension(const std::string &s, const std::string &suffix) {
+  if (s.size() < suffix.size()) {
+    return false;
+  }
+  return std::equal(suffix.rbegin(), suffix.rend(), s.rbegin(),
+                    [](char a, char b) { return a == std::tolower(b); });
+}
+
+} // namespace
+
+/**
+ * @details Decides the format of a trajectory from its extension (.dcd, .xtc,
+ * or .bin for LAMMPS binary dumps, in either case). Any other file is taken
+ * to be a LAMMPS text dump.
+ * @param[in] filename The trajectory file
+ * @return The format of the trajectory
+ */
+sinp::TrajectoryFormat sinp::trajectoryFormat(const std::string &filename) {
+  if (hasExtension(filename, ".dcd")) {
+    return sinp::TrajectoryFormat::dcd;
+  }
+  if (hasExtension(filename, ".xtc")) {
+    return sinp::TrajectoryFormat::xtc;
+  }
+  if (hasExtension(filename, ".bin")) {
+    return sinp::TrajectoryFormat::lammpsBinary;
+  }
+  return sinp::TrajectoryFormat::lammpsText;
+}
+
+/**
+ * @details Reads the first frame of a LAMMPS text dump (with every atom), and
+ * keeps the atom IDs, molecule IDs and types of its atoms, sorted by atom ID,
+ * along with the box. These are used for every DCD or XTC frame read
+ * afterwards, whose atoms must be in the same order.
+ * @param[in] filename LAMMPS trajectory file, whose first frame is used
+ * @return 0 if the topology was set, 1 otherwise
+ */
+int sinp::setTopology(std::string filename) {
+  molSys::PointCloud<molSys::Point<double>, double> topoCloud;
+  sinp::readLammpsTrj(filename, 1, &topoCloud);
+  if (topoCloud.pts.empty()) {
+    std::cerr << "Could not read the topology from " << filename << ".\n";
+    return 1;
+  }
+  std::sort(topoCloud.pts.begin(), topoCloud.pts.end(),
+            [](const molSys::Point<double> &a, const molSys::Point<double> &b) {
+              return a.atomID < b.atomID;
+            });
+  auto topology = std::make_shared<Topology>();
+  for (auto &iPoint : topoCloud.pts) {
+    topology->atomID.push_back(iPoint.atomID);
+    topology->molID.push_back(iPoint.molID);
+    topology->type.push_back(iPoint.type);
+  }
+  topology->box = topoCloud.box;
+  topology->boxLow = topoCloud.boxLow;
+  InputRegistry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  reg.topology = topology;
+  return 0;
+}
+
+/**
+ * @details Returns the byte offset at which every frame of a DCD, XTC or
+ * LAMMPS binary file starts. The offsets are found the first time a file is
+ * used, and found again only if its size or modification time changes.
+ * @param[in] filename The trajectory file
+ * @return Byte offsets of the frames (empty if the file could not be read)
+ */
+std::vector<std::int64_t> sinp::frameOffsets(std::string filename) {
+  auto index = trajectoryIndex(filename);
+  if (!index) {
+    return std::vector<std::int64_t>();
+  }
+  return index->offsets;
+}
+
+/**
+ * @details Returns the number of (complete) frames in a DCD, XTC or LAMMPS
+ * binary file.
+ * @param[in] filename The trajectory file
+ * @return The number of frames
+ */
+int sinp::countFrames(std::string filename) {
+  auto index = trajectoryIndex(filename);
+  return index ? index->offsets.size() : 0;
+}
+
+/**
+ * @details Reads a frame (frame number, starting from 1, not the timestep)
+ * of a DCD, XTC or LAMMPS binary file, seeking directly to it. The atoms are
+ * saved exactly as the LAMMPS text readers do: with typeI=-1 and
+ * dropOutsideSlice=false like sinp::readLammpsTrj, with a type like
+ * sinp::readLammpsTrjO, and with a type and dropOutsideSlice=true like
+ * sinp::readLammpsTrjreduced.
+ * @param[in] filename The trajectory file
+ * @param[in] targetFrame The frame number whose information will be read in
+ * @param[out] yCloud The outputted PointCloud
+ * @param[in] typeI The type ID of the atoms to save (-1 for every atom)
+ * @param[in] dropOutsideSlice Atoms outside the slice are not saved if true,
+ *  and only flagged (with inSlice) otherwise
+ * @param[in] isSlice This decides whether a slice will be created or not
+ * @param[in] coordLow Contains the lower limits of the slice, if a slice is to
+ *  be created
+ * @param[in] coordHigh Contains the upper limits of the slice, if a slice is
+ *  to be created
+ * @return 0 if the frame was read, 1 otherwise
+ */
+int sinp::readBinaryTrj(
+    std::string filename, int targetFrame,
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud, int typeI,
+    bool dropOutsideSlice, bool isSlice, std::array<double, 3> coordLow,
+    std::array<double, 3> coordHigh) {
+  sprof::StageTimer timer("parse");
+  *yCloud = molSys::clearPointCloud(yCloud);
+  yCloud->currentFrame = targetFrame;
+  yCloud->nop = 0;
+  auto index = trajectoryIndex(filename);
+  if (!index) {
+    return 1;
+  }
+  if (targetFrame < 1 || targetFrame > index->offsets.size()) {
+    std::cout << "You entered a frame that doesn't exist.\n";
+    return 1;
+  }
+  std::shared_ptr<const Topology> topology;
+  {
+    InputRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    topology = reg.topology;
+  }
+  // -----------------
+  // Read the frame
+  std::ifstream file(filename, std::ios::binary);
+  file.seekg(index->offsets[targetFrame - 1]);
+  RawFrame frame;
+  int ret = 1;
+  switch (index->format) {
+  case sinp::TrajectoryFormat::dcd:
+    ret = readDCDframe(file, *index, *topology, frame);
+    break;
+  case sinp::TrajectoryFormat::xtc:
+    ret = readXTCframe(file, *topology, frame);
+    break;
+  case sinp::TrajectoryFormat::lammpsBinary:
+    ret = readLammpsBinFrame(file, frame);
+    break;
+  case sinp::TrajectoryFormat::lammpsText:
+    break;
+  }
+  if (ret != 0) {
+    std::cerr << "Could not read frame " << targetFrame << " of " << filename
+              << ".\n";
+    return 1;
+  }
+  int natoms = frame.x.size();
+  if (frame.atomID.empty() && !topology->atomID.empty() &&
+      topology->atomID.size() != natoms) {
+    std::cerr << "The topology has " << topology->atomID.size()
+              << " atoms, but frame " << targetFrame << " of " << filename
+              << " has " << natoms << ".\n";
+    return 1;
+  }
+  // -----------------
+  // Save the atoms, as the LAMMPS text readers do
+  yCloud->box = frame.box;
+  yCloud->boxLow = frame.boxLow;
+  for (int iatom = 0; iatom < natoms; iatom++) {
+    molSys::Point<double> iPoint;
+    if (!frame.atomID.empty()) {
+      iPoint.atomID = frame.atomID[iatom];
+      iPoint.molID = frame.molID[iatom];
+      iPoint.type = frame.type[iatom];
+    } else if (!topology->atomID.empty()) {
+      iPoint.atomID = topology->atomID[iatom];
+      iPoint.molID = topology->molID[iatom];
+      iPoint.type = topology->type[iatom];
+    } else {
+      iPoint.atomID = iPoint.molID = iatom + 1;
+      iPoint.type = 1;
+    }
+    iPoint.x = frame.x[iatom];
+    iPoint.y = frame.y[iatom];
+    iPoint.z = frame.z[iatom];
+    if (isSlice) {
+      iPoint.inSlice = sinp::atomInSlice(iPoint.x, iPoint.y, iPoint.z,
+                                         coordLow, coordHigh);
+      if (dropOutsideSlice && !iPoint.inSlice) {
+        continue;
+      }
+    }
+    if (typeI != -1 && iPoint.type != typeI) {
+      continue;
+    }
+    yCloud->pts.push_back(iPoint);
+    yCloud->idIndexMap[iPoint.atomID] = yCloud->pts.size() - 1;
+  } // end of loop through atoms
+  yCloud->nop = yCloud->pts.size();
+  // Put the atoms in the order set with molSys::setAtomOrder
+  molSys::reorderAtoms(yCloud, molSys::atomOrder());
+  sprof::count("parse", yCloud->pts.size());
+  return 0;
+}
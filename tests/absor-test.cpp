@@ -154,8 +154,9 @@ SCENARIO("Test the shape-matching of a perfect HC rotated by 30 degrees",
     // Get the re-ordered matched basal rings, ordered with respect to each
     // other
 
-    pntToPnt::relOrderHC(&targetCloud, rings[iring], rings[jring], nList,
-                         &matchedBasal1, &matchedBasal2);
+    pntToPnt::relOrderHC(&targetCloud, rings[iring], rings[jring],
+                         nneigh::Adjacency(nList), &matchedBasal1,
+                         &matchedBasal2);
     //
     // --------------------------
     // Now get the absolute orientation of the left (candidate/target) system
@@ -0,0 +1,336 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <accumulators.hpp>
+#include <mol_sys.hpp>
+#include <output_sink.hpp>
+#include <seams_output.hpp>
+
+// Standard
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+using Cloud = molSys::PointCloud<molSys::Point<double>, double>;
+
+// Counts of the values in nBins equal bins between low and high, counted
+// the slow way, with underflow and overflow as the last two entries
+std::vector<std::uint64_t> exactCounts(const std::vector<double> &values,
+                                       double low, double high, int nBins) {
+  std::vector<std::uint64_t> counts(nBins + 2, 0);
+  double width = (high - low) / nBins;
+  for (double value : values) {
+    if (value < low) {
+      counts[nBins]++;
+    } else if (value >= high) {
+      counts[nBins + 1]++;
+    } else {
+      int ibin = 0;
+      while (ibin + 1 < nBins && value >= low + (ibin + 1) * width) {
+        ibin++;
+      }
+      counts[ibin]++;
+    }
+  } // end of loop through the values
+  return counts;
+}
+
+// The smallest value with at least a fraction p of the values at or below it
+double exactQuantile(std::vector<double> values, double p) {
+  std::sort(values.begin(), values.end());
+  auto rank = static_cast<std::size_t>(std::ceil(p * values.size()));
+  return values[std::max<std::size_t>(rank, 1) - 1];
+}
+
+// Fraction of the values at or below x
+double fractionBelow(const std::vector<double> &values, double x) {
+  return std::count_if(values.begin(), values.end(),
+                       [x](double value) { return value <= x; }) /
+         static_cast<double>(values.size());
+}
+
+// Reads the numbers dumped one per line by sout::writeHisto
+std::vector<double> readValues(const std::string &fileName) {
+  std::vector<double> values;
+  std::ifstream file(fileName);
+  double value;
+  while (file >> value) {
+    values.push_back(value);
+  }
+  return values;
+}
+
+// A frame of 60 atoms (every fourth one of type 2, which writeHisto skips),
+// with between one and four neighbours each. The c_ij values lie in a few
+// narrow ranges only, so that most bins stay empty, and some are exactly 1
+// (at the upper end of the range)
+void bondFrame(Cloud *yCloud, std::vector<std::vector<int>> *nList,
+               std::vector<double> *avgQ6) {
+  std::mt19937 engine(43); // Fixed seed, for reproducibility
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::vector<std::pair<double, double>> ranges = {
+      {-0.95, -0.8}, {-0.42, -0.38}, {0.05, 0.25}, {0.9, 0.93}};
+  for (int iatom = 0; iatom < 60; iatom++) {
+    molSys::Point<double> pnt;
+    pnt.type = iatom % 4 == 3 ? 2 : 1;
+    pnt.molID = pnt.atomID = iatom + 1;
+    pnt.x = pnt.y = pnt.z = 0.0;
+    int nNeighbours = 1 + iatom % 4;
+    nList->push_back({iatom});
+    for (int j = 0; j < nNeighbours; j++) {
+      nList->back().push_back((iatom + j + 1) % 60);
+      auto range = ranges[(iatom + j) % ranges.size()];
+      double cij = range.first + (range.second - range.first) * unit(engine);
+      if ((iatom + j) % 17 == 0) {
+        cij = 1.0;
+      }
+      pnt.c_ij.push_back({molSys::bond_type::staggered, cij});
+    } // end of loop through neighbours
+    yCloud->pts.push_back(pnt);
+    avgQ6->push_back(iatom % 11 == 0 ? 1.0 : 0.3 + 0.2 * unit(engine));
+  } // end of loop through atoms
+  yCloud->nop = yCloud->pts.size();
+  yCloud->currentFrame = 1;
+}
+
+} // namespace
+
+SCENARIO("Test the streaming histograms, moments and quantiles against the "
+         "values they summarize.",
+         "[accumulators]") {
+  GIVEN("A known sample, with values below, inside and above the range") {
+    std::mt19937 engine(5); // Fixed seed, for reproducibility
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<double> values;
+    for (int i = 0; i < 4000; i++) {
+      // Only the odd bins of [0,1) get values
+      double value = (2 * (i % 10) + 1 + unit(engine)) / 20.0;
+      values.push_back(value);
+    }
+    values.insert(values.end(), {-0.5, -1e-12, 1.0, 1.0, 2.5});
+    WHEN("The values are added to a distribution of 20 bins in [0,1)") {
+      sstat::Distribution dist(0.0, 1.0, 20, {0.1, 0.5, 0.9});
+      for (double value : values) {
+        dist.add(value);
+      }
+      THEN("The counts, moments and quantiles should be exact.") {
+        std::vector<std::uint64_t> counts = exactCounts(values, 0.0, 1.0, 20);
+        for (int ibin = 0; ibin < 20; ibin++) {
+          REQUIRE(dist.histogram.counts[ibin] == counts[ibin]);
+          if (ibin % 2 == 0) {
+            REQUIRE(dist.histogram.counts[ibin] == 0);
+          } // empty bin
+        }
+        REQUIRE(dist.histogram.underflow == 2);
+        REQUIRE(dist.histogram.overflow == 3);
+        // Moments, against the two-pass formulas
+        double mean = 0.0, m2 = 0.0;
+        for (double value : values) {
+          mean += value;
+        }
+        mean /= values.size();
+        for (double value : values) {
+          m2 += (value - mean) * (value - mean);
+        }
+        REQUIRE(dist.moments.n == values.size());
+        REQUIRE(dist.moments.mean == Approx(mean).epsilon(1e-12));
+        REQUIRE(dist.moments.variance() ==
+                Approx(m2 / (values.size() - 1)).epsilon(1e-12));
+        REQUIRE(dist.moments.min == -0.5);
+        REQUIRE(dist.moments.max == 2.5);
+        // Quantiles of the values in range, from the histogram: inside the
+        // bin of the exact quantile, and never inside an empty bin (though
+        // possibly at its edge)
+        std::vector<double> inRange;
+        for (double value : values) {
+          if (value >= 0.0 && value < 1.0) {
+            inRange.push_back(value);
+          }
+        }
+        for (double p : {0.0, 0.1, 0.25, 0.5, 0.9, 1.0}) {
+          double estimate = dist.histogram.quantile(p);
+          double exact = exactQuantile(inRange, p);
+          REQUIRE(std::abs(estimate - exact) <=
+                  dist.histogram.binWidth() + 1e-12);
+          int below =
+              std::max(0, static_cast<int>(std::ceil(estimate * 20)) - 1);
+          int above = std::min(19, static_cast<int>(estimate * 20));
+          REQUIRE(dist.histogram.counts[below] + dist.histogram.counts[above] >
+                  0);
+        }
+        // The P² estimates, over every value, are off by a small fraction
+        // of the values (in the gaps, their values can be anywhere)
+        for (double p : {0.1, 0.5, 0.9}) {
+          REQUIRE(fractionBelow(values, dist.quantile(p)) ==
+                  Approx(p).margin(0.02));
+        }
+      }
+    } // End of the whole sample
+    WHEN("The values are split between two distributions, which are merged") {
+      sstat::Distribution whole(0.0, 1.0, 20, {0.5});
+      sstat::Distribution first(0.0, 1.0, 20, {0.5});
+      sstat::Distribution second(0.0, 1.0, 20, {0.5});
+      for (int i = 0; i < values.size(); i++) {
+        whole.add(values[i]);
+        (i % 3 == 0 ? first : second).add(values[i]);
+      }
+      first.merge(second);
+      THEN("The merged histogram and moments should match those of the whole "
+           "sample.") {
+        REQUIRE(first.histogram.counts == whole.histogram.counts);
+        REQUIRE(first.histogram.underflow == whole.histogram.underflow);
+        REQUIRE(first.histogram.overflow == whole.histogram.overflow);
+        REQUIRE(first.moments.n == whole.moments.n);
+        REQUIRE(first.moments.mean == Approx(whole.moments.mean));
+        REQUIRE(first.moments.variance() == Approx(whole.moments.variance()));
+        REQUIRE(first.moments.min == whole.moments.min);
+        REQUIRE(first.moments.max == whole.moments.max);
+        // After a merge, quantiles come from the histogram
+        REQUIRE(first.quantile(0.5) == whole.histogram.quantile(0.5));
+      }
+    } // End of merging
+  } // End of given
+
+  GIVEN("An empty distribution, and one with fewer than five values") {
+    sstat::Distribution empty(0.0, 1.0, 10, {0.5});
+    sstat::P2Quantile median(0.5), upper(0.75);
+    for (double value : {0.7, 0.1, 0.4}) {
+      median.add(value);
+      upper.add(value);
+    }
+    THEN("The quantiles should be NaN, and the exact ones, respectively.") {
+      REQUIRE(std::isnan(empty.quantile(0.5)));
+      REQUIRE(std::isnan(empty.histogram.quantile(0.5)));
+      REQUIRE(median.value() == 0.4);
+      REQUIRE(upper.value() == 0.7);
+    }
+  } // End of given
+} // End of scenario
+
+SCENARIO("Test the distributions filled by writeHisto against the values it "
+         "dumps.",
+         "[accumulators]") {
+  GIVEN("A frame with known bond correlation factors") {
+    Cloud yCloud;
+    std::vector<std::vector<int>> nList;
+    std::vector<double> avgQ6;
+    bondFrame(&yCloud, &nList, &avgQ6);
+    sstat::reset();
+    sstat::setQuantiles({0.5});
+    sout::dumpHistogramValues(true);
+    WHEN("The frame is written out twice") {
+      sout::writeHisto(&yCloud, nList, avgQ6);
+      sout::writeHisto(&yCloud, nList, avgQ6);
+      sout::closeAllSinks();
+      auto merged = sstat::mergedDistributions();
+      THEN("The distributions should hold every value of the frames.") {
+        // The exact values, twice over
+        std::vector<double> cij, q3, q6;
+        for (int pass = 0; pass < 2; pass++) {
+          for (int iatom = 0; iatom < yCloud.nop; iatom++) {
+            if (yCloud.pts[iatom].type != 1) {
+              continue;
+            }
+            double sum = 0.0;
+            for (auto &result : yCloud.pts[iatom].c_ij) {
+              cij.push_back(result.c_value);
+              sum += result.c_value;
+            }
+            q3.push_back(sum / yCloud.pts[iatom].c_ij.size());
+            q6.push_back(avgQ6[iatom]);
+          } // end of loop through atoms
+        }
+        // The dumped values are the same ones, up to the printed precision
+        std::vector<double> cijDumped = readValues("cij.txt");
+        REQUIRE(cijDumped.size() == cij.size());
+        for (int i = 0; i < cij.size(); i++) {
+          REQUIRE(cijDumped[i] == Approx(cij[i]).margin(1e-5));
+        }
+        REQUIRE(readValues("q3.txt").size() == q3.size());
+        REQUIRE(readValues("q6.txt").size() == q6.size());
+        // Histograms, with the bins of writeHisto
+        std::vector<std::pair<std::string, std::vector<double> *>> named = {
+            {"cij", &cij}, {"q3", &q3}, {"q6", &q6}};
+        for (auto &entry : named) {
+          const sstat::Distribution &dist = merged.at(entry.first);
+          const std::vector<double> &exact = *entry.second;
+          std::vector<std::uint64_t> counts =
+              exactCounts(exact, dist.histogram.low, dist.histogram.high, 200);
+          int nEmpty = 0;
+          for (int ibin = 0; ibin < 200; ibin++) {
+            REQUIRE(dist.histogram.counts[ibin] == counts[ibin]);
+            nEmpty += counts[ibin] == 0;
+          }
+          REQUIRE(nEmpty > 100);
+          REQUIRE(dist.histogram.underflow == counts[200]);
+          REQUIRE(dist.histogram.overflow == counts[201]);
+          REQUIRE(dist.moments.n == exact.size());
+          REQUIRE(dist.moments.min == *std::min_element(exact.begin(),
+                                                         exact.end()));
+          REQUIRE(dist.moments.max == *std::max_element(exact.begin(),
+                                                         exact.end()));
+        } // end of loop through the distributions
+        REQUIRE(merged.at("cij").histogram.overflow > 0);
+        REQUIRE(merged.at("q6").histogram.overflow > 0);
+        // The written histogram lists every bin, empty ones included
+        sstat::writeAll("");
+        sout::flushAllSinks(); // Waits for the writer thread
+        std::ifstream file("cij-histogram.txt");
+        std::string line;
+        int ibin = 0;
+        bool foundQuantile = false;
+        while (std::getline(file, line)) {
+          if (line.rfind("# quantile 0.5 ", 0) == 0) {
+            foundQuantile = true;
+            double median = std::stod(line.substr(15));
+            REQUIRE(fractionBelow(cij, median) == Approx(0.5).margin(0.1));
+          }
+          if (line[0] == '#') {
+            continue;
+          }
+          std::istringstream fields(line);
+          double centre, density;
+          std::uint64_t count;
+          fields >> centre >> count >> density;
+          REQUIRE(centre == Approx(-1.0 + (ibin + 0.5) * 0.01));
+          REQUIRE(count == merged.at("cij").histogram.counts[ibin]);
+          REQUIRE(density ==
+                  Approx(count / (cij.size() * 0.01)).epsilon(1e-5));
+          ibin++;
+        } // end of loop through lines
+        REQUIRE(foundQuantile);
+        REQUIRE(ibin == 200);
+      }
+    } // End of writing the frame
+    sout::dumpHistogramValues(false);
+    sstat::setQuantiles({});
+    sstat::reset();
+    for (auto fileName : {"cij.txt", "q3.txt", "q6.txt", "cij-histogram.txt",
+                          "q3-histogram.txt", "q6-histogram.txt"}) {
+      std::remove(fileName);
+    }
+  } // End of given
+} // End of scenario
@@ -0,0 +1,93 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <bond.hpp>
+
+// Standard
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+// Bonds between random atoms, with about a quarter of them repeated. The atom
+// IDs are the given base plus random offsets below span, shifted left by
+// shift bits
+std::vector<std::vector<int>> randomBonds(int nBonds, int base, int span,
+                                          int shift, std::mt19937 &engine) {
+  std::uniform_int_distribution<int> offset(0, span - 1);
+  std::vector<std::vector<int>> bonds;
+  while (bonds.size() < nBonds) {
+    if (!bonds.empty() && engine() % 4 == 0) {
+      bonds.push_back(bonds[engine() % bonds.size()]);
+    } else {
+      bonds.push_back({base + (offset(engine) << shift),
+                       base + (offset(engine) << shift)});
+    }
+  } // end of adding bonds
+  return bonds;
+}
+
+// The bonds sorted and deduplicated as vectors of vectors
+std::vector<std::vector<int>>
+referenceBonds(std::vector<std::vector<int>> bonds) {
+  std::sort(bonds.begin(), bonds.end());
+  bonds.erase(std::unique(bonds.begin(), bonds.end()), bonds.end());
+  return bonds;
+}
+
+} // namespace
+
+SCENARIO("Test the radix sort of packed bonds against std::sort and "
+         "std::unique.",
+         "[bond]") {
+  GIVEN("Bonds between atoms with IDs spread over every 16-bit digit") {
+    std::mt19937 engine(44); // Fixed seed, for reproducibility
+    // Base, span and shift of the atom IDs:
+    // - up to 2^31, so that every digit of both halves of the keys varies
+    // - large IDs whose upper digit is the same for every atom
+    // - IDs which only differ above the lower 16 bits
+    // - IDs which only differ in the lowest bits
+    struct Ids {
+      int base, span, shift;
+    };
+    std::vector<Ids> idRanges = {{0, 0x7fffffff, 0},
+                                 {0x5a3c0000, 0xffff, 0},
+                                 {3, 0x7fff, 16},
+                                 {1000000, 40, 0}};
+    WHEN("Lists shorter and longer than the radix sort threshold are sorted") {
+      THEN("The bonds should be the same as with std::sort and std::unique.") {
+        for (auto &ids : idRanges) {
+          for (int nBonds : {0, 1, 255, 256, 257, 5000, 70000}) {
+            std::vector<std::vector<int>> bonds =
+                randomBonds(nBonds, ids.base, ids.span, ids.shift, engine);
+            bond::BondList sorted = bond::packBonds(bonds);
+            bond::sortUniqueBonds(sorted);
+            std::vector<std::vector<int>> expected = referenceBonds(bonds);
+            REQUIRE(sorted.keys == bond::packBonds(expected).keys);
+            // Unpacking gives back the atoms
+            for (int ibond = 0; ibond < sorted.size(); ibond++) {
+              REQUIRE(sorted.first(ibond) == expected[ibond][0]);
+              REQUIRE(sorted.second(ibond) == expected[ibond][1]);
+            }
+          } // end of loop through list sizes
+        }   // end of loop through ID ranges
+      }
+    } // End of sorting
+  } // End of given
+} // End of scenario
@@ -0,0 +1,310 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <bulkTUM.hpp>
+#include <cage.hpp>
+#include <franzblau.hpp>
+#include <neighbours.hpp>
+#include <output_sink.hpp>
+#include <pntCorrespondence.hpp>
+#include <ring.hpp>
+#include <shapeMatch.hpp>
+#include <topo_bulk.hpp>
+
+// Standard
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+#include <catch2/catch.hpp>
+
+namespace {
+
+using Cloud = molSys::PointCloud<molSys::Point<double>, double>;
+
+// Ice of nCells orthorhombic unit cells of the given lengths, each holding
+// atoms at the given fractional positions, jittered at random
+Cloud iceLattice(std::array<double, 3> cellLength,
+                 const std::vector<std::array<double, 3>> &basis,
+                 std::array<int, 3> nCells, std::mt19937 &engine) {
+  std::uniform_real_distribution<double> jitter(-0.2, 0.2);
+  Cloud yCloud;
+  for (int k = 0; k < 3; k++) {
+    yCloud.box.push_back(nCells[k] * cellLength[k]);
+    yCloud.boxLow.push_back(0.0);
+  }
+  for (int ix = 0; ix < nCells[0]; ix++) {
+    for (int iy = 0; iy < nCells[1]; iy++) {
+      for (int iz = 0; iz < nCells[2]; iz++) {
+        for (auto &site : basis) {
+          molSys::Point<double> iPoint;
+          iPoint.type = 1;
+          iPoint.atomID = yCloud.pts.size() + 1;
+          iPoint.molID = iPoint.atomID;
+          iPoint.x = (ix + site[0]) * cellLength[0] + jitter(engine);
+          iPoint.y = (iy + site[1]) * cellLength[1] + jitter(engine);
+          iPoint.z = (iz + site[2]) * cellLength[2] + jitter(engine);
+          yCloud.idIndexMap[iPoint.atomID] = yCloud.pts.size();
+          yCloud.pts.push_back(iPoint);
+        } // end of loop through the basis
+      }
+    }
+  } // end of loop through the unit cells
+  yCloud.nop = yCloud.pts.size();
+  yCloud.currentFrame = 1;
+  return yCloud;
+}
+
+// Hexagonal ice (with HCs and hexagonal prism blocks), with an O-O distance
+// of 2.76
+Cloud hexagonalIce(std::mt19937 &engine) {
+  double c = 2.76 / 0.375;
+  double a = c / std::sqrt(8.0 / 3.0);
+  return iceLattice({a, std::sqrt(3.0) * a, c},
+                    {{0.0, 1.0 / 3, 0.0625},
+                     {0.0, 1.0 / 3, 0.4375},
+                     {0.5, 1.0 / 6, 0.5625},
+                     {0.5, 1.0 / 6, 0.9375},
+                     {0.5, 5.0 / 6, 0.0625},
+                     {0.5, 5.0 / 6, 0.4375},
+                     {0.0, 2.0 / 3, 0.5625},
+                     {0.0, 2.0 / 3, 0.9375}},
+                    {4, 2, 2}, engine);
+}
+
+// Cubic ice (with DDCs), with an O-O distance of 2.76
+Cloud cubicIce(std::mt19937 &engine) {
+  double a = 4.0 * 2.76 / std::sqrt(3.0);
+  std::vector<std::array<double, 3>> basis = {
+      {0.0, 0.0, 0.0}, {0.0, 0.5, 0.5}, {0.5, 0.0, 0.5}, {0.5, 0.5, 0.0}};
+  for (int k = 0; k < 4; k++) {
+    basis.push_back(
+        {basis[k][0] + 0.25, basis[k][1] + 0.25, basis[k][2] + 0.25});
+  }
+  return iceLattice({a, a, a}, basis, {3, 3, 3}, engine);
+}
+
+// Contents of every file written under a directory, by relative path
+std::map<std::string, std::string> filesUnder(const std::string &path) {
+  std::map<std::string, std::string> files;
+  for (auto &entry :
+       boost::filesystem::recursive_directory_iterator(path)) {
+    if (!boost::filesystem::is_regular_file(entry.path())) {
+      continue;
+    }
+    std::ifstream file(entry.path().string());
+    std::stringstream contents;
+    contents << file.rdbuf();
+    files[entry.path().string().substr(path.size())] = contents.str();
+  } // end of loop through the files
+  return files;
+}
+
+} // namespace
+
+SCENARIO("Test the clustering of cages which share rings.", "[tum3]") {
+  GIVEN("A list of HCs and DDCs, some sharing rings across types") {
+    std::vector<cage::Cage> cageList; // HCs and DDCs
+    int nRings = 70;                  // Rings the cages are made of
+    std::vector<int> clusterID;       // Cluster of each cage
+    // Cage 0 (HC) shares ring 4 with cage 1 (a DDC) and with cage 2 (an HC)
+    cageList.push_back({cage::HexC, {0, 1, 2, 3, 4}});
+    cageList.push_back({cage::DoubleDiaC, {4, 5, 6, 7, 8, 9, 19}});
+    cageList.push_back({cage::HexC, {10, 11, 12, 13, 4}});
+    // A single DDC
+    cageList.push_back({cage::DoubleDiaC, {20, 21, 22, 23, 24, 25, 26}});
+    // DDCs joined to cage 1 (directly, and through cage 4)
+    cageList.push_back({cage::DoubleDiaC, {5, 30, 31, 32, 33, 34, 35}});
+    cageList.push_back({cage::HexC, {40, 41, 42, 43, 44}});
+    cageList.push_back({cage::HexC, {44, 45, 46, 47, 48}});
+    cageList.push_back({cage::DoubleDiaC, {35, 50, 51, 52, 53, 54, 55}});
+    // HC joined to cage 0 through cage 2
+    cageList.push_back({cage::HexC, {12, 60, 61, 62, 63}});
+    // HC joining the cluster of cage 0 with the cluster of cages 5 and 6
+    cageList.push_back({cage::HexC, {3, 41, 64, 65, 66}});
+    // An HC sharing ring 26 with the single DDC, and ring 0 with cage 0
+    cageList.push_back({cage::HexC, {26, 67, 68, 69, 0}});
+    WHEN("The clusters are found") {
+      THEN("Cages of the same type sharing rings should be grouped, numbered "
+           "by their lowest cage index.") {
+        clusterID = tum3::cageClusterIDs(cageList, cageList.size(), nRings);
+        // Cage 3 stays single, although cage 10 shares one of its rings
+        REQUIRE(clusterID ==
+                std::vector<int>{0, 1, 0, -1, 1, 0, 0, 1, 0, 0, 0});
+      }
+      THEN("Cages of different types sharing rings should stay separate.") {
+        // Only cage 0 (HC) and cage 1 (DDC), sharing ring 4
+        clusterID = tum3::cageClusterIDs(cageList, 2, nRings);
+        REQUIRE(clusterID == std::vector<int>{-1, -1});
+        // An HC and a DDC sharing ring 26, plus an unrelated pair of HCs
+        std::vector<cage::Cage> mixed = {cageList[5], cageList[3],
+                                         cageList[6], cageList[10]};
+        mixed[3].rings = {26, 67, 68, 69};
+        clusterID = tum3::cageClusterIDs(mixed, mixed.size(), nRings);
+        REQUIRE(clusterID == std::vector<int>{0, -1, 0, -1});
+      }
+    } // End of finding the clusters
+  }   // End of given
+} // End of scenario
+
+SCENARIO("Test that the shape-matching of prism blocks and cages gives the "
+         "same results on any number of threads.",
+         "[tum3]") {
+  GIVEN("Frames of hexagonal and cubic ice, with their hexagonal rings") {
+    std::mt19937 engine(46);
+    std::vector<Cloud> frames = {hexagonalIce(engine), cubicIce(engine)};
+    // The reference cages are read from the templates directory
+    bool copiedTemplates = !boost::filesystem::exists("templates");
+    if (copiedTemplates) {
+      boost::filesystem::create_directory("templates");
+      for (std::string name : {"hc.xyz", "ddc.xyz"}) {
+        boost::filesystem::copy_file("../templates/" + name,
+                                     "templates/" + name);
+      }
+    } // templates
+    for (int iframe = 0; iframe < frames.size(); iframe++) {
+      Cloud &yCloud = frames[iframe];
+      std::vector<std::vector<int>> nList = nneigh::neighbourListByIndex(
+          &yCloud, nneigh::neighListO(3.2, &yCloud, 1));
+      std::vector<std::vector<int>> rings = primitive::ringNetwork(nList, 6);
+      std::vector<std::vector<int>> hexagons =
+          ring::getSingleRingSize(rings, 6);
+      REQUIRE(!hexagons.empty());
+      WHEN("The prism blocks are found on one and on four threads, in frame " +
+           std::to_string(iframe)) {
+        std::vector<std::vector<ring::strucType>> ringTypes;
+        std::vector<std::vector<double>> rmsdPerAtom;
+        for (int nThreads : {1, 4}) {
+          match::setThreads(nThreads);
+          ringTypes.emplace_back(hexagons.size(), ring::unclassified);
+          rmsdPerAtom.emplace_back(yCloud.nop, -1);
+          prism3::findBulkPrisms(hexagons, &ringTypes.back(), nList, &yCloud,
+                                 &rmsdPerAtom.back());
+        } // end of loop through the numbers of threads
+        match::setThreads(1);
+        THEN("The ring types and the RMSD per atom are identical.") {
+          REQUIRE(ringTypes[1] == ringTypes[0]);
+          REQUIRE(rmsdPerAtom[1] == rmsdPerAtom[0]);
+          if (iframe == 0) {
+            REQUIRE(std::count(ringTypes[0].begin(), ringTypes[0].end(),
+                               ring::Prism) > 0);
+          }
+        } // End of then
+      }   // End of when
+      WHEN("The cages are matched on one and on four threads, in frame " +
+           std::to_string(iframe)) {
+        std::vector<std::map<std::string, std::string>> outputs;
+        for (int nThreads : {1, 4}) {
+          match::setThreads(nThreads);
+          // A new directory every time, since sout::ensurePath only creates
+          // a directory once per run
+          std::string path = "tumFrame" + std::to_string(iframe) +
+                             "Threads" + std::to_string(nThreads) + "/";
+          tum3::topoUnitMatchingBulk(path, rings, nList, &yCloud, 1, false,
+                                     true);
+          sout::flushAllSinks();
+          outputs.push_back(filesUnder(path));
+          boost::filesystem::remove_all(path);
+        } // end of loop through the numbers of threads
+        match::setThreads(1);
+        THEN("Every output file, with the atom types and the RMSD per atom, "
+             "is identical.") {
+          REQUIRE(!outputs[0].empty());
+          REQUIRE(outputs[1] == outputs[0]);
+          // Some atoms are in a cage, with an RMSD
+          std::string dump = outputs[0]["bulkTopo/dumpFiles/dump-1.lammpstrj"];
+          REQUIRE(!dump.empty());
+          std::istringstream lines(dump);
+          std::string line;
+          int nInCages = 0;
+          for (int iline = 0; std::getline(lines, line); iline++) {
+            std::istringstream columns(line);
+            int atomID, molID, type;
+            if (iline >= 9 && columns >> atomID >> molID >> type) {
+              nInCages += type == (iframe == 0 ? 1 : 2);
+            }
+          } // end of loop through the lines of the dump file
+          REQUIRE(nInCages > 0);
+        } // End of then
+      }   // End of when
+    }     // end of loop through frames
+    if (copiedTemplates) {
+      boost::filesystem::remove_all("templates");
+    }
+  } // End of given
+} // End of scenario
+
+SCENARIO("Test that changing the order of a DDC only reorders its atoms.",
+         "[tum3]") {
+  GIVEN("The fourteen atoms of a DDC, in the order of pntToPnt::relOrderDDC") {
+    Cloud yCloud;
+    yCloud.box = {100.0, 100.0, 100.0};
+    yCloud.boxLow = {0.0, 0.0, 0.0};
+    std::vector<int> ddcOrder;
+    for (int iatom = 0; iatom < 14; iatom++) {
+      molSys::Point<double> iPoint;
+      iPoint.atomID = iatom + 1;
+      iPoint.x = 10.0 + iatom;
+      iPoint.y = 20.0 + 2 * iatom;
+      iPoint.z = 30.0 + 3 * iatom;
+      yCloud.pts.push_back(iPoint);
+      ddcOrder.push_back(iatom);
+    }
+    yCloud.nop = yCloud.pts.size();
+    WHEN("The order is changed for every starting index of the equatorial "
+         "ring") {
+      THEN("Every atom comes from ddcOrder, wrapped within its part of the "
+           "cage.") {
+        for (int startingIndex = 0; startingIndex < 6; startingIndex++) {
+          Eigen::MatrixXd pointSet =
+              pntToPnt::changeDiaCageOrder(&yCloud, ddcOrder, startingIndex);
+          int peripheralShift = startingIndex <= 1 ? 0
+                                : startingIndex <= 3 ? 1
+                                                     : 2;
+          for (int i = 0; i < 14; i++) {
+            // Expected position in ddcOrder
+            int j;
+            if (i < 6) {
+              j = (i + startingIndex) % 6;
+            } else if (i < 9) {
+              j = 6 + (i - 6 + peripheralShift) % 3;
+            } else if (i > 9 && i < 13) {
+              j = 10 + (i - 10 + peripheralShift) % 3;
+            } else {
+              j = i;
+            } // apex atoms
+            // Every row is placed relative to the first one, as
+            // changeDiaCageOrder does
+            int first = ddcOrder[startingIndex];
+            std::array<double, 3> dr =
+                gen::relDist(&yCloud, first, ddcOrder[j]);
+            REQUIRE(pointSet(i, 0) == yCloud.pts[first].x + dr[0]);
+            REQUIRE(pointSet(i, 1) == yCloud.pts[first].y + dr[1]);
+            REQUIRE(pointSet(i, 2) == yCloud.pts[first].z + dr[2]);
+          } // end of loop through the atoms of the cage
+        }   // end of loop through the starting indices
+      }
+    } // End of changing the order
+  }   // End of given
+} // End of scenario
@@ -0,0 +1,203 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <compressed_input.hpp>
+#include <mol_sys.hpp>
+#include <seams_input.hpp>
+
+// Standard
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+#include <zlib.h>
+
+namespace {
+
+// A LAMMPS trajectory of several MB, as text, along with the offset at which
+// every frame starts
+std::string lammpsText(int nFrames, int nAtoms,
+                       std::vector<std::size_t> &frameStarts) {
+  std::mt19937 engine(11); // Fixed seed, for reproducibility
+  std::uniform_real_distribution<double> position(0.0, 40.0);
+  std::ostringstream text;
+  for (int iframe = 0; iframe < nFrames; iframe++) {
+    frameStarts.push_back(text.tellp());
+    text << "ITEM: TIMESTEP\n" << 250 * iframe << "\n";
+    text << "ITEM: NUMBER OF ATOMS\n" << nAtoms << "\n";
+    text << "ITEM: BOX BOUNDS pp pp pp\n";
+    text << "0 " << 40 + 0.01 * iframe << "\n0 40\n-1 39\n";
+    text << "ITEM: ATOMS id mol type x y z\n";
+    for (int iatom = 0; iatom < nAtoms; iatom++) {
+      text << iatom + 1 << " " << iatom / 3 + 1 << " " << 1 + (iatom % 3 == 0)
+           << " " << position(engine) << " " << position(engine) << " "
+           << position(engine) - 1.0 << "\n";
+    }
+  } // end of loop through frames
+  return text.str();
+}
+
+// Compresses text into gzip members, split at the given offsets, and writes
+// them one after the other into a file
+void writeGzip(const std::string &filename, const std::string &text,
+               std::vector<std::size_t> splits) {
+  std::ofstream out(filename, std::ios::binary);
+  splits.insert(splits.begin(), 0);
+  splits.push_back(text.size());
+  for (std::size_t k = 0; k + 1 < splits.size(); k++) {
+    z_stream stream = {};
+    // 15 bits of window, +16 for a gzip header and trailer
+    deflateInit2(&stream, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::vector<unsigned char> compressed(
+        deflateBound(&stream, splits[k + 1] - splits[k]));
+    stream.next_in = reinterpret_cast<Bytef *>(
+        const_cast<char *>(text.data() + splits[k]));
+    stream.avail_in = splits[k + 1] - splits[k];
+    stream.next_out = compressed.data();
+    stream.avail_out = compressed.size();
+    deflate(&stream, Z_FINISH);
+    out.write(reinterpret_cast<char *>(compressed.data()), stream.total_out);
+    deflateEnd(&stream);
+  }
+}
+
+// Writes text as zstd frames, split at the given offsets. The blocks are
+// stored raw, or as RLE blocks for runs of one byte, which is valid zstd data
+// that can be written without the zstd library
+void writeZstd(const std::string &filename, const std::string &text,
+               std::vector<std::size_t> splits) {
+  std::ofstream out(filename, std::ios::binary);
+  splits.insert(splits.begin(), 0);
+  splits.push_back(text.size());
+  const std::size_t blockSize = 1 << 17; // Largest block for a 128 KB window
+  auto put = [&out](std::uint32_t value, int nBytes) {
+    for (int b = 0; b < nBytes; b++) {
+      out.put(static_cast<char>((value >> (8 * b)) & 0xff));
+    }
+  };
+  for (std::size_t k = 0; k + 1 < splits.size(); k++) {
+    put(0xFD2FB528u, 4); // Magic number
+    put(0x00, 1);        // No content size or checksum, not single segment
+    put(7 << 3, 1);      // Window of 2^(10+7) bytes
+    std::size_t begin = splits[k];
+    while (begin < splits[k + 1]) {
+      // An RLE block for a newline, then a raw block for the rest
+      if (text[begin] == '\n' && begin + 1 < splits[k + 1]) {
+        put(static_cast<std::uint32_t>(1 << 3 | 1 << 1), 3);
+        out.put('\n');
+        begin++;
+      }
+      std::size_t size = std::min(blockSize, splits[k + 1] - begin);
+      bool last = begin + size == splits[k + 1];
+      put(static_cast<std::uint32_t>(size << 3 | last), 3);
+      out.write(text.data() + begin, size);
+      begin += size;
+    }
+  }
+}
+
+// Compares two PointClouds read from the same frame
+void requireSameFrame(
+    const molSys::PointCloud<molSys::Point<double>, double> &a,
+    const molSys::PointCloud<molSys::Point<double>, double> &b) {
+  REQUIRE(a.nop == b.nop);
+  REQUIRE(a.box == b.box);
+  REQUIRE(a.boxLow == b.boxLow);
+  for (int iatom = 0; iatom < a.nop; iatom++) {
+    REQUIRE(a.pts[iatom].atomID == b.pts[iatom].atomID);
+    REQUIRE(a.pts[iatom].molID == b.pts[iatom].molID);
+    REQUIRE(a.pts[iatom].type == b.pts[iatom].type);
+    REQUIRE(a.pts[iatom].x == b.pts[iatom].x);
+    REQUIRE(a.pts[iatom].y == b.pts[iatom].y);
+    REQUIRE(a.pts[iatom].z == b.pts[iatom].z);
+  }
+}
+
+} // namespace
+
+SCENARIO("Test reading gzip and zstd compressed LAMMPS trajectories.",
+         "[compressed]") {
+  GIVEN("A trajectory of about 10 MB, plain and compressed") {
+    std::vector<std::size_t> frameStarts; // Start of every frame in the text
+    std::string text = lammpsText(40, 6000, frameStarts);
+    std::string plainName = "compressedTest.lammpstrj";
+    std::string gzName = "compressedTest.lammpstrj.gz";
+    std::string bgzName = "compressedTest-members.lammpstrj.gz";
+    std::string zstName = "compressedTest.lammpstrj.zst";
+    std::ofstream(plainName, std::ios::binary) << text;
+    // One gzip member, and several members split in the middle of frames
+    writeGzip(gzName, text, {});
+    std::vector<std::size_t> splits = {frameStarts[3] + 1234,
+                                       frameStarts[17] + 50000,
+                                       frameStarts[30] + 7};
+    writeGzip(bgzName, text, splits);
+    writeZstd(zstName, text, splits);
+    std::vector<std::string> compressed = {gzName, bgzName};
+    if (sinp::compressionSupported(sinp::Compression::zstd)) {
+      compressed.push_back(zstName);
+    }
+    WHEN("Every frame is read from each file") {
+      THEN("The compressed files should give the frames of the plain file.") {
+        // The decompression thread hands over blocks of 256 KB, and keeps
+        // access points every 4 MB of text: some frames must straddle both
+        bool straddlesBlock = false, straddlesAccess = false;
+        for (std::size_t iframe = 0; iframe + 1 < frameStarts.size();
+             iframe++) {
+          straddlesBlock |= frameStarts[iframe] / (1 << 18) !=
+                            (frameStarts[iframe + 1] - 1) / (1 << 18);
+          straddlesAccess |= frameStarts[iframe] / (4 << 20) !=
+                             (frameStarts[iframe + 1] - 1) / (4 << 20);
+        }
+        REQUIRE(straddlesBlock);
+        REQUIRE(straddlesAccess);
+        REQUIRE(sinp::compression(plainName) == sinp::Compression::none);
+        REQUIRE(sinp::compression(gzName) == sinp::Compression::gzip);
+        REQUIRE(sinp::compression(zstName) == sinp::Compression::zstd);
+        molSys::PointCloud<molSys::Point<double>, double> plain, other;
+        // Frames in an order which jumps back and forth
+        for (int frame : {1, 2, 3, 4, 5, 18, 17, 31, 22, 40, 39, 12}) {
+          sinp::readLammpsTrj(plainName, frame, &plain);
+          REQUIRE(plain.nop == 6000);
+          REQUIRE(plain.currentFrame == frame);
+          for (auto &filename : compressed) {
+            sinp::readLammpsTrj(filename, frame, &other);
+            REQUIRE(other.currentFrame == frame);
+            requireSameFrame(plain, other);
+          }
+        } // end of loop through frames
+        // Reading the whole file as one stream
+        for (auto &filename : compressed) {
+          std::unique_ptr<std::istream> stream = sinp::openInput(filename);
+          std::string all((std::istreambuf_iterator<char>(*stream)),
+                          std::istreambuf_iterator<char>());
+          REQUIRE(all == text);
+        }
+      }
+    } // End of reading the frames
+    for (auto &filename : {plainName, gzName, bgzName, zstName}) {
+      std::remove(filename.c_str());
+    }
+  } // End of given
+} // End of scenario
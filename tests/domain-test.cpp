@@ -0,0 +1,203 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <bond.hpp>
+#include <bop.hpp>
+#include <domain.hpp>
+#include <franzblau.hpp>
+#include <mol_sys.hpp>
+#include <neighbours.hpp>
+#include <pipeline.hpp>
+
+// Standard
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+using Cloud = molSys::PointCloud<molSys::Point<double>, double>;
+
+// A frame of cubic ice (a diamond lattice of oxygen atoms) with the given
+// number of unit cells along each dimension, slightly jittered. Every water
+// molecule donates its two hydrogen atoms along two of its four bonds, chosen
+// at random, so that some bonds are not hydrogen bonds and the network is not
+// perfect. The oxygen atoms are of type 2 and the hydrogen atoms of type 1
+spipe::FrameData iceFrame(std::array<int, 3> nCells, std::mt19937 &engine) {
+  const double a = 4.0 * 2.76 / std::sqrt(3.0); // Lattice constant
+  const std::array<std::array<double, 3>, 4> fcc = {
+      {{0.0, 0.0, 0.0}, {0.0, 0.5, 0.5}, {0.5, 0.0, 0.5}, {0.5, 0.5, 0.0}}};
+  // Bonds of an atom on the first fcc sublattice (negated for the second)
+  const std::array<std::array<double, 3>, 4> bonds = {
+      {{1, 1, 1}, {1, -1, -1}, {-1, 1, -1}, {-1, -1, 1}}};
+  std::uniform_real_distribution<double> jitter(-0.1, 0.1);
+  spipe::FrameData data;
+  for (int k = 0; k < 3; k++) {
+    data.cloud.box.push_back(nCells[k] * a);
+    data.cloud.boxLow.push_back(0.0);
+  }
+  data.hCloud.box = data.cloud.box;
+  data.hCloud.boxLow = data.cloud.boxLow;
+  int molID = 0;
+  for (int ix = 0; ix < nCells[0]; ix++) {
+    for (int iy = 0; iy < nCells[1]; iy++) {
+      for (int iz = 0; iz < nCells[2]; iz++) {
+        for (int sublattice = 0; sublattice < 2; sublattice++) {
+          for (auto &site : fcc) {
+            molID++;
+            double shift = 0.25 * sublattice;
+            molSys::Point<double> oPoint;
+            oPoint.type = 2;
+            oPoint.molID = molID;
+            oPoint.atomID = 3 * molID - 2;
+            oPoint.x = (ix + site[0] + shift) * a + jitter(engine);
+            oPoint.y = (iy + site[1] + shift) * a + jitter(engine);
+            oPoint.z = (iz + site[2] + shift) * a + jitter(engine);
+            data.cloud.idIndexMap[oPoint.atomID] = data.cloud.pts.size();
+            data.cloud.pts.push_back(oPoint);
+            // Two of the four bonds are donated
+            std::array<int, 4> donated = {0, 1, 2, 3};
+            std::shuffle(donated.begin(), donated.end(), engine);
+            double sign = sublattice == 0 ? 1.0 : -1.0;
+            for (int h = 0; h < 2; h++) {
+              const auto &bond = bonds[donated[h]];
+              double scale = sign / std::sqrt(3.0);
+              molSys::Point<double> hPoint;
+              hPoint.type = 1;
+              hPoint.molID = molID;
+              hPoint.atomID = oPoint.atomID + 1 + h;
+              hPoint.x = oPoint.x + bond[0] * scale;
+              hPoint.y = oPoint.y + bond[1] * scale;
+              hPoint.z = oPoint.z + bond[2] * scale;
+              data.hCloud.idIndexMap[hPoint.atomID] = data.hCloud.pts.size();
+              data.hCloud.pts.push_back(hPoint);
+            } // end of loop through the hydrogen atoms
+          }   // end of loop through the fcc sites
+        }     // end of loop through the sublattices
+      }
+    }
+  } // end of loop through the unit cells
+  data.cloud.nop = data.cloud.pts.size();
+  data.hCloud.nop = data.hCloud.pts.size();
+  data.cloud.currentFrame = data.hCloud.currentFrame = 1;
+  return data;
+}
+
+// The products of the whole frame, computed without subdomains like
+// spipe::Pipeline does
+void wholeFrameProducts(const spipe::Settings &settings,
+                        const std::vector<int> &ringSizes,
+                        spipe::FrameData &data) {
+  data.nList = nneigh::neighListO(settings.cutoffRadius, &data.cloud,
+                                  settings.oxygenType);
+  data.hbnList = bond::populateHbondsWithInputClouds(&data.cloud, &data.hCloud,
+                                                     data.nList);
+  data.hbnList = nneigh::neighbourListByIndex(&data.cloud, data.hbnList);
+  if (ringSizes.empty()) {
+    data.rings = ring::RingsBySize(
+        primitive::ringNetwork(data.hbnList, settings.maxDepth));
+  } else {
+    data.rings = ring::RingsBySize(
+        primitive::ringNetworkOfSizes(data.hbnList, ringSizes));
+  }
+  chill::getCorrelPlus(&data.cloud, data.nList, settings.isSlice);
+}
+
+// The rings of a frame, sorted
+std::vector<std::vector<int>> sortedRings(const spipe::FrameData &data) {
+  std::vector<std::vector<int>> rings = data.rings.toVector();
+  std::sort(rings.begin(), rings.end());
+  return rings;
+}
+
+} // namespace
+
+SCENARIO("Test that the products computed subdomain by subdomain are those of "
+         "the whole frame.",
+         "[domain]") {
+  GIVEN("A frame of cubic ice, long enough along x to be split into three "
+        "subdomains") {
+    std::mt19937 engine(48);
+    spipe::FrameData frame = iceFrame({13, 4, 3}, engine);
+    spipe::Settings settings;
+    settings.oxygenType = 2;
+    settings.hydrogenType = 1;
+    settings.cutoffRadius = 3.2;
+    settings.maxDepth = 6;
+    std::vector<spipe::Product> order = {
+        spipe::Product::frame, spipe::Product::hydrogens,
+        spipe::Product::neighbours, spipe::Product::hbonds,
+        spipe::Product::rings, spipe::Product::bop};
+    double halo = sdom::haloWidth(settings, order);
+    REQUIRE(halo == Approx(settings.cutoffRadius * settings.maxDepth));
+    WHEN("the box is decomposed") {
+      std::vector<sdom::Domain> domains =
+          sdom::decompose(&frame.cloud, {3, 2, 2}, halo);
+      THEN("only x is split, since the halos would overlap along y and z") {
+        // L/n + 2h <= L along x only
+        REQUIRE(frame.cloud.box[0] / 3 + 2 * halo <= frame.cloud.box[0]);
+        REQUIRE(frame.cloud.box[1] / 2 + 2 * halo > frame.cloud.box[1]);
+        REQUIRE(frame.cloud.box[2] / 2 + 2 * halo > frame.cloud.box[2]);
+        REQUIRE(domains.size() == 3);
+        // Every atom is owned by exactly one subdomain
+        std::vector<int> nOwners(frame.cloud.nop, 0);
+        for (auto &domain : domains) {
+          REQUIRE(domain.atoms.size() < frame.cloud.nop);
+          REQUIRE(std::is_sorted(domain.atoms.begin(), domain.atoms.end()));
+          for (int iatom = 0; iatom < domain.atoms.size(); iatom++) {
+            nOwners[domain.atoms[iatom]] += domain.owned[iatom];
+          }
+        } // end of loop through the subdomains
+        REQUIRE(std::all_of(nOwners.begin(), nOwners.end(),
+                            [](int n) { return n == 1; }));
+      } // End of then
+    }   // End of when
+    for (std::vector<int> ringSizes :
+         {std::vector<int>{}, std::vector<int>{4, 6}}) {
+      WHEN("the products are computed subdomain by subdomain, for ring "
+           "sizes " +
+           std::to_string(ringSizes.size())) {
+        spipe::FrameData whole = frame;
+        wholeFrameProducts(settings, ringSizes, whole);
+        spipe::FrameData split = frame;
+        settings.domains = {3, 1, 1};
+        settings.domainThreads = 2;
+        REQUIRE(sdom::isDecomposed(settings));
+        REQUIRE(sdom::computeProducts(settings, order, ringSizes, split) == 0);
+        THEN("the neighbour lists, hydrogen bonds, rings and bond "
+             "correlations are identical") {
+          REQUIRE(whole.rings.size() > 0);
+          REQUIRE(split.nList == whole.nList);
+          REQUIRE(split.hbnList == whole.hbnList);
+          REQUIRE(sortedRings(split) == sortedRings(whole));
+          for (int iatom = 0; iatom < whole.cloud.nop; iatom++) {
+            const auto &expected = whole.cloud.pts[iatom].c_ij;
+            const auto &found = split.cloud.pts[iatom].c_ij;
+            REQUIRE(found.size() == expected.size());
+            for (int j = 0; j < expected.size(); j++) {
+              REQUIRE(found[j].classifier == expected[j].classifier);
+              REQUIRE(found[j].c_value == expected[j].c_value);
+            }
+          } // end of loop through atoms
+        }   // End of then
+      }     // End of when
+    }       // end of loop through the ring sizes
+  }         // End of given
+} // End of scenario
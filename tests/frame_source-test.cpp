@@ -0,0 +1,174 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <frame_source.hpp>
+#include <mol_sys.hpp>
+#include <seams_input.hpp>
+
+// Standard
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+using Cloud = molSys::PointCloud<molSys::Point<double>, double>;
+
+// Writes a LAMMPS trajectory of nFrames frames, with atoms of types 1 and 2
+// which move a little from one frame to the next
+void writeTrajectory(const std::string &filename, int nFrames, int nAtoms) {
+  std::mt19937 engine(23); // Fixed seed, for reproducibility
+  std::uniform_real_distribution<double> position(0.0, 30.0);
+  std::uniform_real_distribution<double> step(-0.4, 0.4);
+  std::vector<std::array<double, 3>> r(nAtoms);
+  for (auto &ri : r) {
+    ri = {position(engine), position(engine), position(engine)};
+  }
+  std::ofstream out(filename);
+  for (int iframe = 0; iframe < nFrames; iframe++) {
+    out << "ITEM: TIMESTEP\n" << 100 * iframe << "\n";
+    out << "ITEM: NUMBER OF ATOMS\n" << nAtoms << "\n";
+    out << "ITEM: BOX BOUNDS pp pp pp\n";
+    out << "0 " << 30 + 0.01 * iframe << "\n0 30\n0 30\n";
+    out << "ITEM: ATOMS id mol type x y z\n";
+    for (int iatom = 0; iatom < nAtoms; iatom++) {
+      for (auto &x : r[iatom]) {
+        x += step(engine);
+      }
+      out << iatom + 1 << " " << iatom / 3 + 1 << " " << 1 + (iatom % 3 == 0)
+          << " " << r[iatom][0] << " " << r[iatom][1] << " " << r[iatom][2]
+          << "\n";
+    }
+  } // end of loop through frames
+}
+
+// True if two PointClouds hold exactly the same frame
+bool sameFrame(const Cloud &a, const Cloud &b) {
+  if (a.nop != b.nop || a.pts.size() != b.pts.size() ||
+      a.currentFrame != b.currentFrame || a.box != b.box ||
+      a.boxLow != b.boxLow || a.idIndexMap != b.idIndexMap) {
+    return false;
+  }
+  for (int iatom = 0; iatom < a.pts.size(); iatom++) {
+    const auto &p = a.pts[iatom];
+    const auto &q = b.pts[iatom];
+    if (p.atomID != q.atomID || p.molID != q.molID || p.type != q.type ||
+        p.x != q.x || p.y != q.y || p.z != q.z) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The frames of the Lua loop for frame=first,last,gap
+std::vector<int> loopFrames(int first, int last, int gap) {
+  std::vector<int> frames;
+  for (int frame = first; gap > 0 ? frame <= last : frame >= last;
+       frame += gap) {
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+} // namespace
+
+SCENARIO("Test the frames read ahead by several threads against the "
+         "synchronous readers.",
+         "[prefetch]") {
+  GIVEN("A trajectory with two types of atoms") {
+    std::string filename = "frameSourceTest.lammpstrj";
+    int nFrames = 30; // Frames in the trajectory
+    writeTrajectory(filename, nFrames, 600);
+    std::array<double, 3> coordLow = {5.0, 0.0, 0.0};
+    std::array<double, 3> coordHigh = {20.0, 30.0, 30.0};
+    // Loops (first, last, gap) forwards, backwards, and with a last frame
+    // which is skipped over
+    std::vector<std::array<int, 3>> loops = {
+        {1, nFrames, 1}, {2, 29, 3}, {28, 3, -4}, {7, 7, 1}};
+    std::vector<sinp::FrameReader> readers = {
+        sinp::FrameReader::allAtoms, sinp::FrameReader::oneType,
+        sinp::FrameReader::reduced, sinp::FrameReader::twoTypes};
+    WHEN("The frames are handed out by sources with several threads") {
+      THEN("Every frame of the loop should come out once, in order, exactly "
+           "as the synchronous reader gives it.") {
+        for (auto &loop : loops) {
+          std::vector<int> frames = loopFrames(loop[0], loop[1], loop[2]);
+          for (auto reader : readers) {
+            for (bool isSlice : {false, true}) {
+              for (int nThreads : {2, 4}) {
+                sinp::FrameSource source(filename, loop[0], loop[1], loop[2],
+                                         reader, 2, isSlice, coordLow,
+                                         coordHigh, 3, nThreads, 1);
+                REQUIRE(source.size() == frames.size());
+                Cloud yCloud, jCloud, expected, expectedJ;
+                for (int frame : frames) {
+                  REQUIRE(source.nextFrame(&yCloud, &jCloud));
+                  switch (reader) {
+                  case sinp::FrameReader::allAtoms:
+                    sinp::readLammpsTrj(filename, frame, &expected, isSlice,
+                                        coordLow, coordHigh);
+                    break;
+                  case sinp::FrameReader::oneType:
+                    sinp::readLammpsTrjO(filename, frame, &expected, 2,
+                                         isSlice, coordLow, coordHigh);
+                    break;
+                  case sinp::FrameReader::reduced:
+                    sinp::readLammpsTrjreduced(filename, frame, &expected, 2,
+                                               isSlice, coordLow, coordHigh);
+                    break;
+                  case sinp::FrameReader::twoTypes:
+                    sinp::readLammpsTrjreduced(filename, frame, &expected, 2,
+                                               isSlice, coordLow, coordHigh);
+                    // The second type is never sliced
+                    sinp::readLammpsTrjreduced(filename, frame, &expectedJ,
+                                               1);
+                    REQUIRE(sameFrame(jCloud, expectedJ));
+                    break;
+                  }
+                  REQUIRE(yCloud.currentFrame == frame);
+                  REQUIRE(yCloud.nop > 0);
+                  REQUIRE(sameFrame(yCloud, expected));
+                } // end of loop through frames
+                REQUIRE(!source.nextFrame(&yCloud, &jCloud));
+                REQUIRE(source.framesRead() == frames.size());
+              } // end of loop through thread counts
+            }
+          } // end of loop through readers
+        }   // end of loop through the loops
+      }     // End of then
+    }       // End of when
+    WHEN("A source is destroyed before all its frames are handed out") {
+      THEN("The threads should stop without reading the rest.") {
+        Cloud yCloud;
+        {
+          sinp::FrameSource source(filename, 1, nFrames, 1,
+                                   sinp::FrameReader::allAtoms, -1, false,
+                                   coordLow, coordHigh, 4, 4);
+          REQUIRE(source.nextFrame(&yCloud));
+          REQUIRE(source.nextFrame(&yCloud));
+          REQUIRE(source.framesRead() == 2);
+        }
+        REQUIRE(yCloud.currentFrame == 2);
+      } // End of then
+    }   // End of when
+    std::remove(filename.c_str());
+  } // End of given
+} // End of scenario
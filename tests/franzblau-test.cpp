@@ -1,12 +1,130 @@
 // Internal
+#include <frame_arena.hpp>
 #include <franzblau.hpp>
+#include <ring.hpp>
+#include <ring_set.hpp>
 
 // Standard
+#include <algorithm>
 #include <iostream>
+#include <memory_resource>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <set>
+#include <utility>
 
 #include <catch2/catch.hpp>
 #include <rang.hpp>
 
+namespace {
+
+// Undirected graph, as a set of edges (i < j)
+using EdgeSet = std::set<std::pair<int, int>>;
+
+// Row-ordered neighbour list by index of a graph
+std::vector<std::vector<int>> listFromEdges(const EdgeSet &edges,
+                                            int nVertices) {
+  std::vector<std::vector<int>> nList(nVertices);
+  for (int iatom = 0; iatom < nVertices; iatom++) {
+    nList[iatom].push_back(iatom);
+  }
+  for (auto &edge : edges) {
+    nList[edge.first].push_back(edge.second);
+    nList[edge.second].push_back(edge.first);
+  }
+  return nList;
+}
+
+// Random geometric graph: vertices closer than rcutoff are joined, which
+// gives a network with rings of many different sizes
+EdgeSet randomNetwork(int nVertices, double boxLength, double rcutoff,
+                      std::mt19937 &engine) {
+  std::uniform_real_distribution<double> position(0.0, boxLength);
+  std::vector<std::array<double, 3>> r(nVertices);
+  EdgeSet edges;
+  for (auto &ri : r) {
+    ri = {position(engine), position(engine), position(engine)};
+  }
+  for (int i = 0; i < nVertices; i++) {
+    for (int j = i + 1; j < nVertices; j++) {
+      double rSq = 0.0;
+      for (int k = 0; k < 3; k++) {
+        rSq += (r[i][k] - r[j][k]) * (r[i][k] - r[j][k]);
+      }
+      if (rSq < rcutoff * rcutoff) {
+        edges.insert({i, j});
+      }
+    }
+  }
+  return edges;
+}
+
+// Number of bonds between a vertex and every other vertex (-1 if unreachable)
+std::vector<int> hopsFrom(const std::vector<std::vector<int>> &nList,
+                          int source) {
+  std::vector<int> hops(nList.size(), -1);
+  std::queue<int> front;
+  hops[source] = 0;
+  front.push(source);
+  while (!front.empty()) {
+    int iatom = front.front();
+    front.pop();
+    for (int j = 1; j < nList[iatom].size(); j++) {
+      int jatom = nList[iatom][j];
+      if (hops[jatom] < 0) {
+        hops[jatom] = hops[iatom] + 1;
+        front.push(jatom);
+      }
+    }
+  }
+  return hops;
+}
+
+// Toggles the edge between i and j
+void toggleEdge(EdgeSet &edges, int i, int j) {
+  std::pair<int, int> edge = {std::min(i, j), std::max(i, j)};
+  if (!edges.erase(edge)) {
+    edges.insert(edge);
+  }
+}
+
+// Adds a cycle through the given vertices, in order
+void addCycle(EdgeSet &edges, const std::vector<int> &vertices) {
+  for (int k = 0; k < vertices.size(); k++) {
+    int i = vertices[k];
+    int j = vertices[(k + 1) % vertices.size()];
+    edges.insert({std::min(i, j), std::max(i, j)});
+  }
+}
+
+// The rings (in the same order) of the given sizes, whose root is marked
+std::vector<std::vector<int>>
+filterRings(const std::vector<std::vector<int>> &rings,
+            const std::vector<int> &ringSizes, const std::vector<char> &roots) {
+  std::vector<std::vector<int>> kept;
+  for (auto &ring : rings) {
+    bool rightSize = ringSizes.empty() ||
+                     std::find(ringSizes.begin(), ringSizes.end(),
+                               ring.size()) != ringSizes.end();
+    if (rightSize && roots[ring[0]]) {
+      kept.push_back(ring);
+    }
+  }
+  return kept;
+}
+
+// Rings with the members of every ring sorted, and the rings sorted
+std::vector<std::vector<int>> sortedRings(std::vector<std::vector<int>> rings) {
+  for (auto &ring : rings) {
+    std::sort(ring.begin(), ring.end());
+  }
+  std::sort(rings.begin(), rings.end());
+  return rings;
+}
+
+} // namespace
+
 SCENARIO(
     "Test the number of rings formed when there is one 4-membered ring and one "
     "3-membered ring.",
@@ -183,3 +301,273 @@ SCENARIO(
     }  // End of getting all the rings (non-primitive included)
   }    // End of given
 } // End of scenario
+
+SCENARIO("Test the incremental ring update against a full search, over a "
+         "graph perturbed step by step.",
+         "[ring]") {
+  GIVEN("A random network with rings of many sizes") {
+    std::mt19937 engine(7);  // Fixed seed, for reproducibility
+    int nVertices = 600;     // Number of vertices
+    int maxDepth = 6;        // Maximum depth of the ring search
+    EdgeSet edges = randomNetwork(nVertices, 14.2, 1.7, engine);
+    std::uniform_int_distribution<int> vertex(0, nVertices - 1);
+    primitive::RingTracker tracker;       // Rings of the previous step
+    std::vector<std::vector<int>> nList;  // Neighbour list by index
+    std::vector<std::vector<int>> rings;  // Rings from a full search
+    WHEN("Bonds are added and removed at every step") {
+      THEN("The tracked rings should always be those of a full search.") {
+        for (int step = 0; step < 24; step++) {
+          if (step > 0) {
+            // One or two random bonds toggled anywhere
+            int nToggles = 1 + step % 2;
+            for (int k = 0; k < nToggles; k++) {
+              int i = vertex(engine);
+              int j = vertex(engine);
+              if (i != j) {
+                toggleEdge(edges, i, j);
+              }
+            }
+            // A bond toggled at the edge of the region searched again
+            // around vertex a: between the vertices maxDepth-2 and
+            // maxDepth-1 bonds away, or maxDepth-1 and maxDepth bonds away
+            int a = vertex(engine);
+            int changed = vertex(engine);
+            toggleEdge(edges, a, changed == a ? (a + 1) % nVertices : changed);
+            std::vector<int> hops = hopsFrom(nList, a);
+            int inner = maxDepth - 2 + step % 2;
+            for (auto &edge : edges) {
+              if ((hops[edge.first] == inner &&
+                   hops[edge.second] == inner + 1) ||
+                  (hops[edge.second] == inner &&
+                   hops[edge.first] == inner + 1)) {
+                toggleEdge(edges, edge.first, edge.second);
+                break;
+              }
+            } // end of search for a bond at the edge
+          }   // perturb the graph
+          nList = listFromEdges(edges, nVertices);
+          rings = primitive::ringNetwork(nList, maxDepth);
+          REQUIRE(!rings.empty());
+          std::vector<std::vector<int>> tracked =
+              primitive::ringNetworkIncremental(tracker, nList, maxDepth);
+          REQUIRE(sortedRings(tracked) == sortedRings(rings));
+          // The rings are also in the same order
+          REQUIRE(tracked == rings);
+        } // end of loop through steps
+        REQUIRE(tracker.nFull == 1);
+        REQUIRE(tracker.nIncremental == 23);
+        // Every ring size up to maxDepth should have been seen
+        std::set<int> sizes;
+        for (auto &ring : rings) {
+          sizes.insert(ring.size());
+        }
+        REQUIRE(sizes.size() >= 3);
+      }
+    } // End of perturbing the graph
+  }   // End of given
+} // End of scenario
+
+SCENARIO("Test the ring search restricted to some ring sizes or some roots "
+         "against a full search.",
+         "[ring]") {
+  GIVEN("A network of fused 4-, 5-, 6- and 7-membered rings, a ring too large "
+        "to be found, isolated vertices and a random network") {
+    std::mt19937 engine(49); // Fixed seed, for reproducibility
+    int maxDepth = 7;        // Maximum depth of the ring search
+    EdgeSet edges;
+    // Fused rings: each one shares a bond with the previous one
+    addCycle(edges, {0, 1, 2, 3});
+    addCycle(edges, {3, 2, 4, 5, 6});
+    addCycle(edges, {6, 5, 7, 8, 9, 10});
+    addCycle(edges, {10, 9, 11, 12, 13, 14, 15});
+    // A ring of sixteen, too large to be found. The opposite side of the
+    // ring is out of the reach of the search from any of its vertices
+    std::vector<int> largeRing(16);
+    std::iota(largeRing.begin(), largeRing.end(), 16);
+    addCycle(edges, largeRing);
+    // Vertices 32 and 33 are isolated (unreachable from any other vertex);
+    // the random network starts at 34
+    int offset = 34;
+    int nRandom = 300;
+    for (auto &edge : randomNetwork(nRandom, 11.3, 1.7, engine)) {
+      edges.insert({edge.first + offset, edge.second + offset});
+    }
+    int nVertices = offset + nRandom;
+    std::vector<std::vector<int>> nList = listFromEdges(edges, nVertices);
+    std::vector<std::vector<int>> rings =
+        primitive::ringNetwork(nList, maxDepth);
+    std::vector<char> everyRoot(nVertices, 1);
+    // The fused rings are found, and nothing else among the first vertices
+    std::vector<std::vector<int>> fused;
+    for (auto &ring : rings) {
+      if (ring[0] < offset) {
+        fused.push_back(ring);
+      }
+    }
+    REQUIRE(sortedRings(fused) ==
+            sortedRings({{0, 1, 2, 3},
+                         {2, 3, 4, 5, 6},
+                         {5, 6, 7, 8, 9, 10},
+                         {9, 10, 11, 12, 13, 14, 15}}));
+    std::set<int> sizes;
+    for (auto &ring : rings) {
+      sizes.insert(ring.size());
+    }
+    REQUIRE(sizes.size() >= 4);
+    std::vector<std::vector<int>> sizeSets = {
+        {4, 5, 6, 7}, {3, 4}, {5, 7}, {6}, {7}, {4, 6, 7}};
+    WHEN("only rings of some sizes are searched for") {
+      THEN("they are the rings of the full search of these sizes, in the same "
+           "order") {
+        for (auto &ringSizes : sizeSets) {
+          std::vector<std::vector<int>> expected =
+              filterRings(rings, ringSizes, everyRoot);
+          REQUIRE(primitive::ringNetworkOfSizes(nList, ringSizes) ==
+                  expected);
+          if (*std::max_element(ringSizes.begin(), ringSizes.end()) ==
+              maxDepth) {
+            REQUIRE(!expected.empty());
+          }
+        } // end of loop through the sets of ring sizes
+      }   // End of then
+    }     // End of when
+    WHEN("only some roots are searched from") {
+      std::bernoulli_distribution marked(0.3);
+      std::vector<char> roots(nVertices);
+      for (auto &root : roots) {
+        root = marked(engine);
+      }
+      // Some of the fused rings, the large ring and an isolated vertex
+      roots[0] = roots[6] = roots[16] = roots[32] = 1;
+      roots[2] = roots[9] = 0;
+      THEN("they are the rings of the full search with these roots, in the "
+           "same order") {
+        std::vector<std::vector<int>> expected =
+            filterRings(rings, {}, roots);
+        REQUIRE(!expected.empty());
+        REQUIRE(primitive::ringNetworkFromRoots(nList, maxDepth, roots) ==
+                expected);
+        REQUIRE(primitive::ringNetworkFromRoots(nList, maxDepth, everyRoot) ==
+                rings);
+        for (auto &ringSizes : sizeSets) {
+          REQUIRE(primitive::ringNetworkFromRoots(nList, maxDepth, roots,
+                                                  ringSizes) ==
+                  filterRings(rings, ringSizes, roots));
+        } // end of loop through the sets of ring sizes
+      }   // End of then
+    }     // End of when
+  }       // End of given
+} // End of scenario
+
+SCENARIO("Test the rings bucketed by size against the full list of rings.",
+         "[ring]") {
+  GIVEN("The rings of a random network with rings of many sizes") {
+    std::mt19937 engine(40); // Fixed seed, for reproducibility
+    int nVertices = 400;     // Number of vertices
+    int maxDepth = 7;        // Maximum depth of the ring search
+    std::vector<std::vector<int>> nList =
+        listFromEdges(randomNetwork(nVertices, 12.4, 1.7, engine), nVertices);
+    std::vector<std::vector<int>> rings =
+        primitive::ringNetwork(nList, maxDepth);
+    REQUIRE(!rings.empty());
+    WHEN("The rings are sorted into buckets") {
+      ring::RingsBySize bySize(rings);
+      // Built one ring at a time
+      ring::RingsBySize added;
+      for (auto &ring : rings) {
+        added.add(ring);
+      }
+      THEN("Every bucket should hold the rings of ring::getSingleRingSize, "
+           "with stable global IDs.") {
+        REQUIRE(bySize.size() == rings.size());
+        REQUIRE(bySize.toVector() == rings);
+        int nSizes = 0; // Ring sizes with at least one ring
+        for (int ringSize = 0; ringSize <= maxDepth + 1; ringSize++) {
+          std::vector<std::vector<int>> expected =
+              ring::getSingleRingSize(rings, ringSize);
+          nSizes += !expected.empty();
+          REQUIRE(bySize.ofSize(ringSize) == expected);
+          REQUIRE(bySize.count(ringSize) == expected.size());
+          REQUIRE(added.ofSize(ringSize) == expected);
+          // The global ID of a ring is its index in the full list
+          const std::vector<int> &ids = bySize.idsOfSize(ringSize);
+          REQUIRE(ids.size() == expected.size());
+          REQUIRE(std::is_sorted(ids.begin(), ids.end()));
+          for (int k = 0; k < ids.size(); k++) {
+            REQUIRE(rings[ids[k]] == expected[k]);
+            REQUIRE(bySize.ring(ids[k]) == expected[k]);
+          }
+          REQUIRE(added.idsOfSize(ringSize) == ids);
+        } // end of loop through ring sizes
+        REQUIRE(nSizes >= 3);
+        // The search which fills the buckets directly gives the same IDs
+        ring::RingsBySize searched =
+            primitive::ringNetworkBySize(nList, maxDepth);
+        REQUIRE(searched.toVector() == rings);
+        for (int id = 0; id < rings.size(); id++) {
+          REQUIRE(searched.ring(id) == rings[id]);
+        }
+      } // End of then
+    }   // End of when
+  }     // End of given
+} // End of scenario
+
+SCENARIO("Test that the ring search gives the same rings, without asking the "
+         "heap for memory, frame after frame.",
+         "[ring]") {
+  GIVEN("Two random networks with rings of many sizes, read in turns") {
+    std::mt19937 engine(11); // Fixed seed, for reproducibility
+    int maxDepth = 7;        // Maximum depth of the ring search
+    std::vector<std::vector<std::vector<int>>> frames;
+    frames.push_back(
+        listFromEdges(randomNetwork(300, 11.3, 1.7, engine), 300));
+    frames.push_back(
+        listFromEdges(randomNetwork(450, 13.0, 1.7, engine), 450));
+    // Rings of the first search of each frame
+    std::vector<std::vector<std::vector<int>>> firstRings;
+    for (auto &nList : frames) {
+      firstRings.push_back(primitive::ringNetwork(nList, maxDepth));
+      REQUIRE(!firstRings.back().empty());
+    }
+    WHEN("The frames are searched again and again") {
+      THEN("The rings should not change, and the arena should stop growing "
+           "once it fits the largest frame.") {
+        std::uint64_t heapBlocks = 0; // Blocks requested after warming up
+        for (int round = 0; round < 6; round++) {
+          if (round == 1) {
+            heapBlocks = smem::stats().upstreamAllocations;
+          }
+          for (int iframe = 0; iframe < frames.size(); iframe++) {
+            REQUIRE(primitive::ringNetwork(frames[iframe], maxDepth) ==
+                    firstRings[iframe]);
+            REQUIRE(
+                primitive::ringNetworkBySize(frames[iframe], maxDepth)
+                    .toVector() == firstRings[iframe]);
+          }
+        } // end of loop through rounds
+        REQUIRE(smem::stats().upstreamAllocations == heapBlocks);
+        // No scope is left open by the searches
+        REQUIRE(smem::scratch() == std::pmr::new_delete_resource());
+      } // End of then
+    }   // End of when
+    WHEN("A graph is built with no scratch scope open") {
+      primitive::Graph fullGraph =
+          primitive::countAllRingsFromIndex(frames[0], maxDepth);
+      primitive::removeNonSPrings(&fullGraph);
+      // Scopes opened and closed while the graph is alive
+      primitive::ringNetwork(frames[1], maxDepth);
+      THEN("It should live on the heap, and keep its rings after other "
+           "searches.") {
+        REQUIRE(fullGraph.rings.get_allocator().resource() ==
+                std::pmr::new_delete_resource());
+        REQUIRE(fullGraph.pts[0].neighListIndex.get_allocator().resource() ==
+                std::pmr::new_delete_resource());
+        std::vector<std::vector<int>> rings;
+        for (auto &ring : fullGraph.rings) {
+          rings.emplace_back(ring.begin(), ring.end());
+        }
+        REQUIRE(rings == firstRings[0]);
+      } // End of then
+    }   // End of when
+  }     // End of given
+} // End of scenario
@@ -0,0 +1,144 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <bond.hpp>
+#include <mol_sys.hpp>
+#include <neighbours.hpp>
+
+// Standard
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+using Cloud = molSys::PointCloud<molSys::Point<double>, double>;
+
+// Random atoms in a periodic box, with atom IDs which are neither contiguous
+// nor in increasing order
+Cloud randomCloud(int nAtoms, double boxLength, std::mt19937 &engine) {
+  std::uniform_real_distribution<double> position(0.0, boxLength);
+  std::vector<int> atomIDs(nAtoms);
+  for (int iatom = 0; iatom < nAtoms; iatom++) {
+    atomIDs[iatom] = 3 * iatom + 7;
+  }
+  std::shuffle(atomIDs.begin(), atomIDs.end(), engine);
+  Cloud yCloud;
+  for (int iatom = 0; iatom < nAtoms; iatom++) {
+    molSys::Point<double> iPoint;
+    iPoint.type = 1;
+    iPoint.atomID = atomIDs[iatom];
+    iPoint.molID = iPoint.atomID / 3;
+    iPoint.x = position(engine);
+    iPoint.y = position(engine);
+    iPoint.z = position(engine);
+    yCloud.pts.push_back(iPoint);
+    yCloud.idIndexMap[iPoint.atomID] = iatom;
+  } // end of loop through atoms
+  yCloud.nop = nAtoms;
+  yCloud.box = {boxLength, boxLength, boxLength};
+  yCloud.boxLow = {0.0, 0.0, 0.0};
+  yCloud.currentFrame = 1;
+  return yCloud;
+}
+
+// The neighbour list of a reordered cloud, with every index replaced by the
+// position of the atom in the file, and the rows in file order. The
+// neighbours of every atom are sorted
+std::vector<std::vector<int>>
+nListInFileOrder(const std::vector<std::vector<int>> &nList,
+                 const Cloud &yCloud) {
+  std::vector<int> position = molSys::filePositions(&yCloud);
+  std::vector<std::vector<int>> mapped(nList.size());
+  for (int k = 0; k < nList.size(); k++) {
+    for (int iatom : nList[molSys::fileIndex(&yCloud, k)]) {
+      mapped[k].push_back(position[iatom]);
+    }
+    std::sort(mapped[k].begin() + 1, mapped[k].end());
+  } // end of loop through atoms
+  return mapped;
+}
+
+} // namespace
+
+SCENARIO("Test that reordering the atoms along a space-filling curve can be "
+         "undone.",
+         "[mol_sys]") {
+  GIVEN("Random atoms in the order in which they were read in") {
+    std::mt19937 engine(47); // Fixed seed, for reproducibility
+    Cloud original = randomCloud(300, 14.0, engine);
+    double rcutoff = 3.2;
+    std::vector<std::vector<int>> nList = nneigh::neighbourListByIndex(
+        &original, nneigh::neighListO(rcutoff, &original, 1));
+    bond::BondList bonds = bond::populateBonds(nList, &original);
+    REQUIRE(bonds.size() > 300);
+    // The same neighbour list, with sorted rows
+    std::vector<std::vector<int>> expected =
+        nListInFileOrder(nList, original);
+    // Orders to put the atoms in, one after the other
+    std::vector<std::vector<molSys::AtomOrder>> orderings = {
+        {molSys::AtomOrder::morton},
+        {molSys::AtomOrder::hilbert},
+        {molSys::AtomOrder::morton, molSys::AtomOrder::hilbert},
+        {molSys::AtomOrder::hilbert, molSys::AtomOrder::file}};
+    for (auto &orders : orderings) {
+      WHEN("The atoms are reordered") {
+        Cloud reordered = original;
+        for (auto order : orders) {
+          molSys::reorderAtoms(&reordered, order);
+        }
+        THEN("The file order should give back the atoms as they were read.") {
+          REQUIRE(reordered.fileOrder.size() == original.pts.size());
+          std::vector<int> position = molSys::filePositions(&reordered);
+          int nMoved = 0;
+          for (int k = 0; k < original.pts.size(); k++) {
+            int iatom = molSys::fileIndex(&reordered, k);
+            nMoved += iatom != k;
+            // fileIndex and filePositions are inverse permutations
+            REQUIRE(position[iatom] == k);
+            REQUIRE(reordered.pts[iatom].atomID == original.pts[k].atomID);
+            REQUIRE(reordered.pts[iatom].x == original.pts[k].x);
+            REQUIRE(reordered.pts[iatom].y == original.pts[k].y);
+            REQUIRE(reordered.pts[iatom].z == original.pts[k].z);
+            REQUIRE(reordered.idIndexMap.at(original.pts[k].atomID) == iatom);
+          } // end of loop through atoms
+          REQUIRE(nMoved > 250);
+          // Neighbouring atoms have nearby indices along the curve
+          std::vector<std::vector<int>> reorderedList =
+              nneigh::neighbourListByIndex(
+                  &reordered, nneigh::neighListO(rcutoff, &reordered, 1));
+          long spanBefore = 0, spanAfter = 0;
+          for (int iatom = 0; iatom < nList.size(); iatom++) {
+            for (int j = 1; j < nList[iatom].size(); j++) {
+              spanBefore += std::abs(nList[iatom][j] - iatom);
+            }
+            for (int j = 1; j < reorderedList[iatom].size(); j++) {
+              spanAfter += std::abs(reorderedList[iatom][j] - iatom);
+            }
+          } // end of loop through atoms
+          REQUIRE(spanAfter < spanBefore / 2);
+          // The neighbour list maps back onto the one before reordering
+          REQUIRE(nListInFileOrder(reorderedList, reordered) == expected);
+          // The bonds are the same, in the same order
+          REQUIRE(bond::populateBonds(reorderedList, &reordered).keys ==
+                  bonds.keys);
+        }
+      } // End of reordering
+    }   // end of loop through orderings
+  } // End of given
+} // End of scenario
@@ -0,0 +1,397 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <mol_sys.hpp>
+#include <neighbours.hpp>
+
+// Standard
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+// Neighbour list with the neighbours of every atom sorted, since the order
+// within a row is not part of the result
+std::vector<std::vector<int>> sortedRows(std::vector<std::vector<int>> nList) {
+  for (auto &row : nList) {
+    if (row.size() > 1) {
+      std::sort(row.begin() + 1, row.end());
+    }
+  }
+  return nList;
+}
+
+// Moves an atom by (dx, dy, dz), wrapping it back into the box
+void moveAtom(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+              int iatom, double dx, double dy, double dz) {
+  auto &point = yCloud->pts[iatom];
+  point.x = std::fmod(point.x + dx + yCloud->box[0], yCloud->box[0]);
+  point.y = std::fmod(point.y + dy + yCloud->box[1], yCloud->box[1]);
+  point.z = std::fmod(point.z + dz + yCloud->box[2], yCloud->box[2]);
+}
+
+// The bond test the topological criteria used before nneigh::Adjacency: a
+// search of row iatom of the neighbour list, after its first element
+bool foundInRow(const std::vector<std::vector<int>> &nList, int iatom,
+                int jatom) {
+  return std::find(nList[iatom].begin() + 1, nList[iatom].end(), jatom) !=
+         nList[iatom].end();
+}
+
+// Periodic distance exactly as the brute-force neighbour lists computed it
+// before the coordinates were packed
+double baselineDist(molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                    int iatom, int jatom) {
+  std::array<double, 3> dr;
+  double r2 = 0.0;
+  dr[0] = fabs(yCloud->pts[iatom].x - yCloud->pts[jatom].x);
+  dr[1] = fabs(yCloud->pts[iatom].y - yCloud->pts[jatom].y);
+  dr[2] = fabs(yCloud->pts[iatom].z - yCloud->pts[jatom].z);
+  for (int k = 0; k < 3; k++) {
+    dr[k] -= yCloud->box[k] * round(dr[k] / yCloud->box[k]);
+    r2 += pow(dr[k], 2.0);
+  }
+  return sqrt(r2);
+}
+
+// The brute-force neighListO (or halfNeighList, if half is set) as it was
+// before the coordinates were packed: pairs in the order of the loops, by ID
+std::vector<std::vector<int>>
+baselineList(double rcutoff,
+             molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+             int typeI, bool half) {
+  std::vector<int> atomIDs(yCloud->nop);
+  for (auto &p : yCloud->idIndexMap) {
+    atomIDs[p.second] = p.first;
+  }
+  std::vector<std::vector<int>> nList(yCloud->nop);
+  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
+    nList[iatom].push_back(atomIDs[iatom]);
+  }
+  for (int iatom = 0; iatom < yCloud->nop - 1; iatom++) {
+    if (yCloud->pts[iatom].type != typeI) {
+      continue;
+    }
+    for (int jatom = iatom + 1; jatom < yCloud->nop; jatom++) {
+      if (yCloud->pts[jatom].type != typeI) {
+        continue;
+      }
+      if (baselineDist(yCloud, iatom, jatom) > rcutoff) {
+        continue;
+      }
+      nList[iatom].push_back(atomIDs[jatom]);
+      if (!half) {
+        nList[jatom].push_back(atomIDs[iatom]);
+      }
+    } // end of loop through jatom
+  }   // end of loop through iatom
+  return nList;
+}
+
+// Pairs of atom IDs (the lower one first) in a neighbour list by ID
+std::set<std::pair<int, int>>
+pairsOf(const std::vector<std::vector<int>> &nList) {
+  std::set<std::pair<int, int>> pairs;
+  for (auto &row : nList) {
+    for (int j = 1; j < row.size(); j++) {
+      pairs.insert(std::minmax(row[0], row[j]));
+    }
+  }
+  return pairs;
+}
+
+} // namespace
+
+SCENARIO("Test the Verlet skin neighbour list against a full rebuild.",
+         "[neighbours]") {
+  GIVEN("Random atoms of two types in a periodic box") {
+    molSys::PointCloud<molSys::Point<double>, double> yCloud; // pointCloud
+    molSys::Point<double> iPoint;                             // A single point
+    nneigh::VerletList verlet;        // Saved pairs across frames
+    std::mt19937 engine(2024);        // Fixed seed, for reproducibility
+    std::uniform_real_distribution<double> position(0.0, 15.0);
+    std::uniform_real_distribution<double> jiggle(-0.02, 0.02);
+    double rcutoff = 3.0;             // Neighbour cutoff
+    verlet.skin = 0.6;
+    //
+    yCloud.box = {15.0, 15.0, 15.0};
+    yCloud.boxLow = {0.0, 0.0, 0.0};
+    for (int iatom = 0; iatom < 400; iatom++) {
+      iPoint.atomID = iatom + 1;
+      iPoint.molID = iatom + 1;
+      iPoint.type = 1 + iatom % 3 / 2; // two thirds are of type 1
+      iPoint.x = position(engine);
+      iPoint.y = position(engine);
+      iPoint.z = position(engine);
+      yCloud.pts.push_back(iPoint);
+      yCloud.idIndexMap[iPoint.atomID] = iatom;
+    } // end of filling the pointCloud
+    yCloud.nop = yCloud.pts.size();
+    // --------------------
+    WHEN("The atoms are displaced frame after frame") {
+      THEN("The Verlet list should always match neighListO, and should only "
+           "be rebuilt after an atom moves by more than half the skin.") {
+        // First frame: the pairs are built
+        REQUIRE(sortedRows(nneigh::neighListOVerlet(verlet, rcutoff, &yCloud,
+                                                    1)) ==
+                sortedRows(nneigh::neighListO(rcutoff, &yCloud, 1)));
+        REQUIRE(verlet.nBuilds == 1);
+        // Small displacements, wrapped across the boundaries (at most
+        // 5*sqrt(3)*0.02 in total, well within half the skin)
+        for (int frame = 0; frame < 5; frame++) {
+          for (int iatom = 0; iatom < yCloud.nop; iatom++) {
+            moveAtom(&yCloud, iatom, jiggle(engine), jiggle(engine),
+                     jiggle(engine));
+          }
+          REQUIRE(sortedRows(nneigh::neighListOVerlet(verlet, rcutoff,
+                                                      &yCloud, 1)) ==
+                  sortedRows(nneigh::neighListO(rcutoff, &yCloud, 1)));
+        } // end of loop through frames
+        REQUIRE(verlet.nBuilds == 1);
+        REQUIRE(verlet.nReuses == 5);
+        // The atoms written out in a different order
+        std::reverse(yCloud.pts.begin(), yCloud.pts.end());
+        for (int iatom = 0; iatom < yCloud.nop; iatom++) {
+          yCloud.idIndexMap[yCloud.pts[iatom].atomID] = iatom;
+        }
+        REQUIRE(sortedRows(nneigh::neighListOVerlet(verlet, rcutoff, &yCloud,
+                                                    1)) ==
+                sortedRows(nneigh::neighListO(rcutoff, &yCloud, 1)));
+        REQUIRE(verlet.nBuilds == 1);
+        // One atom of type 1 moves by more than half the skin
+        int moved = 0;
+        while (yCloud.pts[moved].type != 1) {
+          moved++;
+        }
+        moveAtom(&yCloud, moved, 0.4, 0.0, 0.0);
+        REQUIRE(sortedRows(nneigh::neighListOVerlet(verlet, rcutoff, &yCloud,
+                                                    1)) ==
+                sortedRows(nneigh::neighListO(rcutoff, &yCloud, 1)));
+        REQUIRE(verlet.nBuilds == 2);
+        // The new pairs are reused for the next small step
+        for (int iatom = 0; iatom < yCloud.nop; iatom++) {
+          moveAtom(&yCloud, iatom, jiggle(engine), jiggle(engine),
+                   jiggle(engine));
+        }
+        REQUIRE(sortedRows(nneigh::neighListOVerlet(verlet, rcutoff, &yCloud,
+                                                    1)) ==
+                sortedRows(nneigh::neighListO(rcutoff, &yCloud, 1)));
+        REQUIRE(verlet.nBuilds == 2);
+      }
+    } // End of displacing the atoms
+  }   // End of given
+} // End of scenario
+
+SCENARIO("Test the constant-time bond lookup against a search of the "
+         "neighbour list.",
+         "[neighbours]") {
+  GIVEN("Random neighbour lists, full and half") {
+    std::mt19937 engine(45); // Fixed seed, for reproducibility
+    int nAtoms = 300;        // Number of atoms
+    std::uniform_int_distribution<int> atom(0, nAtoms - 1);
+    std::uniform_int_distribution<int> nNeighbours(0, 6);
+    // Directed random bonds: every row has up to six neighbours (possibly
+    // repeated), and some rows have none. The first element of a row is
+    // usually the atom itself, but sometimes another atom, which must not
+    // count as a bond either
+    std::vector<std::vector<int>> full(nAtoms);
+    for (int iatom = 0; iatom < nAtoms; iatom++) {
+      full[iatom].push_back(iatom % 7 == 0 ? atom(engine) : iatom);
+      int n = iatom % 11 == 0 ? 0 : nNeighbours(engine);
+      for (int k = 0; k < n; k++) {
+        full[iatom].push_back(atom(engine));
+      }
+    } // end of building the full list
+    // Symmetric bonds, with only the higher atom kept on each row (i bonded to
+    // j but not j to i)
+    std::vector<std::vector<int>> half(nAtoms);
+    for (int iatom = 0; iatom < nAtoms; iatom++) {
+      half[iatom].push_back(iatom);
+      for (int j = 1; j < full[iatom].size(); j++) {
+        if (full[iatom][j] > iatom) {
+          half[iatom].push_back(full[iatom][j]);
+        }
+      }
+    } // end of building the half list
+    for (auto *nList : {&full, &half}) {
+      WHEN("The bonds are looked up in an Adjacency, for the " +
+           std::string(nList == &full ? "full" : "half") + " list") {
+        nneigh::Adjacency bonded(*nList);
+        THEN("Every pair of atoms should be bonded exactly if the neighbour "
+             "list has it.") {
+          int nBonds = 0;      // Pairs found in the neighbour list
+          int nDirected = 0;   // Of which only in one direction
+          int nEmptyRows = 0;  // Rows with no neighbours
+          int nSelfBonds = 0;  // First elements also among the neighbours
+          for (int iatom = 0; iatom < nAtoms; iatom++) {
+            nEmptyRows += (*nList)[iatom].size() == 1;
+            // The first element of the row is not a bond, unless it is also
+            // one of the neighbours
+            int self = (*nList)[iatom][0];
+            REQUIRE(bonded.areBonded(iatom, self) ==
+                    foundInRow(*nList, iatom, self));
+            nSelfBonds += foundInRow(*nList, iatom, self);
+            for (int jatom = 0; jatom < nAtoms; jatom++) {
+              bool isBond = foundInRow(*nList, iatom, jatom);
+              REQUIRE(bonded.areBonded(iatom, jatom) == isBond);
+              if (isBond) {
+                nBonds++;
+                nDirected += !foundInRow(*nList, jatom, iatom);
+              }
+            } // end of loop through the second atoms
+            // Atoms which are not in the list at all
+            REQUIRE(!bonded.areBonded(iatom, nAtoms + iatom));
+            REQUIRE(!bonded.areBonded(iatom, -1));
+          } // end of loop through the first atoms
+          REQUIRE(bonded.size() == nBonds);
+          REQUIRE(nDirected > 0);
+          REQUIRE(nEmptyRows > 0);
+          REQUIRE(nSelfBonds < nAtoms / 10);
+        } // End of then
+      }   // End of when
+    }     // end of loop through the lists
+    WHEN("The neighbour list is empty, or has no neighbours at all") {
+      THEN("No atoms should be bonded.") {
+        nneigh::Adjacency none;
+        REQUIRE(!none.areBonded(0, 1));
+        std::vector<std::vector<int>> lonely = {{0}, {1}, {2}};
+        nneigh::Adjacency bonded(lonely);
+        REQUIRE(bonded.size() == 0);
+        for (int iatom = 0; iatom < 3; iatom++) {
+          for (int jatom = 0; jatom < 3; jatom++) {
+            REQUIRE(!bonded.areBonded(iatom, jatom));
+          }
+        }
+      }
+    } // End of the empty lists
+  }   // End of given
+} // End of scenario
+
+SCENARIO("Test the brute-force neighbour lists in both precisions against "
+         "the lists computed before the coordinates were packed.",
+         "[neighbours]") {
+  GIVEN("Random atoms of two types, and pairs placed on the cutoff") {
+    molSys::PointCloud<molSys::Point<double>, double> yCloud; // pointCloud
+    molSys::Point<double> iPoint;                             // A single point
+    std::mt19937 engine(77); // Fixed seed, for reproducibility
+    double rcutoff = 3.2;    // Neighbour cutoff
+    yCloud.box = {14.0, 15.0, 16.0};
+    yCloud.boxLow = {0.0, 0.0, 0.0};
+    std::uniform_real_distribution<double> position(0.0, 14.0);
+    auto addAtom = [&](double x, double y, double z, int type) {
+      iPoint.atomID = 3 * yCloud.pts.size() + 5; // IDs which are not indices
+      iPoint.molID = iPoint.atomID;
+      iPoint.type = type;
+      iPoint.x = x;
+      iPoint.y = y;
+      iPoint.z = z;
+      yCloud.idIndexMap[iPoint.atomID] = yCloud.pts.size();
+      yCloud.pts.push_back(iPoint);
+    };
+    for (int iatom = 0; iatom < 500; iatom++) {
+      addAtom(position(engine), position(engine) + 0.5,
+              position(engine) + 1.0, 1 + iatom % 4 / 3);
+    }
+    // Pairs at the cutoff, just inside and just outside it (closer than
+    // float precision), some of them across the periodic boundary
+    for (int k = 0; k < 12; k++) {
+      double separation = rcutoff * (1.0 + (k % 3 - 1) * 1e-7);
+      double x = k < 6 ? 1.0 + 2.0 * k : 0.4 + 0.2 * k;
+      double xj = x + separation;
+      if (xj >= yCloud.box[0]) {
+        xj -= yCloud.box[0];
+      }
+      if (k >= 6) {
+        // The partner on the other side of the boundary
+        xj = x - separation + yCloud.box[0];
+      }
+      addAtom(x, 1.3 * k, 7.5, 1);
+      addAtom(xj, 1.3 * k, 7.5, 1);
+    }
+    yCloud.nop = yCloud.pts.size();
+    molSys::Precision previous = molSys::precision();
+    // --------------------
+    WHEN("The lists are computed in double precision") {
+      molSys::setPrecision(molSys::Precision::full);
+      std::vector<std::vector<int>> fullList =
+          nneigh::neighListO(rcutoff, &yCloud, 1);
+      std::vector<std::vector<int>> halfList =
+          nneigh::halfNeighList(rcutoff, &yCloud, 1);
+      molSys::setPrecision(previous);
+      THEN("They should be exactly the lists computed before, in the same "
+           "order.") {
+        REQUIRE(fullList == baselineList(rcutoff, &yCloud, 1, false));
+        REQUIRE(halfList == baselineList(rcutoff, &yCloud, 1, true));
+        REQUIRE(nneigh::neighListO(rcutoff, &yCloud, 2) ==
+                baselineList(rcutoff, &yCloud, 2, false));
+      }
+    } // End of double precision
+    WHEN("The lists are computed in single precision") {
+      molSys::setPrecision(molSys::Precision::single);
+      std::vector<std::vector<int>> fullList =
+          nneigh::neighListO(rcutoff, &yCloud, 1);
+      std::vector<std::vector<int>> halfList =
+          nneigh::halfNeighList(rcutoff, &yCloud, 1);
+      molSys::setPrecision(previous);
+      THEN("They should only differ for pairs within float precision of the "
+           "cutoff.") {
+        std::vector<std::vector<int>> expected =
+            baselineList(rcutoff, &yCloud, 1, false);
+        REQUIRE(fullList.size() == expected.size());
+        REQUIRE(halfList.size() == expected.size());
+        for (int iatom = 0; iatom < yCloud.nop; iatom++) {
+          REQUIRE(fullList[iatom][0] == expected[iatom][0]);
+          REQUIRE(halfList[iatom][0] == expected[iatom][0]);
+        }
+        std::set<std::pair<int, int>> basePairs = pairsOf(expected);
+        // Rounding the coordinates (up to the box length) to floats moves
+        // distances by a few float epsilons of the box length at most
+        double tolerance = 16.0 * FLT_EPSILON * yCloud.box[2];
+        for (auto *nList : {&fullList, &halfList}) {
+          std::set<std::pair<int, int>> pairs = pairsOf(*nList);
+          std::vector<std::pair<int, int>> differing;
+          std::set_symmetric_difference(pairs.begin(), pairs.end(),
+                                        basePairs.begin(), basePairs.end(),
+                                        std::back_inserter(differing));
+          for (auto &pair : differing) {
+            double dist =
+                baselineDist(&yCloud, yCloud.idIndexMap[pair.first],
+                             yCloud.idIndexMap[pair.second]);
+            REQUIRE(std::fabs(dist - rcutoff) <= tolerance);
+          }
+          // Nearly every pair is found in both precisions
+          REQUIRE(differing.size() <= 12);
+        }
+        // The half list holds every pair once
+        int nHalf = 0;
+        for (auto &row : halfList) {
+          nHalf += row.size() - 1;
+        }
+        REQUIRE(nHalf == pairsOf(halfList).size());
+      }
+    } // End of single precision
+  }   // End of given
+} // End of scenario
@@ -0,0 +1,104 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <output_sink.hpp>
+
+// Standard
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+// Reads a whole file, line by line
+std::vector<std::string> readLines(const std::string &filename) {
+  std::vector<std::string> lines;
+  std::ifstream inpFile(filename);
+  std::string line;
+  while (std::getline(inpFile, line)) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+} // namespace
+
+SCENARIO("Test that interleaved appends to two sinks are written out in "
+         "order.",
+         "[output_sink]") {
+  GIVEN("Two files appended to in turns, with more output than the flush "
+        "threshold") {
+    std::string fileA = "sinkInterleavedA.dat";
+    std::string fileB = "sinkInterleavedB.dat";
+    std::remove(fileA.c_str());
+    std::remove(fileB.c_str());
+    // About 3 MB per file, so that each one is handed over in several jobs
+    int nLines = 3 * static_cast<int>(sout::OutputSink::flushThreshold) / 20;
+    // A line which is as long as a few lines, to shift the job boundaries
+    std::string padding(37, 'x');
+    WHEN("The lines are printed alternately to the two sinks") {
+      for (int i = 0; i < nLines; i++) {
+        sout::appendSink(fileA).print("{} A\n", i);
+        sout::appendSink(fileB).print("{} B {}\n", i, padding);
+      }
+      int flushResult = sout::flushAllSinks();
+      THEN("Both files should hold every line, in order, after the flush.") {
+        REQUIRE(flushResult == 0);
+        std::vector<std::string> linesA = readLines(fileA);
+        std::vector<std::string> linesB = readLines(fileB);
+        REQUIRE(linesA.size() == static_cast<std::size_t>(nLines));
+        REQUIRE(linesB.size() == static_cast<std::size_t>(nLines));
+        bool inOrder = true;
+        for (int i = 0; i < nLines; i++) {
+          inOrder = inOrder && linesA[i] == std::to_string(i) + " A" &&
+                    linesB[i] == std::to_string(i) + " B " + padding;
+        }
+        REQUIRE(inOrder);
+        // Appending after the flush continues the same files
+        sout::appendSink(fileA).print("last\n");
+        REQUIRE(sout::closeAllSinks() == 0);
+        linesA = readLines(fileA);
+        REQUIRE(linesA.size() == static_cast<std::size_t>(nLines) + 1);
+        REQUIRE(linesA.back() == "last");
+      } // End of then
+      std::remove(fileA.c_str());
+      std::remove(fileB.c_str());
+    } // End of when
+  }   // End of given
+} // End of scenario
+
+SCENARIO("Test that failed writes are reported when the sinks are flushed.",
+         "[output_sink]") {
+  GIVEN("A sink for a device which is always full") {
+    std::string fullDevice = "/dev/full";
+    if (!std::ifstream(fullDevice).good()) {
+      WARN("Skipping, since " << fullDevice << " is not available.");
+      return;
+    }
+    WHEN("Output is appended and the sinks are flushed") {
+      sout::appendSink(fullDevice).print("{}\n", "lost");
+      int flushResult = sout::flushAllSinks();
+      int closeResult = sout::closeAllSinks();
+      THEN("The flush should report the failure exactly once.") {
+        REQUIRE(flushResult == 1);
+        REQUIRE(closeResult == 0);
+      } // End of then
+    }   // End of when
+  }     // End of given
+} // End of scenario
@@ -0,0 +1,139 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <mol_sys.hpp>
+#include <output_sink.hpp>
+#include <seams_binary.hpp>
+
+// Standard
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "boost/filesystem/operations.hpp"
+#include <catch2/catch.hpp>
+
+SCENARIO("Test the round trip of two frames through the binary trajectory.",
+         "[sbin]") {
+  GIVEN("A pointCloud with per-atom results and rings for two frames") {
+    molSys::PointCloud<molSys::Point<double>, double> yCloud; // pointCloud
+    molSys::Point<double> iPoint;                             // A single point
+    std::string fileName = "sbinRoundTrip.bin";  // Binary trajectory
+    std::string path = "sbinRoundTrip/";         // Converted output
+    std::vector<int> atomClass;                  // Per-atom classification
+    std::vector<double> rmsd;                    // Per-atom RMSD
+    std::vector<int> clusterID;                  // Per-atom cluster ID
+    std::vector<std::vector<int>> rings;         // Rings, by atom index
+    sbin::FrameRecord rec;                       // Frame read back in
+    //
+    yCloud.box = {10.0, 11.0, 12.0};
+    yCloud.boxLow = {-1.0, -2.0, -3.0};
+    // Six atoms, two molecules of three atoms each
+    for (int iatom = 0; iatom < 6; iatom++) {
+      iPoint.atomID = 10 + iatom;
+      iPoint.molID = 1 + iatom / 3;
+      iPoint.type = 1 + iatom % 3;
+      iPoint.x = 0.5 * iatom;
+      iPoint.y = 1.25 * iatom;
+      iPoint.z = -0.75 * iatom;
+      iPoint.iceType = static_cast<molSys::atom_state_type>(iatom % 4);
+      yCloud.pts.push_back(iPoint);
+      yCloud.idIndexMap[iPoint.atomID] = iatom;
+    } // end of filling the pointCloud
+    yCloud.nop = yCloud.pts.size();
+    // --------------------
+    WHEN("Both frames are recorded and read back in") {
+      REQUIRE(sbin::openTrajectory(fileName) == 0);
+      // Frame 1: every column, and two rings
+      yCloud.currentFrame = 1;
+      atomClass = {0, 1, 2, 3, 4, 5};
+      rmsd = {0.1, 0.2, 0.3, 0.4, 0.5, 0.6};
+      clusterID = {-1, 0, 0, 1, 1, -1};
+      rings = {{0, 1, 2, 3}, {2, 3, 4, 5, 0}};
+      REQUIRE(sbin::recordAtoms(&yCloud) == 0);
+      REQUIRE(sbin::recordAtomClass(&yCloud, atomClass) == 0);
+      REQUIRE(sbin::recordRMSD(&yCloud, rmsd) == 0);
+      REQUIRE(sbin::recordClusterIDs(&yCloud, clusterID) == 0);
+      REQUIRE(sbin::recordRings(&yCloud, rings) == 0);
+      // Frame 2: moved atoms and one ring, no other analysis columns
+      yCloud.currentFrame = 2;
+      for (auto &point : yCloud.pts) {
+        point.x += 1.0;
+      }
+      REQUIRE(sbin::recordRings(&yCloud, {{5, 4, 3}}) == 0);
+      REQUIRE(sbin::closeTrajectory() == 0);
+      THEN("The index, the columns and the rings should be unchanged.") {
+        std::vector<sbin::IndexEntry> index = sbin::readIndex(fileName);
+        REQUIRE(index.size() == 2);
+        REQUIRE(index[0].frame == 1);
+        REQUIRE(index[1].frame == 2);
+        // Frame 1
+        REQUIRE(sbin::readFrame(fileName, 1, &rec) == 0);
+        REQUIRE(rec.frame == 1);
+        REQUIRE(rec.box == yCloud.box);
+        REQUIRE(rec.boxLow == yCloud.boxLow);
+        REQUIRE(rec.atomID.size() == 6);
+        for (int iatom = 0; iatom < 6; iatom++) {
+          REQUIRE(rec.atomID[iatom] == 10 + iatom);
+          REQUIRE(rec.molID[iatom] == 1 + iatom / 3);
+          REQUIRE(rec.type[iatom] == 1 + iatom % 3);
+          REQUIRE(rec.iceType[iatom] == iatom % 4);
+          REQUIRE(rec.x[iatom] == 0.5 * iatom);
+          REQUIRE(rec.y[iatom] == 1.25 * iatom);
+          REQUIRE(rec.z[iatom] == -0.75 * iatom);
+          REQUIRE(rec.atomClass[iatom] == atomClass[iatom]);
+          REQUIRE(rec.rmsd[iatom] == rmsd[iatom]);
+          REQUIRE(rec.clusterID[iatom] == clusterID[iatom]);
+        } // end of loop through atoms
+        REQUIRE(rec.ringOffsets == std::vector<std::uint64_t>{0, 4, 9});
+        REQUIRE(rec.ringAtoms ==
+                std::vector<std::int32_t>{0, 1, 2, 3, 2, 3, 4, 5, 0});
+        // Frame 2, with the analysis columns unset
+        REQUIRE(sbin::readFrame(fileName, 2, &rec) == 0);
+        REQUIRE(rec.frame == 2);
+        for (int iatom = 0; iatom < 6; iatom++) {
+          REQUIRE(rec.x[iatom] == 0.5 * iatom + 1.0);
+          REQUIRE(rec.atomClass[iatom] == -1);
+          REQUIRE(rec.rmsd[iatom] == -1.0);
+          REQUIRE(rec.clusterID[iatom] == -1);
+        } // end of loop through atoms
+        REQUIRE(rec.ringOffsets == std::vector<std::uint64_t>{0, 3});
+        REQUIRE(rec.ringAtoms == std::vector<std::int32_t>{5, 4, 3});
+        // A frame which was never written
+        REQUIRE(sbin::readFrame(fileName, 3, &rec) == 1);
+      }
+      THEN("The converted rings should list the atom IDs.") {
+        REQUIRE(sbin::convertToASCII(fileName, path) == 0);
+        std::ifstream ringFile(path + "ringFiles/rings-1.dat");
+        std::string line;
+        REQUIRE(std::getline(ringFile, line));
+        REQUIRE(line == "10 11 12 13 ");
+        REQUIRE(std::getline(ringFile, line));
+        REQUIRE(line == "12 13 14 15 10 ");
+        std::ifstream dumpFile(path + "dumpFiles/dump-2.lammpstrj");
+        int nLines = 0;
+        while (std::getline(dumpFile, line)) {
+          nLines++;
+        }
+        REQUIRE(nLines == 9 + 6); // header and one line per atom
+      }
+      std::remove(fileName.c_str());
+      std::remove((fileName + ".idx").c_str());
+      boost::filesystem::remove_all(path);
+    } // End of recording the frames
+  }   // End of given
+} // End of scenario
@@ -0,0 +1,265 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <mol_sys.hpp>
+#include <selection.hpp>
+
+// Standard
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+// Index of the oxygen atom at a grid point of a 4x4x2 grid
+int gridIndex(int a, int b, int c) { return (c * 4 + b) * 4 + a; }
+
+// Water-like molecules on a grid: yCloud has an O and two H atoms per
+// molecule, and oCloud only the O atoms (with the same atom IDs)
+void buildGridClouds(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    molSys::PointCloud<molSys::Point<double>, double> *oCloud) {
+  molSys::Point<double> iPoint;
+  double spacing = 2.8;
+  for (auto *cloud : {yCloud, oCloud}) {
+    cloud->box = {4 * spacing, 4 * spacing, 2 * spacing};
+    cloud->boxLow = {0, 0, 0};
+  }
+  for (int imol = 0; imol < 32; imol++) {
+    double x = spacing * (imol % 4);
+    double y = spacing * ((imol / 4) % 4);
+    double z = spacing * (imol / 16);
+    for (int k = 0; k < 3; k++) {
+      iPoint.atomID = 3 * imol + k + 1;
+      iPoint.molID = imol + 1;
+      iPoint.type = k == 0 ? 2 : 1;
+      // The H atoms stick out along +x and +z, so that a region can contain
+      // a hydrogen atom of a molecule without its oxygen atom
+      iPoint.x = x + (k == 1 ? 0.9 : 0.0);
+      iPoint.y = y;
+      iPoint.z = z + (k == 2 ? 0.9 : 0.0);
+      yCloud->idIndexMap[iPoint.atomID] = yCloud->pts.size();
+      yCloud->pts.push_back(iPoint);
+      if (k == 0) {
+        oCloud->idIndexMap[iPoint.atomID] = oCloud->pts.size();
+        oCloud->pts.push_back(iPoint);
+      }
+    } // end of loop through the atoms of the molecule
+  }   // end of loop through molecules
+  yCloud->nop = yCloud->pts.size();
+  oCloud->nop = oCloud->pts.size();
+}
+
+// Regions overlapping each other and cutting through molecules
+std::vector<gen::Region> overlappingRegions() {
+  return {gen::slabRegion({0, 0, 0}, {0, 0, 1.0}),
+          gen::slabRegion({0, 0, 0.5}, {0, 0, 3.0}),
+          gen::slabRegion({2.0, 0, 0}, {6.0, 0, 0}),
+          gen::slabRegion({2.5, 2.5, 0}, {6.0, 6.0, 0}),
+          gen::sphereRegion({4.2, 4.2, 1.4}, 3.0),
+          gen::cylinderRegion({5.6, 5.6, 0}, 1.5, 2),
+          gen::cylinderRegion({0, 2.8, 2.8}, 1.0, 0),
+          [](double x, double y, double z) { return x + y < 3.0; },
+          [](double, double, double) { return false; }};
+}
+
+// The inSlice bools of a PointCloud
+std::vector<bool>
+inSliceValues(molSys::PointCloud<molSys::Point<double>, double> *yCloud) {
+  std::vector<bool> selected(yCloud->nop);
+  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
+    selected[iatom] = yCloud->pts[iatom].inSlice;
+  }
+  return selected;
+}
+
+// Indices of the atoms marked in a vector of bools
+std::vector<int> markedIndices(const std::vector<bool> &marked) {
+  std::vector<int> indices;
+  for (int iatom = 0; iatom < marked.size(); iatom++) {
+    if (marked[iatom]) {
+      indices.push_back(iatom);
+    }
+  }
+  return indices;
+}
+
+// Selection of molecules in a region, the way it used to be done: with a
+// molID multimap rebuilt for every region
+std::vector<bool>
+referenceMoleculesInRegion(
+    molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+    const gen::Region &region) {
+  auto molIDAtomIDmap = molSys::createMolIDAtomIDMultiMap(yCloud);
+  for (auto &point : yCloud->pts) {
+    point.inSlice = false;
+  }
+  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
+    auto &point = yCloud->pts[iatom];
+    if (region(point.x, point.y, point.z)) {
+      gen::setAtomsWithSameMolID(yCloud, molIDAtomIDmap, point.molID, true);
+    }
+  } // end of loop through atoms
+  std::vector<bool> selected(yCloud->nop);
+  for (int iatom = 0; iatom < yCloud->nop; iatom++) {
+    selected[iatom] = yCloud->pts[iatom].inSlice;
+  }
+  return selected;
+}
+
+} // namespace
+
+SCENARIO("Test the ring edge selection against a per-ring search.",
+         "[selection]") {
+  GIVEN("Square rings through molecules on a grid, and overlapping regions") {
+    molSys::PointCloud<molSys::Point<double>, double> yCloud; // All atoms
+    molSys::PointCloud<molSys::Point<double>, double> oCloud; // O atoms
+    std::vector<std::vector<int>> rings; // Rings, by index in oCloud
+    buildGridClouds(&yCloud, &oCloud);
+    // The squares of each layer (each atom is in up to four rings)
+    for (int c = 0; c < 2; c++) {
+      for (int b = 0; b < 3; b++) {
+        for (int a = 0; a < 3; a++) {
+          rings.push_back({gridIndex(a, b, c), gridIndex(a + 1, b, c),
+                           gridIndex(a + 1, b + 1, c), gridIndex(a, b + 1, c)});
+        }
+      }
+    } // end of building the rings
+    WHEN("The edge atoms are selected for every region in turn") {
+      THEN("The selection should match the rings with an atom in the region.") {
+        for (auto &region : overlappingRegions()) {
+          // Reference: rings (found with std::find) of the O atoms in the
+          // region, and every molecule of their members in yCloud
+          std::vector<bool> oExpected(oCloud.nop, false);
+          std::vector<bool> seed(oCloud.nop, false);
+          for (int iatom = 0; iatom < oCloud.nop; iatom++) {
+            auto &point = oCloud.pts[iatom];
+            seed[iatom] = region(point.x, point.y, point.z);
+            oExpected[iatom] = seed[iatom];
+          }
+          for (auto &point : yCloud.pts) {
+            point.inSlice = false;
+          }
+          auto molIDAtomIDmap = molSys::createMolIDAtomIDMultiMap(&yCloud);
+          for (auto &ring : rings) {
+            bool hasSeed = std::any_of(ring.begin(), ring.end(),
+                                       [&seed](int iatom) { return seed[iatom]; });
+            if (!hasSeed) {
+              continue;
+            }
+            for (int jatom : ring) {
+              oExpected[jatom] = true;
+              gen::setAtomsWithSameMolID(&yCloud, molIDAtomIDmap,
+                                         oCloud.pts[jatom].molID, true);
+            }
+          } // end of loop through rings
+          std::vector<bool> yExpected = inSliceValues(&yCloud);
+          // Indexed selection, starting from the same yCloud state
+          for (auto &point : yCloud.pts) {
+            point.inSlice = false;
+          }
+          ring::getEdgeMoleculesInRingsRegion(rings, &oCloud, &yCloud, region);
+          REQUIRE(inSliceValues(&oCloud) == oExpected);
+          REQUIRE(inSliceValues(&yCloud) == yExpected);
+          // With identical clouds only oCloud is updated
+          ring::getEdgeMoleculesInRingsRegion(rings, &oCloud, &oCloud, region,
+                                              true);
+          REQUIRE(inSliceValues(&oCloud) == oExpected);
+        } // end of loop through regions
+      }
+    } // End of selecting the edge atoms
+  }   // End of given
+} // End of scenario
+
+SCENARIO("Test the single-pass selection of several regions against a "
+         "selection region by region.",
+         "[selection]") {
+  GIVEN("Molecules on a grid, and overlapping regions") {
+    molSys::PointCloud<molSys::Point<double>, double> yCloud; // All atoms
+    molSys::PointCloud<molSys::Point<double>, double> oCloud; // O atoms
+    buildGridClouds(&yCloud, &oCloud);
+    // More than 64 regions, so that every atom needs two words of the mask
+    std::vector<gen::Region> regions;
+    for (int k = 0; k < 8; k++) {
+      for (auto &region : overlappingRegions()) {
+        regions.push_back(region);
+      }
+    }
+    REQUIRE(regions.size() > 64);
+    // Reference: the atoms (and the whole molecules) in every region,
+    // selected one region at a time
+    std::vector<std::vector<bool>> atomsExpected;
+    std::vector<std::vector<bool>> moleculesExpected;
+    for (auto &region : regions) {
+      std::vector<bool> inside(yCloud.nop);
+      for (int iatom = 0; iatom < yCloud.nop; iatom++) {
+        auto &point = yCloud.pts[iatom];
+        inside[iatom] = region(point.x, point.y, point.z);
+      }
+      atomsExpected.push_back(inside);
+      moleculesExpected.push_back(referenceMoleculesInRegion(&yCloud, region));
+    } // end of loop through regions
+    // Some regions hold part of a molecule only
+    REQUIRE(atomsExpected != moleculesExpected);
+    WHEN("The regions are selected in a single pass") {
+      gen::RegionSelection selection = gen::selectRegions(&yCloud, regions);
+      THEN("Every region should contain the atoms inside it.") {
+        REQUIRE(selection.nRegions == regions.size());
+        REQUIRE(selection.nWords == 2);
+        std::vector<std::vector<int>> lists = gen::regionAtomLists(selection);
+        REQUIRE(lists.size() == regions.size());
+        for (int r = 0; r < regions.size(); r++) {
+          for (int iatom = 0; iatom < yCloud.nop; iatom++) {
+            REQUIRE(selection.contains(iatom, r) == atomsExpected[r][iatom]);
+          }
+          REQUIRE(lists[r] == markedIndices(atomsExpected[r]));
+        } // end of loop through regions
+      }
+      THEN("Extended to whole molecules, every region should contain the "
+           "molecules with an atom inside it.") {
+        gen::expandToMolecules(selection, gen::buildMolIndex(&yCloud));
+        for (int r = 0; r < regions.size(); r++) {
+          gen::setInSliceFromSelection(&yCloud, selection, r);
+          REQUIRE(inSliceValues(&yCloud) == moleculesExpected[r]);
+        } // end of loop through regions
+      }
+    } // End of selecting in a single pass
+    WHEN("The atoms in the regions are listed") {
+      std::vector<std::vector<int>> molecules =
+          gen::atomsInRegions(&yCloud, regions);
+      std::vector<std::vector<int>> atoms =
+          gen::atomsInRegions(&yCloud, regions, false);
+      THEN("The lists should match the selection region by region.") {
+        REQUIRE(molecules.size() == regions.size());
+        REQUIRE(atoms.size() == regions.size());
+        for (int r = 0; r < regions.size(); r++) {
+          REQUIRE(molecules[r] == markedIndices(moleculesExpected[r]));
+          REQUIRE(atoms[r] == markedIndices(atomsExpected[r]));
+        } // end of loop through regions
+      }
+    } // End of listing the atoms
+    WHEN("The molecules in every region are selected in turn") {
+      THEN("The inSlice values should match the per-region selection.") {
+        for (int r = 0; r < regions.size(); r++) {
+          gen::moleculesInRegion(&yCloud, regions[r]);
+          REQUIRE(inSliceValues(&yCloud) == moleculesExpected[r]);
+        } // end of loop through regions
+      }
+    } // End of selecting the molecules
+  }   // End of given
+} // End of scenario
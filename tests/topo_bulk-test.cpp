@@ -7,11 +7,64 @@
 #include <topo_bulk.hpp>
 
 // Standard
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <iostream>
+#include <random>
+#include <vector>
 
 #include <catch2/catch.hpp>
 #include <rang.hpp>
 
+namespace {
+
+// Hexagonal rings of radius 1.4 with random centres and orientations, every
+// ring made of its own atoms. The atoms are wrapped into the box, so that
+// rings near its faces cross the periodic boundary
+void randomRings(int nRings, std::array<double, 3> box, std::mt19937 &engine,
+                 molSys::PointCloud<molSys::Point<double>, double> *yCloud,
+                 std::vector<std::vector<int>> *rings) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  yCloud->box = {box[0], box[1], box[2]};
+  yCloud->boxLow = {0.0, 0.0, 0.0};
+  for (int iring = 0; iring < nRings; iring++) {
+    std::array<double, 3> centre;
+    for (int k = 0; k < 3; k++) {
+      centre[k] = box[k] * uniform(engine);
+    }
+    // Two orthogonal unit vectors spanning the plane of the ring
+    double theta = std::acos(2.0 * uniform(engine) - 1.0);
+    double phi = 2.0 * M_PI * uniform(engine);
+    std::array<double, 3> u = {std::cos(theta) * std::cos(phi),
+                               std::cos(theta) * std::sin(phi),
+                               -std::sin(theta)};
+    std::array<double, 3> v = {-std::sin(phi), std::cos(phi), 0.0};
+    std::vector<int> ring;
+    for (int m = 0; m < 6; m++) {
+      double angle = m * M_PI / 3.0;
+      std::array<double, 3> r;
+      for (int k = 0; k < 3; k++) {
+        r[k] = centre[k] + 1.4 * (std::cos(angle) * u[k] +
+                                  std::sin(angle) * v[k]);
+        r[k] -= box[k] * std::floor(r[k] / box[k]);
+      }
+      molSys::Point<double> iPoint;
+      iPoint.type = 1;
+      iPoint.atomID = yCloud->pts.size() + 1;
+      iPoint.x = r[0];
+      iPoint.y = r[1];
+      iPoint.z = r[2];
+      ring.push_back(yCloud->pts.size());
+      yCloud->pts.push_back(iPoint);
+    } // end of loop through ring members
+    rings->push_back(ring);
+  } // end of loop through rings
+  yCloud->nop = yCloud->pts.size();
+}
+
+} // namespace
+
 SCENARIO("Test the HC algorithm for a single hexagonal cage.", "[topo]") {
   GIVEN("A pointCloud") {
     // Hard-coded example of a single tetragonal prism
@@ -262,3 +315,70 @@ SCENARIO("Test the DDC algorithm for a single double-diamond cage.", "[topo]") {
     }  // End of getting the neighbour list
   }    // End of given
 } // End of scenario
+
+SCENARIO("Test that the ring spatial index finds every pair of rings close "
+         "enough to be the basal rings of a prism.",
+         "[topo]") {
+  GIVEN("Random rings, in boxes with many cells or fewer than three") {
+    // Box lengths: many cells along every dimension; fewer than three cells
+    // along some (with a reach of 3 + 2 * 1.4 = 5.8); a single cell
+    std::vector<std::array<double, 3>> boxes = {
+        {30.0, 30.0, 30.0}, {12.0, 30.0, 15.0}, {5.0, 5.0, 5.0}};
+    double heightCutoff = 3.0;
+    for (auto &box : boxes) {
+      molSys::PointCloud<molSys::Point<double>, double> yCloud;
+      std::vector<std::vector<int>> rings;
+      std::mt19937 engine(31);
+      int nRings = 6 * box[0] * box[1] * box[2] / 1000.0 + 8;
+      randomRings(nRings, box, engine, &yCloud, &rings);
+      WHEN("The nearby rings of every ring are found with the index, in a "
+           "box of " +
+           std::to_string(box[0]) + " x " + std::to_string(box[1]) + " x " +
+           std::to_string(box[2])) {
+        ring::RingSpatialIndex index =
+            ring::buildRingSpatialIndex(rings, &yCloud, heightCutoff);
+        THEN("They include every pair passing a brute-force search.") {
+          // Only the first box has three cells or more along every dimension
+          bool fewCells = std::any_of(index.nCells.begin(), index.nCells.end(),
+                                      [](int n) { return n < 3; });
+          REQUIRE(fewCells == (box[0] < 20.0));
+          int nPairs = 0;          // Pairs passing the separation check
+          int nAcrossBoundary = 0; // Of which across the periodic boundary
+          for (int iring = 0; iring < rings.size(); iring++) {
+            std::vector<int> nearby = ring::nearbyRings(index, iring);
+            REQUIRE(std::is_sorted(nearby.begin(), nearby.end()));
+            for (int jring = iring + 1; jring < rings.size(); jring++) {
+              // Any pair of members closer than the cutoff
+              bool isClose = false;
+              bool isAcross = false;
+              for (int l : rings[iring]) {
+                for (int m : rings[jring]) {
+                  if (gen::periodicDist(&yCloud, l, m) < heightCutoff) {
+                    isClose = true;
+                    std::array<double, 3> dr = {
+                        yCloud.pts[l].x - yCloud.pts[m].x,
+                        yCloud.pts[l].y - yCloud.pts[m].y,
+                        yCloud.pts[l].z - yCloud.pts[m].z};
+                    for (int k = 0; k < 3; k++) {
+                      isAcross = isAcross || std::fabs(dr[k]) > box[k] / 2;
+                    }
+                  }
+                }
+              } // end of loop through member pairs
+              bool isBasal = prism3::basalRingsSeparation(
+                  &yCloud, rings[iring], rings[jring], heightCutoff);
+              if (isClose || isBasal) {
+                nPairs += isBasal;
+                nAcrossBoundary += isBasal && isAcross;
+                REQUIRE(std::binary_search(nearby.begin(), nearby.end(),
+                                           jring));
+              }
+            } // end of loop through the other rings
+          }   // end of loop through rings
+          REQUIRE(nPairs > 0);
+          REQUIRE(nAcrossBoundary > 0);
+        } // End of then
+      }   // End of when
+    }     // end of loop through boxes
+  }       // End of given
+} // End of scenario
@@ -0,0 +1,542 @@
+//-----------------------------------------------------------------------------------
+// d-SEAMS - Deferred Structural Elucidation Analysis for Molecular Simulations
+//
+// Copyright (c) 2018--present d-SEAMS core team
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License as published by
+// the Open Source Initiative.
+//
+// A copy of the MIT License is included in the LICENSE file of this repository.
+// You should have received a copy of the MIT License along with this program.
+// If not, see <https://opensource.org/licenses/MIT>.
+//-----------------------------------------------------------------------------------
+
+
+// Internal
+#include <mol_sys.hpp>
+#include <seams_input.hpp>
+#include <trajectory_formats.hpp>
+
+// Standard
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+using Frame = std::vector<std::array<double, 3>>; // Coordinates of the atoms
+
+// Writes binary values in either byte order
+class ByteWriter {
+public:
+  ByteWriter(const std::string &filename, bool bigEndian)
+      : file(filename, std::ios::binary), bigEndian(bigEndian) {}
+
+  template <typename T> void put(T value) {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    std::uint16_t probe = 1;
+    bool hostLittle = *reinterpret_cast<unsigned char *>(&probe) == 1;
+    if (hostLittle == bigEndian) {
+      for (std::size_t i = 0; i < sizeof(T) / 2; i++) {
+        std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+      }
+    }
+    file.write(reinterpret_cast<char *>(bytes), sizeof(T));
+  }
+  void putBytes(const void *data, std::size_t n) {
+    file.write(static_cast<const char *>(data), n);
+  }
+
+private:
+  std::ofstream file;
+  bool bigEndian;
+};
+
+// Writes a CHARMM-style DCD file, with or without the unit cell of each frame
+void writeDCD(const std::string &filename, const std::vector<Frame> &frames,
+              const std::vector<std::array<double, 3>> &boxes, bool bigEndian,
+              bool withCell) {
+  ByteWriter out(filename, bigEndian);
+  std::int32_t natoms = frames[0].size();
+  std::int32_t icntrl[20] = {0};
+  icntrl[0] = frames.size(); // Number of frames
+  icntrl[2] = 1;             // Frames between saves
+  icntrl[10] = withCell;     // Unit cell in every frame
+  icntrl[19] = 24;           // CHARMM version
+  out.put<std::int32_t>(84);
+  out.putBytes("CORD", 4);
+  for (auto value : icntrl) {
+    out.put(value);
+  }
+  out.put<std::int32_t>(84);
+  // Title block, with one 80 character line
+  char title[80];
+  std::memset(title, ' ', 80);
+  std::memcpy(title, "d-SEAMS test", 12);
+  out.put<std::int32_t>(84);
+  out.put<std::int32_t>(1);
+  out.putBytes(title, 80);
+  out.put<std::int32_t>(84);
+  out.put<std::int32_t>(4);
+  out.put(natoms);
+  out.put<std::int32_t>(4);
+  for (std::size_t iframe = 0; iframe < frames.size(); iframe++) {
+    if (withCell) {
+      // A, gamma, B, beta, alpha, C, with the angles alternately given as
+      // cosines and in degrees
+      double right = iframe % 2 == 0 ? 0.0 : 90.0;
+      out.put<std::int32_t>(48);
+      for (double value : {boxes[iframe][0], right, boxes[iframe][1], right,
+                           right, boxes[iframe][2]}) {
+        out.put(value);
+      }
+      out.put<std::int32_t>(48);
+    }
+    for (int k = 0; k < 3; k++) {
+      out.put<std::int32_t>(4 * natoms);
+      for (auto &r : frames[iframe]) {
+        out.put(static_cast<float>(r[k]));
+      }
+      out.put<std::int32_t>(4 * natoms);
+    }
+  } // end of loop through frames
+}
+
+// Table of the xdrfile compression: the sizes of the small differences
+const int magicints[] = {
+    0,        0,        0,       0,       0,       0,       0,       0,
+    0,        8,        10,      12,      16,      20,      25,      32,
+    40,       50,       64,      80,      101,     128,     161,     203,
+    256,      322,      406,     512,     645,     812,     1024,    1290,
+    1625,     2048,     2580,    3250,    4096,    5060,    6501,    8192,
+    10321,    13003,    16384,   20642,   26007,   32768,   41285,   52015,
+    65536,    82570,    104031,  131072,  165140,  208063,  262144,  330280,
+    416127,   524287,   660561,  832255,  1048576, 1321122, 1664510, 2097152,
+    2642245,  3329021,  4194304, 5284491, 6658042, 8388607, 10568983,
+    13316085, 16777216};
+const int firstIdx = 9;
+const int lastIdx = sizeof(magicints) / sizeof(*magicints);
+
+// Bit stream, written most significant bit first
+class BitWriter {
+public:
+  void bits(int nBits, unsigned int value) {
+    for (int b = nBits - 1; b >= 0; b--) {
+      if (nUsed % 8 == 0) {
+        data.push_back(0);
+      }
+      if ((value >> b) & 1u) {
+        data.back() |= 0x80 >> (nUsed % 8);
+      }
+      nUsed++;
+    }
+  }
+  // Three integers, packed as the digits of one number with the given sizes
+  // (the first integer is the most significant), written least significant
+  // byte first
+  void ints(int nBits, const unsigned int sizes[3], const int nums[3]) {
+    unsigned __int128 packed =
+        (static_cast<unsigned __int128>(nums[0]) * sizes[1] + nums[1]) *
+            sizes[2] +
+        nums[2];
+    while (nBits > 8) {
+      bits(8, static_cast<unsigned int>(packed & 0xff));
+      packed >>= 8;
+      nBits -= 8;
+    }
+    bits(nBits, static_cast<unsigned int>(packed));
+  }
+
+  std::vector<unsigned char> data;
+
+private:
+  long nUsed = 0;
+};
+
+// Number of bits needed for the numbers below sizes[0]*sizes[1]*sizes[2]
+int bitsForProduct(const unsigned int sizes[3]) {
+  unsigned __int128 product =
+      static_cast<unsigned __int128>(sizes[0]) * sizes[1] * sizes[2];
+  int nBits = 0;
+  while (product > 0) {
+    nBits++;
+    product >>= 1;
+  }
+  return nBits;
+}
+
+// True if each component of a - b fits into the small differences of smallidx
+bool fitsSmall(const int *a, const int *b, int smallidx) {
+  if (smallidx < firstIdx || smallidx >= lastIdx) {
+    return false;
+  }
+  for (int d = 0; d < 3; d++) {
+    int value = a[d] - b[d] + magicints[smallidx] / 2;
+    if (value < 0 || value >= magicints[smallidx]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Statistics of the compressed stream, to make sure that the test covers runs
+// of small differences and changes of their size in both directions
+struct XTCStats {
+  int nRuns = 0, nGrow = 0, nShrink = 0;
+};
+
+// Compresses integer coordinates as in xdrfile: each atom is written in full,
+// followed by up to eight atoms as small differences from the atom before,
+// with the first two atoms of a run swapped
+std::vector<unsigned char> compressXTC(const std::vector<int> &coords,
+                                       const int minint[3],
+                                       const unsigned int sizeint[3],
+                                       int smallidx, XTCStats &stats) {
+  int natoms = coords.size() / 3;
+  BitWriter out;
+  int bitsize = bitsForProduct(sizeint);
+  int prevrun = -1;
+  int i = 0;
+  while (i < natoms) {
+    const int *atom = &coords[3 * i];
+    // Atoms of the run, as small differences
+    std::vector<int> smallAtoms;
+    int full = i;
+    if (i + 1 < natoms && fitsSmall(atom, atom + 3, smallidx)) {
+      full = i + 1;
+      smallAtoms.push_back(i);
+      int prev = i;
+      for (int j = i + 2; j < natoms && smallAtoms.size() < 8; j++) {
+        if (!fitsSmall(&coords[3 * j], &coords[3 * prev], smallidx)) {
+          break;
+        }
+        smallAtoms.push_back(j);
+        prev = j;
+      }
+    }
+    // Size of the differences after this run
+    int isSmaller = 0;
+    int next = i + 1 + smallAtoms.size();
+    int last = smallAtoms.empty() ? i : smallAtoms.back();
+    if (next < natoms && smallAtoms.size() < 8 &&
+        !fitsSmall(&coords[3 * next], &coords[3 * last], smallidx) &&
+        fitsSmall(&coords[3 * next], &coords[3 * last], smallidx + 1)) {
+      isSmaller = 1;
+    } else if (!smallAtoms.empty() && smallidx > firstIdx) {
+      bool shrink = fitsSmall(atom, atom + 3, smallidx - 1);
+      for (std::size_t k = 1; k < smallAtoms.size(); k++) {
+        int prev = k == 1 ? i : smallAtoms[k - 1];
+        shrink = shrink && fitsSmall(&coords[3 * smallAtoms[k]],
+                                     &coords[3 * prev], smallidx - 1);
+      }
+      isSmaller = shrink ? -1 : 0;
+    }
+    // Full coordinates
+    int fullInts[3];
+    for (int d = 0; d < 3; d++) {
+      fullInts[d] = coords[3 * full + d] - minint[d];
+    }
+    out.ints(bitsize, sizeint, fullInts);
+    // Run length and change of size
+    int run = 3 * smallAtoms.size();
+    if (run != prevrun || isSmaller != 0) {
+      prevrun = run;
+      out.bits(1, 1);
+      out.bits(5, run + isSmaller + 1);
+    } else {
+      out.bits(1, 0);
+    }
+    // Small differences
+    unsigned int sizesmall[3] = {
+        static_cast<unsigned int>(magicints[smallidx]),
+        static_cast<unsigned int>(magicints[smallidx]),
+        static_cast<unsigned int>(magicints[smallidx])};
+    int smallnum = magicints[smallidx] / 2;
+    for (std::size_t k = 0; k < smallAtoms.size(); k++) {
+      int from = k == 0 ? full : (k == 1 ? i : smallAtoms[k - 1]);
+      int diff[3];
+      for (int d = 0; d < 3; d++) {
+        diff[d] = coords[3 * smallAtoms[k] + d] - coords[3 * from + d] +
+                  smallnum;
+      }
+      out.ints(smallidx, sizesmall, diff);
+    }
+    stats.nRuns += !smallAtoms.empty();
+    stats.nGrow += isSmaller > 0;
+    stats.nShrink += isSmaller < 0;
+    smallidx += isSmaller;
+    i = next;
+  } // end of loop through atoms
+  return out.data;
+}
+
+// Writes a GROMACS XTC file (coordinates and box lengths in nm). Frames with
+// more than 9 atoms are compressed
+XTCStats writeXTC(const std::string &filename, const std::vector<Frame> &frames,
+                  const std::vector<std::array<double, 3>> &boxes,
+                  float precision) {
+  ByteWriter out(filename, true);
+  XTCStats stats;
+  for (std::size_t iframe = 0; iframe < frames.size(); iframe++) {
+    const Frame &frame = frames[iframe];
+    std::int32_t natoms = frame.size();
+    out.put<std::int32_t>(1995);
+    out.put(natoms);
+    out.put<std::int32_t>(100 * iframe); // step
+    out.put<float>(0.5f * iframe);       // time
+    for (int row = 0; row < 3; row++) {
+      for (int col = 0; col < 3; col++) {
+        out.put<float>(row == col ? boxes[iframe][row] : 0.0f);
+      }
+    }
+    out.put(natoms);
+    if (natoms <= 9) {
+      for (auto &r : frame) {
+        for (int d = 0; d < 3; d++) {
+          out.put(static_cast<float>(r[d]));
+        }
+      }
+      continue;
+    } // uncompressed
+    std::vector<int> coords;
+    int minint[3] = {INT32_MAX, INT32_MAX, INT32_MAX};
+    int maxint[3] = {INT32_MIN, INT32_MIN, INT32_MIN};
+    for (auto &r : frame) {
+      for (int d = 0; d < 3; d++) {
+        int value = std::lround(r[d] * precision);
+        coords.push_back(value);
+        minint[d] = std::min(minint[d], value);
+        maxint[d] = std::max(maxint[d], value);
+      }
+    }
+    unsigned int sizeint[3];
+    for (int d = 0; d < 3; d++) {
+      sizeint[d] = maxint[d] - minint[d] + 1;
+    }
+    int smallidx = 18; // Differences up to +-32 to start with
+    std::vector<unsigned char> data =
+        compressXTC(coords, minint, sizeint, smallidx, stats);
+    out.put(precision);
+    for (int d = 0; d < 3; d++) {
+      out.put<std::int32_t>(minint[d]);
+    }
+    for (int d = 0; d < 3; d++) {
+      out.put<std::int32_t>(maxint[d]);
+    }
+    out.put<std::int32_t>(smallidx);
+    out.put<std::int32_t>(data.size());
+    data.resize((data.size() + 3) / 4 * 4, 0); // XDR opaque padding
+    out.putBytes(data.data(), data.size());
+  } // end of loop through frames
+  return stats;
+}
+
+// Writes a LAMMPS binary dump in the old format (dump atom, with scaled
+// coordinates, in two chunks per frame)
+void writeLammpsBin(const std::string &filename,
+                    const std::vector<Frame> &frames,
+                    const std::vector<std::array<double, 3>> &boxes,
+                    std::array<double, 3> lo) {
+  ByteWriter out(filename, false);
+  for (std::size_t iframe = 0; iframe < frames.size(); iframe++) {
+    const Frame &frame = frames[iframe];
+    std::int64_t natoms = frame.size();
+    out.put<std::int64_t>(1000 * iframe); // timestep
+    out.put(natoms);
+    out.put<std::int32_t>(0); // orthogonal box
+    for (int k = 0; k < 6; k++) {
+      out.put<std::int32_t>(0); // periodic boundaries
+    }
+    for (int d = 0; d < 3; d++) {
+      out.put(lo[d]);
+      out.put(lo[d] + boxes[iframe][d]);
+    }
+    out.put<std::int32_t>(5); // id type xs ys zs
+    std::int64_t half = natoms / 2;
+    out.put<std::int32_t>(2); // chunks
+    for (std::int64_t begin : {std::int64_t{0}, half}) {
+      std::int64_t end = begin == 0 ? half : natoms;
+      out.put<std::int32_t>(5 * (end - begin));
+      for (std::int64_t iatom = begin; iatom < end; iatom++) {
+        out.put<double>(iatom + 1);
+        out.put<double>(1 + iatom % 2);
+        for (int d = 0; d < 3; d++) {
+          out.put((frame[iatom][d] - lo[d]) / boxes[iframe][d]);
+        }
+      }
+    }
+  } // end of loop through frames
+}
+
+// Three frames of water-like molecules: an O atom with two close H atoms
+std::vector<Frame> waterFrames(int nMolecules, double spacing, double bond) {
+  std::vector<Frame> frames;
+  for (int iframe = 0; iframe < 3; iframe++) {
+    Frame frame;
+    for (int imol = 0; imol < nMolecules; imol++) {
+      double x = spacing * (imol % 4) - 0.4 + 0.01 * iframe;
+      double y = spacing * (imol / 4 % 4) + 0.003 * imol;
+      double z = spacing * (imol / 16) + 0.02 * iframe;
+      frame.push_back({x, y, z});
+      // Molecules cycle through a spread out, a medium and a compact
+      // geometry, so that the size of the small differences changes in both
+      // directions
+      double b = bond * (imol % 3 == 0 ? 1.0 : (imol % 3 == 1 ? 0.3 : 0.1));
+      frame.push_back({x + b, y + 0.3 * b, z - 0.2 * b});
+      frame.push_back({x - 0.3 * b, y + b, z + 0.1 * b});
+    }
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+} // namespace
+
+SCENARIO("Test the DCD reader on files of both byte orders.", "[trj]") {
+  GIVEN("DCD files of three frames, with and without unit cells") {
+    std::vector<Frame> frames = waterFrames(12, 3.1, 0.96);
+    std::vector<std::array<double, 3>> boxes = {
+        {12.4, 12.4, 6.2}, {12.5, 12.3, 6.1}, {12.6, 12.2, 6.0}};
+    molSys::PointCloud<molSys::Point<double>, double> yCloud;
+    for (bool bigEndian : {false, true}) {
+      for (bool withCell : {true, false}) {
+        std::string filename =
+            std::string("trjTest-") + (bigEndian ? "be" : "le") +
+            (withCell ? "-cell" : "") + ".dcd";
+        writeDCD(filename, frames, boxes, bigEndian, withCell);
+        WHEN("Every frame is read in") {
+          THEN("The frame count, coordinates and box should match.") {
+            REQUIRE(sinp::trajectoryFormat(filename) ==
+                    sinp::TrajectoryFormat::dcd);
+            REQUIRE(sinp::countFrames(filename) == 3);
+            for (int iframe = 0; iframe < 3; iframe++) {
+              REQUIRE(sinp::readBinaryTrj(filename, iframe + 1, &yCloud) == 0);
+              REQUIRE(yCloud.nop == frames[iframe].size());
+              for (int iatom = 0; iatom < yCloud.nop; iatom++) {
+                REQUIRE(yCloud.pts[iatom].atomID == iatom + 1);
+                REQUIRE(yCloud.pts[iatom].x ==
+                        static_cast<float>(frames[iframe][iatom][0]));
+                REQUIRE(yCloud.pts[iatom].y ==
+                        static_cast<float>(frames[iframe][iatom][1]));
+                REQUIRE(yCloud.pts[iatom].z ==
+                        static_cast<float>(frames[iframe][iatom][2]));
+              }
+              if (withCell) {
+                REQUIRE(yCloud.box.size() == 3);
+                for (int d = 0; d < 3; d++) {
+                  REQUIRE(yCloud.box[d] == Approx(boxes[iframe][d]));
+                }
+              }
+            } // end of loop through frames
+            // A frame past the end
+            REQUIRE(sinp::readBinaryTrj(filename, 4, &yCloud) == 1);
+          }
+        } // End of reading the frames
+        std::remove(filename.c_str());
+      }
+    }
+  } // End of given
+} // End of scenario
+
+SCENARIO("Test the XTC reader on compressed and uncompressed frames.",
+         "[trj]") {
+  GIVEN("An XTC file with 60 atoms per frame, and one with 6") {
+    // Coordinates in nm, including negative ones
+    std::vector<Frame> frames = waterFrames(20, 0.31, 0.0957);
+    std::vector<Frame> smallFrames = waterFrames(2, 0.31, 0.0957);
+    std::vector<std::array<double, 3>> boxes = {
+        {1.24, 1.24, 0.62}, {1.25, 1.23, 0.61}, {1.26, 1.22, 0.60}};
+    float precision = 1000.0f;
+    molSys::PointCloud<molSys::Point<double>, double> yCloud;
+    std::string filename = "trjTest.xtc";
+    std::string smallName = "trjTest-small.xtc";
+    XTCStats stats = writeXTC(filename, frames, boxes, precision);
+    writeXTC(smallName, smallFrames, boxes, precision);
+    WHEN("Every frame is read in") {
+      THEN("The coordinates should be those of the file, in Angstrom.") {
+        // The frames should use runs and change the size of the small
+        // differences both ways, so that every branch of the decompression
+        // is tested
+        REQUIRE(stats.nRuns > 0);
+        REQUIRE(stats.nGrow > 0);
+        REQUIRE(stats.nShrink > 0);
+        REQUIRE(sinp::countFrames(filename) == 3);
+        for (int iframe = 0; iframe < 3; iframe++) {
+          REQUIRE(sinp::readBinaryTrj(filename, iframe + 1, &yCloud) == 0);
+          REQUIRE(yCloud.nop == 60);
+          for (int iatom = 0; iatom < yCloud.nop; iatom++) {
+            auto &point = yCloud.pts[iatom];
+            double r[3] = {point.x, point.y, point.z};
+            for (int d = 0; d < 3; d++) {
+              // Rounded to the precision of the file
+              double expected =
+                  10.0 * std::lround(frames[iframe][iatom][d] * precision) /
+                  precision;
+              REQUIRE(r[d] == Approx(expected).margin(1e-4));
+            }
+          }
+          for (int d = 0; d < 3; d++) {
+            REQUIRE(yCloud.box[d] ==
+                    Approx(10.0 * boxes[iframe][d]).margin(1e-5));
+          }
+        } // end of loop through frames
+        // Uncompressed frames are stored as floats
+        REQUIRE(sinp::countFrames(smallName) == 3);
+        REQUIRE(sinp::readBinaryTrj(smallName, 2, &yCloud) == 0);
+        REQUIRE(yCloud.nop == 6);
+        for (int iatom = 0; iatom < 6; iatom++) {
+          REQUIRE(yCloud.pts[iatom].y ==
+                  Approx(10.0 * static_cast<float>(smallFrames[1][iatom][1])));
+        }
+      }
+    } // End of reading the frames
+    std::remove(filename.c_str());
+    std::remove(smallName.c_str());
+  } // End of given
+} // End of scenario
+
+SCENARIO("Test the LAMMPS binary dump reader.", "[trj]") {
+  GIVEN("A LAMMPS binary dump with scaled coordinates, in two chunks") {
+    std::vector<Frame> frames = waterFrames(5, 3.1, 0.96);
+    std::vector<std::array<double, 3>> boxes = {
+        {12.4, 12.4, 6.2}, {12.5, 12.3, 6.1}, {12.6, 12.2, 6.0}};
+    std::array<double, 3> lo = {-1.0, 0.5, -2.0};
+    molSys::PointCloud<molSys::Point<double>, double> yCloud;
+    std::string filename = "trjTest.bin";
+    writeLammpsBin(filename, frames, boxes, lo);
+    WHEN("Every frame is read in, with and without a type filter") {
+      THEN("The atoms and the box should match.") {
+        REQUIRE(sinp::countFrames(filename) == 3);
+        for (int iframe = 0; iframe < 3; iframe++) {
+          REQUIRE(sinp::readBinaryTrj(filename, iframe + 1, &yCloud) == 0);
+          REQUIRE(yCloud.nop == 15);
+          for (int iatom = 0; iatom < 15; iatom++) {
+            REQUIRE(yCloud.pts[iatom].atomID == iatom + 1);
+            REQUIRE(yCloud.pts[iatom].type == 1 + iatom % 2);
+            REQUIRE(yCloud.pts[iatom].x ==
+                    Approx(frames[iframe][iatom][0]).margin(1e-12));
+            REQUIRE(yCloud.pts[iatom].z ==
+                    Approx(frames[iframe][iatom][2]).margin(1e-12));
+          }
+          for (int d = 0; d < 3; d++) {
+            REQUIRE(yCloud.boxLow[d] == lo[d]);
+            REQUIRE(yCloud.box[d] == Approx(boxes[iframe][d]));
+          }
+        } // end of loop through frames
+        REQUIRE(sinp::readBinaryTrj(filename, 3, &yCloud, 2) == 0);
+        REQUIRE(yCloud.nop == 7);
+      }
+    } // End of reading the frames
+    std::remove(filename.c_str());
+  } // End of given
+} // End of scenario